@@ -45,6 +45,11 @@ using namespace loos;
 typedef vector<AtomicGroup>      vGroup;
 
 
+// Each fiducial pass revisits every unassigned frame, so keep as
+// many decoded frames (of the subset only) in memory as fit here
+const unsigned long cache_bytes = 512ul << 20;
+
+
 
 
 string fullHelpMessage(void) {
@@ -97,10 +102,11 @@ int main(int argc, char *argv[]) {
   AtomicGroup model = createSystem(argv[opti++]);
   model.clearBonds();
 
-  pTraj traj = createTrajectory(argv[opti++], model);
+  string traj_name(argv[opti++]);
   string range(argv[opti++]);
   string selection(argv[opti++]);
   AtomicGroup subset = selectAtoms(model, selection);
+  pTraj traj(new CachedTrajectory(createTrajectory(traj_name, model), cache_bytes, subset));
   string outname(argv[opti++]);
   double cutoff = strtod(argv[opti++], 0);
 
@@ -132,7 +138,7 @@ int main(int argc, char *argv[]) {
     uint pick = possible_frames[static_cast<uint>(floor(possible_frames.size() * rng()))];
 
     traj->readFrame(frames[pick]);
-    traj->updateGroupCoords(model);
+    traj->updateGroupCoords(subset);
 
     AtomicGroup fiducial = subset.copy();
     fiducial.centerAtOrigin();
@@ -150,7 +156,7 @@ int main(int argc, char *argv[]) {
       if (assignments[i] >= 0 || i == pick)
         continue;
       traj->readFrame(frames[i]);
-      traj->updateGroupCoords(model);
+      traj->updateGroupCoords(subset);
       subset.centerAtOrigin();
       subset.alignOnto(fiducial);
       double d = subset.rmsd(fiducial);
@@ -43,6 +43,11 @@ using namespace std;
 using namespace loos;
 
 
+// Each fiducial pass revisits every unassigned frame, so keep as
+// many decoded frames (of the subset only) in memory as fit here
+const unsigned long cache_bytes = 512ul << 20;
+
+
 string fullHelpMessage(void) {
   string msg =
     "\n"
@@ -83,10 +88,11 @@ int main(int argc, char *argv[]) {
   AtomicGroup model = createSystem(argv[opti++]);
   model.clearBonds();
 
-  pTraj traj = createTrajectory(argv[opti++], model);
+  string traj_name(argv[opti++]);
   string range(argv[opti++]);
   string selection(argv[opti++]);
   AtomicGroup subset = selectAtoms(model, selection);
+  pTraj traj(new CachedTrajectory(createTrajectory(traj_name, model), cache_bytes, subset));
   string outname(argv[opti++]);
   double cutoff = strtod(argv[opti++], 0);
 
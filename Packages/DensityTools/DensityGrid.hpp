@@ -499,11 +499,11 @@ namespace loos {
         std::vector<DensityGridpoint> res;
         std::vector<DensityGridpoint>::iterator i;
 
-        double r2 = r*r;
+        loos::DistanceKernels::WithinCutoff< loos::DistanceKernels::NoPeriodicity<double> > within(r);
 
         for (i=pts.begin(); i != pts.end(); i++) {
           loos::GCoord v = gridToWorld(*i);
-          if (u.distance2(v) <= r2)
+          if (within(u, v))
             res.push_back(*i);
         }
 
@@ -525,8 +525,8 @@ namespace loos {
         DensityGridpoint a = gridpoint(u - r);
         DensityGridpoint b = gridpoint(u + r);
         double r2 = r * r;
+        loos::DistanceKernels::Distance2< loos::DistanceKernels::NoPeriodicity<double> > dist2;
 
-        std::vector<DensityGridpoint> res;
         for (int k=a[2]; k <= b[2]; k++) {
           if (k < 0 || k >= dims[2])
             continue;
@@ -539,7 +539,7 @@ namespace loos {
 	    
               DensityGridpoint point(i, j, k);
               loos::GCoord v = gridToWorld(point);
-              double d = u.distance2(v);
+              double d = dist2(u, v);
               if (d <= r2)
                 f(operator()(v), d);
             }
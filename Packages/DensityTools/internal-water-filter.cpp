@@ -90,14 +90,14 @@ namespace loos {
       bdd_ = boundingBox(prot);
       vector<int> result(solv.size());
 
-      double r2 = radius_ * radius_;
+      DistanceKernels::WithinCutoff< DistanceKernels::NoPeriodicity<double> > op(radius_);
+      vector<double> xyz;
+      DistanceKernels::packCoords(prot, xyz);
+
       for (uint j=0; j<solv.size(); ++j) {
         GCoord sc = solv[j]->coords();
-        for (uint i=0; i<prot.size(); ++i)
-          if (sc.distance2(prot[i]->coords()) <= r2) {
-            result[j] = 1;
-            break;
-          }
+        double u[3] = { sc.x(), sc.y(), sc.z() };
+        result[j] = DistanceKernels::anyWithinBatch(op, u, xyz.data(), prot.size());
       }
       
       return(result);
@@ -131,18 +131,15 @@ namespace loos {
       bdd_ = boundingBox(prot);
       vector<int> result(solv.size());
 
-      double r2 = radius_ * radius_;
+      DistanceKernels::WithinCutoff< DistanceKernels::NoPeriodicity<double> > op(radius_);
+      vector<double> xyz;
+      DistanceKernels::packCoords(prot, xyz);
+
       for (uint j=0; j<solv.size(); ++j) {
-	uint count = 0;
-	for (uint i=0; i<prot.size(); ++i) {
-	  if (solv[j]->coords().distance2(prot[i]->coords()) <= r2) {
-	    ++count;
-	    if (count >= threshold_) {
-	      result[j] = 1;
-	      break;
-	    }
-	  }
-	}
+        GCoord sc = solv[j]->coords();
+        double u[3] = { sc.x(), sc.y(), sc.z() };
+        uint count = DistanceKernels::countWithinBatch(op, u, xyz.data(), prot.size());
+        result[j] = (count > 0 && count >= threshold_);
       }
 
       return(result);
@@ -83,6 +83,7 @@ bool debug;
 
 string spring_desc;
 string bound_spring_desc;
+uint nthreads;
 
 string fullHelpMessage() {
 
@@ -164,12 +165,13 @@ public:
     o.add_options()
       ("debug", po::value<bool>(&debug)->default_value(false), "Turn on debugging (output intermediate matrices)")
       ("spring,S", po::value<string>(&spring_desc)->default_value("distance"),"Spring function to use")
-      ("bound", po::value<string>(&bound_spring_desc), "Bound spring");
+      ("bound", po::value<string>(&bound_spring_desc), "Bound spring")
+      ("threads", po::value<uint>(&nthreads)->default_value(1), "Number of threads to use for building the Hessian (0=all available)");
   }
 
   string print() const {
     ostringstream oss;
-    oss << boost::format("debug=%d, spring='%s', bound='%s'") % debug % spring_desc % bound_spring_desc;
+    oss << boost::format("debug=%d, spring='%s', bound='%s', threads=%d") % debug % spring_desc % bound_spring_desc % nthreads;
     return(oss.str());
   }
 };
@@ -254,6 +256,7 @@ int main(int argc, char *argv[]) {
   anm.prefix(prefix);
   anm.meta(header);
   anm.verbosity(verbosity);
+  anm.threads(nthreads);
 
   anm.solve();
 
@@ -191,27 +191,25 @@ int main(int argc, char *argv[]) {
     for (uint j=0; j<m; ++j)
       V(j, i) = eigvecs(j, modes[i]);
 
-  // Make a copy and scale by the appropriate eigenvalue,
-  // remembering that eigenvalues are inverted for ENM,
-  // or squaring and not inverting in the case of PCA
-  DoubleMatrix VS = V.copy();
+  // Weight each mode by the appropriate eigenvalue, remembering that
+  // eigenvalues are inverted for ENM, or squaring and not inverting
+  // in the case of PCA
+  vector<double> w(n);
   for (uint i=0; i<n; ++i) {
     double e = eigvals[modes[i]];
-    double s = (pca_input) ? (scale * e * e): (scale / e);
-    for (uint j=0; j<m; ++j)
-      VS(j, i) *= s;
+    w[i] = (pca_input) ? (scale * e * e): (scale / e);
   }
-  
-  // U = Covariance matrix
-  DoubleMatrix U = loos::Math::MMMultiply(VS,V,false,true);
 
-  // B-factors come from trace of diagonal 3x3 superblocks
+  // B-factors come from the trace of the diagonal 3x3 superblocks of
+  // the covariance, V diag(w) V', which are summed directly rather
+  // than forming the whole m x m matrix
+  vector<double> fluct = modeFluctuations(V, w);
   vector<double> B;
   double prefactor = 8.0 *  M_PI * M_PI / 3.0;
-  for (uint i=0; i<m; i += 3) {
-    double b = prefactor * (U(i,i) + U(i+1, i+1) + U(i+2, i+2));
+  for (uint i=0; i<fluct.size(); ++i) {
+    double b = prefactor * fluct[i];
     B.push_back(b);
-    cout << boost::format("%-8d %g\n") % (i/3) % b;
+    cout << boost::format("%-8d %g\n") % i % b;
   }
 
   if (!pdb_name.empty()) {
@@ -0,0 +1,268 @@
+/*
+  enm-fit-check.cpp
+
+  Checks the warm-started eigensolver and the parallel tempering fit
+  used for fitting ENM spring parameters
+*/
+
+
+
+/*
+  This file is part of LOOS.
+
+  LOOS (Lightweight Object-Oriented Structure library)
+  Copyright (c) 2010 Tod D. Romo
+  Department of Biochemistry and Biophysics
+  School of Medicine & Dentistry, University of Rochester
+
+  This package (LOOS) is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation under version 3 of the License.
+
+  This package is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include <loos.hpp>
+
+#include "anm-lib.hpp"
+#include "enm-fit.hpp"
+#include "mc_fit.hpp"
+
+
+using namespace std;
+using namespace loos;
+using namespace ENM;
+
+
+// The "true" network the fits should recover
+const double true_scale = -0.8;
+const uint nmodes = 10;
+
+
+// Exposes the Hessian an ANM builds, without solving it
+struct HessianBuilder : public ANM {
+  HessianBuilder(SuperBlock* b) : ANM(b) { }
+  void build() { buildHessian(); }
+};
+
+
+uint failures = 0;
+
+void fail(const string& msg) {
+  cerr << "FAILED- " << msg << endl;
+  ++failures;
+}
+
+
+// Lowest n eigenpairs of H straight from LAPACK
+void lapackModes(const DoubleMatrix& H, const uint nvecs, vector<double>& vals, DoubleMatrix& vecs) {
+  DoubleMatrix A = H.copy();
+
+  char jobz = 'V';
+  char range = 'I';
+  char uplo = 'L';
+  f77int n = A.rows();
+  f77int lda = n;
+  double vl = 0.0, vu = 0.0;
+  f77int il = 1;
+  f77int iu = nvecs;
+  double abstol = 0.0;
+  f77int m;
+  vector<double> W(n);
+  vecs = DoubleMatrix(n, iu);
+  f77int ldz = n;
+  vector<f77int> isuppz(2 * iu);
+  f77int lwork = -1, liwork = -1, info;
+  double wq;
+  f77int iwq;
+
+  dsyevr_(&jobz, &range, &uplo, &n, A.get(), &lda, &vl, &vu, &il, &iu, &abstol, &m, &W[0], vecs.get(), &ldz, &isuppz[0], &wq, &lwork, &iwq, &liwork, &info);
+  lwork = static_cast<f77int>(wq);
+  liwork = iwq;
+  vector<double> work(lwork);
+  vector<f77int> iwork(liwork);
+  dsyevr_(&jobz, &range, &uplo, &n, A.get(), &lda, &vl, &vu, &il, &iu, &abstol, &m, &W[0], vecs.get(), &ldz, &isuppz[0], &work[0], &lwork, &iwork[0], &liwork, &info);
+  if (info != 0 || m != iu)
+    throw(NumericalError("dsyevr failed in the check", info));
+
+  vals.assign(W.begin(), W.begin() + iu);
+}
+
+
+// Compares the solver's eigenpairs with LAPACK's.  The rigid-body
+// modes (and any other degenerate ones) can come back as any basis for
+// their subspace, so each eigenvector is checked by how much of it lies
+// in the span of LAPACK's eigenvectors.  That span includes a few past
+// the last requested mode, in case it is degenerate with the next one.
+void compareModes(const string& label, const LowModeSolver& solver, const DoubleMatrix& H) {
+  uint nvecs = solver.eigenvalues().rows();
+  vector<double> vals;
+  DoubleMatrix vecs;
+  lapackModes(H, nvecs + 4, vals, vecs);
+
+  double scale = vals[nvecs - 1];
+  double tol = 10.0 * solver.tolerance();
+  for (uint i=6; i<nvecs; ++i)
+    if (fabs(solver.eigenvalues()[i] - vals[i]) > tol * scale) {
+      fail(label + ": eigenvalues differ from dsyevr");
+      break;
+    }
+
+  uint nspan = nvecs;
+  while (nspan < vals.size() && vals[nspan] - scale <= tol * scale)
+    ++nspan;
+
+  const DoubleMatrix& U = solver.eigenvectors();
+  uint n = H.rows();
+  for (uint i=0; i<nvecs; ++i) {
+    double inside = 0.0;
+    for (uint k=0; k<nspan; ++k) {
+      double d = 0.0;
+      for (uint r=0; r<n; ++r)
+        d += U(r, i) * vecs(r, k);
+      inside += d * d;
+    }
+    if (1.0 - inside > tol) {
+      fail(label + ": eigenvectors are not in the span of dsyevr's");
+      break;
+    }
+  }
+}
+
+
+// A random walk through the spring parameters, checking the refined
+// (warm-started) eigenpairs at each step
+void checkRefinement(SuperBlock* blocker, const CachedHessian& cache, const uint nsteps) {
+  LowModeSolver solver(nmodes + 6);
+  base_generator_type rng(3);
+  boost::uniform_real<> step(-0.01, 0.01);
+  boost::variate_generator<base_generator_type&, boost::uniform_real<> > uni(rng, step);
+
+  vector<double> p(1, true_scale);
+  uint refined = 0;
+  for (uint i=0; i<nsteps; ++i) {
+    p[0] += uni();
+    blocker->setParams(p);
+    DoubleMatrix H = cache.hessian(blocker);
+    solver.solve(H);
+    if (solver.iterations() > 0)
+      ++refined;
+    compareModes("walk step " + boost::lexical_cast<string>(i), solver, H);
+  }
+
+  cout << "Refined " << refined << " of " << nsteps << " solves\n";
+  if (refined == 0)
+    fail("eigenpairs were never refined");
+}
+
+
+// Fits the spring to modes from the true network, once with a single
+// thread and once with several
+void checkFit(const AtomicGroup& nodes, const CachedHessian& cache, const DoubleMatrix& pca_s, const DoubleMatrix& pca_U,
+              const uint nthreads, const uint nsweeps) {
+  const uint nreplicas = 4;
+  vector<double> start(1, -1.5);
+  vector<double> steps(1, 0.05);
+
+  vector<double> best[2];
+  double value[2];
+  for (uint pass=0; pass<2; ++pass) {
+    vector<SuperBlock*> blockers;
+    vector<ENMFitness*> fits;
+    for (uint r=0; r<nreplicas; ++r) {
+      blockers.push_back(new SuperBlock(springFactory("exponential"), nodes));
+      fits.push_back(new ENMFitness(blockers[r], cache, pca_s, pca_U, nmodes));
+    }
+    double start_value = (*fits[0])(start);
+
+    ParallelTempering<ENMFitness> pt(fits, ParallelTempering<ENMFitness>::geometricTemperatures(1e-4, 1e-2, nreplicas));
+    pt.threads(pass ? nthreads : 1);
+    pt.seed(7);
+    pt.stepSizes(steps);
+    best[pass] = pt.optimize(start, nsweeps);
+    value[pass] = pt.finalValue();
+
+    vector<double> swaps = pt.swapRates();
+    cout << "Fit with " << (pass ? nthreads : 1) << " thread(s): scale " << best[pass][0]
+         << ", value " << value[pass] << ", swap rates";
+    for (uint i=0; i<swaps.size(); ++i)
+      cout << " " << swaps[i];
+    cout << endl;
+
+    if (!(value[pass] < start_value))
+      fail("parallel tempering did not improve on the starting parameters");
+    if (fabs(best[pass][0] - true_scale) > 0.05)
+      fail("parallel tempering did not recover the spring parameter");
+
+    for (uint r=0; r<nreplicas; ++r) {
+      delete fits[r];
+      delete blockers[r];
+    }
+  }
+
+  if (best[0] != best[1] || value[0] != value[1])
+    fail("fit depends on the number of threads");
+}
+
+
+
+
+int main(int argc, char *argv[]) {
+
+  if (argc < 3 || argc > 6) {
+    cerr << "Usage- enm-fit-check model selection [threads [walk-steps [sweeps]]]\n"
+         << "Checks warm-started ENM modes against LAPACK and fits a spring by parallel tempering\n";
+    exit(-1);
+  }
+
+  AtomicGroup model = createSystem(argv[1]);
+  AtomicGroup nodes = selectAtoms(model, argv[2]);
+  uint nthreads = argc > 3 ? strtoul(argv[3], 0, 10) : 4;
+  uint nsteps = argc > 4 ? strtoul(argv[4], 0, 10) : 20;
+  uint nsweeps = argc > 5 ? strtoul(argv[5], 0, 10) : 30;
+
+  SuperBlock* truth = new SuperBlock(springFactory("exponential"), nodes);
+  truth->setParams(vector<double>(1, true_scale));
+  CachedHessian cache(truth);
+
+  // The cached Hessian should match the one an ENM builds
+  HessianBuilder anm(truth);
+  anm.build();
+  DoubleMatrix H = cache.hessian(truth);
+  double maxdiff = 0.0, maxval = 0.0;
+  for (ulong i=0; i<H.size(); ++i) {
+    maxdiff = max(maxdiff, fabs(H[i] - anm.hessian()[i]));
+    maxval = max(maxval, fabs(H[i]));
+  }
+  if (maxdiff > 1e-10 * maxval)
+    fail("cached Hessian differs from the ENM's");
+
+  // The first solve goes straight to LAPACK
+  LowModeSolver first(nmodes + 6);
+  first.solve(H);
+  compareModes("first solve", first, H);
+
+  checkRefinement(truth, cache, nsteps);
+
+  // Use the true network's modes as the "PCA"
+  DoubleMatrix pca_s(nmodes, 1), pca_U(H.rows(), nmodes);
+  for (uint i=0; i<nmodes; ++i) {
+    pca_s[i] = 1.0 / sqrt(first.eigenvalues()[i+6]);
+    for (uint r=0; r<H.rows(); ++r)
+      pca_U(r, i) = first.eigenvectors()(r, i+6);
+  }
+  checkFit(nodes, cache, pca_s, pca_U, nthreads, nsweeps);
+
+  if (failures) {
+    cerr << failures << " check(s) failed\n";
+    exit(-2);
+  }
+  cout << "All ENM fit checks passed\n";
+}
@@ -0,0 +1,487 @@
+/*
+  This file is part of LOOS.
+
+  LOOS (Lightweight Object-Oriented Structure library)
+  Copyright (c) 2010 Tod D. Romo
+  Department of Biochemistry and Biophysics
+  School of Medicine & Dentistry, University of Rochester
+
+  This package (LOOS) is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation under version 3 of the License.
+
+  This package is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+
+#include "enm-fit.hpp"
+
+#include <map>
+
+using namespace std;
+using namespace loos;
+
+
+namespace ENM {
+
+  namespace {
+
+    // Columns [c0, c1) of A
+    DoubleMatrix columns(const DoubleMatrix& A, const uint c0, const uint c1) {
+      DoubleMatrix B(A.rows(), c1 - c0);
+      copy(A.get() + static_cast<ulong>(c0) * A.rows(), A.get() + static_cast<ulong>(c1) * A.rows(), B.get());
+      return(B);
+    }
+
+    // [A B]
+    DoubleMatrix concatColumns(const DoubleMatrix& A, const DoubleMatrix& B) {
+      DoubleMatrix C(A.rows(), A.cols() + B.cols());
+      copy(A.get(), A.get() + A.size(), C.get());
+      copy(B.get(), B.get() + B.size(), C.get() + A.size());
+      return(C);
+    }
+
+
+    // Eigenvalues (ascending) of the symmetric matrix A, which is
+    // overwritten with the eigenvectors
+    vector<double> symmetricEigen(DoubleMatrix& A) {
+      f77int n = A.rows();
+      char jobz = 'V';
+      char uplo = 'L';
+      f77int lda = n;
+      f77int lwork = -1;
+      f77int info;
+      vector<double> W(n);
+      double wq;
+
+      dsyev_(&jobz, &uplo, &n, A.get(), &lda, &W[0], &wq, &lwork, &info);
+      if (info != 0)
+        throw(NumericalError("dsyev failed to give an estimate of space required", info));
+
+      lwork = static_cast<f77int>(wq);
+      vector<double> work(lwork);
+      dsyev_(&jobz, &uplo, &n, A.get(), &lda, &W[0], &work[0], &lwork, &info);
+      if (info != 0)
+        throw(NumericalError("dsyev reported an error", info));
+
+      return(W);
+    }
+
+
+    // S -= X (X' S), where X has orthonormal columns
+    void projectOut(DoubleMatrix& S, const DoubleMatrix& X) {
+      DoubleMatrix C = Math::MMMultiply(X, S, true, false);
+      DoubleMatrix XC = Math::MMMultiply(X, C);
+      for (ulong i=0; i<S.size(); ++i)
+        S[i] -= XC[i];
+    }
+
+
+    // Orthonormal basis for the columns of S, from the eigenvectors
+    // of S'S (dropping directions that are numerically dependent).
+    // Done twice, since one pass loses accuracy when S is poorly
+    // conditioned.
+    DoubleMatrix orthonormalize(DoubleMatrix S) {
+      for (uint pass=0; pass<2 && S.cols() > 0; ++pass) {
+        uint m = S.rows();
+        for (uint j=0; j<S.cols(); ++j) {
+          double* s = S.get() + static_cast<ulong>(j) * m;
+          double l = 0.0;
+          for (uint i=0; i<m; ++i)
+            l += s[i] * s[i];
+          l = sqrt(l);
+          if (l > 0.0)
+            for (uint i=0; i<m; ++i)
+              s[i] /= l;
+        }
+
+        DoubleMatrix G = Math::MMMultiply(S, S, true, false);
+        vector<double> g = symmetricEigen(G);
+
+        vector<uint> keep;
+        for (uint j=0; j<g.size(); ++j)
+          if (g[j] > 1e-10 * g.back())
+            keep.push_back(j);
+
+        DoubleMatrix V(G.rows(), keep.size());
+        for (uint j=0; j<keep.size(); ++j) {
+          double k = 1.0 / sqrt(g[keep[j]]);
+          for (uint i=0; i<G.rows(); ++i)
+            V(i, j) = G(i, keep[j]) * k;
+        }
+        S = Math::MMMultiply(S, V);
+      }
+
+      return(S);
+    }
+
+  }
+
+
+
+  // --------------------------------------------------------------------------------
+
+
+  CachedHessian::CachedHessian(SuperBlock* blocker) : nnodes_(blocker->size()) {
+    const AtomicGroup& nodes = blocker->nodeList();
+    map<SpringFunction*, uint> group_of;
+
+    for (uint i=1; i<nnodes_; ++i) {
+      GCoord v = nodes[i]->coords();
+      for (uint j=0; j<i; ++j) {
+        SpringFunction* spring = blocker->springFunction(j, i);
+        map<SpringFunction*, uint>::iterator gi = group_of.find(spring);
+        if (gi == group_of.end()) {
+          gi = group_of.insert(pair<SpringFunction*, uint>(spring, groups_.size())).first;
+          groups_.push_back(PairGroup());
+        }
+
+        PairGroup& grp = groups_[gi->second];
+        GCoord d = v - nodes[j]->coords();
+        grp.js.push_back(j);
+        grp.is.push_back(i);
+        grp.r2.push_back(d.length2());
+        grp.dd.push_back(d[0] * d[0]);
+        grp.dd.push_back(d[0] * d[1]);
+        grp.dd.push_back(d[0] * d[2]);
+        grp.dd.push_back(d[1] * d[1]);
+        grp.dd.push_back(d[1] * d[2]);
+        grp.dd.push_back(d[2] * d[2]);
+      }
+    }
+  }
+
+
+  DoubleMatrix CachedHessian::hessian(SuperBlock* blocker) const {
+    if (blocker->size() != nnodes_)
+      throw(std::logic_error("SuperBlock does not match the CachedHessian"));
+
+    DoubleMatrix H(3*nnodes_, 3*nnodes_);
+    vector<double> k;
+
+    for (vector<PairGroup>::const_iterator g = groups_.begin(); g != groups_.end(); ++g) {
+      uint m = g->js.size();
+      SpringFunction* spring = blocker->springFunction(g->js[0], g->is[0]);
+      k.resize(m);
+      bool batched = spring->constants(&(g->r2[0]), &k[0], m);
+
+      for (uint p=0; p<m; ++p) {
+        double b[9];
+        if (batched) {
+          if (k[p] == 0.0)
+            continue;
+          const double* e = &(g->dd[6*p]);
+          b[0] = e[0] * k[p];
+          b[1] = b[3] = e[1] * k[p];
+          b[2] = b[6] = e[2] * k[p];
+          b[4] = e[3] * k[p];
+          b[5] = b[7] = e[4] * k[p];
+          b[8] = e[5] * k[p];
+        } else {
+          DoubleMatrix B = blocker->block(g->js[p], g->is[p]);
+          copy(B.get(), B.get() + 9, b);
+        }
+
+        // Off-diagonal superblocks, plus their contribution to the
+        // diagonal ones (as in ElasticNetworkModel::buildHessian())
+        uint i = g->is[p], j = g->js[p];
+        for (uint x=0; x<3; ++x)
+          for (uint y=0; y<3; ++y) {
+            H(i*3 + y, j*3 + x) = -b[x*3 + y];
+            H(j*3 + x, i*3 + y) = -b[y*3 + x];
+            H(i*3 + y, i*3 + x) += b[x*3 + y];
+            H(j*3 + y, j*3 + x) += b[x*3 + y];
+          }
+      }
+    }
+
+    return(H);
+  }
+
+
+
+  // --------------------------------------------------------------------------------
+
+
+  LowModeSolver::LowModeSolver(const uint nmodes)
+    : nmodes_(nmodes), nguard_(8), maxiter_(0), iterations_(0), skip_(0), backoff_(0), tol_(1e-5)
+  {
+    if (nmodes == 0)
+      throw(std::logic_error("LowModeSolver needs at least one mode"));
+  }
+
+
+  void LowModeSolver::solve(const DoubleMatrix& H) {
+    if (H.rows() != H.cols())
+      throw(std::logic_error("LowModeSolver needs a square matrix"));
+    if (H.rows() < nmodes_)
+      throw(std::logic_error("LowModeSolver asked for more modes than the matrix has"));
+
+    // After a failed refinement, go straight to LAPACK for a while
+    // (longer after each consecutive failure), so a network whose
+    // modes are slow to refine costs little more than always using
+    // LAPACK
+    bool refined = false;
+    if (block_.rows() == H.rows()) {
+      if (skip_ > 0)
+        --skip_;
+      else if (refine(H))
+        refined = true;
+      else {
+        backoff_ = backoff_ ? min(2 * backoff_, 16u) : 1;
+        skip_ = backoff_;
+      }
+    }
+
+    if (refined)
+      backoff_ = 0;
+    else
+      direct(H);
+
+    eigenvals_ = DoubleMatrix(nmodes_, 1);
+    for (uint i=0; i<nmodes_; ++i)
+      eigenvals_[i] = blockvals_[i];
+    eigenvecs_ = columns(block_, 0, nmodes_);
+  }
+
+
+  void LowModeSolver::direct(const DoubleMatrix& H) {
+    DoubleMatrix A = H.copy();
+
+    char jobz = 'V';
+    char range = 'I';
+    char uplo = 'L';
+    f77int n = A.rows();
+    f77int lda = n;
+    double vl = 0.0;
+    double vu = 0.0;
+    f77int il = 1;
+    f77int iu = min(nmodes_ + nguard_, A.rows());
+
+    char dpar = 'S';
+    double abstol = 2.0 * dlamch_(&dpar);
+
+    f77int m;
+    vector<double> W(n);
+    DoubleMatrix Z(n, iu);
+    f77int ldz = n;
+    vector<f77int> isuppz(2 * iu);
+
+    f77int lwork = -1;
+    f77int liwork = -1;
+    f77int info;
+    double wq;
+    f77int iwq;
+
+    dsyevr_(&jobz, &range, &uplo, &n, A.get(), &lda, &vl, &vu, &il, &iu, &abstol, &m, &W[0], Z.get(), &ldz, &isuppz[0], &wq, &lwork, &iwq, &liwork, &info);
+    if (info != 0)
+      throw(NumericalError("dsyevr failed to give an estimate of space required", info));
+
+    lwork = static_cast<f77int>(wq);
+    liwork = iwq;
+    vector<double> work(lwork);
+    vector<f77int> iwork(liwork);
+
+    dsyevr_(&jobz, &range, &uplo, &n, A.get(), &lda, &vl, &vu, &il, &iu, &abstol, &m, &W[0], Z.get(), &ldz, &isuppz[0], &work[0], &lwork, &iwork[0], &liwork, &info);
+    if (info != 0)
+      throw(NumericalError("dsyevr reported an error", info));
+    if (m != iu)
+      throw(NumericalError("dsyevr did not find all of the requested eigenpairs"));
+
+    block_ = Z;
+    blockvals_.assign(W.begin(), W.begin() + iu);
+    iterations_ = 0;
+    factor_.reset();
+  }
+
+
+  // Cholesky factorization of H + sigma I, with sigma a small fraction
+  // of the largest eigenvalue in the block (so the preconditioner is
+  // close to H^-1 at the low end of the spectrum while staying
+  // positive definite despite the rigid-body modes).  Leaves factor_
+  // empty if H can't be factored.
+
+  bool LowModeSolver::factor(const DoubleMatrix& H) {
+    f77int n = H.rows();
+
+    double mean_diag = 0.0;
+    for (f77int i=0; i<n; ++i)
+      mean_diag += H(i, i);
+    mean_diag /= n;
+    if (!(mean_diag > 0.0)) {
+      factor_.reset();
+      return(false);
+    }
+
+    double sigma = max(0.01 * blockvals_.back(), 1e-8 * mean_diag);
+    factor_ = H.copy();
+    for (f77int i=0; i<n; ++i)
+      factor_(i, i) += sigma;
+
+    char uplo = 'L';
+    f77int lda = n;
+    f77int info;
+    dpotrf_(&uplo, &n, factor_.get(), &lda, &info);
+    if (info != 0) {
+      factor_.reset();
+      return(false);
+    }
+
+    return(true);
+  }
+
+
+  // Block LOBPCG, starting from the previous eigenvectors and
+  // preconditioned with the cached factorization from factor().  The
+  // factorization is only redone when convergence slows down (or after
+  // a LAPACK solve), since the matrices being solved usually differ by
+  // a small change in the spring constants.  Returns false if it fails
+  // to converge.
+
+  bool LowModeSolver::refine(const DoubleMatrix& H) {
+    f77int n = H.rows();
+    uint k = block_.cols();
+
+    if (factor_.rows() != H.rows() && !factor(H))
+      return(false);
+
+    // Unless told otherwise, allow about as many iterations as would
+    // cost the same as a LAPACK solve (roughly 4n^3/3 flops for LAPACK
+    // versus 6kn^2 for each iteration, though LAPACK gets less out of
+    // each flop)
+    uint maxiter = maxiter_ ? maxiter_ : max(4u, static_cast<uint>(n) / (4 * k));
+
+    double mean_diag = 0.0;
+    for (f77int i=0; i<n; ++i)
+      mean_diag += H(i, i);
+    mean_diag /= n;
+
+    char uplo = 'L';
+    f77int lda = n;
+    f77int info;
+
+    // Start with the Rayleigh-Ritz vectors of the previous block
+    DoubleMatrix X = block_.copy();
+    DoubleMatrix AX = Math::MMMultiply(H, X);
+    DoubleMatrix T = Math::MMMultiply(X, AX, true, false);
+    vector<double> theta = symmetricEigen(T);
+    X = Math::MMMultiply(X, T);
+    AX = Math::MMMultiply(AX, T);
+
+    DoubleMatrix P;
+    for (uint iter=1; iter <= maxiter; ++iter) {
+
+      DoubleMatrix R = AX.copy();
+      for (uint j=0; j<k; ++j)
+        for (f77int i=0; i<n; ++i)
+          R(i, j) -= theta[j] * X(i, j);
+
+      double limit = tol_ * max(fabs(theta[nmodes_ - 1]), 1e-8 * mean_diag);
+      bool converged = true;
+      for (uint j=0; j<nmodes_ && converged; ++j) {
+        double r = 0.0;
+        for (f77int i=0; i<n; ++i)
+          r += R(i, j) * R(i, j);
+        converged = sqrt(r) <= limit;
+      }
+
+      if (converged) {
+        block_ = X;
+        blockvals_.assign(theta.begin(), theta.begin() + k);
+        iterations_ = iter;
+        if (iter > maxiter / 2)
+          factor_.reset();
+        return(true);
+      }
+
+      // Preconditioned residuals
+      f77int nrhs = k;
+      f77int ldb = n;
+      dpotrs_(&uplo, &n, &nrhs, factor_.get(), &lda, R.get(), &ldb, &info);
+      if (info != 0)
+        return(false);
+
+      // New search directions, orthogonal to X
+      DoubleMatrix S = (P.cols() > 0) ? concatColumns(R, P) : R;
+      projectOut(S, X);
+      projectOut(S, X);
+      S = orthonormalize(S);
+      if (S.cols() == 0)
+        return(false);
+      DoubleMatrix AS = Math::MMMultiply(H, S);
+
+      // Rayleigh-Ritz over [X S]
+      DoubleMatrix Q = concatColumns(X, S);
+      DoubleMatrix AQ = concatColumns(AX, AS);
+      T = Math::MMMultiply(Q, AQ, true, false);
+      for (uint j=0; j<T.cols(); ++j)
+        for (uint i=0; i<j; ++i)
+          T(i, j) = T(j, i) = 0.5 * (T(i, j) + T(j, i));
+      vector<double> vals = symmetricEigen(T);
+
+      DoubleMatrix Y = columns(T, 0, k);
+      X = Math::MMMultiply(Q, Y);
+      AX = Math::MMMultiply(AQ, Y);
+      theta.assign(vals.begin(), vals.begin() + k);
+
+      // Next P is the part of the new X that came from S
+      DoubleMatrix Ys(S.cols(), k);
+      for (uint j=0; j<k; ++j)
+        for (uint i=0; i<S.cols(); ++i)
+          Ys(i, j) = Y(k + i, j);
+      P = Math::MMMultiply(S, Ys);
+    }
+
+    return(false);
+  }
+
+
+
+  // --------------------------------------------------------------------------------
+
+
+  ENMFitness::ENMFitness(SuperBlock* blocker, const CachedHessian& cache,
+                         const DoubleMatrix& pca_s, const DoubleMatrix& pca_U, const uint nmodes)
+    : blocker_(blocker), cache_(cache), nmodes_(nmodes), solver_(nmodes + 6)
+  {
+    if (pca_s.rows() < nmodes || pca_U.cols() < nmodes)
+      throw(std::logic_error("Not enough PCA modes for ENMFitness"));
+    if (pca_U.rows() != 3 * cache.size())
+      throw(std::logic_error("PCA and ENM have different numbers of nodes"));
+
+    pca_lam_ = DoubleMatrix(nmodes, 1);
+    for (uint i=0; i<nmodes; ++i)
+      pca_lam_[i] = pca_s[i] * pca_s[i];
+    pca_U_ = columns(pca_U, 0, nmodes);
+  }
+
+
+  double ENMFitness::operator()(const vector<double>& params) {
+    blocker_->setParams(params);
+    if (!blocker_->validParams())
+      return(invalidValue());
+
+    solver_.solve(cache_.hessian(blocker_));
+
+    const DoubleMatrix& vals = solver_.eigenvalues();
+    DoubleMatrix lam(nmodes_, 1);
+    for (uint i=0; i<nmodes_; ++i) {
+      double e = vals[i + 6];
+      if (e <= 0.0)
+        return(invalidValue());
+      lam[i] = 1.0 / e;
+    }
+    DoubleMatrix U = columns(solver_.eigenvectors(), 6, nmodes_ + 6);
+
+    return(1.0 - Math::covarianceOverlap(pca_lam_, pca_U_, lam, U));
+  }
+
+
+};
@@ -0,0 +1,213 @@
+/*
+  This file is part of LOOS.
+
+  LOOS (Lightweight Object-Oriented Structure library)
+  Copyright (c) 2010 Tod D. Romo
+  Department of Biochemistry and Biophysics
+  School of Medicine & Dentistry, University of Rochester
+
+  This package (LOOS) is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation under version 3 of the License.
+
+  This package is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+
+/** \addtogroup ENM
+ *@{
+ */
+
+
+#if !defined(LOOS_ENM_FIT_HPP)
+#define LOOS_ENM_FIT_HPP
+
+#include <loos.hpp>
+#include "hessian.hpp"
+
+#if defined(__linux__) || defined(__CYGWIN__) || defined(__FreeBSD__)
+extern "C" {
+  void dsyevr_(char*, char*, char*, int*, double*, int*, double*, double*, int*, int*, double*, int*, double*, double*, int*, int*, double*, int*, int*, int*, int*);
+  void dpotrf_(char*, int*, double*, int*, int*);
+  void dpotrs_(char*, int*, int*, double*, int*, double*, int*, int*);
+}
+#endif
+
+
+namespace ENM {
+
+
+  //! Node pairs of a network, cached so the Hessian can be rebuilt for new spring parameters
+  /**
+   * When fitting spring parameters, the nodes never move, so the
+   * distance between each pair of nodes, the outer product of their
+   * difference vector, and which spring function applies to them are
+   * all fixed.  CachedHessian works these out once from a SuperBlock,
+   * grouping the pairs by spring function, so building a Hessian only
+   * needs the spring constants (one SpringFunction::constants() call
+   * per group).  Spring functions that cannot do this fall back to
+   * SuperBlock::block() for each of their pairs.
+   *
+   * The cache only depends on the nodes and on which spring function
+   * applies to each pair, so it can be shared by any SuperBlocks with
+   * the same structure, e.g. copies of a network (each with its own
+   * spring functions) being fit in separate threads.  hessian() may be
+   * called from several threads at once, as long as each passes its
+   * own SuperBlock.
+   */
+  class CachedHessian {
+  public:
+    explicit CachedHessian(SuperBlock* blocker);
+
+    //! Number of nodes
+    uint size() const { return(nnodes_); }
+
+    //! Builds the Hessian with the spring functions (and their current parameters) of \a blocker
+    loos::DoubleMatrix hessian(SuperBlock* blocker) const;
+
+  private:
+    struct PairGroup {
+      std::vector<uint> js, is;
+      std::vector<double> r2;
+      std::vector<double> dd;      // xx, xy, xz, yy, yz, zz for each pair
+    };
+
+    uint nnodes_;
+    std::vector<PairGroup> groups_;
+  };
+
+
+
+  //! Lowest eigenpairs of a series of similar Hessians
+  /**
+   * Finds the \a nmodes lowest eigenpairs of a symmetric matrix
+   * (for an ENM Hessian, this includes the six rigid-body modes).
+   * The first call uses LAPACK (dsyevr) to find only the requested
+   * eigenpairs.  Later calls assume the matrix has changed only a
+   * little (e.g. new spring constants for the same network) and
+   * refine the previous eigenvectors with a block eigensolver
+   * (LOBPCG), preconditioned by a Cholesky factorization of a
+   * shifted matrix.  The factorization is kept between calls and
+   * only redone when the refinement slows down.  Each iteration costs
+   * O(n^2) against O(n^3) for LAPACK, so the savings grow with the
+   * size of the network.  If the refinement does not converge,
+   * LAPACK is used instead, so the eigenpairs always meet the
+   * tolerance, and the refinement is skipped for the next few calls
+   * (more after each consecutive failure).  For small networks with
+   * crowded low modes, this ends up close to always using LAPACK.
+   *
+   * A few extra (guard) vectors beyond \a nmodes are carried along,
+   * which speeds convergence when the highest requested modes are
+   * close to the next ones.
+   */
+  class LowModeSolver {
+  public:
+    explicit LowModeSolver(const uint nmodes);
+
+    //! Find the lowest eigenpairs of \a H
+    void solve(const loos::DoubleMatrix& H);
+
+    //! Eigenvalues (as an nmodes x 1 matrix), in ascending order
+    const loos::DoubleMatrix& eigenvalues() const { return(eigenvals_); }
+
+    //! Corresponding eigenvectors (in columns)
+    const loos::DoubleMatrix& eigenvectors() const { return(eigenvecs_); }
+
+    //! Residual norm allowed for each mode, relative to the largest requested eigenvalue
+    void tolerance(const double d) { tol_ = d; }
+    double tolerance() const { return(tol_); }
+
+    //! Refinement iterations allowed before falling back to LAPACK
+    /**
+     * The default (0) allows about as many as would cost the same as
+     * a LAPACK solve, which depends on the matrix size.
+     */
+    void maximumIterations(const uint n) { maxiter_ = n; }
+    uint maximumIterations() const { return(maxiter_); }
+
+    //! Number of extra vectors to carry along
+    void guardVectors(const uint n) { nguard_ = n; reset(); }
+    uint guardVectors() const { return(nguard_); }
+
+    //! Refinement iterations used by the last solve() (0 if LAPACK was used)
+    uint iterations() const { return(iterations_); }
+
+    //! Forget the previous eigenvectors, so the next solve() uses LAPACK
+    void reset() { block_.reset(); factor_.reset(); skip_ = backoff_ = 0; }
+
+  private:
+    void direct(const loos::DoubleMatrix& H);
+    bool refine(const loos::DoubleMatrix& H);
+    bool factor(const loos::DoubleMatrix& H);
+
+    uint nmodes_, nguard_, maxiter_, iterations_;
+    uint skip_, backoff_;              // Calls to skip refinement for, after failures
+    double tol_;
+
+    loos::DoubleMatrix block_;         // Previous eigenvectors, including guards
+    std::vector<double> blockvals_;
+    loos::DoubleMatrix factor_;        // Cholesky factor of a recent H + sigma I
+
+    loos::DoubleMatrix eigenvals_;
+    loos::DoubleMatrix eigenvecs_;
+  };
+
+
+
+  //! How badly an ENM reproduces a PCA, as a function of the spring parameters
+  /**
+   * This is the function to minimize when fitting spring parameters
+   * to a simulation.  Given a set of parameters, it sets them in the
+   * SuperBlock (see SuperBlock::setParams()), builds the Hessian
+   * from \a cache, finds the lowest modes, and returns one minus the
+   * covariance overlap between the first \a nmodes non-rigid ENM
+   * modes and the first \a nmodes PCA modes, so 0 is a perfect fit.
+   * The PCA is given as the singular values and left singular
+   * vectors from svd (the singular values are squared, and the ENM
+   * eigenvalues inverted, before comparing).  The covariance overlap
+   * depends on the overall scale, so the singular values should be
+   * scaled so their squares are variances (i.e. divided by the
+   * square root of the number of frames), and the fit then also
+   * determines the overall spring strength.
+   *
+   * Invalid parameters (or ones that give a non-positive eigenvalue
+   * past the six rigid-body modes) return invalidValue().  Each
+   * instance keeps the previous modes to warm-start the next solve,
+   * and modifies its SuperBlock, so use one instance (with its own
+   * SuperBlock and spring functions) per thread.
+   */
+  class ENMFitness {
+  public:
+    ENMFitness(SuperBlock* blocker, const CachedHessian& cache,
+               const loos::DoubleMatrix& pca_s, const loos::DoubleMatrix& pca_U, const uint nmodes);
+
+    double operator()(const std::vector<double>& params);
+
+    //! Value returned for unusable parameters
+    static double invalidValue() { return(1e10); }
+
+    LowModeSolver& solver() { return(solver_); }
+
+  private:
+    SuperBlock* blocker_;
+    const CachedHessian& cache_;
+    uint nmodes_;
+    loos::DoubleMatrix pca_lam_, pca_U_;
+    LowModeSolver solver_;
+  };
+
+
+};
+
+
+#endif
+
+
+/** @} */
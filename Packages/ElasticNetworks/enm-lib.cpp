@@ -22,6 +22,9 @@
 
 
 #include "enm-lib.hpp"
+#include "workers.hpp"
+
+#include <boost/thread/thread.hpp>
 
 
 using namespace std;
@@ -81,38 +84,100 @@ namespace ENM {
 
 
 
-  void ElasticNetworkModel::buildHessian() {
-    uint n = blocker_->size();
-    loos::DoubleMatrix H(3*n,3*n);
+  namespace {
+
+    // Node pairs are evaluated in tiles of tile_size x tile_size nodes
+    const uint tile_size = 64;
+
+
+    // Off-diagonal superblocks for every nworkers'th tile, starting
+    // with tile worker.  Each pair of nodes only touches its own two
+    // superblocks, so threads never write to the same part of H.
+    void offDiagonalTiles(SuperBlock* blocker, DoubleMatrix& H, const vector< pair<uint, uint> >& tiles,
+                          const uint worker, const uint nworkers) {
+      uint n = blocker->size();
+      vector<uint> js, is;
+      vector<double> B;
+
+      for (uint t=worker; t<tiles.size(); t += nworkers) {
+        uint i0 = tiles[t].first * tile_size;
+        uint j0 = tiles[t].second * tile_size;
+        uint i1 = min(i0 + tile_size, n);
 
-    for (uint i=1; i<n; ++i) {
-      for (uint j=0; j<i; ++j) {
-        loos::DoubleMatrix B = blocker_->block(j, i);
-        for (uint x = 0; x<3; ++x)
-          for (uint y = 0; y<3; ++y) {
-            H(i*3 + y, j*3 + x) = -B(y, x);
-            H(j*3 + x, i*3 + y) = -B(x ,y);
+        js.clear();
+        is.clear();
+        for (uint i=max(i0, 1u); i<i1; ++i)
+          for (uint j=j0; j<min(j0 + tile_size, i); ++j) {
+            js.push_back(j);
+            is.push_back(i);
           }
+        if (js.empty())
+          continue;
+
+        B.resize(9 * js.size());
+        blocker->blocks(&js[0], &is[0], &B[0], js.size());
+
+        for (uint p=0; p<js.size(); ++p) {
+          uint i = is[p], j = js[p];
+          const double* b = &B[9*p];
+          for (uint x = 0; x<3; ++x)
+            for (uint y = 0; y<3; ++y) {
+              H(i*3 + y, j*3 + x) = -b[x*3 + y];
+              H(j*3 + x, i*3 + y) = -b[y*3 + x];
+            }
+        }
       }
     }
 
-    // Now handle the diagonal...
-    for (uint i=0; i<n; ++i) {
-      loos::DoubleMatrix B(3,3);
-      for (uint j=0; j<n; ++j) {
-        if (j == i)
-          continue;
-      
+
+    // Diagonal superblocks for every nworkers'th node
+    void diagonalBlocks(DoubleMatrix& H, const uint n, const uint worker, const uint nworkers) {
+      for (uint i=worker; i<n; i += nworkers) {
+        double B[9] = { 0.0 };
+        for (uint j=0; j<n; ++j) {
+          if (j == i)
+            continue;
+
+          for (uint x=0; x<3; ++x)
+            for (uint y=0; y<3; ++y)
+              B[x*3 + y] += H(j*3 + y, i*3 + x);
+        }
+
         for (uint x=0; x<3; ++x)
           for (uint y=0; y<3; ++y)
-            B(y,x) += H(j*3 + y, i*3 + x);
+            H(i*3 + y, i*3 + x) = -B[x*3 + y];
       }
-
-      for (uint x=0; x<3; ++x)
-        for (uint y=0; y<3; ++y)
-          H(i*3 + y, i*3 + x) = -B(y,x);
     }
 
+  }
+
+
+
+  void ElasticNetworkModel::threads(const uint n) {
+    nthreads_ = n ? n : boost::thread::hardware_concurrency();
+    if (nthreads_ == 0)
+      nthreads_ = 1;
+  }
+
+
+  void ElasticNetworkModel::buildHessian() {
+    uint n = blocker_->size();
+    loos::DoubleMatrix H(3*n,3*n);
+
+    // Tiles covering the lower triangle (i > j)
+    uint ntiles = (n + tile_size - 1) / tile_size;
+    vector< pair<uint, uint> > tiles;
+    for (uint ti=0; ti<ntiles; ++ti)
+      for (uint tj=0; tj<=ti; ++tj)
+        tiles.push_back(pair<uint, uint>(ti, tj));
+
+    uint nthreads = max(1u, min(nthreads_, static_cast<uint>(tiles.size())));
+
+    runWorkers(nthreads, [&](const uint t) { offDiagonalTiles(blocker_, H, tiles, t, nthreads); });
+
+    // Now handle the diagonal...
+    runWorkers(nthreads, [&](const uint t) { diagonalBlocks(H, n, t, nthreads); });
+
     hessian_ = H;
   }
 
@@ -72,7 +72,7 @@ namespace ENM {
      constructed, i.e. what nodes are used and how the spring function
      between them is calculated.
     */
-    ElasticNetworkModel(SuperBlock* blocker) : blocker_(blocker), name_("ENM"), prefix_(""), meta_(""), debugging_(false), verbosity_(0) { }
+    ElasticNetworkModel(SuperBlock* blocker) : blocker_(blocker), name_("ENM"), prefix_(""), meta_(""), debugging_(false), verbosity_(0), nthreads_(1) { }
     virtual ~ElasticNetworkModel() { }
 
     // Should we allow this?
@@ -97,6 +97,10 @@ namespace ENM {
     void verbosity(const int i) { verbosity_ = i; }
     int verbosity() const { return(verbosity_); }
 
+    //! Number of threads to use when building the hessian (0 means all available)
+    void threads(const uint n);
+    uint threads() const { return(nthreads_); }
+
     // -----------------------------------------------------
     //! Forwards to contained superblock
     SpringFunction::Params setParams(const SpringFunction::Params& v) {
@@ -128,7 +132,9 @@ namespace ENM {
     //! Construct the hessian using the contained SuperBlock
     /**
      * It is not expected that subclasses will want to override this...
-     * Uses the contained SuperBlock to build a hessian
+     * Uses the contained SuperBlock to build a hessian.  The node pairs
+     * are passed to SuperBlock::blocks() a tile at a time, with tiles
+     * dealt out to threads (see threads()).
      */
     void buildHessian();
   
@@ -143,6 +149,7 @@ namespace ENM {
     std::string meta_;
     bool debugging_;
     int verbosity_;
+    uint nthreads_;
 
     loos::DoubleMatrix eigenvecs_;
     loos::DoubleMatrix eigenvals_;
@@ -528,38 +528,63 @@ int main(int argc, char *argv[]) {
   double delta = (doublesided ? 2.0 : 1.0)*PI/nsteps;
   double phase = negative ? PI : 0.0;
 
-  // Loop over requested number of frames...
-  for (int frameno=0; frameno<nsteps; frameno++) {
-    double k = sin(delta * frameno + phase);
-
-    // Have to make a copy of the atoms since we're computing a
-    // displacement from the model structure...
-    AtomicGroup frame = superset.copy();
-    AtomicGroup frame_subset = selectAtoms(frame, sopts->selection);
-
-    // Loop over all requested modes...
-    for (uint j = 0; j<cols.size(); ++j) {
-      // Loop over all atoms...
-      for (uint i=0; i<frame_subset.size(); i++) {
-	GCoord c = frame_subset[i]->coords();
-
-	// This gets the displacement vector for the ith atom of the
-	// ci'th mode...
-        GCoord d( U(i*3, cols[j]), U(i*3+1, cols[j]), U(i*3+2, cols[j]) );
-	if (uniform)
-	  d /= d.length();
-	
-	c += k * scalings[j] * d;
-
-	// Stuff those coords back into the Atom object...
-	frame_subset[i]->coords(c);
-        if (tag)
-          frame_subset[i]->chainId("E");
-      }
+  // Have to make a copy of the atoms since we're computing a
+  // displacement from the model structure...
+  AtomicGroup frame = superset.copy();
+  AtomicGroup frame_subset = selectAtoms(frame, sopts->selection);
+  if (frame_subset.size() * 3 > m) {
+    cerr << boost::format("Error - The selection has %d atoms in the superset, but the vectors only have %d.\n") %
+      frame_subset.size() % (m / 3);
+    exit(-1);
+  }
+  if (tag)
+    for (uint i=0; i<frame_subset.size(); ++i)
+      frame_subset[i]->chainId("E");
+
+  // Expand the requested modes out to the superset (atoms outside
+  // the selection stay put) so each block of frames is one multiply
+  uint ns = frame.size();
+  vector<int> subset_index(frame_subset.size());
+  for (uint i=0, j=0; i<frame_subset.size(); ++i) {
+    while (j < ns && frame[j] != frame_subset[i])
+      ++j;
+    subset_index[i] = j;
+  }
+
+  Matrix D = scaledModes(U, cols, vector<double>(cols.size(), 1.0), uniform);
+  Matrix Dsuper(3*ns, cols.size());
+  for (uint j=0; j<cols.size(); ++j)
+    for (uint i=0; i<subset_index.size(); ++i)
+      for (uint k=0; k<3; ++k)
+        Dsuper(3*subset_index[i]+k, j) = D(3*i+k, j);
+
+  vector<double> x0(3*ns);
+  for (uint i=0; i<ns; ++i) {
+    GCoord c = frame[i]->coords();
+    for (uint k=0; k<3; ++k)
+      x0[3*i+k] = c[k];
+  }
+
+  // Frames are built and written a block at a time
+  const uint frames_per_block = 32;
+  for (int frameno=0; frameno<nsteps; frameno += frames_per_block) {
+    uint nf = min(static_cast<int>(frames_per_block), nsteps - frameno);
+
+    // Displacement along each mode in each frame
+    Matrix A(nf, cols.size());
+    for (uint f=0; f<nf; ++f) {
+      double k = sin(delta * (frameno + f) + phase);
+      for (uint j=0; j<cols.size(); ++j)
+        A(f, j) = k * scalings[j];
     }
 
+    Matrix X = modeFrames(x0, Dsuper, A);
+
     if (frameno == 0) {
       // Write out the selection, converting it to a PDB
+      for (uint i=0; i<ns; ++i)
+        frame[i]->coords(GCoord(X(3*i, 0), X(3*i+1, 0), X(3*i+2, 0)));
+
       string outpdb(popts->prefix + ".pdb");
       ofstream ofs(outpdb.c_str());
       PDB pdb;
@@ -570,8 +595,8 @@ int main(int argc, char *argv[]) {
       ofs << pdb;
     }
 
-
-    // Now that we've displaced the frame, add it to the growing trajectory...
-    traj->writeFrame(frame);
+    // Now add the displaced frames to the growing trajectory...
+    traj->writeFrames(frame, X.get(), nf);
   }
+  traj->flush();
 }
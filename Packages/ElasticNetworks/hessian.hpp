@@ -37,6 +37,8 @@
 #define LOOS_HESSIAN_HPP
 
 
+#include <typeinfo>
+
 #include <loos.hpp>
 
 #include "spring_functions.hpp"
@@ -71,6 +73,9 @@ namespace ENM {
 
     uint size() const { return(static_cast<uint>(nodes.size())); }
 
+    //! The nodes the Hessian is built from
+    const loos::AtomicGroup& nodeList() const { return(nodes); }
+
     // ------------------------------------------------------
     //! Forwards to the contained SpringFunction...
     virtual SpringFunction::Params setParams(const SpringFunction::Params& v) {
@@ -89,6 +94,34 @@ namespace ENM {
       return(blockImpl(j, i, springs));
     }
 
+    //! Computes the superblocks for a batch of node pairs
+    /**
+     * Superblock \a p is the same as block(js[p], is[p]) and is written
+     * (column-major) to B[9p] through B[9p+8].  The whole batch goes
+     * to the spring function in one call, so this is what
+     * ElasticNetworkModel::buildHessian() uses.  For derived classes,
+     * the default calls block() for each pair, so overriding block()
+     * alone is still correct; override this as well to batch the
+     * pairs.  It may be called from several threads at once (with
+     * different pairs).
+     */
+    virtual void blocks(const uint* js, const uint* is, double* B, const uint n) {
+      if (typeid(*this) == typeid(SuperBlock)) {
+        blocksImpl(js, is, B, n, springs);
+        return;
+      }
+
+      for (uint p=0; p<n; ++p) {
+        loos::DoubleMatrix b = block(js[p], is[p]);
+        std::copy(b.get(), b.get() + 9, B + 9*p);
+      }
+    }
+
+    //! The SpringFunction that block() would use for the two nodes
+    virtual SpringFunction* springFunction(const uint j, const uint i) {
+      return(springs);
+    }
+
 
   protected:
 
@@ -119,6 +152,43 @@ namespace ENM {
     }
 
 
+    //! Implementation of the batched SuperBlock calculation
+    void blocksImpl(const uint* js, const uint* is, double* B, const uint n, SpringFunction* fptr) {
+      if (fptr == 0)
+        throw(std::runtime_error("No spring function defined for hessian!"));
+      if (n == 0)
+        return;
+
+      std::vector<double> dx(n), dy(n), dz(n), r2(n), k(n);
+      for (uint p=0; p<n; ++p) {
+        if (is[p] >= size() || js[p] >= size())
+          throw(std::runtime_error("Invalid index in Hessian SuperBlock"));
+
+        loos::GCoord d = nodes[is[p]]->coords() - nodes[js[p]]->coords();
+        dx[p] = d[0];
+        dy[p] = d[1];
+        dz[p] = d[2];
+        r2[p] = d.length2();
+      }
+
+      if (!fptr->constants(&r2[0], &k[0], n)) {
+        for (uint p=0; p<n; ++p) {
+          loos::DoubleMatrix b = blockImpl(js[p], is[p], fptr);
+          std::copy(b.get(), b.get() + 9, B + 9*p);
+        }
+        return;
+      }
+
+      for (uint p=0; p<n; ++p) {
+        double d[3] = { dx[p], dy[p], dz[p] };
+        double* b = B + 9*p;
+        for (uint y=0; y<3; ++y)
+          for (uint x=0; x<3; ++x)
+            b[y*3 + x] = d[x]*d[y] * k[p];
+      }
+    }
+
+
     SpringFunction* springs;
     loos::AtomicGroup nodes;
   };
@@ -204,6 +274,41 @@ namespace ENM {
         return(decorated->block(j, i));
     }
 
+    SpringFunction* springFunction(const uint j, const uint i) {
+      if (connectivity(j, i))
+        return(bound_spring);
+      else
+        return(decorated->springFunction(j, i));
+    }
+
+    // Splits the batch into bound and unbound pairs, handing the
+    // latter to the decorated SuperBlock as a single batch
+    void blocks(const uint* js, const uint* is, double* B, const uint n) {
+      std::vector<uint> bj, bi, bp, uj, ui, up;
+      for (uint p=0; p<n; ++p) {
+        if (connectivity(js[p], is[p])) {
+          bj.push_back(js[p]);
+          bi.push_back(is[p]);
+          bp.push_back(p);
+        } else {
+          uj.push_back(js[p]);
+          ui.push_back(is[p]);
+          up.push_back(p);
+        }
+      }
+
+      std::vector<double> bb(9 * bp.size()), ub(9 * up.size());
+      if (!bp.empty())
+        blocksImpl(&bj[0], &bi[0], &bb[0], bp.size(), bound_spring);
+      if (!up.empty())
+        decorated->blocks(&uj[0], &ui[0], &ub[0], up.size());
+
+      for (uint p=0; p<bp.size(); ++p)
+        std::copy(bb.begin() + 9*p, bb.begin() + 9*p + 9, B + 9*bp[p]);
+      for (uint p=0; p<up.size(); ++p)
+        std::copy(ub.begin() + 9*p, ub.begin() + 9*p + 9, B + 9*up[p]);
+    }
+
     //! Assign parameters and propagate to the decorated superblock
     SpringFunction::Params setParams(const SpringFunction::Params& v) {
       SpringFunction::Params u = bound_spring->setParams(v);
@@ -1,344 +1,268 @@
-#if !defined(LOOS_MC_FIT_HPP)
-#define LOOS_MC_FIT_HPP
-
-#include <iostream>
-#include <vector>
-#include <ctime>            
-#include <boost/random/linear_congruential.hpp>
-#include <boost/random/uniform_real.hpp>
-#include <boost/random/variate_generator.hpp>
-
-// @cond TOOLS_INTERNAL
-
-typedef boost::minstd_rand rand_num;
-
-struct ConstantAcceptor {
-  ConstantAcceptor() : val(0.25) { }
-  ConstantAcceptor(double d) : val(d) { }
-  double operator()(const uint iter) { return(val); }
-
-  double val;
-};
-
+/*
+  This file is part of LOOS.
 
-struct ExponentialAcceptor {
-  ExponentialAcceptor() : k(1.0) { }
-  ExponentialAcceptor(const double scale) : k(scale) { }
-  double operator()(const uint iter) { return(exp(-k * iter)); }
+  LOOS (Lightweight Object-Oriented Structure library)
+  Copyright (c) 2010 Tod D. Romo
+  Department of Biochemistry and Biophysics
+  School of Medicine & Dentistry, University of Rochester
 
-  double k;
-};
+  This package (LOOS) is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation under version 3 of the License.
 
+  This package is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
 
-template<typename T = double>
-class mcoptimo {
-  typedef std::vector< std::vector<T> >     VVectors;
-
-public:
-  //  void reseed(const mcoptimo& previous, mcoptimo &current){
-  //    current.setParams(randomize(previous.getParams()));
-  //    //    current.setParams() = randomize(previous.getParams());
-  // }
-  
-
-  void setParams(const vector<T>& v) {
-    myparams = v;
-  }
-  
-  vector<T> getParams() const { return(myparams); }
-
-
-  //  vector<T>& setParams() { return(myparams); }
-
-
-  //private:
-  //  vector<T> myparams;
-
-
-//   void accept(&previous, const &current){
-//     if (current.getCov() > previous.getCov()){       //accept
-//       previous = current;
-//       // }else if (current.getCov() > e^(Energy/T_star)){ //accept
-//       // previous = current;
-//     } // else{                                           //reject
-//       //   continue; 
-//       // }
-//   }
-
-  //  void optimum(const &current, &best){
-  //    if (current.getCov() > best.getCov()) best = current;
-  //  }
-
-  // Return a perturbed set of parameters
-  vector<T> randomize(const vector<T>& current, const vector<T>& sizes) {
-    //use the BOOST random generator per alan's suggestion
-    //using type pseudo-random number generator, based on the previous k's
-    //rand_num generator(time(0)); //<---Talk to Tod about other seeds!!!
-    //    base_generator_type& generator = rng_singleton();
-
-    vector<T> newParams;
-    for (int i = 0; i < previous.getParams->paramSize(); ++i){//i want the size of the vector myparams
-                                                              //for the 'previous' instance of mcoptimize
-      T springval = 0;//add stuff here to grab that a particular param 
-
-      // Set range/bounds to the size here...
-      // T lowerbound = springval / 2;
-      // T upperbound = 3 * springval / 2;
-      // boost::uniform_real<> uni_dist(lowerbound , upperbound);
-      boost::uniform_real<> uni_dist(-1, 1);
-      boost::variate_generator<rand_num&, boost::uniform_real<> > uni(generator, uni_dist);
-      double scaled_random = (uni() + uni()) * current[i]; 
-      newParams.push_back(scaled_random + current[i]);
-    }
-    return(newParams);
-  }
-
-  //  template<class C>
-  T randomize(uint iter){
-    base_generator_type& single_random = rng_singleton();
-    T upperbound = acceptance(iter);
-    boost::uniform_real<> uni_dist(0, upperbound*2);
-    boost::variate_generator<rand_num&, boost::uniform_real<> > uni(single_random, uni_dist);
-    double my_random = uni();
-    return(my_random);
-  }
-
-//   template<class C>
-//   T acceptance(uint iter, const uint stepSize, const uint absTemp){
-//     //maybe use scope to grab stepSize and absTemp
-//     //but what scope do they belong in??
-                                                                  
-//     //this should not be hard wired.  
-//     //we want another ftor that pts
-//     //to an acceptance function
-//     T cutoff = absTemp - (stepSize * iter);
-//     return(cutoff);
-//  }
-
-
-  template<class C, class Acceptor = ConstantAcceptor>
-  vector<T> takeStep(const vector<T>& current, const vector<T>& sizes, C& ftor, Acceptor& acc, uint iter) {
-    
-    vector<T> newStep = randomize(current, sizes);
-    T prev = ftor(current);
-    T val = ftor(newStep);
-
-    if (val < prev){
-      return(newStep);
-    }elseif (randomize(iter) < acc(iter)){//define both of these!!!
-      return(newStep);
-    }
-    return(current);
-  }
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
-  
+*/
 
-  // vector<double> takeStep(const vector<double>& current, const vector<double>& sizes, FitAggregator& ftor)
-  template<class C, class A = ConstantAcceptor>
-  vector<T> optimize(const vector<T>& current, C& ftor, A& ator) {
-    
-    vector<T> params(current);//<<----do i need this??
-    vector<T> sizes(initial_sizes);
-    uint iter = 0;
-    
-    while (!converged) {
-      vector<T> params = takeStep(params, sizes, ftor, ator, iter);
-      ++iter;
 
-    return(params);
-  }
+/** \addtogroup ENM
+ *@{
+ */
 
-  void setSizes(const vector<T>& s) {
-    initial_sizes = s;
-  }
 
+#if !defined(LOOS_MC_FIT_HPP)
+#define LOOS_MC_FIT_HPP
 
-private:
-  //double cov;
-  //params K; //should this be a springFactory instance???
-  vector<T> initial_sizes;
-  vector<T> myparams;
+#include <vector>
+#include <cmath>
+#include <stdexcept>
 
+#include <boost/random/uniform_real.hpp>
+#include <boost/random/variate_generator.hpp>
+#include <boost/thread/thread.hpp>
+
+#include <loos.hpp>
+
+#include "workers.hpp"
+
+
+namespace ENM {
+
+
+  //! Parallel tempering Monte Carlo minimizer
+  /**
+   * Minimizes a functor of a parameter vector (lower is better, as
+   * with Simplex) using several Monte Carlo chains (replicas), each
+   * at its own temperature.  In each sweep, every replica perturbs
+   * each parameter by up to its step size (scaled by the square root
+   * of the replica's temperature relative to the coldest, so hotter
+   * replicas take bigger steps) and accepts the move by the Metropolis
+   * criterion.  The replicas are spread over threads.  After each
+   * sweep, alternating pairs of neighboring temperatures try to swap
+   * configurations, which lets the cold replicas escape from local
+   * minima.  The best parameters seen by any replica are kept.
+   *
+   * Each replica has its own functor, since evaluating one usually
+   * modifies some state (for an ENM, the SuperBlock's spring
+   * functions and the eigensolver's warm start), so a functor is only
+   * ever used by one thread at a time.  When two replicas swap
+   * configurations, they swap functors too, so each functor's warm
+   * start follows the configuration it was last used for.  Each
+   * temperature also has its own random number stream, derived from
+   * seed(), so a run gives the same result regardless of the number
+   * of threads.
+   *
+   * For example, to fit spring parameters to a PCA (see ENMFitness),
+   * with one SuperBlock (and set of spring functions) per replica,
+   \code
+   CachedHessian cache(blockers[0]);
+   vector<ENMFitness*> fits;
+   for (uint i=0; i<blockers.size(); ++i)
+     fits.push_back(new ENMFitness(blockers[i], cache, pca_s, pca_U, 20));
+
+   ParallelTempering<ENMFitness> pt(fits, ParallelTempering<ENMFitness>::geometricTemperatures(1e-4, 1e-2, fits.size()));
+   pt.threads(0);
+   pt.stepSizes(steps);
+   vector<double> best = pt.optimize(initial_params, 500);
+   \endcode
+   */
+  template<class C>
+  class ParallelTempering {
+  public:
+
+    //! One functor per replica and the replica temperatures, coldest first
+    ParallelTempering(const std::vector<C*>& ftors, const std::vector<double>& temperatures)
+      : ftors_(ftors), temps_(temperatures), nthreads_(1), seed_(1), best_value_(0.0), nsweeps_(0)
+    {
+      if (ftors.empty() || ftors.size() != temperatures.size())
+        throw(std::logic_error("ParallelTempering needs one temperature per functor"));
+      for (uint i=0; i<temps_.size(); ++i)
+        if (!(temps_[i] > 0.0))
+          throw(std::logic_error("ParallelTempering temperatures must be positive"));
+    }
 
-  //////////////////////////////////////////////////
 
+    //! Temperatures from \a tmin to \a tmax, evenly spaced in log(T)
+    static std::vector<double> geometricTemperatures(const double tmin, const double tmax, const uint n) {
+      std::vector<double> t(n, tmin);
+      for (uint i=1; i<n; ++i)
+        t[i] = tmin * pow(tmax / tmin, static_cast<double>(i) / (n - 1));
+      return(t);
+    }
 
 
-  // The core of the optimizer...
-  template<class C>
-  void core(C& ftor) {
-    int i, next_worst, j, mpts;
-    T best, current, previous;//sum, saved, val, num, den;
+    //! Number of threads to use (0 means all available)
+    void threads(const uint n) {
+      nthreads_ = n ? n : boost::thread::hardware_concurrency();
+      if (nthreads_ == 0)
+        nthreads_ = 1;
+    }
 
-    mpts = ndim + 1;
+    //! Seed for the random number streams
+    void seed(const uint s) { seed_ = s; }
 
-    for (j=0; j<ndim; j++) {
-      for (sum = 0.0, i = 0; i<mpts; i++)
+    //! Step size for each parameter (for the coldest replica)
+    void stepSizes(const std::vector<double>& s) { steps_ = s; }
 
-        sum += simplex[i][j];
-      simpsum[j] = sum;
-    }
 
-    int n_evals = 0;
+    //! Run \a nsweeps sweeps, with all replicas starting at \a start
+    std::vector<double> optimize(const std::vector<double>& start, const uint nsweeps) {
+      if (steps_.size() != start.size())
+        throw(std::logic_error("ParallelTempering needs a step size for each parameter"));
 
-    while (n_evals <= maxiters) {
-      best = 1;
-      if (values[0] > values[1]) {
-        worst = 0;
-        next_worst = 1;
-      } else {
-        worst = 1;
-        next_worst = 0;
+      uint n = ftors_.size();
+      replicas_.assign(n, Replica());
+      for (uint r=0; r<n; ++r) {
+        replicas_[r].params = start;
+        replicas_[r].rng.seed(seed_ + 1 + r);
       }
+      loos::base_generator_type swap_rng(seed_);
+      boost::uniform_real<> unit(0.0, 1.0);
+      boost::variate_generator<loos::base_generator_type&, boost::uniform_real<> > swap_uni(swap_rng, unit);
 
+      swaps_tried_.assign(n > 1 ? n-1 : 0, 0);
+      swaps_accepted_.assign(n > 1 ? n-1 : 0, 0);
 
-      // Find candidate vertices in the simplex...
+      runReplicas(&ParallelTempering::evaluate);
+      best_params_ = start;
+      best_value_ = replicas_[0].value;
 
-      for (i=0; i<mpts; i++) {
-        if (values[i] <= values[best])
-          best = i;
-        if (values[i] > values[worst]) {
-          next_worst = worst;
-          worst = i;
-        } else if (values[i] > values[next_worst] && i != worst)
-          next_worst = i;
-      }
+      for (nsweeps_ = 0; nsweeps_ < nsweeps; ) {
+        runReplicas(&ParallelTempering::step);
+        ++nsweeps_;
 
-      // Check for convergence...
-      // Some conditions may have the numerator and denominator equal (or both 0)
-      // which can cause problems below, hence the special test.
-
-      num = fabs(values[worst] - values[best]);
-      den = fabs(values[worst]) + fabs(values[best]);
-      rtol = 2.0 * num / den;
-      if (rtol < tol || num == den)
-        return;
-
-      // Now try reflecting, contracting, expanding the simplex...
-
-      n_evals += 2;
-      val = modify(-1.0, ftor);
-      if (val <= values[best])
-        val = modify(2.0, ftor);
-      else if (val >= values[next_worst]) {
-
-        saved = values[worst];
-        val = modify(0.5, ftor);
-
-        if (val >= saved) {
-          for (i=0; i<mpts; i++) {
-            if (i != best) {
-              for (j=0; j<ndim; j++)
-                simplex[i][j] = simpsum[j] = 0.5 * (simplex[i][j] + simplex[best][j]);
-              values[i] = ftor(simpsum);
-            }
+        for (uint r=0; r<n; ++r)
+          if (replicas_[r].value < best_value_) {
+            best_value_ = replicas_[r].value;
+            best_params_ = replicas_[r].params;
           }
-          n_evals += ndim;
 
-          for (j=0; j<ndim; j++) {
-            for (sum=0.0, i=0; i<mpts; i++)
-              sum += simplex[i][j];
-            simpsum[j] = sum;
+        for (uint r = nsweeps_ % 2; r+1 < n; r += 2) {
+          Replica& a = replicas_[r];
+          Replica& b = replicas_[r+1];
+          double delta = (1.0 / temps_[r] - 1.0 / temps_[r+1]) * (a.value - b.value);
+          ++swaps_tried_[r];
+          if (delta >= 0.0 || swap_uni() < exp(delta)) {
+            std::swap(a.params, b.params);
+            std::swap(a.value, b.value);
+            std::swap(ftors_[r], ftors_[r+1]);
+            ++swaps_accepted_[r];
           }
         }
+      }
 
-      } else
-        --n_evals;
-
+      return(best_params_);
     }
 
-  }
-
 
-  void allocateSpace(const int n) {
-    q = std::vector<T>(n+1, 0.0);
-    qq = std::vector<T>(n+1, 0.0);
-    simpsum = std::vector<T>(n, 0.0);
-    values = std::vector<T>(n+1, 0.0);
-    trial = std::vector<T>(n, 0.0);
-    simplex.clear();
-    for (int i=0; i<n+1; ++i)
-      simplex.push_back(std::vector<T>(n, 0.0));
-  }
+    //! Best parameters found
+    std::vector<double> finalParameters() const { return(best_params_); }
 
+    //! Value of the functor for the best parameters
+    double finalValue() const { return(best_value_); }
 
+    //! Fraction of moves accepted by each replica
+    std::vector<double> acceptanceRates() const {
+      std::vector<double> rates(replicas_.size(), 0.0);
+      if (nsweeps_ > 0)
+        for (uint r=0; r<replicas_.size(); ++r)
+          rates[r] = static_cast<double>(replicas_[r].accepted) / nsweeps_;
+      return(rates);
+    }
 
-public:
+    //! Fraction of swaps accepted between each temperature and the next
+    std::vector<double> swapRates() const {
+      std::vector<double> rates(swaps_tried_.size(), 0.0);
+      for (uint r=0; r<rates.size(); ++r)
+        if (swaps_tried_[r] > 0)
+          rates[r] = static_cast<double>(swaps_accepted_[r]) / swaps_tried_[r];
+      return(rates);
+    }
 
-  Simplex(const int n) : tol(1e-3), ndim(n), maxiters(2000), best(-1), worst(-1) {
-    allocateSpace(n);
-  }
 
-  //! Set the number of dimensions
-  void dim(const int n) { ndim = n; allocateSpace(n); }
+  private:
 
-  //! Initial guess
-  void seedLengths(const std::vector<T>& seeds) { characteristics = seeds; }
+    struct Replica {
+      Replica() : value(0.0), accepted(0) { }
 
-  //! Convergence criterion
-  void tolerance(const double d) { tol = d; }
+      std::vector<double> params;
+      double value;
+      loos::base_generator_type rng;
+      ulong accepted;
+    };
 
-  //! Limit on the number of function evaluations to perform
-  void maximumIterations(const int n) { maxiters = n; }
-  
-  //! Retrieve the final (best fit) parameters
-  std::vector<T> finalParameters(void) const {
-    if (best < 0)
-      throw(std::logic_error("Simplex has not been optimized"));
-    return(simplex[best]);
-  }
 
-  //! Final (best) value
-  T finalValue(void) const { return(values[best]); }
- 
-  //! Optimize via a functor
-  template<class C>
-  std::vector<T> optimize(std::vector<T>& f, C& ftor) {
-    int i, j, n;
+    void evaluate(const uint r) {
+      replicas_[r].value = (*ftors_[r])(replicas_[r].params);
+    }
 
-    if (characteristics.size() != f.size())
-      throw(std::logic_error("Invalid seed"));
 
-    n = ndim + 1;
+    // One Metropolis move for replica r
+    void step(const uint r) {
+      Replica& rep = replicas_[r];
+      boost::uniform_real<> unit(0.0, 1.0);
+      boost::variate_generator<loos::base_generator_type&, boost::uniform_real<> > uni(rep.rng, unit);
 
-    // Initial simplex is based on Nelder-Meade's construction...
+      double scale = sqrt(temps_[r] / temps_[0]);
+      std::vector<double> trial(rep.params);
+      for (uint i=0; i<trial.size(); ++i)
+        trial[i] += (2.0 * uni() - 1.0) * steps_[i] * scale;
 
-    for (i=0; i<ndim; i++) {
-      q[i] = characteristics[i] * ( (sqrtf(n) + ndim) / (n * sqrt(2.0)) );
-      qq[i] = characteristics[i] * ( (sqrtf(n) - 1.0) / (n * sqrt(2.0)) );
+      double value = (*ftors_[r])(trial);
+      double u = uni();
+      if (value <= rep.value || u < exp(-(value - rep.value) / temps_[r])) {
+        rep.params = trial;
+        rep.value = value;
+        ++rep.accepted;
+      }
     }
 
-    for (j=0; j<n; j++)
-      for (i=0; i<ndim; i++)
-        if (j == i+1)
-          simplex[j][i] = f[i] + qq[i];
-        else
-          simplex[j][i] = f[i] + q[i];
 
-    for (j=0; j<n; ++j) {
-      values[j] = ftor(simplex[j]);
+    // Calls f for every replica, with replicas dealt out to threads
+    void runReplicas(void (ParallelTempering::*f)(const uint)) {
+      uint n = replicas_.size();
+      uint nthreads = std::max(1u, std::min(nthreads_, n));
+
+      runWorkers(nthreads, [=](const uint t) {
+          for (uint r=t; r<n; r += nthreads)
+            (this->*f)(r);
+        });
     }
 
-    core(ftor);
-    return(simplex[best]);
-  }
 
-private:
-  double tol;
-  int ndim, maxiters, best, worst;
-  double rtol;
+    std::vector<C*> ftors_;
+    std::vector<double> temps_;
+    std::vector<double> steps_;
+    uint nthreads_, seed_;
 
-  std::vector<T> characteristics;
-  std::vector<T> simpsum;
-  std::vector<T> values;
-  std::vector<T> q;
-  std::vector<T> qq;
-  std::vector<T> trial;
-  VVectors simplex;
+    std::vector<Replica> replicas_;
+    std::vector<double> best_params_;
+    double best_value_;
+    uint nsweeps_;
+    std::vector<ulong> swaps_tried_, swaps_accepted_;
+  };
 
-};
 
+};
 
-// @endcond
 
 #endif
+
+
+/** @} */
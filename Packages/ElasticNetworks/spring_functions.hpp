@@ -32,6 +32,7 @@
 
 
 #include <loos.hpp>
+#include <atomic>
 
 
 namespace ENM {
@@ -71,6 +72,10 @@ namespace ENM {
    *setParams() takes a vector of doubles that represents the internal
    *"constants" for the spring functions.  It treats the vector as a
    *LIFO stack and picks off the ones it neds, returning the rest.
+   *
+   *Spring functions that only depend on the distance between nodes
+   *can also implement constants(), which computes the spring constant
+   *for a whole batch of pairs in one call.
    */
   class SpringFunction {
   public:
@@ -96,16 +101,28 @@ namespace ENM {
     //! Actually compute the spring constant as a 3x3 matrix
     virtual loos::DoubleMatrix constant(const loos::GCoord& u, const loos::GCoord& v, const loos::GCoord& d)  =0;
 
+    //! Compute the (uniform) spring constants for a batch of node pairs
+    /**
+     * \a r2 holds the squared distance for each of \a n pairs, and the
+     * spring constant for each pair is written to \a k.  This is one
+     * virtual call for the whole batch, with the spring function in a
+     * loop the compiler can vectorize.  Returns false if the function
+     * cannot do this (i.e. it is not uniform, or it needs more than the
+     * distance), in which case constant() must be called for each pair.
+     */
+    virtual bool constants(const double* r2, double* k, const uint n) { return(false); }
+
   protected:
 
     //! Check for negative spring-constants
     /**
-     * Issues a one-time warning if a negative spring constant is found
+     * Issues a one-time warning if a negative spring constant is found.
+     * Hessian blocks may be built from several threads at once, so only
+     * the thread that flips the flag prints the warning.
      */
     double checkConstant(double d) {
       if (d < 0.0) {
-        if (!warned) {
-          warned = true;
+        if (!warned.exchange(true)) {
           std::cerr << "Warning- negative spring constants found in " << name() << ".  Setting to 0.\n";
         }
         d = 0.0;
@@ -114,8 +131,15 @@ namespace ENM {
       return(d);
     }
 
+    //! Check a batch of spring constants for negative values
+    void checkConstants(double* k, const uint n) {
+      for (uint i=0; i<n; ++i)
+        if (k[i] < 0.0)
+          k[i] = checkConstant(k[i]);
+    }
+
   private:
-    bool warned;
+    std::atomic<bool> warned;
   };
 
 
@@ -192,6 +216,13 @@ namespace ENM {
       return(0.0);
     }
 
+    bool constants(const double* r2, double* k, const uint n) {
+      for (uint i=0; i<n; ++i)
+        k[i] = (r2[i] <= radius) ? 1./r2[i] : 0.0;
+      checkConstants(k, n);
+      return(true);
+    }
+
   private:
     double radius;
   };
@@ -226,6 +257,13 @@ namespace ENM {
       return(pow(s, power));
     }
 
+    bool constants(const double* r2, double* k, const uint n) {
+      for (uint i=0; i<n; ++i)
+        k[i] = pow(sqrt(r2[i]), power);
+      checkConstants(k, n);
+      return(true);
+    }
+
   private:
     double power;
   };
@@ -261,6 +299,13 @@ namespace ENM {
       return(exp(scale * s));
     }
 
+    bool constants(const double* r2, double* k, const uint n) {
+      for (uint i=0; i<n; ++i)
+        k[i] = exp(scale * sqrt(r2[i]));
+      checkConstants(k, n);
+      return(true);
+    }
+
   private:
     double scale;
   };
@@ -332,6 +377,15 @@ namespace ENM {
       return(k);
     }
 
+    bool constants(const double* r2, double* k, const uint n) {
+      for (uint i=0; i<n; ++i) {
+        double s = sqrt(r2[i]);
+        k[i] = (s <= rcut) ? k1 * s - k2 : k3 * pow(s, -k4);
+      }
+      checkConstants(k, n);
+      return(true);
+    }
+
   private:
     double rcut, k1, k2, k3, k4;
   };
@@ -363,6 +417,13 @@ public:
     return(scale);
   }
 
+  bool constants(const double* r2, double* k, const uint n) {
+    for (uint i=0; i<n; ++i)
+      k[i] = scale;
+    checkConstants(k, n);
+    return(true);
+  }
+
 private:
   double scale;
 };
@@ -66,6 +66,7 @@ string psf_file;
 
 string spring_desc;
 bool nomass;
+uint nthreads;
 
 
 string fullHelpMessage() {
@@ -172,17 +173,19 @@ public:
       ("debug", po::value<bool>(&debug)->default_value(false), "Turn on debugging (output intermediate matrices)")
       ("occupancies", po::value<bool>(&occupancies_are_masses)->default_value(false), "Atom masses are stored in the PDB occupancy field")
       ("nomass", po::value<bool>(&nomass)->default_value(false), "Disable mass as part of the VSA solution")
-      ("spring,S", po::value<string>(&spring_desc)->default_value("distance"), "Spring method and arguments");
+      ("spring,S", po::value<string>(&spring_desc)->default_value("distance"), "Spring method and arguments")
+      ("threads", po::value<uint>(&nthreads)->default_value(1), "Number of threads to use for building the Hessian (0=all available)");
   }
 
   string print() const {
     ostringstream oss;
-    oss << boost::format("psf='%s', debug=%d, occupancies=%d, nomass=%d, spring='%s'")
+    oss << boost::format("psf='%s', debug=%d, occupancies=%d, nomass=%d, spring='%s', threads=%d")
       % psf_file
       % debug
       % occupancies_are_masses
       % nomass
-      % spring_desc;
+      % spring_desc
+      % nthreads;
     return(oss.str());
   }
 
@@ -252,6 +255,7 @@ int main(int argc, char *argv[]) {
   vsa.meta(hdr);
   vsa.debugging(debug);
   vsa.verbosity(verbosity);
+  vsa.threads(nthreads);
 
   if (!nomass) {
     DoubleMatrix M = getMasses(composite);
@@ -0,0 +1,87 @@
+/*
+  This file is part of LOOS.
+
+  LOOS (Lightweight Object-Oriented Structure library)
+  Copyright (c) 2010 Tod D. Romo
+  Department of Biochemistry and Biophysics
+  School of Medicine & Dentistry, University of Rochester
+
+  This package (LOOS) is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation under version 3 of the License.
+
+  This package is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+
+/** \addtogroup ENM
+ *@{
+ */
+
+
+#if !defined(LOOS_ENM_WORKERS_HPP)
+#define LOOS_ENM_WORKERS_HPP
+
+#include <vector>
+#include <exception>
+
+#include <boost/thread/thread.hpp>
+
+#include <loos_defs.hpp>
+
+
+namespace ENM {
+
+
+  //! Runs f(worker) for each of \a nthreads workers, each in its own thread
+  /**
+   * With one worker, \a f is called in the calling thread.  Once all
+   * workers have finished, the first exception thrown by any of them
+   * (in worker order) is rethrown.  This is shared by the Hessian
+   * builder and ParallelTempering, which both deal their work out
+   * round-robin by worker number.
+   */
+  template<class F>
+  void runWorkers(const uint nthreads, F f) {
+    if (nthreads <= 1) {
+      f(0);
+      return;
+    }
+
+    std::vector<std::exception_ptr> errors(nthreads);
+    std::vector<boost::thread*> threads(nthreads);
+    for (uint t=0; t<nthreads; ++t)
+      threads[t] = new boost::thread([&, t]() {
+          try {
+            f(t);
+          }
+          catch (...) {
+            errors[t] = std::current_exception();
+          }
+        });
+
+    for (uint t=0; t<nthreads; ++t) {
+      threads[t]->join();
+      delete threads[t];
+    }
+
+    for (uint t=0; t<nthreads; ++t)
+      if (errors[t])
+        std::rethrow_exception(errors[t]);
+  }
+
+
+};
+
+
+#endif
+
+
+/** @} */
@@ -35,9 +35,8 @@
 using namespace loos;
 using namespace HBonds;
 
-double SimpleAtom::inner = 0.0;
-double SimpleAtom::outer = 3.5;
-double SimpleAtom::deviation = 20.0;
+SimpleAtom::Criteria SimpleAtom::defaults;
+boost::mutex SimpleAtom::defaults_lock;
 
 
 // Reports distance^2 between hydrogen and heavy atom
@@ -45,14 +44,13 @@ double SimpleAtom::deviation = 20.0;
 //   |-----|
 double SimpleAtom::distance2(const SimpleAtom& s) const
 {
-  double d;
-  
-  if (usePeriodicity)
-    d = atom->coords().distance2(s.atom->coords(), sbox.box());
-  else
-    d = atom->coords().distance2(s.atom->coords());
-  
-  return(d);
+  if (usePeriodicity) {
+    loos::DistanceKernels::Distance2< loos::DistanceKernels::Orthorhombic<double> > op(sbox.box());
+    return(op(atom->coords(), s.atom->coords()));
+  }
+
+  loos::DistanceKernels::Distance2< loos::DistanceKernels::NoPeriodicity<double> > op;
+  return(op(atom->coords(), s.atom->coords()));
 }
 
 
@@ -140,7 +138,7 @@ bool SimpleAtom::hydrogenBond(const SAtom& o) const {
   double dist = distance2(o);
   double angl = angle(o);
 
-  if (dist >= inner && dist <= outer && fmod(fabs(angl - 180.0), 360.0) <= deviation)
+  if (dist >= criteria.inner && dist <= criteria.outer && fmod(fabs(angl - 180.0), 360.0) <= criteria.deviation)
     return(true);
 
   return(false);
@@ -29,6 +29,7 @@
 #if !defined(LOOS_HCORE_HPP)
 #define LOOS_HCORE_HPP
 
+#include <boost/thread/mutex.hpp>
 #include <loos.hpp>
 
 
@@ -65,12 +66,26 @@ namespace loos {
     //
     // Note that we hook into the parent group's SharedPeriodicBox so we
     // always have current periodic boundary info...
+    //
+    // The bond criteria (radii and angle) are copied into each
+    // SimpleAtom when it is created, from process-wide defaults.  The
+    // static setters below change those defaults (from any thread), so
+    // they must be called before processSelection().  SimpleAtoms can
+    // then be handed to other threads without sharing any settings.
 
 
     class SimpleAtom {
+
+      struct Criteria {
+        Criteria() : inner(0.0), outer(3.5), deviation(20.0), debugging(false) { }
+
+        double inner, outer, deviation;    // inner and outer are squared
+        bool debugging;
+      };
+
     public:
-      SimpleAtom(const loos::pAtom& a) : atom(a), isHydrogen(divineHydrogen(a->name())), usePeriodicity(false) { }
-      SimpleAtom(const loos::pAtom& a, const loos::SharedPeriodicBox& b, const bool c = true) : atom(a), isHydrogen(divineHydrogen(a->name())), usePeriodicity(c), sbox(b) { }
+      SimpleAtom(const loos::pAtom& a) : atom(a), isHydrogen(divineHydrogen(a->name())), usePeriodicity(false), criteria(currentDefaults()) { }
+      SimpleAtom(const loos::pAtom& a, const loos::SharedPeriodicBox& b, const bool c = true) : atom(a), isHydrogen(divineHydrogen(a->name())), usePeriodicity(c), criteria(currentDefaults()), sbox(b) { }
 
       void attach(const loos::pAtom&a) { attached_to = a; }
       loos::pAtom attachedTo() const { return(attached_to); }
@@ -80,17 +95,18 @@ namespace loos {
       double distance2(const SimpleAtom& s) const;
       double angle(const SimpleAtom& s) const;
 
-      static bool debuggingMode() { return(debugging); }
-      static void debuggingMode(const bool b) { debugging = b; }
+      // These get/set the defaults for SimpleAtoms created afterwards
+      static bool debuggingMode() { return(currentDefaults().debugging); }
+      static void debuggingMode(const bool b) { boost::mutex::scoped_lock lock(defaults_lock); defaults.debugging = b; }
 
-      static double innerRadius()  { return(sqrt(inner)); }
-      static void innerRadius(const double r)  { inner = r*r; }
+      static double innerRadius()  { return(sqrt(currentDefaults().inner)); }
+      static void innerRadius(const double r)  { boost::mutex::scoped_lock lock(defaults_lock); defaults.inner = r*r; }
 
-      static double outerRadius()  { return(sqrt(outer)); }
-      static void outerRadius(const double r)  { outer = r*r; }
+      static double outerRadius()  { return(sqrt(currentDefaults().outer)); }
+      static void outerRadius(const double r)  { boost::mutex::scoped_lock lock(defaults_lock); defaults.outer = r*r; }
 
-      static double maxDeviation()  { return(deviation); }
-      static void maxDeviation(const double d)  { deviation = d; }
+      static double maxDeviation()  { return(currentDefaults().deviation); }
+      static void maxDeviation(const double d)  { boost::mutex::scoped_lock lock(defaults_lock); defaults.deviation = d; }
 
 
       // Tests whether two SimpleAtoms have a potential hydrogen-bond
@@ -144,13 +160,19 @@ namespace loos {
 
       bool divineHydrogen(const std::string& name);
 
+      static Criteria currentDefaults() {
+        boost::mutex::scoped_lock lock(defaults_lock);
+        return(defaults);
+      }
+
 
       loos::pAtom atom;
       bool isHydrogen;
       bool usePeriodicity;
+      Criteria criteria;
 
-      static double inner, outer, deviation;
-      static bool debugging;
+      static Criteria defaults;
+      static boost::mutex defaults_lock;
 
       loos::SharedPeriodicBox sbox;
       loos::pAtom attached_to;
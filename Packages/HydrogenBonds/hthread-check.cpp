@@ -0,0 +1,97 @@
+/*
+  hthread-check.cpp
+
+  Checks that the hydrogen-bond criteria are shared by all threads
+*/
+
+
+/*
+  This file is part of LOOS.
+
+  LOOS (Lightweight Object-Oriented Structure library)
+  Copyright (c) 2010 Tod D. Romo
+  Department of Biochemistry and Biophysics
+  School of Medicine & Dentistry, University of Rochester
+
+  This package (LOOS) is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation under version 3 of the License.
+
+  This package is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include <boost/thread/thread.hpp>
+
+#include "hcore.hpp"
+
+using namespace std;
+using namespace loos;
+using namespace HBonds;
+
+
+uint failures = 0;
+boost::mutex failure_lock;
+
+void fail(const string& msg) {
+  boost::mutex::scoped_lock lock(failure_lock);
+  cerr << "FAILED- " << msg << endl;
+  ++failures;
+}
+
+
+// Two atoms 3.0 apart, which is only a hydrogen bond when the outer
+// radius is larger than that
+bool bonded() {
+  pAtom h(new Atom(1, "H", GCoord(0, 0, 0)));
+  pAtom o(new Atom(2, "O", GCoord(3, 0, 0)));
+  pAtom n(new Atom(3, "N", GCoord(-1, 0, 0)));
+
+  SimpleAtom donor(h);
+  donor.attach(n);
+  SimpleAtom acceptor(o);
+
+  return(donor.hydrogenBond(acceptor));
+}
+
+
+int main(int argc, char *argv[]) {
+  uint nthreads = argc > 1 ? strtoul(argv[1], 0, 10) : 8;
+
+  // Change the defaults from one thread, then build atoms in others
+  for (uint pass=0; pass<2; ++pass) {
+    double radius = pass ? 2.5 : 3.5;
+    bool expected = !pass;
+
+    vector<boost::thread*> threads(nthreads);
+    boost::thread setter([=]() { SimpleAtom::outerRadius(radius); });
+    setter.join();
+
+    for (uint t=0; t<nthreads; ++t)
+      threads[t] = new boost::thread([=]() {
+          for (uint i=0; i<1000; ++i) {
+            if (SimpleAtom::outerRadius() != radius)
+              fail("worker does not see the outer radius set by another thread");
+            if (bonded() != expected)
+              fail("SimpleAtom created by a worker does not use the current criteria");
+          }
+        });
+
+    for (uint t=0; t<nthreads; ++t) {
+      threads[t]->join();
+      delete threads[t];
+    }
+  }
+
+  if (failures) {
+    cerr << failures << " check(s) failed\n";
+    exit(-2);
+  }
+  cout << "All hydrogen-bond thread checks passed\n";
+}
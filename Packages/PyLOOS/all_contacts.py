@@ -129,7 +129,8 @@ else:
 residues = target.splitByResidue()
 # now remove the backbone -- doing before the split loses the glycines
 if args.no_backbone:
-    residues = list([loos.selectAtoms(r, "!backbone") for r in residues])
+    residues = loos.AtomicGroupVector([loos.selectAtoms(r, "!backbone")
+                                       for r in residues])
 
 frac_contacts = numpy.zeros([len(residues), len(residues), num_trajs],
                             numpy.float)
@@ -137,13 +138,10 @@ frac_contacts = numpy.zeros([len(residues), len(residues), num_trajs],
 
 for traj_id in range(num_trajs):
     traj = all_trajs[traj_id]
+    counts = numpy.zeros([len(residues), len(residues)])
     for frame in traj:
-        for i in range(len(residues)):
-            for j in range(i+1, len(residues)):
-                if residues[i].contactWith(args.cutoff, residues[j]):
-                    frac_contacts[i, j, traj_id] += 1.0
-                    frac_contacts[j, i, traj_id] += 1.0
-    frac_contacts[:, :, traj_id] /= len(traj)
+        loos.accumulateContacts(residues, args.cutoff, counts)
+    frac_contacts[:, :, traj_id] = counts / len(traj)
     if (num_trajs > 1) and args.individual:
         numpy.savetxt(out_names[traj_id], frac_contacts[:, :, traj_id],
                       header=header)
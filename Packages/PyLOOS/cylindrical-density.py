@@ -77,32 +77,13 @@ target = loos.selectAtoms(system, target_selection_string)
 zbin_width = (zmax - zmin) / znum_bins
 
 rbin_width = (rmax - rmin) / rnum_bins
-rmin2 = rmin*rmin
-rmax2 = rmax*rmax
 
 hist = numpy.zeros([rnum_bins, znum_bins])
 
 for frame in traj:
-
     centroid = centering.centroid()
-    target.translate(-centroid)
-    target.reimageByAtom()
-
-    for atom in target:
-        x = atom.coords().x()
-        y = atom.coords().y()
-        z = atom.coords().z()
-
-        r2 = x*x + y*y
-
-        if (zmin < z < zmax) and (rmin2 < r2 < rmax2):
-            r = math.sqrt(r2)
-
-            rbin = int((r - rmin) / rbin_width)
-            zbin = int((z - zmin) / zbin_width)
-
-            if (0 <= rbin < rnum_bins) and (0 <= zbin < znum_bins):
-                hist[rbin, zbin] += 1.0
+    loos.accumulateCylindricalHistogram(target, centroid, rmin, rmax,
+                                        zmin, zmax, hist)
 
 hist /= len(traj)
 
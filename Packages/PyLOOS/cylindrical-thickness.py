@@ -50,7 +50,6 @@ import sys
 import loos
 import loos.pyloos
 import numpy
-import math
 
 header = " ".join(sys.argv)
 print("# ", header)
@@ -71,38 +70,18 @@ target = loos.selectAtoms(system, target_selection_string)
 
 
 rbin_width = (rmax - rmin) / rnum_bins
-rmin2 = rmin*rmin
-rmax2 = rmax*rmax
 
-upper_sum = numpy.zeros(rnum_bins)
-upper_count = numpy.zeros(rnum_bins)
-lower_sum = numpy.zeros(rnum_bins)
-lower_count = numpy.zeros(rnum_bins)
+heights = numpy.zeros([rnum_bins, 4])
 
 for frame in traj:
-
     centroid = centering.centroid()
-    target.translate(-centroid)
-    target.reimageByAtom()
-
-    for atom in target:
-        x = atom.coords().x()
-        y = atom.coords().y()
-        z = atom.coords().z()
-
-        r2 = x*x + y*y
-
-        if (rmin2 < r2 < rmax2):
-            r = math.sqrt(r2)
-
-            rbin = int((r - rmin)/rbin_width)
-            if z > 0:
-                upper_sum[rbin] += z
-                upper_count[rbin] += 1
-            else:
-                lower_sum[rbin] += z
-                lower_count[rbin] += 1
+    loos.accumulateCylindricalHeights(target, centroid, rmin, rmax, heights)
 
+# Columns are upper sum, upper count, lower sum, lower count
+upper_sum = heights[:, 0]
+upper_count = heights[:, 1]
+lower_sum = heights[:, 2]
+lower_count = heights[:, 3]
 
 print("#r   Thick   UpperHeight LowerHeight")
 for i in range(rnum_bins):
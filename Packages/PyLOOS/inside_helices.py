@@ -5,6 +5,7 @@ protein
 """
 
 import sys
+import numpy
 import loos
 from loos.pyloos import ConvexHull
 import argparse
@@ -156,24 +157,23 @@ while (traj.readFrame()):
             hulls.append(hull)
 
     for chain in chains:
+        xyz = chain.getCoords()
+        z = xyz[:, 2]
+
+        # skip atoms outside the z range
+        in_range = (z > args.zmin) & (z < args.zmax)
+        index = ((z - args.zmin) / block_size).astype(int)
+
         atoms_inside = 0
-        for atom in chain:
-            z = atom.coords().z()
-
-            # skip atoms outside the z range
-            if not (args.zmin < z < args.zmax):
-                continue
-
-            index = int((z-args.zmin)/block_size)
-
-            if hulls[index] and hulls[index].is_inside(atom.coords()):
-                atoms_inside += 1
-                if atoms_inside >= args.threshold:
-                    key = atom.segid() + ":" + str(atom.resid())
-                    if key not in bound_lipids:
-                        bound_lipids[key] = []
-                    bound_lipids[key].append(frame)
-                    break
+        for i in numpy.unique(index[in_range]):
+            if hulls[i]:
+                atoms_inside += hulls[i].count_inside(xyz[in_range & (index == i)])
+
+        if atoms_inside >= args.threshold:
+            key = chain[0].segid() + ":" + str(chain[0].resid())
+            if key not in bound_lipids:
+                bound_lipids[key] = []
+            bound_lipids[key].append(frame)
     frame += 1
     if frame % 20 == 0: print(frame)
 
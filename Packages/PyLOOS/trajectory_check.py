@@ -0,0 +1,73 @@
+#!/usr/bin/env python3
+"""
+trajectory_check.py : smoke check for loos.pyloos.Trajectory.  Writes a
+small model and DCD into a temporary directory, then builds Trajectory
+objects (plain, with a subset, and with the frame cache) and reads
+the first two frames from each.  Exits with a non-zero status on failure.
+
+Usage: trajectory_check.py
+"""
+
+import loos
+import loos.pyloos
+import os
+import sys
+import tempfile
+
+model_pdb = """\
+ATOM      1  CA  ALA     1       0.000   0.000   0.000  1.00  0.00      P
+ATOM      2  CA  ALA     2       3.800   0.000   0.000  1.00  0.00      P
+ATOM      3  CA  ALA     3       7.600   0.000   0.000  1.00  0.00      P
+END
+"""
+
+nframes = 5
+
+
+def fail(msg):
+    print("FAILED: " + msg)
+    sys.exit(1)
+
+
+# Frame i has every atom shifted by i along y
+def writeTrajectory(model, fname):
+    dcd = loos.DCDWriter(fname)
+    for i in range(nframes):
+        frame = model.copy()
+        for atom in frame:
+            c = atom.coords()
+            atom.coords(loos.GCoord(c.x(), c.y() + i, c.z()))
+        dcd.writeFrame(frame)
+
+
+def checkTrajectory(traj, label):
+    if len(traj) != nframes:
+        fail("%s: expected %d frames, got %d" % (label, nframes, len(traj)))
+
+    n = 0
+    for frame in traj:
+        y = frame[0].coords().y()
+        if abs(y - n) > 1e-3:
+            fail("%s: frame %d has y=%f" % (label, n, y))
+        n += 1
+        if n == 2:
+            break
+
+    if n != 2:
+        fail("%s: only read %d frames" % (label, n))
+
+
+with tempfile.TemporaryDirectory() as tmpdir:
+    pdb_name = os.path.join(tmpdir, "model.pdb")
+    dcd_name = os.path.join(tmpdir, "traj.dcd")
+    with open(pdb_name, "w") as f:
+        f.write(model_pdb)
+
+    model = loos.createSystem(pdb_name)
+    writeTrajectory(model, dcd_name)
+
+    checkTrajectory(loos.pyloos.Trajectory(dcd_name, model), "plain")
+    checkTrajectory(loos.pyloos.Trajectory(dcd_name, model, subset='resid <= 2'), "subset")
+    checkTrajectory(loos.pyloos.Trajectory(dcd_name, model, cache=1), "cached")
+
+print("OK")
@@ -299,6 +299,7 @@ int main(int argc, char *argv[]) {
       if (i == 0)
         savePDB(prefopts->prefix + ".pdb", header, applyto_sub);
     }
+    outtraj->flush();
 
   } else {    // else, aligning to reference structure (i.e. non-iterative)
 
@@ -354,6 +355,7 @@ int main(int argc, char *argv[]) {
         first = false;
       }
     }
+    outtraj->flush();
 
   }
 }
@@ -0,0 +1,142 @@
+/*
+  amber-check.cpp
+
+  Compares blocks of frames read with AmberTraj::readFrames() with the
+  same frames read one at a time
+*/
+
+
+
+/*
+
+  This file is part of LOOS.
+
+  LOOS (Lightweight Object-Oriented Structure library)
+  Copyright (c) 2008, Tod D. Romo
+  Department of Biochemistry and Biophysics
+  School of Medicine & Dentistry, University of Rochester
+
+  This package (LOOS) is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation under version 3 of the License.
+
+  This package is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <loos.hpp>
+
+
+using namespace std;
+using namespace loos;
+
+
+uint failures = 0;
+
+void fail(const string& msg) {
+  cerr << "FAILED- " << msg << endl;
+  ++failures;
+}
+
+
+// Reads the whole trajectory in blocks of nblock frames using nthreads
+// threads, checking each frame against the one readFrame() gives.
+// Both go through the same parser, so they must match exactly.
+void checkBlocks(AmberTraj& traj, const vector< vector<GCoord> >& reference, const vector<GCoord>& boxes,
+                 const uint nblock, const uint nthreads) {
+  string label = "blocks of " + boost::lexical_cast<string>(nblock) + " with "
+    + boost::lexical_cast<string>(nthreads) + " thread(s)";
+
+  // readFrames() must not move the current frame
+  traj.readFrame(1);
+  vector<GCoord> current = traj.coords();
+
+  uint n = traj.nframes();
+  for (uint start=0; start<n; start += nblock) {
+    uint m = min(nblock, n - start);
+    vector< vector<GCoord> > frames;
+    vector<GCoord> pboxes;
+    traj.readFrames(start, m, frames, pboxes, nthreads);
+
+    if (frames.size() != m || pboxes.size() != m) {
+      fail(label + ": wrong number of frames returned");
+      return;
+    }
+    for (uint i=0; i<m; ++i) {
+      if (frames[i] != reference[start + i]) {
+        fail(label + ": coordinates differ at frame " + boost::lexical_cast<string>(start + i));
+        return;
+      }
+      if (traj.hasPeriodicBox() && pboxes[i] != boxes[start + i]) {
+        fail(label + ": box differs at frame " + boost::lexical_cast<string>(start + i));
+        return;
+      }
+    }
+  }
+
+  if (traj.coords() != current)
+    fail(label + ": current frame changed");
+  traj.readFrame();
+  if (traj.coords() != reference[2])
+    fail(label + ": next frame is not the one after the current frame");
+
+  // Reading past the end is an error
+  try {
+    vector< vector<GCoord> > frames;
+    vector<GCoord> pboxes;
+    traj.readFrames(n - 1, 2, frames, pboxes, nthreads);
+    fail(label + ": reading past the end did not throw");
+  }
+  catch (FileError& e) { }
+}
+
+
+
+int main(int argc, char *argv[]) {
+
+  if (argc < 3 || argc > 4) {
+    cerr << "Usage- amber-check model mdcrd [threads]\n"
+         << "Compares blocks of Amber frames read with readFrames() with single frames\n";
+    exit(-1);
+  }
+
+  AtomicGroup model = createSystem(argv[1]);
+  uint nthreads = argc == 4 ? strtoul(argv[3], 0, 10) : 4;
+
+  AmberTraj traj(argv[2], model.size());
+  if (!traj.isFixedWidth()) {
+    cerr << "Error- " << argv[2] << " does not use the fixed-width layout\n";
+    exit(-1);
+  }
+  if (traj.nframes() < 3) {
+    cerr << "Error- the check needs at least 3 frames\n";
+    exit(-1);
+  }
+
+  vector< vector<GCoord> > reference;
+  vector<GCoord> boxes;
+  for (uint i=0; i<traj.nframes(); ++i) {
+    traj.readFrame(i);
+    reference.push_back(traj.coords());
+    boxes.push_back(traj.periodicBox());
+  }
+  cout << "Read " << reference.size() << " frames of " << traj.natoms() << " atoms"
+       << (traj.hasPeriodicBox() ? " with a box\n" : "\n");
+
+  uint sizes[] = { 1, 7, 64, traj.nframes() };
+  for (uint i=0; i<4; ++i) {
+    checkBlocks(traj, reference, boxes, sizes[i], 1);
+    checkBlocks(traj, reference, boxes, sizes[i], nthreads);
+  }
+
+  if (failures) {
+    cerr << failures << " check(s) failed\n";
+    exit(-2);
+  }
+  cout << "All Amber trajectory checks passed\n";
+}
@@ -79,7 +79,9 @@ string fullHelpMessage(void)
     "As with the other rdf tools (rdf, xy_rdf), histogram-min, histogram-max,\n"
     "and histogram-bins control the range over which the rdf is computed, and\n"
     "the number of bins used, in this case from 0 to 20 Angstroms, with 0.5\n"
-    "angstrom bins.\n";
+    "angstrom bins.\n"
+    "\n"
+    "Use --procs to split the trajectory across multiple processes.\n";
     return(s);
     }
 
@@ -89,6 +91,7 @@ int main (int argc, char *argv[])
 // Build options
 opts::BasicOptions* bopts = new opts::BasicOptions(fullHelpMessage());
 opts::TrajectoryWithFrameIndices* tropts = new opts::TrajectoryWithFrameIndices;
+opts::ProcessOptions* popts = new opts::ProcessOptions;
 opts::RequiredArguments* ropts = new opts::RequiredArguments;
 
 // These are required command-line arguments (non-optional options)
@@ -99,7 +102,7 @@ ropts->addArgument("max", "max radius");
 ropts->addArgument("num_bins", "number of bins");
 
 opts::AggregateOptions options;
-options.add(bopts).add(tropts).add(ropts);
+options.add(bopts).add(tropts).add(popts).add(ropts);
 if (!options.parse(argc, argv))
   exit(-1);
 
@@ -144,57 +147,70 @@ if (group2.empty())
     exit(-1);
     }
 
-// Create the histogram and zero it out
-vector<double> hist;
-hist.reserve(num_bins);
-hist.insert(hist.begin(), num_bins, 0.0);
-
 double min2 = hist_min*hist_min;
 double max2 = hist_max*hist_max;
 
+// Each worker process accumulates its own histogram and the summed
+// box volume of its frames
+ProcessPool pool(popts->procs);
+SharedReduction<double> partial(pool.size(), num_bins);
+SharedReduction<double> volumes(pool.size(), 1);
+
 // loop over the frames of the trajectory
 vector<uint> framelist = tropts->frameList();
 uint framecnt = framelist.size();
-double volume = 0.0;
-unsigned long unique_pairs=0;
-for (uint index = 0; index<framecnt; ++index)
+pool.run(framelist, [&](const vector<uint>& frames, const uint worker)
     {
-    traj->readFrame(framelist[index]);
+    if (pool.size() > 1)
+        traj = tropts->openTrajectory();
+    double* hist = partial.slot(worker);
+    double& volume_sum = *volumes.slot(worker);
 
-    // update coordinates and periodic box
-    traj->updateGroupCoords(system);
-    GCoord box = system.periodicBox(); 
-    volume += box.x() * box.y() * box.z();
-
-    unique_pairs = 0;
-    // compute the distribution of g2 around g1 
-    for (uint j = 0; j < group1.size(); j++)
+    for (uint index = 0; index<frames.size(); ++index)
         {
-        pAtom a1 = group1[j];
-        GCoord p1 = a1->coords();
-        for (uint k = 0; k < group2.size(); k++)
+        traj->readFrame(frames[index]);
+
+        // update coordinates and periodic box
+        traj->updateGroupCoords(system);
+        GCoord box = system.periodicBox();
+        volume_sum += box.x() * box.y() * box.z();
+
+        // compute the distribution of g2 around g1
+        for (uint j = 0; j < group1.size(); j++)
             {
-            pAtom a2 = group2[k];
-            // skip "self" pairs 
-            if (a1 == a2)
+            pAtom a1 = group1[j];
+            GCoord p1 = a1->coords();
+            for (uint k = 0; k < group2.size(); k++)
                 {
-                continue;
-                }
-            unique_pairs++;
-            GCoord p2 = a2->coords();
-            // Compute the distance squared, taking periodicity into account
-            double d2 = p1.distance2(p2, box);
-            if ( (d2 < max2) && (d2 > min2) )
-                {
-                double d = sqrt(d2);
-                int bin = int((d-hist_min)/bin_width);
-                hist[bin]++;
+                pAtom a2 = group2[k];
+                // skip "self" pairs
+                if (a1 == a2)
+                    {
+                    continue;
+                    }
+                GCoord p2 = a2->coords();
+                // Compute the distance squared, taking periodicity into account
+                double d2 = p1.distance2(p2, box);
+                if ( (d2 < max2) && (d2 > min2) )
+                    {
+                    double d = sqrt(d2);
+                    int bin = int((d-hist_min)/bin_width);
+                    hist[bin]++;
+                    }
                 }
             }
         }
-    }
+    });
 
-volume /= framecnt;
+vector<double> hist = partial.sum();
+double volume = volumes.sum()[0] / framecnt;
+
+// The number of pairs is the same every frame
+unsigned long unique_pairs=0;
+for (uint j = 0; j < group1.size(); j++)
+    for (uint k = 0; k < group2.size(); k++)
+        if (group1[j] != group2[k])
+            unique_pairs++;
 
 
 
@@ -0,0 +1,200 @@
+/*
+  cache-check.cpp
+
+  Compares frames read through a CachedTrajectory with frames read
+  directly from the trajectory
+*/
+
+
+
+/*
+
+  This file is part of LOOS.
+
+  LOOS (Lightweight Object-Oriented Structure library)
+  Copyright (c) 2008, Tod D. Romo
+  Department of Biochemistry and Biophysics
+  School of Medicine & Dentistry, University of Rochester
+
+  This package (LOOS) is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation under version 3 of the License.
+
+  This package is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <loos.hpp>
+#include <boost/thread/thread.hpp>
+
+
+using namespace std;
+using namespace loos;
+
+
+uint failures = 0;
+boost::mutex failure_lock;
+
+void fail(const string& msg) {
+  boost::mutex::scoped_lock lock(failure_lock);
+  cerr << "FAILED- " << msg << endl;
+  ++failures;
+}
+
+
+// Largest difference between the coordinates of two groups.  The
+// cache stores single precision, so the reference is rounded the
+// same way.
+double maxDifference(const AtomicGroup& reference, const AtomicGroup& cached) {
+  double d = 0.0;
+  for (uint i=0; i<reference.size(); ++i) {
+    GCoord r = reference[i]->coords();
+    GCoord c = cached[i]->coords();
+    for (uint k=0; k<3; ++k)
+      d = max(d, fabs(static_cast<float>(r[k]) - c[k]));
+  }
+  return(d);
+}
+
+
+// Frames are visited in a random order with repeats, so some come
+// from the cache and some have to be (re)read
+vector<uint> visitOrder(const uint nframes, const uint n) {
+  boost::uniform_int<uint> pick(0, nframes - 1);
+  boost::variate_generator<base_generator_type&, boost::uniform_int<uint> > gen(rng_singleton(), pick);
+
+  vector<uint> order(n);
+  for (uint i=0; i<n; ++i)
+    order[i] = gen();
+  return(order);
+}
+
+
+void compare(const string& label, CachedTrajectory& cached, AtomicGroup& cached_group,
+             pTraj& traj, AtomicGroup& reference, const vector<uint>& order) {
+  for (uint i=0; i<order.size(); ++i) {
+    traj->readFrame(order[i]);
+    traj->updateGroupCoords(reference);
+
+    if (!cached.readFrame(order[i])) {
+      fail(label + ": cannot read frame");
+      return;
+    }
+    cached.updateGroupCoords(cached_group);
+
+    if (maxDifference(reference, cached_group) > 0.0) {
+      fail(label + ": coordinates differ from the trajectory");
+      return;
+    }
+    if (traj->hasPeriodicBox() && cached_group.periodicBox() != reference.periodicBox()) {
+      fail(label + ": periodic box differs from the trajectory");
+      return;
+    }
+  }
+}
+
+
+
+
+int main(int argc, char *argv[]) {
+
+  if (argc < 4 || argc > 5) {
+    cerr << "Usage- cache-check model trajectory selection [threads]\n"
+         << "Compares frames read through a CachedTrajectory with frames read directly\n";
+    exit(-1);
+  }
+
+  string model_name(argv[1]), traj_name(argv[2]), selection(argv[3]);
+  uint nthreads = argc == 5 ? strtoul(argv[4], 0, 10) : 4;
+  seedRNG(1);
+
+  AtomicGroup model = createSystem(model_name);
+  AtomicGroup subset = selectAtoms(model, selection);
+  pTraj traj = createTrajectory(traj_name, model);
+  uint nframes = traj->nframes();
+  if (nframes == 0) {
+    cerr << "Error- trajectory has no frames\n";
+    exit(-1);
+  }
+
+  unsigned long frame_bytes = 3 * sizeof(float) * model.size();
+  unsigned long subset_bytes = 3 * sizeof(float) * subset.size();
+  vector<uint> order = visitOrder(nframes, 4 * nframes);
+
+  // Whole frames, with room for every frame and with room for only a
+  // few (forcing evictions)
+  {
+    AtomicGroup reference = model.copy();
+    AtomicGroup cached_group = model.copy();
+
+    CachedTrajectory all(createTrajectory(traj_name, model), nframes * frame_bytes);
+    compare("all atoms", all, cached_group, traj, reference, order);
+
+    // The constructor reads the first frame
+    set<uint> distinct(order.begin(), order.end());
+    distinct.insert(0);
+    if (all.misses() != distinct.size())
+      fail("frames were read more than once with room for all of them");
+
+    CachedTrajectory few(createTrajectory(traj_name, model), 3 * frame_bytes);
+    compare("all atoms, small cache", few, cached_group, traj, reference, order);
+    if (few.evictions() == 0 || few.cachedFrames() > 3)
+      fail("small cache did not evict frames");
+
+    if (few.coords().size() != model.size())
+      fail("coords() is the wrong size");
+  }
+
+  // Only the selected atoms are cached
+  {
+    AtomicGroup reference = subset.copy();
+    AtomicGroup cached_group = subset.copy();
+
+    CachedTrajectory sub(createTrajectory(traj_name, model), 5 * subset_bytes, subset);
+    compare("subset", sub, cached_group, traj, reference, order);
+
+    bool threw = false;
+    try {
+      sub.coords();
+    }
+    catch (LOOSError& e) {
+      threw = true;
+    }
+    if (!threw)
+      fail("coords() should not be available for a subset cache");
+  }
+
+  // Copies in several threads share one cache
+  {
+    CachedTrajectory shared(createTrajectory(traj_name, model), (nframes / 2) * frame_bytes);
+    shared.resetStatistics();
+    vector<boost::thread*> threads(nthreads);
+    for (uint t=0; t<nthreads; ++t)
+      threads[t] = new boost::thread([&, t]() {
+          CachedTrajectory mine(shared);
+          pTraj direct = createTrajectory(traj_name, model);
+          AtomicGroup reference = model.copy();
+          AtomicGroup cached_group = model.copy();
+          compare("threaded copy", mine, cached_group, direct, reference, order);
+        });
+
+    for (uint t=0; t<nthreads; ++t) {
+      threads[t]->join();
+      delete threads[t];
+    }
+
+    if (shared.hits() + shared.misses() != nthreads * order.size())
+      fail("hits and misses do not add up to the frames read");
+  }
+
+  if (failures) {
+    cerr << failures << " check(s) failed\n";
+    exit(-2);
+  }
+  cout << "All cache checks passed\n";
+}
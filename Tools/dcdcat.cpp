@@ -0,0 +1,217 @@
+/*
+  dcdcat.cpp
+
+  Concatenate, slice, or byte-swap DCDs without decoding frames
+*/
+
+
+/*
+  This file is part of LOOS.
+
+  LOOS (Lightweight Object-Oriented Structure library)
+  Copyright (c) 2008 Tod D. Romo
+  Department of Biochemistry and Biophysics
+  School of Medicine & Dentistry, University of Rochester
+
+  This package (LOOS) is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation under version 3 of the License.
+
+  This package is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+
+
+#include <sys/stat.h>
+
+#include <loos.hpp>
+
+
+using namespace std;
+using namespace loos;
+
+namespace opts = loos::OptionsFramework;
+namespace po = loos::OptionsFramework::po;
+
+
+
+string fullHelpMessage(void) {
+  string msg =
+    "\n"
+    "SYNOPSIS\n"
+    "\tConcatenate, slice, or byte-swap DCDs without decoding them\n"
+    "\n"
+    "DESCRIPTION\n"
+    "\n"
+    "\tdcdcat copies frames from one or more DCD files into a new DCD as raw\n"
+    "blocks of bytes, so no coordinates are decoded or re-encoded.  All input\n"
+    "DCDs must have the same number of atoms and must all either have or lack\n"
+    "periodic box information.  Inputs may be in either byte-order.  The header\n"
+    "of the first input is used for the output, with the frame count updated.\n"
+    "\n"
+    "\tThe frames to copy can be selected using --skip and --stride, or with\n"
+    "--range, which is applied to the concatenated input frames.  By default,\n"
+    "the output has the same byte-order as the first input.  Use --native to\n"
+    "convert the output to the native byte-order, or --swab to write it in\n"
+    "the opposite (non-native) byte-order.\n"
+    "\n"
+    "\tOnly complete frames are copied, so dcdcat can also be used to salvage\n"
+    "a truncated DCD.\n"
+    "\n"
+    "EXAMPLES\n"
+    "\n"
+    "\tdcdcat all.dcd run1.dcd run2.dcd run3.dcd\n"
+    "Concatenates the three runs into all.dcd\n"
+    "\n"
+    "\tdcdcat --stride 10 sparse.dcd traj.dcd\n"
+    "Writes every 10th frame of traj.dcd to sparse.dcd\n"
+    "\n"
+    "\tdcdcat --range 100:199 --native 1 out.dcd traj.dcd\n"
+    "Extracts frames 100 through 199, converting to native byte-order\n"
+    "\n"
+    "SEE ALSO\n"
+    "\tsubsetter, merge-traj, fixdcd, dcdinfo\n";
+
+  return(msg);
+}
+
+
+
+// True if both paths name the same existing file
+bool sameFile(const string& a, const string& b) {
+  struct stat sa, sb;
+  if (stat(a.c_str(), &sa) != 0 || stat(b.c_str(), &sb) != 0)
+    return(false);
+  return(sa.st_dev == sb.st_dev && sa.st_ino == sb.st_ino);
+}
+
+
+
+// @cond TOOLS_INTERNAL
+class ToolOptions : public opts::OptionsPackage {
+public:
+  ToolOptions() : skip(0), stride(1), range_spec(""), native(false), swab(false) { }
+
+  void addGeneric(po::options_description& o) {
+    o.add_options()
+      ("skip,k", po::value<uint>(&skip)->default_value(skip), "Number of frames to skip")
+      ("stride,i", po::value<uint>(&stride)->default_value(stride), "Take every ith frame")
+      ("range,r", po::value<string>(&range_spec), "Which frames to use (matlab style range, overrides stride and skip)")
+      ("native", po::value<bool>(&native)->default_value(native), "Write the output in native byte-order")
+      ("swab", po::value<bool>(&swab)->default_value(swab), "Write the output in non-native byte-order");
+  }
+
+  bool postConditions(po::variables_map& map) {
+    if (native && swab) {
+      cerr << "Error- cannot use both --native and --swab\n";
+      return(false);
+    }
+    if (stride == 0) {
+      cerr << "Error- stride must be at least 1\n";
+      return(false);
+    }
+    return(true);
+  }
+
+  string print() const {
+    ostringstream oss;
+    oss << boost::format("skip=%d, stride=%d, range='%s', native=%d, swab=%d") % skip % stride % range_spec % native % swab;
+    return(oss.str());
+  }
+
+  uint skip, stride;
+  string range_spec;
+  bool native, swab;
+};
+// @endcond
+
+
+
+int main(int argc, char *argv[]) {
+
+  opts::BasicOptions* bopts = new opts::BasicOptions(fullHelpMessage());
+  ToolOptions* topts = new ToolOptions;
+  opts::RequiredArguments* ropts = new opts::RequiredArguments;
+  ropts->addArgument("output", "output-dcd");
+  ropts->addVariableArguments("input", "dcd");
+
+  opts::AggregateOptions options;
+  options.add(bopts).add(topts).add(ropts);
+  if (!options.parse(argc, argv))
+    exit(-1);
+
+  DCD::setSuppression(true);
+
+  string outname = ropts->value("output");
+  vector<string> names = ropts->variableValues("input");
+  for (vector<string>::const_iterator i = names.begin(); i != names.end(); ++i)
+    if (sameFile(outname, *i)) {
+      cerr << "Error- output " << outname << " is also an input\n";
+      exit(-2);
+    }
+
+  vector< boost::shared_ptr<RawDCD> > inputs;
+  uint total = 0;
+  for (vector<string>::const_iterator i = names.begin(); i != names.end(); ++i) {
+    boost::shared_ptr<RawDCD> dcd(new RawDCD(*i));
+    if (!inputs.empty() && !inputs[0]->compatible(*dcd)) {
+      cerr << "Error- " << *i << " is not compatible with " << inputs[0]->filename() << endl;
+      exit(-2);
+    }
+    if (dcd->hasPartialFrame())
+      cerr << "Warning- " << *i << " ends with an incomplete frame, which will be ignored.\n";
+    total += dcd->nframes();
+    inputs.push_back(dcd);
+  }
+
+  vector<uint> frames;
+  if (topts->range_spec.empty()) {
+    for (uint i=topts->skip; i<total; i += topts->stride)
+      frames.push_back(i);
+  } else
+    frames = parseRangeList<uint>(topts->range_spec, total);
+
+  // Frames are copied in a single pass over the inputs, so check them
+  // all before the output is created
+  for (uint k=0; k<frames.size(); ++k) {
+    if (frames[k] >= total) {
+      cerr << "Error- frame " << frames[k] << " is out of range (there are " << total << " frames)\n";
+      exit(-2);
+    }
+    if (k > 0 && frames[k] < frames[k-1]) {
+      cerr << "Error- frame " << frames[k] << " is out of order (frames must be in increasing order)\n";
+      exit(-2);
+    }
+  }
+
+  RawDCDWriter::ByteOrder order = RawDCDWriter::SAME_AS_TEMPLATE;
+  if (topts->native)
+    order = RawDCDWriter::NATIVE;
+  else if (topts->swab)
+    order = RawDCDWriter::SWAPPED;
+
+  RawDCDWriter output(outname, *(inputs[0]), order);
+
+  // Map the global frame indices back onto each input, preserving the order
+  // they were requested in...
+  uint offset = 0;
+  uint k = 0;
+  for (uint j=0; j<inputs.size() && k < frames.size(); ++j) {
+    vector<uint> local;
+    uint n = inputs[j]->nframes();
+    while (k < frames.size() && frames[k] >= offset && frames[k] < offset + n)
+      local.push_back(frames[k++] - offset);
+    output.copyFrames(*(inputs[j]), local);
+    offset += n;
+  }
+
+  output.close();
+  cerr << boost::format("Wrote %d frames to %s\n") % output.framesWritten() % outname;
+}
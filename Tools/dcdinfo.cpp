@@ -39,10 +39,20 @@
 using namespace std;
 using namespace loos;
 
-uint countFrames(DCD& dcd) {
-  uint c = 0;
-  for (dcd.rewind(); dcd.readFrame(); ++c) ;
-  return(c);
+// DCD frames are all the same size, so the actual number of frames
+// can be found from the file size without reading any coordinates...
+uint countFrames(DCD& dcd, const string& fname, bool& partial) {
+  if (dcd.frameSize() <= 0)
+    throw(FileReadError(fname, "DCD header gives an invalid frame size"));
+
+  ifstream ifs(fname.c_str(), ios_base::in | ios_base::binary);
+  ifs.seekg(0, ios_base::end);
+  streamoff datasize = static_cast<streamoff>(ifs.tellg()) - static_cast<streamoff>(dcd.firstFramePos());
+  if (datasize < 0)
+    throw(FileReadError(fname, "DCD is shorter than its header"));
+
+  partial = (datasize % dcd.frameSize() != 0);
+  return(datasize / dcd.frameSize());
 }
 
 
@@ -114,20 +124,38 @@ int main(int argc, char *argv[]) {
   }
 
   DCD::setSuppression(true);
-  DCD dcd(argv[opt]);
+  boost::shared_ptr<DCD> pdcd;
+  try {
+    pdcd = DCD::headerOnly(argv[opt]);
+  }
+  catch (FileError& e) {
+    cerr << "Error- " << e.what() << endl;
+    exit(-2);
+  }
+  DCD& dcd = *pdcd;
 
   if (!dcd.nativeFormat())
     cout << "The DCD is not in a native binary format.\n";
 
   cout << boost::format("* DCD has %u atoms in %u frames with a timestep of %f.\n") % dcd.natoms() % dcd.nframes() % dcd.timestep();
-  uint n = countFrames(dcd);
+  bool partial;
+  uint n;
+  try {
+    n = countFrames(dcd, argv[opt], partial);
+  }
+  catch (FileError& e) {
+    cerr << "Error- " << e.what() << endl;
+    exit(-2);
+  }
   if (n != dcd.nframes())
       cout << "WARNING- Trajectory actually has " << n << " rather than what is given in the header!\n"
            << "         You can fix this using the fixdcd tool on the trajectory.\n";
+  if (partial)
+    cout << "WARNING- Trajectory ends with an incomplete frame.\n";
   
   if (dcd.hasCrystalParams()) {
     cout << "* DCD HAS box/crystal information.\n";
-    dcd.readFrame();
+    dcd.readFrame(0);
     vector<double> xtal = dcd.crystalParams();
     cout << "* DCD Crystal params (first frame): ";
     copy(xtal.begin(), xtal.end(), ostream_iterator<double>(cout, " "));
@@ -56,6 +56,7 @@ public:
   bool use_electrons;
   bool write_per_frame;
   bool reimage;
+  uint nthreads;
 
   // Change these options to reflect what your tool needs
   void addGeneric(po::options_description& o) {
@@ -67,6 +68,7 @@ public:
     ("electrons", "Weight atoms by electrons")
     ("per-frame", "Write a distribution for each frame")
     ("reimage", "Account for box size when computing distances")
+    ("threads", po::value<uint>(&nthreads)->default_value(1), "Number of threads to use (0=all available)")
     ;
   }
 
@@ -98,11 +100,12 @@ public:
   // options are set to (for logging purposes)
   string print() const {
     ostringstream oss;
-    oss << boost::format("hist_min=%f, hist_max=%f, num_bins=%d, prefix=%s")
+    oss << boost::format("hist_min=%f, hist_max=%f, num_bins=%d, prefix=%s, threads=%d")
             % hist_min
             % hist_max
             % num_bins
-            % prefix.c_str();
+            % prefix.c_str()
+            % nthreads;
     return(oss.str());
   }
 
@@ -134,6 +137,7 @@ string fullHelp(void) {
   "                    information for this option to work correctly.\n"
   "per-frame:          Write out a histogram for each frame processed\n"
   "reimage:            Account for periodicity when computing distances\n"
+  "threads:            Number of threads used for each frame (0 = all available)\n"
   "\n"
   "Note: reimage is a little tricky.  If you know your molecule isn't\n"
   "      broken across the periodic image, you don't need it.  \n"
@@ -146,6 +150,10 @@ string fullHelp(void) {
   "      using subsetter or merge-traj, so the molecule isn't broken \n"
   "      the periodic image.\n"
   "\n"
+  "Every pair of atoms is used (there is no cutoff), so the time per frame\n"
+  "grows as the square of the number of atoms.  For large selections, such\n"
+  "as a whole protein, use --threads to split each frame across cores.\n"
+  "\n"
   "\n";
   return(s);
 }
@@ -194,56 +202,34 @@ int main(int argc, char *argv[]) {
     weighting.assign(subset.size(), 1.0);
   }
 
+  PairDistanceHistogram pair_histogram(topts->hist_min, topts->hist_max, topts->num_bins);
+  pair_histogram.threads(topts->nthreads);
+  pair_histogram.periodic(topts->reimage);
+
   vector<double> total_histogram;
   total_histogram.assign(topts->num_bins, 0.0);
   uint frames_accumulated = 0;
 
-  // Now iterate over all frames in the trajectory (excluding the skip
-  // region)
-  while (traj->readFrame()) {
-    // Set up the histogram
-    vector<double> histogram;
-    histogram.assign(topts->num_bins, 0.0);
-    double normalization = 0.0;
-    int excluded = 0;
+  // Now iterate over the requested frames
+  vector<uint> frames = tropts->frameList();
+  for (uint f=0; f<frames.size(); ++f) {
+    traj->readFrame(frames[f]);
 
     // Update the coordinates ONLY for the subset of atoms we're
     // interested in...
     traj->updateGroupCoords(subset);
-    GCoord box = model.periodicBox();
-
-    for (uint i=0; i<subset.size()-1; i++) {
-      for (uint j=i+1; j<subset.size(); j++) {
-        double distance;
-        if (topts->reimage) {
-          distance = subset[i]->coords().distance(subset[j]->coords(),
-                                                         box);
-        }
-        else {
-          distance = subset[i]->coords().distance(subset[j]->coords());
-        }
-        if ( (distance >= topts->hist_max) || (distance <= topts->hist_min) ) {
-          excluded++;
-        }
-        else {
-         int bin = static_cast<int>((distance - topts->hist_min)/bin_width);
-         double e2 = weighting[i] * weighting[j];
-         histogram.at(bin) += e2;
-         normalization += e2;
-        }
-      }
-    }
 
-    if (excluded) {
+    pair_histogram.clear();
+    pair_histogram.accumulate(subset, weighting);
+
+    if (pair_histogram.excluded()) {
       cerr << "Frame: " << traj->currentFrame()
-           << " excluded " << excluded
+           << " excluded " << pair_histogram.excluded()
            << " distances." << endl;
     }
 
     // Normalize the histogram
-    for (uint i=0; i<histogram.size(); i++) {
-      histogram[i] /= normalization;
-    }
+    vector<double> histogram = pair_histogram.normalized();
 
     // Output the histogram for the frame
     if (topts->write_per_frame) {
@@ -266,12 +252,9 @@ int main(int argc, char *argv[]) {
     }
 
     // Accumulate the total histogram
-    for (uint i=0; i<histogram.size(); i++) {
+    for (uint i=0; i<histogram.size(); i++)
       total_histogram[i] += histogram[i];
-      frames_accumulated++;
-    }
-
-
+    frames_accumulated++;
   }
 
   cout << "# Distance Probability" << endl;
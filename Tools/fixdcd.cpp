@@ -33,54 +33,25 @@ using namespace std;
 
 
 
-int scanTrajectory(const char* fname, bool* swabbing)
-{
-
-    DCD dcd(fname);
-    *swabbing = !dcd.nativeFormat();
-    
-
-    int n = 0;
-    while (dcd.readFrame())
-        ++n;
-
-    if (n != static_cast<int>(dcd.nframes())) {
-        cout << boost::format("%s claims to have %d frames.\n") % fname % dcd.nframes();
-        cout << boost::format("--> Scanning found %d frames.\n") % n;
-    } else
-        n = -1;   // Signal no-update
-    
-    return(n);
-}
-
-
-
+// DCD frames are all the same size, so the frame count comes from the
+// file size and only the header is rewritten...
 void fixDCD(const char* fname) 
 {
-    bool swabbing;
+    RawDCD dcd(fname);
+    uint n = dcd.nframes();
+    uint claimed = dcd.headerFrames();
+    bool partial = dcd.hasPartialFrame();
 
-    int nframes = scanTrajectory(fname, &swabbing);
-    if (nframes < 0)
-        return;
-    
-
-    
-    fstream file(fname, ios_base::in | ios_base::out);
+    if (partial)
+        cout << boost::format("%s ends with an incomplete frame, which will be ignored.\n") % fname;
 
-    if (file.fail()) {
-        cerr << "Error- cannot open " << fname << endl;
-        exit(-2);
-    }
-
-    if (swabbing)
-        nframes = swab(nframes);
-    
-    file.seekp(8);
-    file.write(reinterpret_cast<char*>(&nframes), sizeof(nframes));
+    if (n == claimed)
+        return;
 
-    file.seekp(20);
-    file.write(reinterpret_cast<char*>(&nframes), sizeof(nframes));
+    cout << boost::format("%s claims to have %d frames.\n") % fname % claimed;
+    cout << boost::format("--> Scanning found %d frames.\n") % n;
 
+    fixDCDHeader(fname);
 }
 
 
@@ -0,0 +1,228 @@
+/*
+  frame-index
+
+  Computes a set of named per-frame features in one pass over a
+  trajectory and stores them in an index for frame-query
+*/
+
+
+/*
+  This file is part of LOOS.
+
+  LOOS (Lightweight Object-Oriented Structure library)
+  Copyright (c) 2008, Tod D. Romo, Alan Grossfield
+  Department of Biochemistry and Biophysics
+  School of Medicine & Dentistry, University of Rochester
+
+  This package (LOOS) is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation under version 3 of the License.
+
+  This package is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+
+#include <loos.hpp>
+
+using namespace std;
+using namespace loos;
+
+namespace opts = loos::OptionsFramework;
+namespace po = loos::OptionsFramework::po;
+
+
+
+// @cond TOOLS_INTERNAL
+
+string fullHelpMessage(void) {
+  string msg =
+    "\n"
+    "SYNOPSIS\n"
+    "\tBuild an index of per-frame features for querying with frame-query\n"
+    "\n"
+    "DESCRIPTION\n"
+    "\n"
+    "\tframe-index computes a set of named quantities for every frame of a trajectory\n"
+    "in a single pass (optionally split across several processes with --procs) and\n"
+    "stores them in a compact binary index, by default next to the trajectory with\n"
+    "\".fidx\" appended to its name.  frame-query can then pick out the frames that meet\n"
+    "any combination of conditions on these features without reading the trajectory\n"
+    "again, and its output can be passed to the --range option of other tools.\n"
+    "\n"
+    "\tEach feature is given as name=kind; selection; ... where kind is one of\n"
+    "\t  distance; sel1; sel2           distance between centroids\n"
+    "\t  mindist; sel1; sel2            smallest distance between any two atoms\n"
+    "\t  contacts; sel1; sel2; cutoff   number of atom pairs within cutoff\n"
+    "\t  count; sel1; sel2; cutoff      number of sel2 atoms within cutoff of sel1\n"
+    "\t  angle; sel1; sel2; sel3        angle between centroids (degrees)\n"
+    "\t  dihedral; sel1; ...; sel4      torsion between centroids (degrees)\n"
+    "\t  rgyr; sel                      radius of gyration\n"
+    "Names may contain letters, digits, and underscores.  Features can be given with\n"
+    "--feature (repeated as needed) or listed one per line in a file with --features\n"
+    "(blank lines and lines starting with '#' are ignored).  Distances use the periodic\n"
+    "box to find the closest image when one is present.\n"
+    "\n"
+    "\tA summary of each feature (minimum, mean, and maximum) is written to stdout.\n"
+    "\n"
+    "EXAMPLES\n"
+    "\n"
+    "\tframe-index --procs 8 \\\n"
+    "\t  --feature 'site=mindist; resname == \"LIG\"; resid == 112 || resid == 207' \\\n"
+    "\t  --feature 'bridge=mindist; resid == 45 && name =~ \"^OE\"; resid == 80 && name == \"NZ\"' \\\n"
+    "\t  --feature 'waters=count; resname == \"LIG\"; name == \"OH2\"; 5' \\\n"
+    "\t  model.psf traj.dcd\n"
+    "This example writes traj.dcd.fidx with three features: the closest approach of the\n"
+    "ligand to the binding site, the salt bridge distance between residues 45 and 80, and\n"
+    "the number of waters within 5 angstroms of the ligand.  The trajectory is split\n"
+    "across 8 processes.\n"
+    "\n"
+    "\tframe-query traj.dcd.fidx 'site < 4 && bridge < 3.5'\n"
+    "This prints the frames where the ligand is bound and the salt bridge is formed.\n"
+    "\n"
+    "SEE ALSO\n"
+    "\tframe-query, subsetter\n";
+
+  return(msg);
+}
+
+
+
+class ToolOptions : public opts::OptionsPackage {
+public:
+
+  void addGeneric(po::options_description& o) {
+    o.add_options()
+      ("feature", po::value< vector<string> >(&features), "Feature to compute (name=kind; selection; ...)")
+      ("features", po::value<string>(&features_file), "File with one feature per line")
+      ("output,o", po::value<string>(&output), "Name of the index (default is the trajectory name + .fidx)");
+  }
+
+  bool postConditions(po::variables_map& map) {
+    if (!features_file.empty()) {
+      ifstream ifs(features_file.c_str());
+      if (!ifs) {
+        cerr << "Error- cannot open " << features_file << endl;
+        return(false);
+      }
+      string line;
+      while (getline(ifs, line)) {
+        boost::trim(line);
+        if (!line.empty() && line[0] != '#')
+          features.push_back(line);
+      }
+    }
+
+    if (features.empty()) {
+      cerr << "Error- at least one feature must be given with --feature or --features\n";
+      return(false);
+    }
+    return(true);
+  }
+
+  string print() const {
+    ostringstream oss;
+    oss << boost::format("feature='%s', features='%s', output='%s'")
+      % vectorAsStringWithCommas<string>(features)
+      % features_file
+      % output;
+    return(oss.str());
+  }
+
+  vector<string> features;
+  string features_file;
+  string output;
+};
+
+// @endcond TOOLS_INTERNAL
+
+
+
+
+int main(int argc, char *argv[]) {
+  string hdr = invocationHeader(argc, argv);
+
+  opts::BasicOptions* bopts = new opts::BasicOptions(fullHelpMessage());
+  opts::TrajectoryWithFrameIndices* tropts = new opts::TrajectoryWithFrameIndices;
+  opts::ProcessOptions* popts = new opts::ProcessOptions;
+  ToolOptions* topts = new ToolOptions;
+
+  opts::AggregateOptions options;
+  options.add(bopts).add(tropts).add(popts).add(topts);
+  if (!options.parse(argc, argv))
+    exit(-1);
+
+  AtomicGroup model = tropts->model;
+  pTraj traj = tropts->trajectory;
+
+  vector<FrameFeature> features;
+  vector<string> names, definitions;
+  for (uint i=0; i<topts->features.size(); ++i) {
+    FrameFeature f(topts->features[i], model);
+    if (find(names.begin(), names.end(), f.name()) != names.end()) {
+      cerr << "Error- feature '" << f.name() << "' is defined more than once\n";
+      exit(-1);
+    }
+    features.push_back(f);
+    names.push_back(f.name());
+    definitions.push_back(f.definition());
+  }
+
+  vector<uint> frames = tropts->frameList();
+  uint nrows = frames.size();
+  uint nfeatures = features.size();
+
+  // Workers get contiguous pieces of the frame list, so each one
+  // fills its own block of rows in every column
+  ProcessPool pool(popts->procs);
+  vector< vector<uint> > parts = ProcessPool::partition(frames, pool.size());
+  vector<uint> first_row(parts.size(), 0);
+  for (uint k=1; k<parts.size(); ++k)
+    first_row[k] = first_row[k-1] + parts[k-1].size();
+
+  SharedReduction<float> table(1, static_cast<size_t>(nrows) * nfeatures);
+  float* columns = table.slot(0);
+
+  pool.run(frames, [&](const vector<uint>& mine, const uint worker) {
+      if (pool.size() > 1)
+        traj = tropts->openTrajectory();
+
+      uint row = first_row[worker];
+      for (uint i=0; i<mine.size(); ++i, ++row) {
+        traj->readFrame(mine[i]);
+        traj->updateGroupCoords(model);
+        for (uint j=0; j<nfeatures; ++j)
+          columns[static_cast<size_t>(j) * nrows + row] = features[j].value();
+      }
+    });
+
+  FrameFeatureIndex index(names, definitions, frames);
+  index.trajectoryName(tropts->traj_name);
+  for (uint j=0; j<nfeatures; ++j)
+    copy(columns + static_cast<size_t>(j) * nrows, columns + static_cast<size_t>(j+1) * nrows, index.column(j).begin());
+
+  string output = topts->output.empty() ? FrameFeatureIndex::defaultName(tropts->traj_name) : topts->output;
+  index.write(output);
+
+  cout << "# " << hdr << endl;
+  cout << "# Wrote " << nrows << " frames to " << output << endl;
+  cout << "# Feature\tMin\tMean\tMax\n";
+  for (uint j=0; j<nfeatures; ++j) {
+    const vector<float>& col = index.column(j);
+    double lo = 0.0, hi = 0.0, mean = 0.0;
+    if (!col.empty()) {
+      lo = *min_element(col.begin(), col.end());
+      hi = *max_element(col.begin(), col.end());
+      for (uint i=0; i<col.size(); ++i)
+        mean += col[i];
+      mean /= col.size();
+    }
+    cout << names[j] << "\t" << lo << "\t" << mean << "\t" << hi << endl;
+  }
+}
@@ -0,0 +1,200 @@
+/*
+  frame-query
+
+  Finds the frames in a frame-index that meet a set of conditions
+*/
+
+
+/*
+  This file is part of LOOS.
+
+  LOOS (Lightweight Object-Oriented Structure library)
+  Copyright (c) 2008, Tod D. Romo, Alan Grossfield
+  Department of Biochemistry and Biophysics
+  School of Medicine & Dentistry, University of Rochester
+
+  This package (LOOS) is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation under version 3 of the License.
+
+  This package is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+
+#include <loos.hpp>
+
+using namespace std;
+using namespace loos;
+
+namespace opts = loos::OptionsFramework;
+namespace po = loos::OptionsFramework::po;
+
+
+
+// @cond TOOLS_INTERNAL
+
+string fullHelpMessage(void) {
+  string msg =
+    "\n"
+    "SYNOPSIS\n"
+    "\tFind the frames in a frame index that meet a set of conditions\n"
+    "\n"
+    "DESCRIPTION\n"
+    "\n"
+    "\tframe-query reads an index built by frame-index and prints the trajectory\n"
+    "frames where the query is true.  The query compares features by name using\n"
+    "<, <=, >, >=, ==, and !=, and combines comparisons with && (and), || (or),\n"
+    "! (not), and parentheses.  Comparisons can be chained to test a range, e.g.\n"
+    "'2.5 <= bridge <= 3.5', and 'frame' is the trajectory frame number.\n"
+    "\n"
+    "\tBy default, the frames are written as a single comma-separated list of\n"
+    "Octave-style ranges, which can be passed directly to the --range option of\n"
+    "other tools (including subsetter).  Use --list to write one frame per line,\n"
+    "--count to write only the number of frames, or --values to write the features\n"
+    "for each matching frame as a table.  Use --describe to list the features in the\n"
+    "index and how they were defined.\n"
+    "\n"
+    "\tIf no frames match, nothing is written and the exit status is nonzero\n"
+    "(an empty --range would otherwise select every frame).\n"
+    "\n"
+    "EXAMPLES\n"
+    "\n"
+    "\tframe-query traj.dcd.fidx 'site < 4 && bridge < 3.5'\n"
+    "Prints the frames where the ligand is within 4 angstroms of the binding site and\n"
+    "the salt bridge is formed (see frame-index for how these were defined).\n"
+    "\n"
+    "\tsubsetter --range \"$(frame-query traj.dcd.fidx 'site < 4 && !(waters > 10)')\" \\\n"
+    "\t  bound model.psf traj.dcd\n"
+    "Extracts the frames where the ligand is bound and at most 10 waters are nearby\n"
+    "into bound.dcd.\n"
+    "\n"
+    "\tframe-query --values traj.dcd.fidx 'frame >= 1000 && 100 < angle1 < 140'\n"
+    "Prints a table of every feature for frames past 1000 where angle1 is between 100\n"
+    "and 140 degrees.\n"
+    "\n"
+    "SEE ALSO\n"
+    "\tframe-index, subsetter\n";
+
+  return(msg);
+}
+
+
+
+class ToolOptions : public opts::OptionsPackage {
+public:
+  ToolOptions() : list(false), count(false), values(false), describe(false) { }
+
+  void addGeneric(po::options_description& o) {
+    o.add_options()
+      ("list", po::value<bool>(&list)->default_value(false), "Write one frame per line")
+      ("count", po::value<bool>(&count)->default_value(false), "Only write the number of matching frames")
+      ("values", po::value<bool>(&values)->default_value(false), "Write the features of each matching frame")
+      ("describe", po::value<bool>(&describe)->default_value(false), "List the features in the index");
+  }
+
+  void addHidden(po::options_description& o) {
+    o.add_options()
+      ("index", po::value<string>(&index_name), "Frame index")
+      ("query", po::value<string>(&query), "Query");
+  }
+
+  void addPositional(po::positional_options_description& pos) {
+    pos.add("index", 1);
+    pos.add("query", 1);
+  }
+
+  bool check(po::variables_map& map) {
+    return(index_name.empty() || (query.empty() && !describe));
+  }
+
+  string help() const { return("index query"); }
+
+  string print() const {
+    ostringstream oss;
+    oss << boost::format("list=%d, count=%d, values=%d, describe=%d, index='%s', query='%s'")
+      % list
+      % count
+      % values
+      % describe
+      % index_name
+      % query;
+    return(oss.str());
+  }
+
+  bool list, count, values, describe;
+  string index_name, query;
+};
+
+// @endcond TOOLS_INTERNAL
+
+
+
+
+int main(int argc, char *argv[]) {
+  string hdr = invocationHeader(argc, argv);
+
+  opts::BasicOptions* bopts = new opts::BasicOptions(fullHelpMessage());
+  ToolOptions* topts = new ToolOptions;
+
+  opts::AggregateOptions options;
+  options.add(bopts).add(topts);
+  if (!options.parse(argc, argv))
+    exit(-1);
+
+  FrameFeatureIndex index(topts->index_name);
+
+  if (topts->describe) {
+    cout << "# " << hdr << endl;
+    cout << "# Index of " << index.frames() << " frames from " << index.trajectoryName() << endl;
+    for (uint i=0; i<index.features(); ++i)
+      cout << index.definitions()[i] << endl;
+    if (topts->query.empty())
+      exit(0);
+  }
+
+  vector<uint> rows = index.queryRows(topts->query);
+  const vector<uint>& frames = index.frameNumbers();
+
+  if (topts->count) {
+    cout << rows.size() << endl;
+
+  } else if (topts->values) {
+    cout << "# " << hdr << endl;
+    cout << "# frame";
+    for (uint j=0; j<index.features(); ++j)
+      cout << "\t" << index.names()[j];
+    cout << endl;
+
+    for (uint i=0; i<rows.size(); ++i) {
+      cout << frames[rows[i]];
+      for (uint j=0; j<index.features(); ++j)
+        cout << "\t" << index.column(j)[rows[i]];
+      cout << endl;
+    }
+
+  } else if (topts->list) {
+    for (uint i=0; i<rows.size(); ++i)
+      cout << frames[rows[i]] << endl;
+
+  } else {
+    vector<uint> matches(rows.size());
+    for (uint i=0; i<rows.size(); ++i)
+      matches[i] = frames[rows[i]];
+    if (matches.empty()) {
+      // An empty --range means every frame to other tools
+      cerr << "Warning- no frames matched\n";
+      exit(1);
+    }
+    cout << rangeListAsString(matches) << endl;
+  }
+
+  if (bopts->verbosity)
+    cerr << boost::format("%d of %d frames matched\n") % rows.size() % index.frames();
+}
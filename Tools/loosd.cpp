@@ -0,0 +1,170 @@
+/*
+  loosd.cpp
+
+  Persistent local analysis server that keeps systems and trajectories loaded
+*/
+
+
+/*
+  This file is part of LOOS.
+
+  LOOS (Lightweight Object-Oriented Structure library)
+  Copyright (c) 2008 Tod D. Romo
+  Department of Biochemistry and Biophysics
+  School of Medicine & Dentistry, University of Rochester
+
+  This package (LOOS) is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation under version 3 of the License.
+
+  This package is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+
+
+#include <loos.hpp>
+
+
+using namespace std;
+using namespace loos;
+
+namespace opts = loos::OptionsFramework;
+namespace po = loos::OptionsFramework::po;
+
+
+
+string fullHelpMessage(void) {
+  string msg =
+    "\n"
+    "SYNOPSIS\n"
+    "\tKeep systems and trajectories loaded for other LOOS tools\n"
+    "\n"
+    "DESCRIPTION\n"
+    "\n"
+    "\tloosd is a long-lived server that loads models and opens trajectories\n"
+    "on behalf of other LOOS tools, and keeps them loaded between runs.  Tools\n"
+    "talk to it over a Unix domain socket.  When a series of short analyses are\n"
+    "run on the same system, this skips reading the model, re-indexing the\n"
+    "trajectory, and (up to the cache size) decoding frames for every tool.\n"
+    "\n"
+    "\tTools that take their model and trajectory through the standard\n"
+    "options will use the server when given --server with the path to the\n"
+    "socket, or when the LOOS_SERVER environment variable is set to it.  If the\n"
+    "server cannot be reached, tools fall back to loading files themselves.\n"
+    "Files are checked for changes each time they are requested and are\n"
+    "reloaded when needed.\n"
+    "\n"
+    "\tThe socket defaults to $XDG_RUNTIME_DIR/loosd.sock, or to\n"
+    "~/.loos/loosd.sock if XDG_RUNTIME_DIR is not set.\n"
+    "\n"
+    "\tDecoded frames are cached in double precision up to --cache megabytes,\n"
+    "split evenly between the open trajectories, with the least recently\n"
+    "used frames discarded first.  Use --stats to print the server's cache\n"
+    "statistics, and --stop to shut down a running server.\n"
+    "\n"
+    "EXAMPLES\n"
+    "\n"
+    "\tloosd &\n"
+    "\texport LOOS_SERVER=$XDG_RUNTIME_DIR/loosd.sock\n"
+    "\trmsf model.pdb traj.dcd >rmsf.asc\n"
+    "\taverager model.pdb traj.dcd >average.pdb\n"
+    "Starts a server and runs two tools through it.  The second tool\n"
+    "gets the model and frames from the server's cache.\n"
+    "\n"
+    "\tloosd --stop 1\n"
+    "Shuts down the server\n"
+    "\n"
+    "NOTES\n"
+    "\tThe server runs with the permissions of the user that started it, and\n"
+    "can be asked to read any file that user can.  The socket is created so\n"
+    "that only that user can connect to it, and connections from other users\n"
+    "are refused.  If giving an explicit socket path, keep it in a directory\n"
+    "only you can write to (not /tmp).\n";
+
+  return(msg);
+}
+
+
+
+// @cond TOOLS_INTERNAL
+class ToolOptions : public opts::OptionsPackage {
+public:
+  ToolOptions() : cache_mb(1024), stats(false), stop(false) { }
+
+  void addGeneric(po::options_description& o) {
+    o.add_options()
+      ("cache", po::value<uint>(&cache_mb)->default_value(cache_mb), "Maximum size of the frame cache (in MB)")
+      ("stats", po::value<bool>(&stats)->default_value(stats), "Print statistics from a running server and exit")
+      ("stop", po::value<bool>(&stop)->default_value(stop), "Stop a running server");
+  }
+
+  void addHidden(po::options_description& o) {
+    o.add_options()
+      ("socket", po::value<string>(&socket), "Socket path");
+  }
+
+  void addPositional(po::positional_options_description& pos) {
+    pos.add("socket", 1);
+  }
+
+  string help() const { return("[socket-path]"); }
+
+  string print() const {
+    ostringstream oss;
+    oss << boost::format("cache=%d, stats=%d, stop=%d, socket='%s'") % cache_mb % stats % stop % socket;
+    return(oss.str());
+  }
+
+  uint cache_mb;
+  bool stats, stop;
+  string socket;
+};
+// @endcond
+
+
+
+int main(int argc, char *argv[]) {
+
+  opts::BasicOptions* bopts = new opts::BasicOptions(fullHelpMessage());
+  ToolOptions* topts = new ToolOptions;
+
+  opts::AggregateOptions options;
+  options.add(bopts).add(topts);
+  if (!options.parse(argc, argv))
+    exit(-1);
+
+  try {
+    bool serving = !(topts->stats || topts->stop);
+    string path = topts->socket.empty() ? AnalysisServer::defaultSocketPath(serving) : topts->socket;
+
+    if (topts->stats || topts->stop) {
+      AnalysisClient client(path);
+      if (topts->stats)
+        cout << client.statistics();
+      if (topts->stop)
+        client.shutdown();
+      exit(0);
+    }
+
+    AnalysisServer server(path, static_cast<unsigned long>(topts->cache_mb) << 20);
+    server.verbose(bopts->verbosity > 0);
+    if (bopts->verbosity > 0)
+      cerr << "loosd: listening on " << path << endl;
+
+    server.run();
+
+    if (bopts->verbosity > 0)
+      cerr << server.statistics();
+  }
+  catch (LOOSError& e) {
+    cerr << "Error- " << e.what() << endl;
+    exit(-2);
+  }
+}
@@ -750,6 +750,10 @@ int main(int argc, char *argv[])
 
         }
 
-
+    output->flush();
+    if (do_downsample)
+        {
+        output_downsample->flush();
+        }
 
     }
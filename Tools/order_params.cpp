@@ -56,6 +56,9 @@ bool block_average = false;
 string block_filename;
 int ba_first, ba_last;
 
+bool blocking = false;
+string blocking_filename;
+
 
 // @cond TOOLS_INTERNAL
 class ToolOptions : public opts::OptionsPackage
@@ -72,7 +75,8 @@ public:
       ("timeseries,T", po::value<string>(&timeseries_filename), "File name for outputing timeseries")
       ("block_average", po::value<string>(&block_filename),"File name for block averaging data")
       ("ba_first", po::value<int>(&ba_first), "Lower range of blocks to average over to calculate uncertainty")
-      ("ba_last", po::value<int>(&ba_last), "Upper range of blocks to average over to calculate uncertainty");
+      ("ba_last", po::value<int>(&ba_last), "Upper range of blocks to average over to calculate uncertainty")
+      ("blocking", po::value<string>(&blocking_filename), "File name for streaming (power-of-two) blocking data");
   }
 
   void addHidden(po::options_description& o)
@@ -158,6 +162,8 @@ public:
         if (!vm.count("ba_last")) ba_last = 5;
       }
 
+    blocking = vm.count("blocking");
+
 
     return(true);
   }
@@ -169,14 +175,15 @@ public:
   string print() const {
     ostringstream oss;
 
-    oss << boost::format("axis_index=%d, one_res_lipid=%d, three_res_lipid=%d, dump_timeseries=%d, block_average=%d, ba_first=%d, ba_last=%d")
+    oss << boost::format("axis_index=%d, one_res_lipid=%d, three_res_lipid=%d, dump_timeseries=%d, block_average=%d, ba_first=%d, ba_last=%d, blocking=%d")
       % axis_index
       % one_res_lipid
       % three_res_lipid
       % dump_timeseries
       % block_average
       % ba_first
-      % ba_last;
+      % ba_last
+      % blocking;
     return(oss.str());
   }
 
@@ -262,6 +269,9 @@ string fullHelpMessage(void)
 "    --ba_last  integer              upper number of blocks to consider\n"
 "                                    as part of the plateau (col 2 in the\n"
 "                                    block_average file).\n"
+"    --blocking filename             turn on streaming blocking, output\n"
+"                                    the standard error for each block\n"
+"                                    size to filename\n"
 "    --timeseries  filename          output a timeseries for the average \n"
 "                                    order parameter for each carbon position\n"
 "\n"
@@ -300,6 +310,18 @@ string fullHelpMessage(void)
 "    error with block size (plot \"file\" using 3:4 w lp in gnuplot, for \n"
 "    example), and then read off from the file which blocks are in that range.\n"
 "\n"
+"    Alternatively, --blocking accumulates the blocking statistics as the\n"
+"    trajectory is read, using block sizes that are powers of two (1, 2, 4,\n"
+"    ... frames).  The file has one line per carbon and block size, giving\n"
+"    the carbon number, the block size in frames, the number of blocks, the\n"
+"    standard error, and the uncertainty in the standard error.  An extra\n"
+"    output column (after BSE, if present) gives the standard error at the\n"
+"    smallest block size past the plateau, chosen using the criterion of\n"
+"    Lee, Needs & Towler (Phys Rev B, 2011, 83, 184506), so no range needs\n"
+"    to be picked by hand.  If no block size qualifies, the trajectory is\n"
+"    too short to estimate the error, and the largest block size with at\n"
+"    least two blocks is used instead (with a warning).\n"
+"\n"
 "    If you wish to do your own analysis of the variation of the average \n"
 "    order parameter, you can specify the --timeseries flag, which will dump\n"
 "    out the average value for each carbon position at each time point, with\n"
@@ -538,6 +560,22 @@ for (unsigned int i=0; i<selections.size(); i++)
     }
 #endif
 
+// Compile the C-H pairs into a single kernel, so each frame is one pass
+// over flat arrays
+BondOrientationKernel kernel(selections.size());
+for (unsigned int i=0; i<selections.size(); i++)
+    {
+    for (uint j=0; j<selections[i].size(); j++)
+        {
+        for (uint k=0; k<hydrogen_list[i][j].size(); k++)
+            {
+            kernel.addVector(i, selections[i][j], hydrogen_list[i][j][k]);
+            }
+        }
+    }
+
+GCoord field(0.0, 0.0, 0.0);
+field[axis_index] = 1.0;
 
 
 const int num_frames = framelist.size();
@@ -546,13 +584,12 @@ const int num_frames = framelist.size();
 // carbon position, and turn this into an average at the end.
 // This will let us do better uncertainty analysis.
 vector<vector<float> > values;
-vector<int> counts;
+vector<BlockingAccumulator<double> > blockers(selections.size());
 values.resize(selections.size());
 for (uint i=0; i<values.size(); i++)
     {
     values[i].insert(values[i].begin(), num_frames, 0.0);
     }
-counts.insert(counts.begin(), selections.size(), 0);
 
 ofstream timeseries_outfile;
 if (dump_timeseries)
@@ -589,43 +626,25 @@ for (uint i=0; i<framelist.size(); ++i)
     traj->updateGroupCoords(system);
 
 
-    // loop over sets of selected carbons
-    for (unsigned int i=0; i<selections.size(); i++)
-        {
-        AtomicGroup *g = &(selections[i]);
-        for (uint j=0; j<g->size(); j++)
-            {
-            // get the carbon
-            pAtom carbon = g->getAtom(j);
-            // get the relevant hydrogens
-            AtomicGroup *hyds = &(hydrogen_list[i][j]);
-
-            AtomicGroup::Iterator iter(*hyds);
-            pAtom h;
-            while ( (h = iter()) )
-                {
-                GCoord v = carbon->coords() - h->coords();
-                double length = v.length();
-                double cos_val =  v[axis_index]/length;
-                double order = 0.5 - 1.5*cos_val*cos_val;
-                values[i][frame_index] += order;
-                counts[i]++;
-                }
-            }
-        }
-    // turn the sum into an average
+    // average over all C-H vectors at each carbon position
+    kernel.compute(field);
     if (dump_timeseries)
         {
         timeseries_outfile << frame_index << "\t";
         }
     for (unsigned int i=0; i<selections.size(); i++)
         {
-        values[i][frame_index] /= counts[i];
+        // kernel computes (3cos^2 - 1)/2, the sign convention here is
+        // the opposite
+        values[i][frame_index] = -kernel.order(i);
+        if (blocking)
+            {
+            blockers[i].push(values[i][frame_index]);
+            }
         if (dump_timeseries)
             {
             timeseries_outfile << boost::format("%8.3f") % fabs(values[i][frame_index]);
             }
-        counts[i] = 0;
         }
     if (dump_timeseries)
         {
@@ -634,16 +653,6 @@ for (uint i=0; i<framelist.size(); ++i)
     frame_index++;
     }
 
-// Print header
-if (!block_average)
-    {
-    cout << "# Carbon  S_cd   +/-" << endl;
-    }
-else
-    {
-    cout << "# Carbon  S_cd   +/-     BSE" << endl;
-    }
-
 ofstream ba_outfile;
 int ba_maxblocks = -1;
 if (block_average)
@@ -668,6 +677,38 @@ if (block_average)
         }
     }
 
+ofstream blocking_outfile;
+if (blocking)
+    {
+    blocking_outfile.open(blocking_filename.c_str());
+    if (!blocking_outfile.good())
+        {
+        cerr << "Failed opening blocking output file "
+             << blocking_filename
+             << endl
+             << "Turning off blocking"
+             << endl;
+        blocking = false;
+        }
+    else
+        {
+        blocking_outfile << "# Carb\tBlockSize\tNumBlocks\tStdErr\tStdErrErr" << endl;
+        }
+    }
+
+// Print header (after opening the output files, since the error
+// columns are dropped if they can't be opened)
+cout << "# Carbon  S_cd   +/-";
+if (block_average)
+    {
+    cout << "     BSE";
+    }
+if (blocking)
+    {
+    cout << "     FPSE";
+    }
+cout << endl;
+
 
 for (unsigned int i = 0; i < selections.size(); i++)
     {
@@ -711,6 +752,27 @@ for (unsigned int i = 0; i < selections.size(); i++)
         float bse = sum / (ba_last - ba_first + 1);
         cout << boost::format("%8.5f") % bse;
         }
+    if (blocking)
+        {
+        const BlockingAccumulator<double>& b = blockers[i];
+        vector<double> errs = b.stdErrs();
+        for (uint k=0; k<errs.size(); k++)
+            {
+            blocking_outfile << boost::format("%d\t%d\t%d\t%8.5f\t%8.5f") %
+                                  index % b.blockSize(k) % b.blocks(k) % errs[k] % b.stdErrError(k);
+            blocking_outfile << endl;
+            }
+        blocking_outfile << endl;
+
+        int level = b.optimalLevel();
+        if (level < 0 && !errs.empty())
+            {
+            cerr << "Warning- no plateau in blocking for carbon " << index
+                 << ", using the largest block size" << endl;
+            level = errs.size() - 1;
+            }
+        cout << boost::format("%8.5f") % (level < 0 ? 0.0 : errs[level]);
+        }
     cout << endl;
 
     }
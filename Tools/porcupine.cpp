@@ -446,22 +446,20 @@ int main(int argc, char *argv[]) {
     exit(-1);
   }
 
+  // Spine vectors for all requested modes, already scaled
+  DoubleMatrix D = scaledModes(U, cols, scalings, uniform);
+
   int atomid = 1;
   AtomicGroup spines;
 
   for (uint j=0; j<cols.size(); ++j) {
     int resid = 1;
-    double k = scalings[j];
     uint col = cols[j];
 
     string segid = generateSegid(col - offset);
 
     for (uint i=0; i<m; i += 3) {
-      GCoord v(U(i,col), U(i+1,col), U(i+2,col));
-      if (uniform)
-        v /= v.length();
-
-      v *= k;
+      GCoord v(D(i,j), D(i+1,j), D(i+2,j));
       pAtom pa = avg.findById(atomids[i/3]);
       GCoord c = pa->coords();
 
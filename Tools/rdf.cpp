@@ -324,6 +324,10 @@ for (uint j=0; j<g1_mols.size(); ++j)
     }
 
 
+// Scratch space for the group 2 centers and distances
+vector<double> g2_centers(3 * g2_mols.size());
+vector<double> d2s(g2_mols.size());
+
 // loop over the frames of the trajectory
 uint framecount = framelist.size();
 double volume = 0.0;
@@ -344,10 +348,26 @@ for (uint index = 0; index<framecount; ++index)
     GCoord box = system.periodicBox();
     volume += weight*(box.x() * box.y() * box.z());
 
+    // The centers of mass for group 2 only need to be computed once
+    // per frame...
+    for (unsigned int k = 0; k < g2_mols.size(); k++)
+        {
+        GCoord p2 = g2_mols[k].centerOfMass();
+        g2_centers[3*k] = p2.x();
+        g2_centers[3*k+1] = p2.y();
+        g2_centers[3*k+2] = p2.z();
+        }
+    DistanceKernels::Distance2< DistanceKernels::Orthorhombic<double> > dist2_op(box);
+
     // compute the distribution of g2 around g1
     for (unsigned int j = 0; j < g1_mols.size(); j++)
         {
-        GCoord p1 = g1_mols[j].centerOfMass();
+        GCoord c1 = g1_mols[j].centerOfMass();
+        double p1[3] = { c1.x(), c1.y(), c1.z() };
+
+        // Compute the distances squared, taking periodicity into account
+        DistanceKernels::distance2Batch(dist2_op, p1, g2_centers.data(), g2_mols.size(), d2s.data());
+
         for (unsigned int k = 0; k < g2_mols.size(); k++)
             {
             // skip "self" pairs -- in case selection1 and selection2 overlap
@@ -355,10 +375,8 @@ for (uint index = 0; index<framecount; ++index)
                 {
                 continue;
                 }
-            GCoord p2 = g2_mols[k].centerOfMass();
 
-            // Compute the distance squared, taking periodicity into account
-            double d2 = p1.distance2(p2, box);
+            double d2 = d2s[k];
             if ( (d2 < max2) && (d2 > min2) )
                 {
                 double d = sqrt(d2);
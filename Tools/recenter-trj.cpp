@@ -178,4 +178,5 @@ while (traj->readFrame())
     traj_out->writeFrame(model);
     }
 
+traj_out->flush();
 }
@@ -194,6 +194,7 @@ int main(int argc, char *argv[])
 
       traj_out->writeFrame(model);
     }
+  traj_out->flush();
 
   cerr << " - done\n";
 
@@ -235,11 +235,16 @@ int main(int argc, char *argv[]) {
     exit(-10);
   }
 
+  // Only the RMSD subset is needed from each frame, so read it as
+  // single-precision (the format's native precision for DCD and XTC)
+  FloatFrame target_frame(target);
+  FloatFrame frame(subset);
   for (uint i=0; i<indices.size(); i++) {
       ptraj->readFrame(indices[i]);
-      ptraj->updateGroupCoords(subset);
-      subset.applyTransform(transforms[i]);
-      double d = target.rmsd(subset);
+      ptraj->updateFrameCoords(frame);
+      if (!transforms.empty())
+        applyTransform(frame, transforms[i]);
+      double d = rmsd(target_frame, frame);
       rmsds.push_back(d);
       avg_rmsd += d;
   }
@@ -85,6 +85,13 @@ string fullHelpMessage(void) {
     "the trajectory either by using the --range1 and --range2 options, or use subsetter to pre-process\n"
     "the trajectory.\n"
     "\n"
+    "\tThe cached coordinates can also be stored at reduced precision with the --storage\n"
+    "option, so more frames fit in the same memory: 'float' halves the memory used, while\n"
+    "'int16' (16-bit integers scaled to each frame's extent) and 'fixed' (rounded to\n"
+    "--fixed-precision angstroms, as in XTC files) use a quarter of it.  Frames are expanded\n"
+    "a block at a time as the RMSDs are calculated.  With -v, the largest error introduced\n"
+    "in any coordinate is reported.\n"
+    "\n"
     "\tThis tool can be run in parallel with multiple threads for performance.  The --threads option\n"
     "controls how many threads are used.  The default is 1 (non-parallel).  Setting it to 0 will use\n"
     "as many threads as possible.  Note that if LOOS was built using a multi-threaded math library,\n"
@@ -100,6 +107,10 @@ string fullHelpMessage(void) {
     "This example uses all alpha-carbons and every frame in the trajectory, run\n"
     "in parallel with 8 threads of execution.\n"
     "\n"
+    "\trmsds --storage=int16 model.pdb simulation.dcd >rmsd.asc\n"
+    "This example stores the alpha-carbon coordinates as 16-bit integers, allowing\n"
+    "roughly four times as many frames to be cached as the default.\n"
+    "\n"
     "\trmsds inactive.pdb inactive.dcd active.pdb active.dcd >rmsd.asc\n"
     "This example uses all alpha-carbons and compares the \"inactive\" simulation\n"
     "with the \"active\" one.\n"
@@ -142,6 +153,8 @@ public:
       ("skip2", po::value<uint>(&skip2)->default_value(0), "Skip n-frames of second trajectory")
       ("range2", po::value<string>(&range2), "Matlab-style range of frames to use from second trajectory")
       ("stats", po::value<bool>(&stats)->default_value(false), "Show some statistics for matrix")
+      ("storage", po::value<string>(&storage)->default_value("double"), "How to store cached coordinates (double, float, int16, fixed)")
+      ("fixed-precision", po::value<double>(&fixed_precision)->default_value(0.001), "Precision (in Angstroms) for fixed storage")
       ("precision,p", po::value<uint>(&matrix_precision)->default_value(2), "Write out matrix coefficients with this many digits.");
   }
 
@@ -165,6 +178,18 @@ public:
     return( ! ( (m.count("model1") && m.count("traj1")) && !(m.count("model2") ^ m.count("traj2"))) );
   }
 
+  bool postConditions(po::variables_map& m) {
+    if (storage != "double" && storage != "float" && storage != "int16" && storage != "fixed") {
+      cerr << "Error- --storage must be one of double, float, int16, or fixed\n";
+      return(false);
+    }
+    if (storage == "fixed" && fixed_precision <= 0.0) {
+      cerr << "Error- --fixed-precision must be positive\n";
+      return(false);
+    }
+    return(true);
+  }
+
 
   string help() const {
     return("model-1 trajectory-1 [model-2 trajectory-2]");
@@ -173,12 +198,13 @@ public:
 
   string print() const {
     ostringstream oss;
-    oss << boost::format("stats=%d,matrix_precision=%d,noout=%d,nthreads=%d,sel1='%s',skip1=%d,range1='%s',sel2='%s',skip2=%d,range2='%s',model1='%s',traj1='%s',model2='%s',traj2='%s'")
+    oss << boost::format("stats=%d,matrix_precision=%d,noout=%d,nthreads=%d,storage='%s',fixed_precision=%f,sel1='%s',skip1=%d,range1='%s',sel2='%s',skip2=%d,range2='%s',model1='%s',traj1='%s',model2='%s',traj2='%s'")
       % stats
       % matrix_precision
       % noop
       % nthreads
-      % matrix_precision
+      % storage
+      % fixed_precision
       % sel1
       % skip1
       % range1
@@ -202,6 +228,8 @@ public:
   string range1, range2;
   string model1, traj1, model2, traj2;
   string sel1, sel2;
+  string storage;
+  double fixed_precision;
 };
 
 typedef vector<double>    vecDouble;
@@ -291,7 +319,9 @@ private:
 
 /*
   Worker thread processes a column of the all-to-all matrix.  Gets which
-  column to work on from the associated Master object.
+  column to work on from the associated Master object.  The other frames
+  are expanded from the (possibly compressed) ensemble a tile at a time
+  into buffers private to each thread.
 */
 
 
@@ -300,7 +330,7 @@ private:
 class DualWorker 
 {
 public:
-  DualWorker(RealMatrix* R, vMatrix* T1, vMatrix* T2, Master* M) : _R(R), _T1(T1), _T2(T2), _M(M), _maxcol(T2->size()) { }
+  DualWorker(RealMatrix* R, CompressedEnsemble* T1, CompressedEnsemble* T2, Master* M) : _R(R), _T1(T1), _T2(T2), _M(M), _maxcol(T2->size()) { }
 
 
   DualWorker(const DualWorker& w) 
@@ -315,9 +345,13 @@ public:
 
   void calc(const uint i) 
   {
-    for (uint j=0; j<_maxcol; ++j) {
-      double d = loos::alignment::centeredRMSD((*_T1)[i], (*_T2)[j]);
-      (*_R)(i, j) = d;
+    _T1->decode(i, _row);
+    for (uint j=0; j<_maxcol; j += _tile.size()) {
+      _T2->decode(j, _T2->tileFrames(), _tile);
+      for (uint k=0; k<_tile.size(); ++k) {
+        double d = loos::alignment::centeredRMSD(_row, _tile[k]);
+        (*_R)(i, j+k) = d;
+      }
     }
   }
 
@@ -332,10 +366,12 @@ public:
 
 private:
   RealMatrix* _R;
-  vMatrix* _T1;
-  vMatrix* _T2;
+  CompressedEnsemble* _T1;
+  CompressedEnsemble* _T2;
   Master* _M;
   uint _maxcol;
+  vecDouble _row;
+  vMatrix _tile;
 };
 
 
@@ -345,7 +381,7 @@ private:
 class SingleWorker 
 {
 public:
-  SingleWorker(RealMatrix* R, vMatrix* T, Master* M) : _R(R), _T(T), _M(M) { }
+  SingleWorker(RealMatrix* R, CompressedEnsemble* T, Master* M) : _R(R), _T(T), _M(M) { }
 
 
   SingleWorker(const SingleWorker& w) 
@@ -358,9 +394,13 @@ public:
 
   void calc(const uint i) 
   {
-    for (uint j=0; j<i; ++j) {
-      double d = loos::alignment::centeredRMSD((*_T)[i], (*_T)[j]);
-      (*_R)(j, i) = (*_R)(i, j) = d;
+    _T->decode(i, _row);
+    for (uint j=0; j<i; j += _tile.size()) {
+      _T->decode(j, std::min(_T->tileFrames(), i-j), _tile);
+      for (uint k=0; k<_tile.size(); ++k) {
+        double d = loos::alignment::centeredRMSD(_row, _tile[k]);
+        (*_R)(j+k, i) = (*_R)(i, j+k) = d;
+      }
     }
   }
 
@@ -375,8 +415,10 @@ public:
 
 private:
   RealMatrix* _R;
-  vMatrix* _T;
+  CompressedEnsemble* _T;
   Master* _M;
+  vecDouble _row;
+  vMatrix _tile;
 };
 
 
@@ -457,9 +499,15 @@ void showStatsWhole(const RealMatrix& R) {
 
 
 
-void centerTrajectory(alignment::vecMatrix& U) {
-  for (uint i=0; i<U.size(); ++i)
-    alignment::centerAtOrigin(U[i]);
+void reportStorage(const CompressedEnsemble& T) {
+  if (!verbosity || T.storage() == CompressedEnsemble::DOUBLE || T.empty())
+    return;
+
+  cerr << boost::format("Cached %d frames in %.2f MB (%.1fx smaller than full precision), max coordinate error = %.2g\n")
+    % T.size()
+    % (static_cast<double>(T.bytes()) / (1lu<<20))
+    % (static_cast<double>(T.uncompressedBytes()) / T.bytes())
+    % T.maxError();
 }
 
 
@@ -512,11 +560,13 @@ int main(int argc, char *argv[]) {
     cerr << "Using " << nthreads << " threads\n";
     cerr << "Reading trajectory - " << topts->traj1 << endl;
   }
-  vMatrix T = readCoords(subset, traj, indices, verbosity > 1);
-  used_memory += T.size() * T[0].size() * sizeof(vMatrix::value_type::value_type);   // Coords matrix
+  CompressedEnsemble::Storage storage = CompressedEnsemble::storageFromName(topts->storage);
+  CompressedEnsemble T(storage, topts->fixed_precision);
+  appendCoords(T, subset, traj, indices, verbosity > 1, true);
+  used_memory += T.bytes();                                                          // Coords matrix
   used_memory += T.size() * T.size() * sizeof(RealMatrix::element_type);             // RMSDS matrix
   checkMemoryUsage(mem);
-  centerTrajectory(T);
+  reportStorage(T);
 
   RealMatrix M;
   if (topts->model2.empty()) {
@@ -542,10 +592,11 @@ int main(int argc, char *argv[]) {
 
     if (verbosity > 1)
       cerr << "Reading trajectory - " << topts->traj2 << endl;
-    vMatrix T2 = readCoords(subset2, traj2, indices2, verbosity > 1);
-    used_memory += T2.size() * T2[0].size() * sizeof(double);
+    CompressedEnsemble T2(storage, topts->fixed_precision);
+    appendCoords(T2, subset2, traj2, indices2, verbosity > 1, true);
+    used_memory += T2.bytes();
     checkMemoryUsage(mem);
-    centerTrajectory(T2);
+    reportStorage(T2);
 
     if (verbosity > 1)
       cerr << "Calculating RMSD...\n";
@@ -126,6 +126,10 @@ public:
 
     virtual void writeFrame(const AtomicGroup& structure) =0;
 
+    // Writes out anything still buffered, once all frames are written
+    virtual void flush() 
+        {}
+
     virtual ~Outputter() 
         {}
     
@@ -226,6 +230,11 @@ public:
             _traj->writeFrame(structure);
         }
 
+    void flush() 
+        {
+            _traj->flush();
+        }
+
 private:
     bool _first_frame;
     bool _renum;
@@ -319,5 +328,6 @@ int main(int argc, char *argv[])
 	    output->writeFrame(outgroup);
 	}
     }
-    
+
+    output->flush();
 }
@@ -239,4 +239,5 @@ int main(int argc, char *argv[]) {
     outtraj->writeFrame(frame);
 
   }
+  outtraj->flush();
 }
@@ -673,6 +673,7 @@ int main(int argc, char *argv[]) {
     if (verbose)
       slayer.update();
   }
+  trajout->flush();
 
   if (verbose)
     slayer.finish();
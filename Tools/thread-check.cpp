@@ -0,0 +1,233 @@
+/*
+  thread-check.cpp
+
+  Stress test for using LOOS from several threads at once
+*/
+
+
+
+/*
+
+  This file is part of LOOS.
+
+  LOOS (Lightweight Object-Oriented Structure library)
+  Copyright (c) 2008, Tod D. Romo
+  Department of Biochemistry and Biophysics
+  School of Medicine & Dentistry, University of Rochester
+
+  This package (LOOS) is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation under version 3 of the License.
+
+  This package is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <loos.hpp>
+#include <boost/thread/thread.hpp>
+#include <boost/thread/barrier.hpp>
+
+
+using namespace std;
+using namespace loos;
+
+
+// Each check runs a function in several threads at once and counts
+// the failures.  The thread number is passed to the function.
+
+uint failures = 0;
+boost::mutex failure_lock;
+
+void fail(const string& msg) {
+  boost::mutex::scoped_lock lock(failure_lock);
+  cerr << "FAILED- " << msg << endl;
+  ++failures;
+}
+
+
+template<class F>
+void runThreads(const uint n, F f) {
+  vector<boost::thread*> threads(n);
+  for (uint i=0; i<n; ++i)
+    threads[i] = new boost::thread([=]() {
+        try {
+          f(i);
+        }
+        catch (exception& e) {
+          fail(string("uncaught exception- ") + e.what());
+        }
+      });
+
+  for (uint i=0; i<n; ++i) {
+    threads[i]->join();
+    delete threads[i];
+  }
+}
+
+
+vector<uint> draws(base_generator_type& rng, const uint n) {
+  vector<uint> v(n);
+  for (uint i=0; i<n; ++i)
+    v[i] = rng();
+  return(v);
+}
+
+
+
+// Every thread draws from a generator derived from the process-wide
+// seed, and no two threads draw the same stream.  Workers that pick
+// their stream get the same numbers however the threads are scheduled.
+void checkRandom(const uint nthreads) {
+  const uint seed = 4242;
+  const uint ndraws = 100;
+
+  seedRNG(seed);
+  base_generator_type expected(seed);
+  if (draws(rng_singleton(), ndraws) != draws(expected, ndraws))
+    fail("main thread's generator does not follow seedRNG()");
+
+  vector< vector<uint> > streams(nthreads);
+  runThreads(nthreads, [&](const uint t) { streams[t] = draws(rng_singleton(), ndraws); });
+
+  for (uint i=0; i<nthreads; ++i) {
+    bool derived = false;
+    for (uint k=1; k<=nthreads + 1 && !derived; ++k) {
+      base_generator_type other(seed + 0x80000000u + k);
+      derived = (draws(other, ndraws) == streams[i]);
+    }
+    if (!derived)
+      fail("worker's generator is not derived from the seed");
+
+    for (uint j=0; j<i; ++j)
+      if (streams[i] == streams[j])
+        fail("two threads drew the same random stream");
+  }
+
+  // Numbered workers draw seed + stream, whichever thread runs first
+  runThreads(nthreads, [&](const uint t) {
+      setRNGStream(t + 1);
+      streams[t] = draws(rng_singleton(), ndraws);
+    });
+  for (uint t=0; t<nthreads; ++t) {
+    base_generator_type numbered(seed + t + 1);
+    if (draws(numbered, ndraws) != streams[t])
+      fail("worker's generator does not follow setRNGStream()");
+  }
+
+  // Threads that are already running pick up a new seed
+  vector< vector<uint> > before(nthreads), after(nthreads);
+  boost::barrier seeded(nthreads + 1), drawn(nthreads + 1);
+  vector<boost::thread*> threads(nthreads);
+  for (uint t=0; t<nthreads; ++t)
+    threads[t] = new boost::thread([&, t]() {
+        before[t] = draws(rng_singleton(), ndraws);
+        drawn.wait();
+        seeded.wait();
+        after[t] = draws(rng_singleton(), ndraws);
+      });
+
+  drawn.wait();
+  seedRNG(seed + 1000);
+  seeded.wait();
+  for (uint t=0; t<nthreads; ++t) {
+    threads[t]->join();
+    delete threads[t];
+  }
+
+  for (uint t=0; t<nthreads; ++t) {
+    if (before[t] == after[t])
+      fail("running thread did not pick up the new seed");
+    for (uint j=0; j<t; ++j)
+      if (after[t] == after[j])
+        fail("two threads drew the same random stream after reseeding");
+  }
+}
+
+
+// Settings are process-wide, whichever thread changes them
+void checkSettings(const uint nthreads) {
+  DCD::setSuppression(true);
+  runThreads(nthreads, [](const uint) {
+      if (!DCD::suppression())
+        fail("worker does not see DCD warning suppression set by the main thread");
+    });
+
+  runThreads(1, [](const uint) { DCD::setSuppression(false); });
+  if (DCD::suppression())
+    fail("main thread does not see DCD warning suppression cleared by a worker");
+}
+
+
+// Selections (including ones that don't parse) and trajectory reads
+// give the same results in every thread as they do serially
+void checkAnalysis(const uint nthreads, const string& model_name, const string& traj_name) {
+  const char* selections[] = { "name == 'CA'", "resid <= 10", "!hydrogen", "all", 0 };
+
+  AtomicGroup model = createSystem(model_name);
+  pTraj traj = createTrajectory(traj_name, model);
+
+  vector<uint> sizes;
+  for (uint i=0; selections[i]; ++i)
+    sizes.push_back(selectAtoms(model, selections[i]).size());
+
+  vector<GCoord> centroids;
+  while (traj->readFrame()) {
+    traj->updateGroupCoords(model);
+    centroids.push_back(model.centroid());
+  }
+
+  runThreads(nthreads, [&](const uint t) {
+      AtomicGroup mine = model.copy();
+      pTraj mytraj = createTrajectory(traj_name, mine);
+
+      for (uint pass=0; pass<5; ++pass) {
+        for (uint i=0; selections[i]; ++i)
+          if (selectAtoms(model, selections[i]).size() != sizes[i])
+            fail(string("selection differs in a thread- ") + selections[i]);
+
+        // The parser reports the error on stderr as well
+        if (pass == 0)
+          try {
+            selectAtoms(model, "name == 'CA' &&");
+            fail("bad selection was accepted");
+          }
+          catch (ParseError& e) { }
+
+        mytraj->rewind();
+        for (uint i=0; mytraj->readFrame(); ++i) {
+          mytraj->updateGroupCoords(mine);
+          if (mine.centroid().distance(centroids[i]) > 1e-6)
+            fail("trajectory frame differs in a thread");
+        }
+      }
+    });
+}
+
+
+
+
+int main(int argc, char *argv[]) {
+
+  if (argc < 3 || argc > 4) {
+    cerr << "Usage- thread-check model trajectory [threads]\n"
+         << "Runs LOOS from several threads at once and checks the results\n";
+    exit(-1);
+  }
+
+  uint nthreads = argc == 4 ? strtoul(argv[3], 0, 10) : 8;
+
+  checkRandom(nthreads);
+  checkSettings(nthreads);
+  checkAnalysis(nthreads, argv[1], argv[2]);
+
+  if (failures) {
+    cerr << failures << " check(s) failed\n";
+    exit(-2);
+  }
+  cout << "All thread checks passed\n";
+}
@@ -37,6 +37,8 @@
 
 #include <loos.hpp>
 #include <boost/format.hpp>
+#include <boost/algorithm/string.hpp>
+#include <boost/thread/thread.hpp>
 
 using namespace std;
 using namespace loos;
@@ -52,6 +54,8 @@ string fullHelpMessage(void) {
     "DESCRIPTION\n"
     "\n"
     "\tConvert any LOOS-supported trajectory format into a DCD trajectory.\n"
+    "If the input is already a DCD, the frames are copied without being\n"
+    "decoded (converting to native byte-order) and the original header is kept.\n"
     "\n"
     "EXAMPLES\n"
     "\n"
@@ -74,6 +78,21 @@ int main(int argc, char *argv[]) {
   }
 
   AtomicGroup model = createSystem(argv[1]);
+
+  // DCD to DCD is just a copy...
+  string suffix = boost::get<1>(splitFilename(argv[2]));
+  boost::to_lower(suffix);
+  if (suffix == "dcd") {
+    RawDCD input(argv[2]);
+    if (input.natoms() == model.size()) {
+      RawDCDWriter dcd(argv[3], input, RawDCDWriter::NATIVE);
+      dcd.copyFrames(input);
+      dcd.close();
+      cerr << boost::format("Copied %d frames.\n") % dcd.framesWritten();
+      exit(0);
+    }
+  }
+
   pTraj traj = createTrajectory(argv[2], model);
   uint n = traj->nframes();
 
@@ -87,14 +106,35 @@ int main(int argc, char *argv[]) {
   cerr << "Processing - ";
   cerr.flush();
 
-  for (uint i=0; i<n; ++i) {
-    if (i % 250 == 0)
+  // Fixed-width Amber trajectories are read a block of frames at a
+  // time, with the block parsed in parallel
+  boost::shared_ptr<AmberTraj> amber = boost::dynamic_pointer_cast<AmberTraj>(traj);
+  if (amber && amber->isFixedWidth()) {
+    const uint nblock = 250;
+    uint nthreads = boost::thread::hardware_concurrency();
+    vector< vector<GCoord> > frames;
+    vector<GCoord> boxes;
+    for (uint i=0; i<n; i += nblock) {
       cerr << '.';
-    traj->readFrame(i);
-    traj->updateGroupCoords(model);
-    dcd.writeFrame(model);
-  }
-  
+      uint m = min(nblock, n - i);
+      amber->readFrames(i, m, frames, boxes, nthreads);
+      for (uint k=0; k<m; ++k) {
+        for (uint j=0; j<model.size(); ++j)
+          model[j]->coords(frames[k][model[j]->index()]);
+        if (amber->hasPeriodicBox())
+          model.periodicBox(boxes[k]);
+        dcd.writeFrame(model);
+      }
+    }
+  } else
+    for (uint i=0; i<n; ++i) {
+      if (i % 250 == 0)
+        cerr << '.';
+      traj->readFrame(i);
+      traj->updateGroupCoords(model);
+      dcd.writeFrame(model);
+    }
+
   cerr << " done\n";
 }
 
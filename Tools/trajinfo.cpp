@@ -39,7 +39,7 @@ namespace opts = loos::OptionsFramework;
 
 string model_name, traj_name;
 bool box_info = false;
-bool centroid = false;
+bool centroid_info = false;
 bool file_is_corrupt = false;
 
 string fullHelpMessage(void)
@@ -62,6 +62,9 @@ string s =
     "\tPeriodic box (yes/no)\n"
     "\n"
     "The --box option also reports the box size\n"
+    "With --brief=1 and --verify=0, only the trajectory\n"
+    "metadata is probed (no coordinates are read), which\n"
+    "is much faster for formats that support it.\n"
     "The --centroid option takes a selection string\n"
     "and returns the average +- standard deviation \n"
     "of this selection across the trajectory.\n"
@@ -269,8 +272,15 @@ void verbInfo(AtomicGroup& model, pTraj& traj, AtomicGroup& center, const bool c
 }
 
 
+// The brief line is the same whether the metadata came from reading
+// the trajectory or from probing it
+void briefLine(const TrajectoryInfo& info) {
+  cout << info.natoms << " " << info.nframes << " " << info.timestep << " " << info.periodic << endl;
+}
+
+
 void briefInfo(pTraj& traj, const bool verify = true) {
-  cout << traj->natoms() << " " << traj->nframes() << " " << traj->timestep() << " " << traj->hasPeriodicBox() << endl;
+  briefLine(trajectoryInfoFrom(*traj));
   if (verify)
     verifyFrames(traj);
 }
@@ -282,7 +292,7 @@ void briefInfo(pTraj& traj, const bool verify = true) {
 int main(int argc, char *argv[]) {
 
   opts::BasicOptions* bopts = new opts::BasicOptions(fullHelpMessage());
-  opts::BasicTrajectory* tropts = new opts::BasicTrajectory;
+  opts::BasicTrajectory* tropts = new opts::BasicTrajectory(false);
   ToolOptions* topts = new ToolOptions;
 
   opts::AggregateOptions options;
@@ -295,20 +305,30 @@ int main(int argc, char *argv[]) {
     cerr << "Warning:  --skip is ignored by this tool\n";
 
   box_info = topts->box_info;
-  centroid = !topts->centroid_selection.empty();
+  centroid_info = !topts->centroid_selection.empty();
 
   AtomicGroup model = tropts->model;
-  pTraj traj = tropts->trajectory;
-
-  if (model.size() != traj->natoms())
-    cerr << boost::format("WARNING- the trajectory has %d atoms but the system defines %d\n") % traj->natoms() % model.size();
 
   // Export names for subsequent functions
   model_name = tropts->model_name;
   traj_name = tropts->traj_name;
 
+  // Metadata only...no frames are read
+  if (topts->brief && !topts->verify) {
+    TrajectoryInfo info = tropts->probe();
+    if (model.size() != info.natoms)
+      cerr << boost::format("WARNING- the trajectory has %d atoms but the system defines %d\n") % info.natoms % model.size();
+    briefLine(info);
+    exit(0);
+  }
+
+  pTraj traj = tropts->openTrajectory();
+
+  if (model.size() != traj->natoms())
+    cerr << boost::format("WARNING- the trajectory has %d atoms but the system defines %d\n") % traj->natoms() % model.size();
+
   AtomicGroup center;
-  if (centroid)
+  if (centroid_info)
     center = selectAtoms(model, topts->centroid_selection);
 
   if (!topts->brief)
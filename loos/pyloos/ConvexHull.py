@@ -3,17 +3,6 @@
 import loos
 import numpy
 
-try:
-    from scipy.spatial import ConvexHull as CH
-except ImportError:
-    import sys
-    print("""
-    Failure importing scipy, needed for ConvexHull calculations
-    You either need to install scipy or adjust your PYTHONPATH
-    to point to it.
-    """)
-    sys.exit(1)
-
 
 class ZSliceSelector:
 
@@ -42,6 +31,13 @@ def test_side(p, p0, p1):
 
 
 class ConvexHull:
+    """
+    Convex hull of an AtomicGroup projected onto the xy-plane.
+
+    The hull itself is computed by loos.ConvexHull2D, so membership
+    tests for many points can be done in one call with inside_flags()
+    or count_inside() rather than looping over is_inside().
+    """
 
     def __init__(self, atomicgroup):
         self.atoms = atomicgroup
@@ -56,34 +52,13 @@ class ConvexHull:
         self.atoms = atomicgroup
 
     def generate_hull(self):
-        points = []
-        for a in self.atoms:
-            points.append([a.coords().x(), a.coords().y()])
-
-        points = numpy.array(points)
-        self.hull = CH(points)
+        self.hull = loos.ConvexHull2D(self.atoms)
 
     def generate_vertices(self):
-        n = self.hull.simplices
-        sorted_neighbors = []
-        sorted_neighbors.append(n[0][0])
-        sorted_neighbors.append(n[0][1])
-        prev_entered = n[0][0]
-        last_entered = n[0][1]
-        num_simplices = len(self.hull.simplices)
-        while (len(sorted_neighbors) < num_simplices):
-            # search neighbor list to find the one with the current simplex
-            # add its pair to the list
-            last_entered = sorted_neighbors[-1]
-            prev_entered = sorted_neighbors[-2]
-            for i in range(len(n)):
-                if ((n[i][0] == last_entered) and (n[i][1] != prev_entered)):
-                    sorted_neighbors.append(n[i][1])
-                    break
-                if ((n[i][1] == last_entered) and (n[i][0] != prev_entered)):
-                    sorted_neighbors.append(n[i][0])
-                    break
-        self.vertices = sorted_neighbors
+        """
+        Stores the indices of the atoms on the hull, in counter-clockwise order
+        """
+        self.vertices = list(self.hull.vertices())
 
     def atom(self, index):
         return self.atoms[int(index)]
@@ -91,29 +66,31 @@ class ConvexHull:
     def coords(self, index):
         return self.atoms[int(index)].coords()
 
+    def area(self):
+        return self.hull.area()
+
     def is_inside(self, p):
         """
         Returns true if p (a GCoord) is inside the hull
         """
-        match = True
-        side = test_side(p, self.coords(self.vertices[0]),
-                         self.coords(self.vertices[1]))
-        prev_side = side
-        for i in range(1, len(self.vertices) - 1):
-            side = test_side(p, self.coords(self.vertices[i]),
-                             self.coords(self.vertices[i + 1]))
-            match = (((side >= 0) and (prev_side >= 0)) or
-                     ((side <= 0) and (prev_side <= 0)))
-            if not match:
-                return False
-            prev_side = side
-
-        # test the closing line segment
-        side = test_side(p, self.coords(self.vertices[-1]),
-                         self.coords(self.vertices[0]))
-        match = (((side >= 0) and (prev_side >= 0)) or
-                 ((side <= 0) and (prev_side <= 0)))
-        return match
+        return self.hull.isInside(p)
+
+    def inside_flags(self, points):
+        """
+        Returns a boolean array that is true for each row of points
+        (an n x 2 or n x 3 numpy array) that is inside the hull
+        """
+        points = numpy.ascontiguousarray(points, dtype=numpy.float64)
+        return self.hull.classify(points).astype(bool)
+
+    def count_inside(self, points):
+        """
+        Returns the number of points (an n x 2 or n x 3 numpy array, or
+        an AtomicGroup) that are inside the hull
+        """
+        if isinstance(points, loos.AtomicGroup):
+            return self.hull.countInside(points)
+        return int(numpy.count_nonzero(self.inside_flags(points)))
 
 
 if __name__ == '__main__':
@@ -137,3 +114,4 @@ if __name__ == '__main__':
     print(hull.is_inside(loos.GCoord(0.0, 0.0, 0.0)))
     print(hull.is_inside(loos.GCoord(20.0, 0.0, 0.0)))
     print(hull.is_inside(loos.GCoord(0.0, 20.0, 0.0)))
+    print(hull.count_inside(ag.getCoords()))
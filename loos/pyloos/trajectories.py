@@ -17,6 +17,11 @@ import copy
 # stride=n   | Step through the wrapped trajectory n-frames at a time
 # iterator=i | Use the python iterator object i to select frames from the wrapped trajectory
 # subset=s   | Use 's' to select a subset of the model to use for each frame
+# prefetch=b | If b is True, read the next frame in the background while the current one is used
+#
+# The frame selection, per-frame updates, and prefetching are handled
+# by a native loos.TrajectoryIterator, so iterating over a Trajectory
+# adds very little overhead to each frame.
 #
 # Remember that all atoms are shared.  If you want to decouple the
 # trajectory from other groups, pass it a copy of the model.
@@ -51,6 +56,14 @@ import copy
 # traj = loos.pyloos.Trajectory('foo.dcd', model.copy())
 # \endcode
 #
+# Keep up to 256 MB of decoded frames in memory when frames are
+# revisited (e.g. bootstrapping or shuffling a VirtualTrajectory),
+# \code
+# traj = loos.pyloos.Trajectory('foo.xtc', model, cache=256)
+# ...
+# print(traj.trajectory().hitRate())
+# \endcode
+#
 
 class Trajectory(object):
     """
@@ -63,6 +76,8 @@ class Trajectory(object):
       stride = # of frames to step through
     iterator = Python iterator used to pick frame (overrides skip and stride)
       subset = Selection used to pick subset for each frame
+    prefetch = Read the next frame in the background (default is False)
+       cache = Keep up to this many megabytes of decoded frames in memory
 
     See the Doxygen documentation for more details.
     """
@@ -73,6 +88,7 @@ class Trajectory(object):
         self._skip = 0
         self._stride = 1
         self._iterator = None
+        self._prefetch = False
 
         if 'skip' in kwargs:
             self._skip = kwargs['skip']
@@ -80,6 +96,8 @@ class Trajectory(object):
             self._stride = kwargs['stride']
         if 'iterator' in kwargs:
             self._iterator = kwargs['iterator']
+        if 'prefetch' in kwargs:
+            self._prefetch = kwargs['prefetch']
         if 'subset' in kwargs:
             self._subset = loos.selectAtoms(model, kwargs['subset'])
         else:
@@ -88,35 +106,56 @@ class Trajectory(object):
         self._model = model
         self._fname = fname
         self._traj = loos.createTrajectory(fname, model)
+        if 'cache' in kwargs and kwargs['cache']:
+            self._traj = loos.CachedTrajectory(self._traj, int(kwargs['cache'] * 1024 * 1024))
 
         self._stale = 1
         self._initFrameList()
 
 
     def _initFrameList(self):
-        self._framelist = []
         if self._iterator is None:
             it = range(self._skip, self._traj.nframes(), self._stride)
         else:
             it = iter(self._iterator)
+        self._framelist = list(it)
+        self._stale = 0
 
-        for i in it:
-            self._framelist.append(i)
+        # The frame list, subset, and per-frame reads are all handled
+        # by the native iterator
+        self._native = loos.TrajectoryIterator()
+        self._addTo(self._native)
+        self._native.prefetch(self._prefetch)
 
-        self._index = 0
-        self._stale = 0
+    def _addTo(self, native):
+        """
+        Add this trajectory as a source to a native loos.TrajectoryIterator
+        """
+        if self._stale:
+            self._initFrameList()
+        native.append(self._traj, self._model, self._subset, loos.UIntVector(self._framelist))
 
     def stride(self, n):
         """
         Step through the trajectory by this number of frames
         """
         self._stride = n
+        self._stale = 1
 
     def skip(self, n):
         """
         Skip this number of frames at the start of the trajectory
         """
         self._skip = n
+        self._stale = 1
+
+    def prefetch(self, flag):
+        """
+        Read the next frame in a background thread while the current one is used
+        """
+        self._prefetch = flag
+        if not self._stale:
+            self._native.prefetch(flag)
 
     def fileName(self):
         """
@@ -130,13 +169,15 @@ class Trajectory(object):
         The selection is a LOOS selection string.
         """
         self._subset = loos.selectAtoms(self._model, selection)
+        if not self._stale:
+            self._native.setSubset(0, self._subset)
 
 
     def __iter__(self):
         if self._stale:
             self._initFrameList()
-        self._index = 0
-        return(self)
+        self._native.reset()
+        return(self._native)
 
     def __len__(self):
         """
@@ -149,15 +190,14 @@ class Trajectory(object):
 
     def reset(self):
         """Reset the iterator"""
-        self._index = 0
+        if self._stale:
+            self._initFrameList()
+        self._native.reset()
 
     def __next__(self):
-        if (self._index >= len(self._framelist)):
-            raise StopIteration
-        frame = self.__getitem__(self._index)
-
-        self._index += 1
-        return(frame)
+        if self._stale:
+            self._initFrameList()
+        return(self._native.__next__())
 
 
     def trajectory(self):
@@ -174,9 +214,7 @@ class Trajectory(object):
             self._initFrameList()
         if (i < 0 or i >= len(self._framelist)):
             raise IndexError
-        self._traj.readFrame(self._framelist[i])
-        self._traj.updateGroupCoords(self._model)
-        return(self._subset)
+        return(self._native.readFrame(i))
 
     def frame(self):
         """Return the current frame (subset)"""
@@ -186,11 +224,13 @@ class Trajectory(object):
         """The 'real' frame in the trajectory for this index"""
         if self._stale:
             self._initFrameList()
-        return(self._framelist[self._index-1])
+        return(self._framelist[self._native.index()])
 
     def index(self):
         """The state of the iterator"""
-        return(self._index-1)
+        if self._stale:
+            self._initFrameList()
+        return(self._native.index())
 
 
     def frameNumber(self, i):
@@ -224,10 +264,7 @@ class Trajectory(object):
         indices = list(range(*s.indices(self.__len__())))
         ensemble = []
         for i in indices:
-            self._traj.readFrame(self._framelist[i])
-            self._traj.updateGroupCoords(self._model)
-            dup = self._subset.copy()
-            ensemble.append(dup)
+            ensemble.append(self._native.readFrame(i).copy())
         return(ensemble)
 
 
@@ -243,11 +280,7 @@ class Trajectory(object):
             i += len(self._framelist)
         if (i >= len(self._framelist) or i < 0):
             raise IndexError
-        self._traj.readFrame(self._framelist[i])
-        self._traj.updateGroupCoords(self._model)
-        return(self._subset)
-
-
+        return(self._native.readFrame(i))
 
 ## Virtual trajectory composed of multiple Trajectory objects
 # This class can combine multiple loos.pyloos.Trajectory objects
@@ -261,6 +294,7 @@ class Trajectory(object):
 # skip=n     | Skip the first n-frames of the virtual trajectory
 # stride=n   | Step through the virtual trajectory n frames at a time
 # iterator=i | Use the python iterator object i to select frames from the virtual trajectory
+# prefetch=b | If b is True, read the next frame in the background while the current one is used
 #
 # There is no requirement that the subsets used for all trajectories
 # must be the same.  Ideally, the frame (subset) that is returned
@@ -309,6 +343,7 @@ class VirtualTrajectory(object):
             skip = # of frames to skip at start of composite traj
           stride = # of frames to step through in the composite traj
         iterator = Python iterator used to pick frames from the composite traj
+        prefetch = Read the next frame in the background (default is False)
 
     See the Doxygen documentation for more details.
     """
@@ -319,11 +354,9 @@ class VirtualTrajectory(object):
         self._stride = 1
         self._nframes = 0
         self._iterator = None
+        self._prefetch = False
         self._trajectories = list(trajs)
-
-        self._index = 0
-        self._framelist = []
-        self._trajlist = []
+        self._native = None
         self._stale = 1
 
         if 'skip' in kwargs:
@@ -332,6 +365,8 @@ class VirtualTrajectory(object):
             self._stride = kwargs['stride']
         if 'iterator' in kwargs:
             self._iterator = kwargs['iterator']
+        if 'prefetch' in kwargs:
+            self._prefetch = kwargs['prefetch']
         if 'subset' in kwargs:
             self.setSubset(kwargs['subset'])
 
@@ -395,6 +430,15 @@ class VirtualTrajectory(object):
         """
         for t in self._trajectories:
             t.setSubset(selection)
+        self._stale = 1
+
+    def prefetch(self, flag):
+        """
+        Read the next frame in a background thread while the current one is used
+        """
+        self._prefetch = flag
+        if not self._stale:
+            self._native.prefetch(flag)
 
     def frame(self):
         """
@@ -404,20 +448,15 @@ class VirtualTrajectory(object):
         if self._stale:
             self._initFrameList()
 
-        if self._index >= len(self._framelist):
-            i = len(self._framelist) - 1
-        else:
-            i = self._index
-
-        return(self._trajectories[self._trajlist[i]].frame())
+        return(self._native.frame())
 
     def index(self):
         """
         Return index into composite trajectory for current frame
         """
-        return(self._index-1)
-
-
+        if self._stale:
+            self._initFrameList()
+        return(self._native.index())
 
     ## Returns information about the ith frame in the VirtualTrajectory
     # The tuple returned has the following format:
@@ -459,32 +498,23 @@ class VirtualTrajectory(object):
             self._initFrameList()
 
         if (i < 0):
-            i += len(self._framelist)
+            i += len(self)
 
-        t = self._trajectories[self._trajlist[i]]
-        return( self._framelist[i], self._trajlist[i], t, t.frameNumber(self._framelist[i]))
+        loc = self._native.location(i)
+        t = self._trajectories[loc[0]]
+        return( loc[1], loc[0], t, t.frameNumber(loc[1]))
 
     def _initFrameList(self):
-        frames = []
-        trajs = []
-        for j in range(len(self._trajectories)):
-            t = self._trajectories[j]
-            for i in range(len(t)):
-                frames.append(i)
-                trajs.append(j)
-
-        self._framelist = []
-        self._trajlist = []
-        n = len(frames)
+        self._native = loos.TrajectoryIterator()
+        for t in self._trajectories:
+            t._addTo(self._native)
+
         if (self._iterator is None):
-            it = iter(range(self._skip, n, self._stride))
+            self._native.setFrames(self._skip, self._stride)
         else:
-            it = iter(iterator)
-        for i in it:
-            self._framelist.append(frames[i])
-            self._trajlist.append(trajs[i])
+            self._native.setFrameList(loos.UIntVector(list(self._iterator)))
 
-        self._index = 0
+        self._native.prefetch(self._prefetch)
         self._stale = 0
 
     def __len__(self):
@@ -493,7 +523,7 @@ class VirtualTrajectory(object):
         """
         if self._stale:
             self._initFrameList()
-        return(len(self._framelist))
+        return(len(self._native))
 
 
     def __getitem__(self, i):
@@ -510,40 +540,35 @@ class VirtualTrajectory(object):
 
         if (i < 0):
             i += len(self)
-        if (i >= len(self)):
+        if (i >= len(self) or i < 0):
             raise IndexError
 
-        return(self._trajectories[self._trajlist[i]][self._framelist[i]])
+        return(self._native.readFrame(i))
 
 
     def __iter__(self):
         if self._stale:
             self._initFrameList()
-        self._index = 0
-        return(self)
+        self._native.reset()
+        return(self._native)
 
     def reset(self):
-        self._index = 0
+        if self._stale:
+            self._initFrameList()
+        self._native.reset()
 
     def __next__(self):
         if self._stale:
             self._initFrameList()
-        if (self._index >= len(self._framelist)):
-            raise StopIteration
-        frame = self.__getitem__(self._index)
-        self._index += 1
-        return(frame)
+        return(self._native.__next__())
 
     def _getSlice(self, s):
         indices = list(range(*s.indices(self.__len__())))
         ensemble = []
         for i in indices:
-            frame = self._trajectories[self._trajlist[i]][self._framelist[i]].copy()
-            ensemble.append(frame)
+            ensemble.append(self._native.readFrame(i).copy())
         return(ensemble)
 
-
-
 ## A virtual trajectory that supports iterative alignment.
 # Only the
 # transformation needed to align each frame is stored.  When a frame
@@ -632,17 +657,7 @@ class AlignedVirtualTrajectory(VirtualTrajectory):
         """
         Add another trajectory at the end.  Requires re-aligning
         """
-        # make sure we're appending only Trajectory objects
-        if isinstance(traj, tuple):
-            for t in traj:
-                if not isinstance(t, loos.pyloos.trajectories.Trajectory):
-                    raise TypeError("Inputs to VirtualTrajectory must be pyloos Trajectory objects")
-        else:
-            if not isinstance(traj, loos.pyloos.trajectories.Trajectory):
-                    raise TypeError("Inputs to VirtualTrajectory must be pyloos Trajectory objects")
-
-        self._trajectories.extend(traj)
-        self._stale = True
+        super(AlignedVirtualTrajectory, self).append(*traj)
         self._aligned = False
 
     def alignWith(self, selection):
@@ -654,57 +669,39 @@ class AlignedVirtualTrajectory(VirtualTrajectory):
 
 
     def __iter__(self):
-        self._align()
-        self._index = 0
-        return(self)
+        if not self._aligned or self._stale:
+            self._align()
+        self._native.reset()
+        return(self._native)
 
 
     def setReference(self, reference):
         self._reference = copy.deepcopy(reference)
         self._aligned = False
 
+    def _initFrameList(self):
+        super(AlignedVirtualTrajectory, self)._initFrameList()
+        self._aligned = False
+
     def _align(self):
         """
         Align the frames (called implicitly on iterator or array access)
         """
-        current_traj = None
-        current_subset = None
-        ensemble = []
-
         if self._stale:
             self._initFrameList()
 
+        # The transforms are computed (and applied to each frame as it
+        # is read) by the native iterator
+        self._native.alignWith(self._alignwith)
         if self._reference:       # Align to a reference structure
-            self._xformlist = []
-            for i in range(len(self._framelist)):
-                t = self._trajectories[self._trajlist[i]]
-                if t != current_traj:
-                    current_traj = t
-                    current_subset = loos.selectAtoms(t.model(), self._alignwith)
-                t.readFrame(self._framelist[i])
-                m = current_subset.superposition(self._reference)
-                x = loos.XForm()
-                x.load(m)
-                self._xformlist.append(x)
-
-            self._rmsd = 0.0
-            self._iters = 0
-
+            self._native.setReference(self._reference)
         else:                      # Iterative alignment
+            self._native.setReference(loos.AtomicGroup())
+        self._native.align()
 
-            ensemble = loos.DoubleVectorMatrix()
-
-            for i in range(len(self._framelist)):
-                t = self._trajectories[self._trajlist[i]]
-                if t != current_traj:
-                    current_traj = t
-                    current_subset = loos.selectAtoms(t.model(), self._alignwith)
-                t.readFrame(self._framelist[i])
-                ensemble.push_back(current_subset.coordsAsVector())
-
-            result = loos.iterativeAlignmentPy(ensemble)
-            (self._xformlist, self._rmsd, self._iters) = (loos.xformVectorToList(result.transforms), result.rmsd, result.iterations)
-
+        self._xformlist = loos.xformVectorToList(self._native.transforms())
+        self._rmsd = self._native.alignmentRMSD()
+        self._iters = self._native.alignmentIterations()
         self._aligned = True
 
 
@@ -716,13 +713,9 @@ class AlignedVirtualTrajectory(VirtualTrajectory):
 
 
     def _getSlice(self, s):
-        indices = list(range(*s.indices(self.__len__())))
-        ensemble = []
-        for i in indices:
-            frame = self._trajectories[self._trajlist[i]][self._framelist[i]].copy()
-            frame.applyTransform(self._xformlist[i])
-            ensemble.append(frame)
-        return(ensemble)
+        if not self._aligned or self._stale:
+            self._align()
+        return(super(AlignedVirtualTrajectory, self)._getSlice(s))
 
 
     def __getitem__(self, i):
@@ -730,17 +723,7 @@ class AlignedVirtualTrajectory(VirtualTrajectory):
         Returns the ith frame aligned.  Supports Python slices.  Negative indices are relative
         to the end of the composite trajectory.
         """
-        if not self._aligned:
+        if not self._aligned or self._stale:
             self._align()
 
-        if isinstance(i, slice):
-            return(self._getSlice(i))
-
-        if (i < 0):
-            i += len(self._framelist)
-        if (i >= len(self._framelist)):
-            raise IndexError
-
-        frame = self._trajectories[self._trajlist[i]][self._framelist[i]]
-        frame.applyTransform(self._xformlist[i])
-        return(frame)
+        return(super(AlignedVirtualTrajectory, self).__getitem__(i))
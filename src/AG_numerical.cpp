@@ -274,11 +274,15 @@ namespace loos {
     std::vector<GCoord> crds(atoms.size());
     const_iterator i;
     GMatrix W = M.current();
+    bool affine = isAffine(W);
     int j = 0;
 
     for (i = atoms.begin(); i != atoms.end(); i++) {
-      GCoord res = W * (*i)->coords();
-      crds[j++] = res;
+      if (affine) {
+        crds[j] = (*i)->coords();
+        affineTransform(W, crds[j++]);
+      } else
+        crds[j++] = W * (*i)->coords();
     }
 
     return(crds);
@@ -291,23 +295,38 @@ namespace loos {
           (*i)->coords() += v;
   }
 
+  // Transforms are almost always affine, in which case only the
+  // upper 3x4 of the matrix is needed...
   void AtomicGroup::applyTransform(const XForm& M) {
     iterator i;
     GMatrix W = M.current();
 
-    for (i = atoms.begin(); i != atoms.end(); i++)
-      (*i)->coords() = W * (*i)->coords();
+    if (isAffine(W))
+      for (i = atoms.begin(); i != atoms.end(); i++)
+        affineTransform(W, (*i)->coords());
+    else
+      for (i = atoms.begin(); i != atoms.end(); i++)
+        (*i)->coords() = W * (*i)->coords();
+
+  }
+
 
+  void AtomicGroup::applyTransform(const std::vector<XForm>& xforms, std::vector<double>& frames) const {
+    const uint n = 3 * size();
+    if (frames.size() != n * xforms.size())
+      throw(LOOSError("Number of transforms does not match the number of frames in AtomicGroup::applyTransform()"));
+
+    for (uint j=0; j<xforms.size(); ++j)
+      xforms[j].transform(&frames[j*n], &frames[j*n], size());
   }
 
 
   void AtomicGroup::rotate(const GCoord& axis, const greal angle_in_degrees) {
-    XForm M;
+    XForm R;
+    R.rotate(axis, -angle_in_degrees);
 
     GCoord center = centroid();
-    M.translate(center);
-    M.rotate(axis, -angle_in_degrees);
-    M.translate(-center);
+    XForm M(centerRotateTranslate(R.current(), center, center));
     applyTransform(M);
   }
 
@@ -347,19 +366,20 @@ namespace loos {
   // Returns a newly allocated array of double coords in row-major order
   // transformed by the current transformation.
   double* AtomicGroup::transformedCoordsAsArray(const XForm& M) const {
-    double *A;
-    GCoord x;
-    int n = size();
+    double *A = coordsAsArray();
     GMatrix W = M.current();
 
-    A = new double[n*3];
-    int k = 0;
-    int i;
-    for (i=0; i<n; i++) {
-      x = W * atoms[i]->coords();
-      A[k++] = x.x();
-      A[k++] = x.y();
-      A[k++] = x.z();
+    if (isAffine(W))
+      affineTransform(W, A, A, size());
+    else {
+      GCoord x;
+      int k = 0;
+      for (uint i=0; i<size(); i++) {
+        x = W * atoms[i]->coords();
+        A[k++] = x.x();
+        A[k++] = x.y();
+        A[k++] = x.z();
+      }
     }
 
     return(A);
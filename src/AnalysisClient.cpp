@@ -0,0 +1,284 @@
+/*
+  This file is part of LOOS.
+
+  LOOS (Lightweight Object-Oriented Structure library)
+  Copyright (c) 2008, Tod D. Romo, Alan Grossfield
+  Department of Biochemistry and Biophysics
+  School of Medicine & Dentistry, University of Rochester
+
+  This package (LOOS) is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation under version 3 of the License.
+
+  This package is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <set>
+
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <AnalysisClient.hpp>
+#include <exceptions.hpp>
+
+
+namespace loos {
+
+  using namespace internal;
+
+
+  namespace {
+
+    // Selects atoms by identity
+    struct AtomSet : public AtomSelector {
+      bool operator()(const pAtom& atom) const { return(atoms.count(atom.get()) != 0); }
+
+      std::set<const Atom*> atoms;
+    };
+
+
+    // The server opens files from its own working directory, so paths
+    // are made absolute here.  The directory is canonicalized, so the
+    // same file always gives the server the same cache key, but the
+    // file name is kept as given since the server picks the format
+    // from its suffix (which resolving a symlink could change).
+    std::string canonicalPath(const std::string& path) {
+      if (path.empty())
+        return(path);
+
+      std::string::size_type k = path.rfind('/');
+      std::string dir = (k == std::string::npos) ? "." : path.substr(0, k);
+      std::string base = (k == std::string::npos) ? path : path.substr(k + 1);
+      if (dir.empty())
+        dir = "/";
+
+      char* resolved = realpath(dir.c_str(), 0);
+      if (!resolved)
+        throw(FileOpenError(path, strerror(errno), errno));
+      std::string canonical(resolved);
+      free(resolved);
+
+      if (canonical[canonical.size() - 1] != '/')
+        canonical += '/';
+      return(canonical + base);
+    }
+
+  }
+
+
+  namespace internal {
+
+    AnalysisConnection::AnalysisConnection(const std::string& path) {
+      struct sockaddr_un addr;
+      if (path.size() >= sizeof(addr.sun_path))
+        throw(AnalysisServerError("Socket path is too long: " + path));
+
+      memset(&addr, 0, sizeof(addr));
+      addr.sun_family = AF_UNIX;
+      strncpy(addr.sun_path, path.c_str(), sizeof(addr.sun_path) - 1);
+
+      _fd = socket(AF_UNIX, SOCK_STREAM, 0);
+      if (_fd < 0)
+        throw(AnalysisServerError(std::string("Cannot create socket: ") + strerror(errno)));
+
+      if (connect(_fd, reinterpret_cast<struct sockaddr*>(&addr), sizeof(addr)) < 0) {
+        std::string msg = strerror(errno);
+        close(_fd);
+        throw(AnalysisServerError("Cannot connect to analysis server at " + path + ": " + msg));
+      }
+    }
+
+
+    AnalysisConnection::~AnalysisConnection() {
+      close(_fd);
+    }
+
+
+    MessageBuffer& AnalysisConnection::transact(const MessageBuffer& request) {
+      if (!sendMessage(_fd, request) || !receiveMessage(_fd, _reply))
+        throw(AnalysisServerError("Lost connection to analysis server"));
+
+      if (_reply.get<uint>() != 0)
+        throw(AnalysisServerError("Analysis server- " + _reply.getString()));
+
+      return(_reply);
+    }
+
+  }
+
+
+
+  AnalysisClient::AnalysisClient(const std::string& path)
+    : _conn(new AnalysisConnection(path))
+  { }
+
+
+  bool AnalysisClient::ping() {
+    MessageBuffer request;
+    request.put<uint>(ANALYSIS_PING);
+    MessageBuffer& reply = _conn->transact(request);
+
+    return(reply.get<uint>() == analysis_protocol_version);
+  }
+
+
+  AtomicGroup AnalysisClient::createSystem(const std::string& name, const std::string& type,
+                                           const std::string& coords, const bool require_coords) {
+    MessageBuffer request;
+    request.put<uint>(ANALYSIS_SYSTEM);
+    request.put(canonicalPath(name));
+    request.put(type);
+    request.put(canonicalPath(coords));
+    request.put<unsigned char>(require_coords);
+
+    return(_conn->transact(request).getAtomicGroup());
+  }
+
+
+  pTraj AnalysisClient::createTrajectory(const std::string& name, const std::string& type,
+                                         const std::string& model_name, const std::string& model_type,
+                                         const std::string& coords) {
+    MessageBuffer request;
+    request.put<uint>(ANALYSIS_TRAJECTORY);
+    request.put(canonicalPath(name));
+    request.put(type);
+    request.put(canonicalPath(model_name));
+    request.put(model_type);
+    request.put(canonicalPath(coords));
+
+    MessageBuffer& reply = _conn->transact(request);
+    uint id = reply.get<uint>();
+    std::string description = reply.getString();
+    uint natoms = reply.get<uint>();
+    uint nframes = reply.get<uint>();
+    float timestep = reply.get<float>();
+    bool periodic = reply.get<unsigned char>();
+
+    return(pTraj(new RemoteTrajectory(_conn, name, id, description, natoms, nframes, timestep, periodic)));
+  }
+
+
+  AtomicGroup AnalysisClient::selectAtoms(const AtomicGroup& model, const std::string& model_name, const std::string& model_type,
+                                          const std::string& coords, const std::string& selection) {
+    MessageBuffer request;
+    request.put<uint>(ANALYSIS_SELECT);
+    request.put(canonicalPath(model_name));
+    request.put(model_type);
+    request.put(canonicalPath(coords));
+    request.put(selection);
+
+    MessageBuffer& reply = _conn->transact(request);
+    std::vector<uint> indices(reply.get<uint>());
+    reply.getArray(indices.data(), indices.size());
+
+    // Selecting through the model keeps the periodic box shared, as
+    // with loos::selectAtoms()
+    AtomSet selector;
+    for (std::vector<uint>::const_iterator i = indices.begin(); i != indices.end(); ++i) {
+      if (*i >= model.size())
+        throw(AnalysisServerError("Selection from analysis server does not match the model"));
+      selector.atoms.insert(model[*i].get());
+    }
+
+    return(model.select(selector));
+  }
+
+
+  std::string AnalysisClient::statistics() {
+    MessageBuffer request;
+    request.put<uint>(ANALYSIS_STATS);
+    return(_conn->transact(request).getString());
+  }
+
+
+  void AnalysisClient::shutdown() {
+    MessageBuffer request;
+    request.put<uint>(ANALYSIS_SHUTDOWN);
+    _conn->transact(request);
+  }
+
+
+
+  RemoteTrajectory::RemoteTrajectory(const pAnalysisConnection& conn, const std::string& fname,
+                                     const uint id, const std::string& description,
+                                     const uint natoms, const uint nframes, const float timestep, const bool periodic)
+    : _conn(conn), _id(id), _description(description), _natoms(natoms), _nframes(nframes),
+      _timestep(timestep), _periodic(periodic), _next(0), _block_size(64), _block_first(0)
+  {
+    _filename = fname;
+    if (_nframes) {
+      parseFrame();
+      cached_first = true;
+    }
+  }
+
+
+  void RemoteTrajectory::fetch(const uint first) {
+    MessageBuffer request;
+    request.put<uint>(ANALYSIS_FRAMES);
+    request.put<uint>(_id);
+    request.put<uint>(first);
+    request.put<uint>(_block_size);
+
+    MessageBuffer& reply = _conn->transact(request);
+    uint n = reply.get<uint>();
+    _block.resize(n);
+    _block_boxes.resize(n);
+
+    std::vector<double> xyz;
+    for (uint i=0; i<n; ++i) {
+      reply.get<unsigned char>();
+      _block_boxes[i] = reply.getCoord();
+
+      uint m = reply.get<uint>();
+      xyz.resize(3 * m);
+      reply.getArray(xyz.data(), xyz.size());
+      _block[i].resize(m);
+      for (uint j=0; j<m; ++j)
+        _block[i][j] = GCoord(xyz[3*j], xyz[3*j+1], xyz[3*j+2]);
+    }
+
+    _block_first = first;
+  }
+
+
+  bool RemoteTrajectory::parseFrame(void) {
+    if (_next >= _nframes)
+      return(false);
+
+    if (_next < _block_first || _next >= _block_first + _block.size())
+      fetch(_next);
+
+    _frame = _block[_next - _block_first];
+    _box = _block_boxes[_next - _block_first];
+    ++_next;
+
+    return(true);
+  }
+
+
+  void RemoteTrajectory::updateGroupCoordsImpl(AtomicGroup& g) {
+    for (AtomicGroup::iterator i = g.begin(); i != g.end(); ++i) {
+      uint idx = (*i)->index();
+      if (idx >= _frame.size())
+        throw(LOOSError(**i, "Atom index into trajectory frame is out of bounds"));
+      (*i)->coords(_frame[idx]);
+    }
+
+    if (_periodic)
+      g.periodicBox(_box);
+  }
+
+}
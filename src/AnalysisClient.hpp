@@ -0,0 +1,185 @@
+/*
+  This file is part of LOOS.
+
+  LOOS (Lightweight Object-Oriented Structure library)
+  Copyright (c) 2008, Tod D. Romo, Alan Grossfield
+  Department of Biochemistry and Biophysics
+  School of Medicine & Dentistry, University of Rochester
+
+  This package (LOOS) is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation under version 3 of the License.
+
+  This package is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#if !defined(LOOS_ANALYSIS_CLIENT_HPP)
+#define LOOS_ANALYSIS_CLIENT_HPP
+
+#include <string>
+#include <vector>
+
+#include <boost/shared_ptr.hpp>
+
+#include <loos_defs.hpp>
+#include <AtomicGroup.hpp>
+#include <Trajectory.hpp>
+#include <AnalysisProtocol.hpp>
+
+
+namespace loos {
+
+  namespace internal {
+
+    // A connection to the server, shared by the client and any
+    // trajectories it opens
+    class AnalysisConnection {
+    public:
+      explicit AnalysisConnection(const std::string& path);
+      ~AnalysisConnection();
+
+      // Sends the request and returns the reply (with the status
+      // already checked)
+      MessageBuffer& transact(const MessageBuffer& request);
+
+    private:
+      AnalysisConnection(const AnalysisConnection&);
+      AnalysisConnection& operator=(const AnalysisConnection&);
+
+      int _fd;
+      MessageBuffer _reply;
+    };
+
+    typedef boost::shared_ptr<AnalysisConnection>    pAnalysisConnection;
+  }
+
+
+
+  //! Client for an AnalysisServer
+  /**
+   * Provides the same systems and trajectories as createSystem() and
+   * createTrajectory(), except that they come from a running
+   * AnalysisServer (see the loosd tool).  The returned model is a
+   * copy, so it can be changed freely.  Trajectories are read from
+   * the server's decoded frame cache a block of frames at a time.
+   * File names are relative to the client's working directory (they
+   * are made absolute before being sent to the server).
+   *
+   * Example:
+   * \code
+   * AnalysisClient client(AnalysisServer::defaultSocketPath());
+   * AtomicGroup model = client.createSystem("model.psf");
+   * pTraj traj = client.createTrajectory("traj.dcd", "", "model.psf", "");
+   * AtomicGroup ca = client.selectAtoms(model, "model.psf", "", "", "name == 'CA'");
+   * \endcode
+   */
+  class AnalysisClient {
+  public:
+    //! Connect to the server listening on \a path
+    explicit AnalysisClient(const std::string& path);
+
+    //! Check the server is alive and speaks the same protocol
+    bool ping();
+
+    //! Load (or fetch the cached copy of) a system
+    /**
+     * \a coords is an optional file to take coordinates from (as in
+     * loadStructureWithCoords()).  If \a require_coords is true and
+     * the model has no coordinates, an error is thrown.
+     */
+    AtomicGroup createSystem(const std::string& name, const std::string& type = "",
+                             const std::string& coords = "", const bool require_coords = false);
+
+    //! Open a trajectory on the server
+    /**
+     * The server opens the trajectory using its own copy of the model
+     * (identified by \a model_name, \a model_type, and \a coords).
+     */
+    pTraj createTrajectory(const std::string& name, const std::string& type,
+                           const std::string& model_name, const std::string& model_type,
+                           const std::string& coords = "");
+
+    //! Select atoms using the server's cached selections
+    /**
+     * \a model must be the client's copy of the system named by \a
+     * model_name, \a model_type, and \a coords.
+     */
+    AtomicGroup selectAtoms(const AtomicGroup& model, const std::string& model_name, const std::string& model_type,
+                            const std::string& coords, const std::string& selection);
+
+    //! The server's cache statistics
+    std::string statistics();
+
+    //! Ask the server to exit
+    void shutdown();
+
+  private:
+    internal::pAnalysisConnection _conn;
+  };
+
+
+
+  //! Trajectory whose frames come from an AnalysisServer
+  /**
+   * Frames are requested from the server in blocks (see
+   * blockSize()), so reading through the trajectory takes one round
+   * trip per block.
+   */
+  class RemoteTrajectory : public Trajectory {
+  public:
+    //! The trajectory must already have been opened on the server (see AnalysisClient)
+    RemoteTrajectory(const internal::pAnalysisConnection& conn, const std::string& fname,
+                     const uint id, const std::string& description,
+                     const uint natoms, const uint nframes, const float timestep, const bool periodic);
+
+    std::string description() const { return(_description + " (via analysis server)"); }
+
+    uint natoms(void) const { return(_natoms); }
+    float timestep(void) const { return(_timestep); }
+    uint nframes(void) const { return(_nframes); }
+    bool hasPeriodicBox(void) const { return(_periodic); }
+    GCoord periodicBox(void) const { return(_box); }
+    std::vector<GCoord> coords(void) const { return(_frame); }
+
+    bool parseFrame(void);
+
+    //! Number of frames fetched from the server at once
+    uint blockSize() const { return(_block_size); }
+    void blockSize(const uint n) { _block_size = (n ? n : 1); }
+
+  private:
+    void rewindImpl(void) { _next = 0; }
+    void seekNextFrameImpl(void) { }
+    void seekFrameImpl(const uint i) { _next = i; }
+    void updateGroupCoordsImpl(AtomicGroup& g);
+
+    void fetch(const uint first);
+
+    internal::pAnalysisConnection _conn;
+    uint _id;
+    std::string _description;
+    uint _natoms, _nframes;
+    float _timestep;
+    bool _periodic;
+    GCoord _box;
+    std::vector<GCoord> _frame;
+
+    uint _next;
+    uint _block_size;
+    uint _block_first;
+    std::vector< std::vector<GCoord> > _block;
+    std::vector<GCoord> _block_boxes;
+  };
+
+
+}
+
+
+#endif
@@ -0,0 +1,252 @@
+/*
+  This file is part of LOOS.
+
+  LOOS (Lightweight Object-Oriented Structure library)
+  Copyright (c) 2008, Tod D. Romo, Alan Grossfield
+  Department of Biochemistry and Biophysics
+  School of Medicine & Dentistry, University of Rochester
+
+  This package (LOOS) is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation under version 3 of the License.
+
+  This package is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+
+#include <AnalysisKernels.hpp>
+#include <DistanceKernels.hpp>
+#include <exceptions.hpp>
+
+
+namespace loos {
+
+  namespace {
+
+    // All groups' coordinates packed end-to-end, along with a
+    // bounding sphere for each group
+    struct PackedGroups {
+      explicit PackedGroups(const std::vector<AtomicGroup>& groups)
+        : offsets(groups.size() + 1, 0), centers(3 * groups.size()), radii(groups.size())
+      {
+        for (uint i=0; i<groups.size(); ++i)
+          offsets[i+1] = offsets[i] + groups[i].size();
+        xyz.resize(3 * offsets.back());
+
+        for (uint i=0; i<groups.size(); ++i) {
+          double* p = &xyz[3 * offsets[i]];
+          uint n = groups[i].size();
+          double cx = 0.0, cy = 0.0, cz = 0.0;
+          for (uint j=0; j<n; ++j) {
+            const GCoord& c = groups[i][j]->coords();
+            p[3*j] = c.x();
+            p[3*j+1] = c.y();
+            p[3*j+2] = c.z();
+            cx += c.x();
+            cy += c.y();
+            cz += c.z();
+          }
+          if (n) {
+            cx /= n;
+            cy /= n;
+            cz /= n;
+          }
+
+          double r2 = 0.0;
+          for (uint j=0; j<n; ++j) {
+            double dx = p[3*j] - cx;
+            double dy = p[3*j+1] - cy;
+            double dz = p[3*j+2] - cz;
+            double d2 = dx*dx + dy*dy + dz*dz;
+            if (d2 > r2)
+              r2 = d2;
+          }
+
+          centers[3*i] = cx;
+          centers[3*i+1] = cy;
+          centers[3*i+2] = cz;
+          radii[i] = sqrt(r2);
+        }
+      }
+
+      const double* coords(const uint i) const { return(&xyz[3 * offsets[i]]); }
+      uint size(const uint i) const { return(offsets[i+1] - offsets[i]); }
+
+      std::vector<uint> offsets;
+      std::vector<double> xyz;
+      std::vector<double> centers;
+      std::vector<double> radii;
+    };
+
+
+    // Calls pair(i, j) for every i < j whose groups are in contact
+    template<class Periodicity, class Pair>
+    void findContacts(const std::vector<AtomicGroup>& groups, const double cutoff, const Periodicity& policy, Pair pair) {
+      PackedGroups packed(groups);
+      DistanceKernels::WithinCutoff<Periodicity> op(cutoff, policy);
+      DistanceKernels::Distance2<Periodicity> d2(policy);
+
+      uint ngroups = groups.size();
+      for (uint i=0; i<ngroups; ++i) {
+        const double* ci = &packed.centers[3*i];
+        const double* xi = packed.coords(i);
+        uint ni = packed.size(i);
+
+        for (uint j=i+1; j<ngroups; ++j) {
+          // The minimum image distance obeys the triangle inequality,
+          // so the bounding spheres can be used with periodicity too
+          double reach = packed.radii[i] + packed.radii[j] + cutoff;
+          if (d2(ci, &packed.centers[3*j]) > reach * reach)
+            continue;
+
+          const double* xj = packed.coords(j);
+          uint nj = packed.size(j);
+          for (uint k=0; k<ni; ++k)
+            if (DistanceKernels::anyWithinBatch(op, xi + 3*k, xj, nj)) {
+              pair(i, j);
+              break;
+            }
+        }
+      }
+    }
+
+
+    struct AddContact {
+      AddContact(double* p, const uint n) : accum(p), stride(n) { }
+      void operator()(const uint i, const uint j) const {
+        accum[i * stride + j] += 1.0;
+        accum[j * stride + i] += 1.0;
+      }
+
+      double* accum;
+      uint stride;
+    };
+
+
+    void checkSquare(const std::vector<AtomicGroup>& groups, const int m, const int n) {
+      if (m != n || static_cast<uint>(m) != groups.size())
+        throw(LOOSError("Contact matrix must be square with one row per group"));
+    }
+
+
+    // Position of atom relative to origin, reimaged if periodic
+    struct Relative {
+      Relative(const AtomicGroup& g, const GCoord& o) : origin(o), periodic(g.isPeriodic()) {
+        if (periodic)
+          box = g.periodicBox();
+      }
+
+      GCoord operator()(const pAtom& a) const {
+        GCoord c = a->coords() - origin;
+        if (periodic)
+          c.reimage(box);
+        return(c);
+      }
+
+      GCoord origin, box;
+      bool periodic;
+    };
+
+  }
+
+
+
+  void accumulateContacts(const std::vector<AtomicGroup>& groups, const double cutoff,
+                          double* accum, int m, int n) {
+    checkSquare(groups, m, n);
+    findContacts(groups, cutoff, DistanceKernels::NoPeriodicity<double>(), AddContact(accum, n));
+  }
+
+
+  void accumulateContacts(const std::vector<AtomicGroup>& groups, const double cutoff, const GCoord& box,
+                          double* accum, int m, int n) {
+    checkSquare(groups, m, n);
+    findContacts(groups, cutoff, DistanceKernels::Orthorhombic<double>(box), AddContact(accum, n));
+  }
+
+
+  void contactMatrix(const std::vector<AtomicGroup>& groups, const double cutoff,
+                     double** outseq, int* m, int* n) {
+    uint ngroups = groups.size();
+    double* dp = static_cast<double*>(malloc(ngroups * ngroups * sizeof(double)));
+    if (ngroups)
+      memset(dp, 0, ngroups * ngroups * sizeof(double));
+    findContacts(groups, cutoff, DistanceKernels::NoPeriodicity<double>(), AddContact(dp, ngroups));
+
+    *m = ngroups;
+    *n = ngroups;
+    *outseq = dp;
+  }
+
+
+
+  void accumulateCylindricalHistogram(const AtomicGroup& target, const GCoord& origin,
+                                      const double rmin, const double rmax,
+                                      const double zmin, const double zmax,
+                                      double* accum, int m, int n) {
+    if (m <= 0 || n <= 0)
+      throw(LOOSError("Cylindrical histogram must have at least one bin in r and z"));
+
+    double rmin2 = rmin * rmin;
+    double rmax2 = rmax * rmax;
+    double rwidth = (rmax - rmin) / m;
+    double zwidth = (zmax - zmin) / n;
+    Relative relative(target, origin);
+
+    for (AtomicGroup::const_iterator i = target.begin(); i != target.end(); ++i) {
+      GCoord c = relative(*i);
+      double r2 = c.x() * c.x() + c.y() * c.y();
+      if (!(c.z() > zmin && c.z() < zmax && r2 > rmin2 && r2 < rmax2))
+        continue;
+
+      int rbin = static_cast<int>((sqrt(r2) - rmin) / rwidth);
+      int zbin = static_cast<int>((c.z() - zmin) / zwidth);
+      if (rbin >= 0 && rbin < m && zbin >= 0 && zbin < n)
+        accum[rbin * n + zbin] += 1.0;
+    }
+  }
+
+
+  void accumulateCylindricalHeights(const AtomicGroup& target, const GCoord& origin,
+                                    const double rmin, const double rmax,
+                                    double* accum, int m, int n) {
+    if (m <= 0 || n != 4)
+      throw(LOOSError("Cylindrical heights need at least one r bin and 4 columns"));
+
+    double rmin2 = rmin * rmin;
+    double rmax2 = rmax * rmax;
+    double rwidth = (rmax - rmin) / m;
+    Relative relative(target, origin);
+
+    for (AtomicGroup::const_iterator i = target.begin(); i != target.end(); ++i) {
+      GCoord c = relative(*i);
+      double r2 = c.x() * c.x() + c.y() * c.y();
+      if (!(r2 > rmin2 && r2 < rmax2))
+        continue;
+
+      int rbin = static_cast<int>((sqrt(r2) - rmin) / rwidth);
+      if (rbin < 0 || rbin >= m)
+        continue;
+
+      double* row = accum + 4 * rbin;
+      if (c.z() > 0.0) {
+        row[0] += c.z();
+        row[1] += 1.0;
+      } else {
+        row[2] += c.z();
+        row[3] += 1.0;
+      }
+    }
+  }
+
+}
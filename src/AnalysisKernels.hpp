@@ -0,0 +1,97 @@
+/*
+  This file is part of LOOS.
+
+  LOOS (Lightweight Object-Oriented Structure library)
+  Copyright (c) 2008, Tod D. Romo, Alan Grossfield
+  Department of Biochemistry and Biophysics
+  School of Medicine & Dentistry, University of Rochester
+
+  This package (LOOS) is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation under version 3 of the License.
+
+  This package is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#if !defined(LOOS_ANALYSIS_KERNELS_HPP)
+#define LOOS_ANALYSIS_KERNELS_HPP
+
+#include <vector>
+
+#include <loos_defs.hpp>
+#include <AtomicGroup.hpp>
+
+
+namespace loos {
+
+  // The accumulating functions below add one frame's worth of data
+  // to a row-major matrix (a NumPy array in PyLOOS, which is updated
+  // in place), so a script can keep a running total over a
+  // trajectory without looping over atoms in Python.
+
+
+  //! Adds the current group-group contacts to an \a m x \a n matrix
+  /**
+   * Two groups (e.g. residues) are in contact if any pair of their
+   * atoms is within \a cutoff, as with AtomicGroup::contactWith().
+   * For each pair of groups in contact, 1 is added to both
+   * accum[i,j] and accum[j,i].  The matrix must be square with one
+   * row per group.  Groups that are too far apart to be in contact
+   * are skipped using bounding spheres, so only nearby groups are
+   * checked atom-by-atom.
+   */
+  void accumulateContacts(const std::vector<AtomicGroup>& groups, const double cutoff,
+                          double* accum, int m, int n);
+
+  //! Adds the current group-group contacts to a matrix, using periodicity
+  void accumulateContacts(const std::vector<AtomicGroup>& groups, const double cutoff, const GCoord& box,
+                          double* accum, int m, int n);
+
+  //! Returns a newly allocated matrix of the current group-group contacts
+  /**
+   * Entries are 1 for groups in contact and 0 otherwise.  The matrix
+   * is allocated with malloc(), as with AtomicGroup::getCoords(), and
+   * becomes a NumPy array in PyLOOS.
+   */
+  void contactMatrix(const std::vector<AtomicGroup>& groups, const double cutoff,
+                     double** outseq, int* m, int* n);
+
+
+  //! Adds the current atom positions around a z-axis through \a origin to an (r, z) histogram
+  /**
+   * The histogram has \a m bins in r over (\a rmin, \a rmax) and \a n
+   * bins in z over (\a zmin, \a zmax), with z measured relative to
+   * \a origin.  Atoms outside the range are ignored.  If \a target
+   * is periodic, each atom's position relative to \a origin is first
+   * reimaged (as with translating by -origin and calling
+   * AtomicGroup::reimageByAtom()).
+   */
+  void accumulateCylindricalHistogram(const AtomicGroup& target, const GCoord& origin,
+                                      const double rmin, const double rmax,
+                                      const double zmin, const double zmax,
+                                      double* accum, int m, int n);
+
+  //! Adds the current heights of atoms above and below \a origin, binned by r
+  /**
+   * Each of the \a m rows is an r bin over (\a rmin, \a rmax) and has
+   * four columns: the sum of z for atoms above the origin, the number
+   * of atoms above, the sum of z for atoms at or below the origin, and
+   * the number of atoms below.  The mean heights of each leaflet of a
+   * membrane are then the ratios of the sums to the counts.
+   * Periodicity is handled as in accumulateCylindricalHistogram().
+   */
+  void accumulateCylindricalHeights(const AtomicGroup& target, const GCoord& origin,
+                                    const double rmin, const double rmax,
+                                    double* accum, int m, int n);
+
+}
+
+
+#endif
@@ -0,0 +1,216 @@
+/*
+  This file is part of LOOS.
+
+  LOOS (Lightweight Object-Oriented Structure library)
+  Copyright (c) 2008, Tod D. Romo, Alan Grossfield
+  Department of Biochemistry and Biophysics
+  School of Medicine & Dentistry, University of Rochester
+
+  This package (LOOS) is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation under version 3 of the License.
+
+  This package is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include <cerrno>
+
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <AnalysisProtocol.hpp>
+#include <AtomicGroup.hpp>
+
+
+namespace loos {
+
+  namespace internal {
+
+    namespace {
+
+      // All of the atom property bits, so they can be copied exactly
+      const Atom::bits property_bits[] = {
+        Atom::coordsbit, Atom::bondsbit, Atom::massbit, Atom::chargebit,
+        Atom::anumbit, Atom::flagbit, Atom::usr1bit, Atom::usr2bit,
+        Atom::usr3bit, Atom::indexbit, Atom::velbit
+      };
+      const uint nproperty_bits = sizeof(property_bits) / sizeof(property_bits[0]);
+
+
+      bool writeAll(const int fd, const char* p, size_t n) {
+#if defined(MSG_NOSIGNAL)
+        const int flags = MSG_NOSIGNAL;
+#else
+        const int flags = 0;
+#endif
+        while (n) {
+          ssize_t k = send(fd, p, n, flags);
+          if (k < 0) {
+            if (errno == EINTR)
+              continue;
+            return(false);
+          }
+          p += k;
+          n -= k;
+        }
+        return(true);
+      }
+
+
+      // Returns the number of bytes read, which is only short of n at
+      // end-of-file
+      size_t readAll(const int fd, char* p, size_t n) {
+        size_t total = 0;
+        while (total < n) {
+          ssize_t k = recv(fd, p + total, n - total, 0);
+          if (k < 0) {
+            if (errno == EINTR)
+              continue;
+            throw(AnalysisServerError(std::string("Error reading from analysis server socket: ") + strerror(errno)));
+          }
+          if (k == 0)
+            break;
+          total += k;
+        }
+        return(total);
+      }
+
+    }
+
+
+
+    void MessageBuffer::put(const AtomicGroup& g) {
+      put<uint>(g.size());
+      for (uint i=0; i<g.size(); ++i) {
+        pAtom a = g[i];
+
+        uint mask = 0;
+        for (uint j=0; j<nproperty_bits; ++j)
+          if (a->checkProperty(property_bits[j]))
+            mask |= property_bits[j];
+        put<uint>(mask);
+
+        put<int>(a->id());
+        put<uint>(a->index());
+        put<int>(a->resid());
+        put<int>(a->atomic_number());
+        put<int>(a->atomType());
+        put(a->name());
+        put(a->altLoc());
+        put(a->chainId());
+        put(a->resname());
+        put(a->segid());
+        put(a->iCode());
+        put(a->PDBelement());
+        put(a->recordName());
+        put(a->coords());
+        put(a->velocities());
+        put<double>(a->bfactor());
+        put<double>(a->occupancy());
+        put<double>(a->mass());
+        put<double>(mask & Atom::chargebit ? a->charge() : 0.0);
+
+        std::vector<int> bonds;
+        if (mask & Atom::bondsbit)
+          bonds = a->getBonds();
+        put<uint>(bonds.size());
+        putArray(bonds.data(), bonds.size());
+      }
+
+      put<unsigned char>(g.isPeriodic());
+      if (g.isPeriodic())
+        put(g.periodicBox());
+    }
+
+
+    AtomicGroup MessageBuffer::getAtomicGroup() {
+      AtomicGroup g;
+      uint n = get<uint>();
+
+      for (uint i=0; i<n; ++i) {
+        pAtom a(new Atom);
+
+        uint mask = get<uint>();
+        a->id(get<int>());
+        a->index(get<uint>());
+        a->resid(get<int>());
+        a->atomic_number(get<int>());
+        a->atomType(get<int>());
+        a->name(getString());
+        a->altLoc(getString());
+        a->chainId(getString());
+        a->resname(getString());
+        a->segid(getString());
+        a->iCode(getString());
+        a->PDBelement(getString());
+        a->recordName(getString());
+        a->coords(getCoord());
+        a->velocities(getCoord());
+        a->bfactor(get<double>());
+        a->occupancy(get<double>());
+        a->mass(get<double>());
+        a->charge(get<double>());
+
+        std::vector<int> bonds(get<uint>());
+        getArray(bonds.data(), bonds.size());
+        if (!bonds.empty())
+          a->setBonds(bonds);
+
+        // The setters above flag properties as set, so restore the
+        // original state...
+        for (uint j=0; j<nproperty_bits; ++j)
+          if (mask & property_bits[j])
+            a->setProperty(property_bits[j]);
+          else
+            a->clearProperty(property_bits[j]);
+
+        g.append(a);
+      }
+
+      if (get<unsigned char>())
+        g.periodicBox(getCoord());
+
+      return(g);
+    }
+
+
+
+    bool sendMessage(const int fd, const MessageBuffer& msg) {
+      if (msg.data.size() > max_message_size)
+        throw(AnalysisServerError("Message to analysis server is too large"));
+      uint n = msg.data.size();
+      if (!writeAll(fd, reinterpret_cast<const char*>(&n), sizeof(n)))
+        return(false);
+      return(writeAll(fd, msg.data.data(), n));
+    }
+
+
+    bool receiveMessage(const int fd, MessageBuffer& msg) {
+      uint n;
+      msg.clear();
+      size_t k = readAll(fd, reinterpret_cast<char*>(&n), sizeof(n));
+      if (k == 0)
+        return(false);
+      if (k != sizeof(n))
+        throw(AnalysisServerError("Truncated message from analysis server"));
+      if (n > max_message_size)
+        throw(AnalysisServerError("Message from analysis server is too large"));
+
+      msg.data.resize(n);
+      if (readAll(fd, msg.data.data(), n) != n)
+        throw(AnalysisServerError("Truncated message from analysis server"));
+
+      return(true);
+    }
+
+  }
+
+}
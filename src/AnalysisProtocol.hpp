@@ -0,0 +1,167 @@
+/*
+  This file is part of LOOS.
+
+  LOOS (Lightweight Object-Oriented Structure library)
+  Copyright (c) 2008, Tod D. Romo, Alan Grossfield
+  Department of Biochemistry and Biophysics
+  School of Medicine & Dentistry, University of Rochester
+
+  This package (LOOS) is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation under version 3 of the License.
+
+  This package is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#if !defined(LOOS_ANALYSIS_PROTOCOL_HPP)
+#define LOOS_ANALYSIS_PROTOCOL_HPP
+
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include <loos_defs.hpp>
+#include <Coord.hpp>
+#include <exceptions.hpp>
+
+
+namespace loos {
+
+  namespace internal {
+
+    // Messages exchanged between the AnalysisServer and AnalysisClient.
+    // Every message is a 32-bit length followed by that many bytes.
+    // Requests begin with a command code, and replies begin with a
+    // status (0 for success, otherwise followed by an error string).
+    // Both ends are on the same machine, so no byte-swapping is done.
+    // Frame coordinates are sent in double precision, so frames read
+    // through the server match those read from the file.  Messages
+    // are limited to max_message_size bytes, which is checked before
+    // a length from the other end is trusted.
+
+    enum AnalysisCommand {
+      ANALYSIS_PING = 1,
+      ANALYSIS_SYSTEM,
+      ANALYSIS_TRAJECTORY,
+      ANALYSIS_FRAMES,
+      ANALYSIS_SELECT,
+      ANALYSIS_STATS,
+      ANALYSIS_SHUTDOWN
+    };
+
+    const uint analysis_protocol_version = 3;
+
+    const unsigned long max_message_size = 1ul << 30;
+
+
+    //! Error in talking to (or being) an analysis server
+    class AnalysisServerError : public LOOSError {
+    public:
+      explicit AnalysisServerError(const std::string& msg) : LOOSError(msg) { }
+    };
+
+
+    //! Buffer for building and decoding messages
+    class MessageBuffer {
+    public:
+      MessageBuffer() : pos(0) { }
+
+      void clear() { data.clear(); pos = 0; }
+
+      template<typename T>
+      void put(const T& t) {
+        append(&t, sizeof(T));
+      }
+
+      void put(const std::string& s) {
+        put<uint>(s.size());
+        append(s.data(), s.size());
+      }
+
+      void put(const GCoord& c) {
+        put<double>(c.x());
+        put<double>(c.y());
+        put<double>(c.z());
+      }
+
+      template<typename T>
+      void putArray(const T* p, const uint n) {
+        append(p, n * sizeof(T));
+      }
+
+      void put(const AtomicGroup& g);
+
+
+      template<typename T>
+      T get() {
+        T t;
+        need(sizeof(T));
+        memcpy(&t, &data[pos], sizeof(T));
+        pos += sizeof(T);
+        return(t);
+      }
+
+      std::string getString() {
+        uint n = get<uint>();
+        need(n);
+        std::string s(data.begin() + pos, data.begin() + pos + n);
+        pos += n;
+        return(s);
+      }
+
+      GCoord getCoord() {
+        double x = get<double>();
+        double y = get<double>();
+        double z = get<double>();
+        return(GCoord(x, y, z));
+      }
+
+      template<typename T>
+      void getArray(T* p, const uint n) {
+        need(n * sizeof(T));
+        memcpy(p, &data[pos], n * sizeof(T));
+        pos += n * sizeof(T);
+      }
+
+      AtomicGroup getAtomicGroup();
+
+
+      std::vector<char> data;
+
+    private:
+      void append(const void* p, const size_t n) {
+        if (n == 0)
+          return;
+        size_t end = data.size();
+        data.resize(end + n);
+        memcpy(&data[end], p, n);
+      }
+
+      void need(const size_t n) const {
+        if (pos + n > data.size())
+          throw(AnalysisServerError("Truncated message from analysis server"));
+      }
+
+      size_t pos;
+    };
+
+
+    //! Send a whole message, returning false if the other end is gone
+    bool sendMessage(const int fd, const MessageBuffer& msg);
+
+    //! Receive a whole message, returning false on end-of-file
+    bool receiveMessage(const int fd, MessageBuffer& msg);
+
+  }
+
+}
+
+
+#endif
@@ -0,0 +1,546 @@
+/*
+  This file is part of LOOS.
+
+  LOOS (Lightweight Object-Oriented Structure library)
+  Copyright (c) 2008, Tod D. Romo, Alan Grossfield
+  Department of Biochemistry and Biophysics
+  School of Medicine & Dentistry, University of Rochester
+
+  This package (LOOS) is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation under version 3 of the License.
+
+  This package is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <sstream>
+
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <boost/bind.hpp>
+#include <boost/format.hpp>
+#include <boost/thread/thread.hpp>
+
+#include <AnalysisServer.hpp>
+#include <sfactories.hpp>
+#include <trr.hpp>
+#include <utils.hpp>
+#include <utils_structural.hpp>
+#include <exceptions.hpp>
+
+
+namespace loos {
+
+  using namespace internal;
+
+
+  namespace {
+
+    // Opens a Unix-domain socket and fills in its address
+    int unixSocket(const std::string& path, struct sockaddr_un& addr) {
+      if (path.size() >= sizeof(addr.sun_path))
+        throw(AnalysisServerError("Socket path is too long: " + path));
+
+      memset(&addr, 0, sizeof(addr));
+      addr.sun_family = AF_UNIX;
+      strncpy(addr.sun_path, path.c_str(), sizeof(addr.sun_path) - 1);
+
+      int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+      if (fd < 0)
+        throw(AnalysisServerError(std::string("Cannot create socket: ") + strerror(errno)));
+      return(fd);
+    }
+
+  }
+
+
+
+  std::string AnalysisServer::defaultSocketPath(const bool create) {
+    const char* p = getenv("XDG_RUNTIME_DIR");
+    if (p && *p)
+      return(std::string(p) + "/loosd.sock");
+
+    p = getenv("HOME");
+    if (!p || !*p)
+      throw(AnalysisServerError("Cannot find a directory for the server socket (neither XDG_RUNTIME_DIR nor HOME is set)"));
+
+    std::string dir = std::string(p) + "/.loos";
+    if (create && mkdir(dir.c_str(), 0700) < 0 && errno != EEXIST)
+      throw(AnalysisServerError("Cannot create " + dir + ": " + strerror(errno)));
+
+    return(dir + "/loosd.sock");
+  }
+
+
+
+  AnalysisServer::AnalysisServer(const std::string& socket_path, const unsigned long cache_bytes)
+    : _path(socket_path), _fd(-1), _done(false), _verbose(false),
+      _cache_max(cache_bytes)
+  {
+    openSocket();
+  }
+
+
+  AnalysisServer::~AnalysisServer() {
+    stopClients();
+    if (_fd >= 0) {
+      close(_fd);
+      unlink(_path.c_str());
+    }
+  }
+
+
+  void AnalysisServer::openSocket() {
+    struct sockaddr_un addr;
+
+    // Check for a server already using this socket, otherwise remove
+    // the stale socket from a server that didn't exit cleanly...
+    struct stat st;
+    if (stat(_path.c_str(), &st) == 0) {
+      if (!S_ISSOCK(st.st_mode))
+        throw(AnalysisServerError("Refusing to replace " + _path + " since it is not a socket"));
+
+      int probe = unixSocket(_path, addr);
+      bool running = (connect(probe, reinterpret_cast<struct sockaddr*>(&addr), sizeof(addr)) == 0);
+      close(probe);
+      if (running)
+        throw(AnalysisServerError("An analysis server is already running on " + _path));
+      unlink(_path.c_str());
+    }
+
+    // Only the user running the server may connect (see also trustedPeer())
+    _fd = unixSocket(_path, addr);
+    if (bind(_fd, reinterpret_cast<struct sockaddr*>(&addr), sizeof(addr)) < 0
+        || chmod(_path.c_str(), S_IRUSR | S_IWUSR) < 0
+        || listen(_fd, 16) < 0) {
+      std::string msg = strerror(errno);
+      close(_fd);
+      _fd = -1;
+      throw(AnalysisServerError("Cannot listen on " + _path + ": " + msg));
+    }
+  }
+
+
+  void AnalysisServer::run() {
+    while (!_done) {
+      int cfd = accept(_fd, 0, 0);
+      if (cfd < 0) {
+        if (errno == EINTR)
+          continue;
+        throw(AnalysisServerError(std::string("Error accepting connection: ") + strerror(errno)));
+      }
+
+      if (_done) {
+        close(cfd);
+        break;
+      }
+
+      if (!trustedPeer(cfd)) {
+        if (_verbose)
+          std::cerr << "loosd: refused connection from another user" << std::endl;
+        close(cfd);
+        continue;
+      }
+
+      startClient(cfd);
+    }
+
+    stopClients();
+  }
+
+
+  // The socket's permissions should already keep other users out, but
+  // check the peer's credentials in case they've been loosened...
+  bool AnalysisServer::trustedPeer(const int fd) const {
+#if defined(SO_PEERCRED)
+    struct ucred cred;
+    socklen_t len = sizeof(cred);
+    if (getsockopt(fd, SOL_SOCKET, SO_PEERCRED, &cred, &len) < 0)
+      return(false);
+    return(cred.uid == getuid());
+#else
+    uid_t uid;
+    gid_t gid;
+    if (getpeereid(fd, &uid, &gid) < 0)
+      return(false);
+    return(uid == getuid());
+#endif
+  }
+
+
+  // Client threads are tracked so that run() can wait for them to
+  // finish.  Threads that have already finished are reaped here.
+  void AnalysisServer::startClient(const int fd) {
+    boost::mutex::scoped_lock lock(_client_lock);
+
+    for (std::list<ClientThread>::iterator i = _clients.begin(); i != _clients.end(); ) {
+      if (i->finished) {
+        i->thread->join();
+        i = _clients.erase(i);
+      } else
+        ++i;
+    }
+
+    _clients.push_back(ClientThread(fd));
+    _clients.back().thread = boost::shared_ptr<boost::thread>(new boost::thread(boost::bind(&AnalysisServer::serveClient, this, fd)));
+  }
+
+
+  // Disconnects any remaining clients and waits for their threads
+  void AnalysisServer::stopClients() {
+    std::list<ClientThread> clients;
+    {
+      boost::mutex::scoped_lock lock(_client_lock);
+      for (std::list<ClientThread>::iterator i = _clients.begin(); i != _clients.end(); ++i)
+        if (!i->finished)
+          ::shutdown(i->fd, SHUT_RDWR);
+      clients.swap(_clients);
+    }
+
+    for (std::list<ClientThread>::iterator i = clients.begin(); i != clients.end(); ++i)
+      i->thread->join();
+  }
+
+
+  // Wakes up the accept() in run() by connecting to ourselves
+  void AnalysisServer::shutdown() {
+    _done = true;
+
+    struct sockaddr_un addr;
+    int fd = unixSocket(_path, addr);
+    connect(fd, reinterpret_cast<struct sockaddr*>(&addr), sizeof(addr));
+    close(fd);
+  }
+
+
+  void AnalysisServer::serveClient(const int fd) {
+    MessageBuffer request, reply;
+    bool stop = false;
+
+    try {
+      while (!_done && receiveMessage(fd, request)) {
+        stop = !handleRequest(request, reply);
+        if (!sendMessage(fd, reply) || stop)
+          break;
+      }
+    }
+    catch (std::exception& e) {
+      if (_verbose)
+        std::cerr << "loosd: " << e.what() << std::endl;
+    }
+
+    // The descriptor is closed while holding the lock so that it
+    // can't be reused by a new client before this one is marked
+    // as finished
+    boost::mutex::scoped_lock lock(_client_lock);
+    for (std::list<ClientThread>::iterator i = _clients.begin(); i != _clients.end(); ++i)
+      if (i->fd == fd && !i->finished) {
+        i->finished = true;
+        break;
+      }
+    close(fd);
+    lock.unlock();
+
+    // Only stop the server once the reply has been sent, since
+    // stopping disconnects all clients
+    if (stop)
+      shutdown();
+  }
+
+
+  // Returns false if the server should shut down
+  bool AnalysisServer::handleRequest(MessageBuffer& request, MessageBuffer& reply) {
+    reply.clear();
+
+    try {
+      uint cmd = request.get<uint>();
+
+      if (cmd == ANALYSIS_SHUTDOWN) {
+        reply.put<uint>(0);
+        return(false);
+      }
+
+      boost::mutex::scoped_lock lock(_lock);
+      ++_stats.requests;
+
+      switch(cmd) {
+      case ANALYSIS_PING:
+        reply.put<uint>(0);
+        reply.put<uint>(analysis_protocol_version);
+        break;
+
+      case ANALYSIS_SYSTEM: doSystem(request, reply); break;
+      case ANALYSIS_TRAJECTORY: doTrajectory(request, reply); break;
+      case ANALYSIS_FRAMES: doFrames(request, reply); break;
+      case ANALYSIS_SELECT: doSelect(request, reply); break;
+
+      case ANALYSIS_STATS:
+        reply.put<uint>(0);
+        lock.unlock();
+        reply.put(statistics());
+        break;
+
+      default:
+        throw(AnalysisServerError("Unknown request"));
+      }
+    }
+    catch (std::exception& e) {
+      if (_verbose)
+        std::cerr << "loosd: error- " << e.what() << std::endl;
+      reply.clear();
+      reply.put<uint>(1);
+      reply.put(std::string(e.what()));
+    }
+
+    return(true);
+  }
+
+
+
+  AnalysisServer::FileStamp AnalysisServer::stamp(const std::string& fname) {
+    FileStamp s;
+    struct stat st;
+
+    if (stat(fname.c_str(), &st) == 0) {
+      s.mtime = st.st_mtime;
+      s.size = st.st_size;
+    }
+    return(s);
+  }
+
+
+  std::string AnalysisServer::systemKey(const std::string& name, const std::string& type, const std::string& coords) {
+    return(name + '\n' + type + '\n' + coords);
+  }
+
+
+  AnalysisServer::CachedSystem& AnalysisServer::system(const std::string& name, const std::string& type, const std::string& coords) {
+    std::string key = systemKey(name, type, coords);
+    FileStamp model_stamp = stamp(name);
+    FileStamp coords_stamp = coords.empty() ? FileStamp() : stamp(coords);
+
+    std::map<std::string, CachedSystem>::iterator i = _systems.find(key);
+    if (i != _systems.end() && i->second.model_stamp == model_stamp && i->second.coords_stamp == coords_stamp) {
+      ++_stats.system_hits;
+      return(i->second);
+    }
+
+    ++_stats.system_misses;
+    if (_verbose)
+      std::cerr << "loosd: loading system " << name << std::endl;
+
+    CachedSystem sys;
+    sys.model = type.empty() ? createSystem(name) : createSystem(name, type);
+    if (!coords.empty()) {
+      AtomicGroup crds = createSystem(coords);
+      sys.model.copyCoordinatesFrom(crds);
+    }
+    sys.model_stamp = model_stamp;
+    sys.coords_stamp = coords_stamp;
+
+    _systems[key] = sys;
+    return(_systems[key]);
+  }
+
+
+  uint AnalysisServer::trajectory(const std::string& name, const std::string& type, const std::string& system_key, const AtomicGroup& model) {
+    std::string key = name + '\n' + type + '\n' + system_key;
+    FileStamp s = stamp(name);
+
+    uint id = _trajectories.size();
+    for (uint i=0; i<_trajectories.size(); ++i)
+      if (_trajectories[i].key == key) {
+        if (_trajectories[i].stamp == s) {
+          ++_stats.traj_hits;
+          return(i);
+        }
+        id = i;
+        break;
+      }
+
+    ++_stats.traj_misses;
+    if (_verbose)
+      std::cerr << "loosd: opening trajectory " << name << std::endl;
+
+    pTraj traj = type.empty() ? createTrajectory(name, model) : createTrajectory(name, type, model);
+
+    // Frames are served as coordinates and a box only, so a TRR can
+    // skip over its velocities and forces
+    boost::shared_ptr<TRR> trr = boost::dynamic_pointer_cast<TRR>(traj);
+    if (trr)
+      trr->sections(TRR::COORDINATES);
+
+    std::vector<uint> indices(traj->natoms());
+    for (uint i=0; i<indices.size(); ++i)
+      indices[i] = i;
+
+    ServedTrajectory t;
+    t.key = key;
+    t.system_key = system_key;
+    t.frames = internal::pFrameCache(new internal::FrameCache(traj, _cache_max, indices, true));
+    t.stamp = s;
+
+    if (id == _trajectories.size())
+      _trajectories.push_back(t);
+    else {
+      _stats.frame_hits += _trajectories[id].frames->hits();
+      _stats.frame_misses += _trajectories[id].frames->misses();
+      _trajectories[id] = t;
+    }
+    balanceFrameCaches();
+
+    return(id);
+  }
+
+
+  // The frame cache budget is split evenly between the trajectories
+  void AnalysisServer::balanceFrameCaches() {
+    for (uint i=0; i<_trajectories.size(); ++i)
+      _trajectories[i].frames->maxBytes(_cache_max / _trajectories.size());
+  }
+
+
+  const std::vector<uint>& AnalysisServer::selection(CachedSystem& sys, const std::string& sel) {
+    std::map<std::string, std::vector<uint> >::iterator i = sys.selections.find(sel);
+    if (i != sys.selections.end()) {
+      ++_stats.selection_hits;
+      return(i->second);
+    }
+
+    ++_stats.selection_misses;
+    AtomicGroup subset = selectAtoms(sys.model, sel);
+
+    std::map<const Atom*, uint> position;
+    for (uint j=0; j<sys.model.size(); ++j)
+      position[sys.model[j].get()] = j;
+
+    std::vector<uint> indices(subset.size());
+    for (uint j=0; j<subset.size(); ++j)
+      indices[j] = position[subset[j].get()];
+
+    sys.selections[sel] = indices;
+    return(sys.selections[sel]);
+  }
+
+
+  void AnalysisServer::doSystem(MessageBuffer& request, MessageBuffer& reply) {
+    std::string name = request.getString();
+    std::string type = request.getString();
+    std::string coords = request.getString();
+    bool require_coords = request.get<unsigned char>();
+
+    CachedSystem& sys = system(name, type, coords);
+    if (require_coords && !sys.model.hasCoords())
+      throw(LOOSError("Error- no coordinates found in specified model(s)"));
+
+    reply.put<uint>(0);
+    reply.put(sys.model);
+  }
+
+
+  void AnalysisServer::doTrajectory(MessageBuffer& request, MessageBuffer& reply) {
+    std::string name = request.getString();
+    std::string type = request.getString();
+    std::string model_name = request.getString();
+    std::string model_type = request.getString();
+    std::string coords = request.getString();
+
+    CachedSystem& sys = system(model_name, model_type, coords);
+    uint id = trajectory(name, type, systemKey(model_name, model_type, coords), sys.model);
+    pTraj t = _trajectories[id].frames->trajectory();
+
+    reply.put<uint>(0);
+    reply.put<uint>(id);
+    reply.put(t->description());
+    reply.put<uint>(t->natoms());
+    reply.put<uint>(t->nframes());
+    reply.put<float>(t->timestep());
+    reply.put<unsigned char>(t->hasPeriodicBox());
+  }
+
+
+  void AnalysisServer::doFrames(MessageBuffer& request, MessageBuffer& reply) {
+    uint id = request.get<uint>();
+    uint first = request.get<uint>();
+    uint n = request.get<uint>();
+
+    if (id >= _trajectories.size())
+      throw(AnalysisServerError("Unknown trajectory"));
+    internal::FrameCache& cache = *(_trajectories[id].frames);
+    pTraj t = cache.trajectory();
+    if (first >= t->nframes())
+      throw(AnalysisServerError("Frame index is out of range"));
+    n = std::min(n, t->nframes() - first);
+
+    // Send fewer frames than asked for rather than go over the
+    // message size limit (but always at least one)
+    unsigned long frame_bytes = 64 + 3 * sizeof(double) * static_cast<unsigned long>(cache.indices().size());
+    n = std::max(1ul, std::min(static_cast<unsigned long>(n), max_message_size / frame_bytes));
+
+    reply.put<uint>(0);
+    reply.put<uint>(n);
+    for (uint i=0; i<n; ++i) {
+      internal::FrameCache::pFrame f = cache.frame(first + i);
+      reply.put<unsigned char>(f->periodic);
+      reply.put(f->box);
+      reply.put<uint>(f->dxyz.size() / 3);
+      reply.putArray(f->dxyz.data(), f->dxyz.size());
+    }
+  }
+
+
+  void AnalysisServer::doSelect(MessageBuffer& request, MessageBuffer& reply) {
+    std::string name = request.getString();
+    std::string type = request.getString();
+    std::string coords = request.getString();
+    std::string sel = request.getString();
+
+    CachedSystem& sys = system(name, type, coords);
+    const std::vector<uint>& indices = selection(sys, sel);
+
+    reply.put<uint>(0);
+    reply.put<uint>(indices.size());
+    reply.putArray(indices.data(), indices.size());
+  }
+
+
+
+  std::string AnalysisServer::statistics() const {
+    boost::mutex::scoped_lock lock(_lock);
+    std::ostringstream oss;
+
+    oss << boost::format("Requests: %d\n") % _stats.requests;
+    oss << boost::format("Systems: %d cached, %d hits, %d misses\n") % _systems.size() % _stats.system_hits % _stats.system_misses;
+    oss << boost::format("Trajectories: %d cached, %d hits, %d misses\n") % _trajectories.size() % _stats.traj_hits % _stats.traj_misses;
+    oss << boost::format("Selections: %d hits, %d misses\n") % _stats.selection_hits % _stats.selection_misses;
+    uint nframes = 0;
+    unsigned long bytes = 0, hits = _stats.frame_hits, misses = _stats.frame_misses;
+    for (uint i=0; i<_trajectories.size(); ++i) {
+      const internal::FrameCache& cache = *(_trajectories[i].frames);
+      nframes += cache.size();
+      bytes += cache.bytes();
+      hits += cache.hits();
+      misses += cache.misses();
+    }
+    oss << boost::format("Frames: %d cached (%.1f of %.1f MB), %d hits, %d misses\n")
+      % nframes % (bytes / 1048576.0) % (_cache_max / 1048576.0) % hits % misses;
+
+    return(oss.str());
+  }
+
+}
@@ -0,0 +1,192 @@
+/*
+  This file is part of LOOS.
+
+  LOOS (Lightweight Object-Oriented Structure library)
+  Copyright (c) 2008, Tod D. Romo, Alan Grossfield
+  Department of Biochemistry and Biophysics
+  School of Medicine & Dentistry, University of Rochester
+
+  This package (LOOS) is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation under version 3 of the License.
+
+  This package is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#if !defined(LOOS_ANALYSIS_SERVER_HPP)
+#define LOOS_ANALYSIS_SERVER_HPP
+
+#include <ctime>
+#include <list>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <boost/shared_ptr.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/thread.hpp>
+
+#include <loos_defs.hpp>
+#include <AtomicGroup.hpp>
+#include <Trajectory.hpp>
+#include <CachedTrajectory.hpp>
+#include <AnalysisProtocol.hpp>
+
+
+namespace loos {
+
+
+  //! Long-lived local server that keeps systems and trajectories loaded
+  /**
+   * Each LOOS tool normally reads its model, builds its selections,
+   * and opens (and possibly indexes) its trajectory from scratch.  The
+   * AnalysisServer does this once and keeps the results around so
+   * that a series of tools run on the same system can skip most of
+   * their startup.  It listens on a Unix domain socket (see the loosd
+   * tool) and caches:
+   *
+   * - Systems, keyed on the model, model type, and alternate
+   *   coordinates file
+   * - Open trajectories (including any frame index built when they
+   *   were opened)
+   * - Selections, stored as the indices of the selected atoms
+   * - Decoded frames (in double precision, so they match reading the
+   *   file directly), up to a fixed number of bytes split evenly
+   *   between the open trajectories, with the least recently used
+   *   frames of each being dropped first (see CachedTrajectory)
+   *
+   * Files are checked for modification each time they are requested
+   * and are reloaded if they have changed.
+   *
+   * Tools use the server through AnalysisClient, which the options
+   * framework does automatically when given --server (or when the
+   * LOOS_SERVER environment variable is set).
+   *
+   * Requests from multiple clients are accepted concurrently, but are
+   * handled one at a time.  The socket is only accessible by the
+   * user running the server (mode 0600), and connections from any
+   * other user are refused.
+   */
+  class AnalysisServer {
+  public:
+    //! Create a server listening on \a socket_path, caching up to \a cache_bytes of frames
+    explicit AnalysisServer(const std::string& socket_path, const unsigned long cache_bytes = 1ul << 30);
+    ~AnalysisServer();
+
+    //! Handle clients until a shutdown is requested
+    void run();
+
+    //! Stop the server (may be called from any thread)
+    void shutdown();
+
+    //! Log requests to stderr
+    void verbose(const bool b) { _verbose = b; }
+
+    //! Summary of what is cached and how well the caches are working
+    std::string statistics() const;
+
+    std::string socketPath() const { return(_path); }
+
+    //! Default socket: \c $XDG_RUNTIME_DIR/loosd.sock, otherwise \c ~/.loos/loosd.sock
+    /**
+     * When falling back to \c ~/.loos, the directory is created (only
+     * accessible by the user) if \a create is true.
+     */
+    static std::string defaultSocketPath(const bool create = false);
+
+  private:
+    struct FileStamp {
+      FileStamp() : mtime(0), size(0) { }
+      bool operator==(const FileStamp& s) const { return(mtime == s.mtime && size == s.size); }
+
+      time_t mtime;
+      off_t size;
+    };
+
+    struct CachedSystem {
+      AtomicGroup model;
+      FileStamp model_stamp, coords_stamp;
+      std::map<std::string, std::vector<uint> > selections;
+    };
+
+    // An open trajectory and its cache of decoded frames
+    struct ServedTrajectory {
+      std::string key;
+      std::string system_key;
+      internal::pFrameCache frames;
+      FileStamp stamp;
+    };
+
+    struct Statistics {
+      Statistics() : requests(0), system_hits(0), system_misses(0), traj_hits(0), traj_misses(0),
+                     selection_hits(0), selection_misses(0), frame_hits(0), frame_misses(0) { }
+
+      unsigned long requests;
+      unsigned long system_hits, system_misses;
+      unsigned long traj_hits, traj_misses;
+      unsigned long selection_hits, selection_misses;
+      unsigned long frame_hits, frame_misses;
+    };
+
+
+    struct ClientThread {
+      ClientThread(const int f) : fd(f), finished(false) { }
+
+      int fd;
+      bool finished;
+      boost::shared_ptr<boost::thread> thread;
+    };
+
+
+    void openSocket();
+    bool trustedPeer(const int fd) const;
+    void startClient(const int fd);
+    void stopClients();
+    void serveClient(const int fd);
+    bool handleRequest(internal::MessageBuffer& request, internal::MessageBuffer& reply);
+
+    static FileStamp stamp(const std::string& fname);
+    static std::string systemKey(const std::string& name, const std::string& type, const std::string& coords);
+
+    CachedSystem& system(const std::string& name, const std::string& type, const std::string& coords);
+    uint trajectory(const std::string& name, const std::string& type, const std::string& system_key, const AtomicGroup& model);
+    const std::vector<uint>& selection(CachedSystem& sys, const std::string& selection);
+    void balanceFrameCaches();
+
+    void doSystem(internal::MessageBuffer& request, internal::MessageBuffer& reply);
+    void doTrajectory(internal::MessageBuffer& request, internal::MessageBuffer& reply);
+    void doFrames(internal::MessageBuffer& request, internal::MessageBuffer& reply);
+    void doSelect(internal::MessageBuffer& request, internal::MessageBuffer& reply);
+
+
+    std::string _path;
+    int _fd;
+    volatile bool _done;
+    bool _verbose;
+
+    mutable boost::mutex _lock;
+
+    boost::mutex _client_lock;
+    std::list<ClientThread> _clients;
+
+    std::map<std::string, CachedSystem> _systems;
+    std::vector<ServedTrajectory> _trajectories;
+
+    unsigned long _cache_max;
+
+    Statistics _stats;
+  };
+
+
+}
+
+
+#endif
@@ -42,6 +42,7 @@
 #include <Atom.hpp>
 #include <XForm.hpp>
 #include <PeriodicBox.hpp>
+#include <DistanceKernels.hpp>
 #include <utils.hpp>
 #include <Matrix.hpp>
 
@@ -638,6 +639,15 @@ namespace loos {
     //! Apply the given transform to the group's coordinates...
     void applyTransform(const XForm&);
 
+    //! Apply a transform to each of a set of packed frames of this group
+    /**
+     * \a frames holds one frame after another, each being the
+     * interleaved coordinates of the group's atoms (as from
+     * coordsAsVector()).  The jth frame is transformed in place by the
+     * jth XForm.  The group itself is not changed.
+     */
+    void applyTransform(const std::vector<XForm>& xforms, std::vector<double>& frames) const;
+
     //! Copy coordinates from a vector of GCoords using the atom index as an index into the vector.
     void copyCoordinatesWithIndex(const std::vector<GCoord>& coords);
 
@@ -795,25 +805,12 @@ namespace loos {
 
   private:
 
-	// These are functors for calculating distance between two coords
+    // These are functors for calculating distance between two coords
     // without and with periodicity.  These can be passed to functions
     // that need to support both ways of calculating distances, such
-    // was within_private() below...
-    struct Distance2WithoutPeriodicity {
-      double operator()(const GCoord& a, const GCoord& b) const {
-        return(a.distance2(b));
-      }
-    };
-
-    struct Distance2WithPeriodicity {
-      Distance2WithPeriodicity(const GCoord& box) : _box(box) { }
-
-      double operator()(const GCoord& a, const GCoord& b) const {
-        return(a.distance2(b, _box));
-      }
-
-      GCoord _box;
-    };
+    // was within_private() below...  See DistanceKernels.hpp
+    typedef DistanceKernels::Distance2< DistanceKernels::NoPeriodicity<double> > Distance2WithoutPeriodicity;
+    typedef DistanceKernels::Distance2< DistanceKernels::Orthorhombic<double> > Distance2WithPeriodicity;
 
 
 
@@ -821,7 +818,8 @@ namespace loos {
     // angstroms of any atom in the passed group.  The distance
     // calculation is determined by the passed functor so that the
     // same code can be used for both periodic and non-periodic
-    // coordinates.
+    // coordinates.  The coordinates of grp are packed once so the
+    // inner loop can use the batch kernel.
 
     template <typename DistanceCalc>
     AtomicGroup within_private(const double dist, AtomicGroup& grp, const DistanceCalc& distance_functor) const {
@@ -829,17 +827,16 @@ namespace loos {
       AtomicGroup res;
       res.box = box;
 
-      double dist2 = dist * dist;
+      DistanceKernels::WithinCutoff<typename DistanceCalc::periodicity_type> op(dist, distance_functor.policy);
+      std::vector<double> xyz;
+      DistanceKernels::packCoords(grp.atoms, xyz);
       std::vector<uint> indices;
 
       for (uint j=0; j<size(); j++) {
-        GCoord c = atoms[j]->coords();
-        for (uint i=0; i<grp.size(); i++) {
-          if (distance_functor(c, grp.atoms[i]->coords()) <= dist2) {
-            indices.push_back(j);
-            break;
-          }
-        }
+        const GCoord& c = atoms[j]->coords();
+        double u[3] = { c.x(), c.y(), c.z() };
+        if (DistanceKernels::anyWithinBatch(op, u, xyz.data(), grp.size()))
+          indices.push_back(j);
       }
 
       if (indices.size() == 0)
@@ -854,15 +851,17 @@ namespace loos {
 
     template<typename DistanceCalc>
     bool contactwith_private(const double dist, const AtomicGroup& grp, const uint min_contacts, const DistanceCalc& distance_function) const {
-      double dist2 = dist * dist;
+      DistanceKernels::WithinCutoff<typename DistanceCalc::periodicity_type> op(dist, distance_function.policy);
+      std::vector<double> xyz;
+      DistanceKernels::packCoords(grp.atoms, xyz);
       uint ncontacts = 0;
 
       for (uint j = 0; j<size(); ++j) {
-        GCoord c = atoms[j]->coords();
-	    for (uint i = 0; i<grp.size(); ++i)
-            if (distance_function(c, grp.atoms[i]->coords()) <= dist2)
-	          if (++ncontacts >= min_contacts)
-	             return(true);
+        const GCoord& c = atoms[j]->coords();
+        double u[3] = { c.x(), c.y(), c.z() };
+        ncontacts += DistanceKernels::countWithinBatch(op, u, xyz.data(), grp.size());
+        if (ncontacts >= min_contacts)
+          return(true);
       }
       return(false);
     }
@@ -874,21 +873,22 @@ namespace loos {
 	   */
 	  template<typename DistanceCalc>
 	  void findBondsImpl(const double dist, const DistanceCalc& distance_function) {
-		  iterator ij;
-		  double dist2 = dist * dist;
-		  double current_dist2;
-
-		  for (ij = begin(); ij != end() - 1; ++ij) {
-			  iterator ii;
-			  GCoord u = (*ij)->coords();
+		  if (atoms.size() < 2)
+			  return;
 
-			  for (ii = ij + 1; ii != end(); ++ii) {
-				  current_dist2 = distance_function(u, (*ii)->coords());
-				  if (current_dist2 < dist2) {
-					  (*ij)->addBond(*ii);
-					  (*ii)->addBond(*ij);
+		  double dist2 = dist * dist;
+		  std::vector<double> xyz;
+		  DistanceKernels::packCoords(atoms, xyz);
+		  std::vector<double> d2(atoms.size());
+
+		  for (uint j=0; j<atoms.size() - 1; ++j) {
+			  uint n = atoms.size() - j - 1;
+			  DistanceKernels::distance2Batch(distance_function, &xyz[3*j], &xyz[3*(j+1)], n, d2.data());
+			  for (uint i=0; i<n; ++i)
+				  if (d2[i] < dist2) {
+					  atoms[j]->addBond(atoms[j+i+1]);
+					  atoms[j+i+1]->addBond(atoms[j]);
 				  }
-			  }
 		  }
 	  }
 
@@ -0,0 +1,191 @@
+/*
+  This file is part of LOOS.
+
+  LOOS (Lightweight Object-Oriented Structure library)
+  Copyright (c) 2008, Tod D. Romo, Alan Grossfield
+  Department of Biochemistry and Biophysics
+  School of Medicine & Dentistry, University of Rochester
+
+  This package (LOOS) is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation under version 3 of the License.
+
+  This package is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+
+#include <BondOrientationKernel.hpp>
+#include <exceptions.hpp>
+
+
+namespace loos {
+
+
+  uint BondOrientationKernel::atomIndex(const pAtom& a) {
+    std::map<const Atom*, uint>::const_iterator i = _index.find(a.get());
+    if (i != _index.end())
+      return(i->second);
+
+    uint n = _atoms.size();
+    _atoms.push_back(a);
+    _index[a.get()] = n;
+    return(n);
+  }
+
+
+  void BondOrientationKernel::addVector(const uint position, const pAtom& a, const pAtom& b) {
+    _first.push_back(atomIndex(a));
+    _second.push_back(atomIndex(b));
+    _position.push_back(position);
+    if (position >= _npositions) {
+      _npositions = position + 1;
+      _sums.resize(2 * _npositions, 0.0);
+      _counts.resize(2 * _npositions, 0);
+    }
+  }
+
+
+  void BondOrientationKernel::addVectors(const uint position, const AtomicGroup& a, const AtomicGroup& b) {
+    if (a.size() != b.size())
+      throw(LOOSError("Groups of atoms for bond vectors must be the same size"));
+    for (uint i=0; i<a.size(); ++i)
+      addVector(position, a[i], b[i]);
+  }
+
+
+  BondOrientationKernel BondOrientationKernel::fromBonds(const std::vector<AtomicGroup>& positions,
+                                                         const AtomicGroup& system,
+                                                         const AtomSelector& partners) {
+    BondOrientationKernel kernel(positions.size());
+    for (uint i=0; i<positions.size(); ++i)
+      for (AtomicGroup::const_iterator j = positions[i].begin(); j != positions[i].end(); ++j) {
+        AtomicGroup bonded = system.groupFromID((*j)->getBonds()).select(partners);
+        if (bonded.empty())
+          throw(LOOSError(**j, "No bonded partners found for atom"));
+        for (AtomicGroup::const_iterator k = bonded.begin(); k != bonded.end(); ++k)
+          kernel.addVector(i, *j, *k);
+      }
+
+    return(kernel);
+  }
+
+
+  // Copies the coordinates of all atoms involved into contiguous
+  // arrays, so the per-vector loops below only do indexed loads
+  void BondOrientationKernel::pack() {
+    uint n = _atoms.size();
+    _x.resize(n);
+    _y.resize(n);
+    _z.resize(n);
+    for (uint i=0; i<n; ++i) {
+      const GCoord& c = _atoms[i]->coords();
+      _x[i] = c.x();
+      _y[i] = c.y();
+      _z[i] = c.z();
+    }
+
+    _cosines.resize(_first.size());
+    _leaflet.resize(_first.size());
+  }
+
+
+  void BondOrientationKernel::compute(const GCoord& normal, const GCoord& center) {
+    pack();
+
+    GCoord u = normal / normal.length();
+    const double ux = u.x(), uy = u.y(), uz = u.z();
+    const double h0 = u * center;
+
+    const uint* first = _first.empty() ? 0 : &_first[0];
+    const uint* second = _second.empty() ? 0 : &_second[0];
+    const double* x = _x.empty() ? 0 : &_x[0];
+    const double* y = _y.empty() ? 0 : &_y[0];
+    const double* z = _z.empty() ? 0 : &_z[0];
+    double* cosines = _cosines.empty() ? 0 : &_cosines[0];
+    unsigned char* leaflet = _leaflet.empty() ? 0 : &_leaflet[0];
+
+    uint n = _first.size();
+    for (uint k=0; k<n; ++k) {
+      uint i = first[k], j = second[k];
+      double dx = x[j] - x[i];
+      double dy = y[j] - y[i];
+      double dz = z[j] - z[i];
+      cosines[k] = (dx*ux + dy*uy + dz*uz) / sqrt(dx*dx + dy*dy + dz*dz);
+      leaflet[k] = (x[i]*ux + y[i]*uy + z[i]*uz) < h0;
+    }
+
+    reduce();
+  }
+
+
+  void BondOrientationKernel::compute(const std::vector<GCoord>& normals, const GCoord& center) {
+    if (normals.size() != _first.size())
+      throw(LOOSError("Need one normal for each bond vector"));
+    pack();
+
+    uint n = _first.size();
+    for (uint k=0; k<n; ++k) {
+      uint i = _first[k], j = _second[k];
+      const GCoord& nk = normals[k];
+      double len = nk.length();
+      double ux = nk.x() / len, uy = nk.y() / len, uz = nk.z() / len;
+      double dx = _x[j] - _x[i];
+      double dy = _y[j] - _y[i];
+      double dz = _z[j] - _z[i];
+      _cosines[k] = (dx*ux + dy*uy + dz*uz) / sqrt(dx*dx + dy*dy + dz*dz);
+      _leaflet[k] = ((_x[i] - center.x())*ux + (_y[i] - center.y())*uy + (_z[i] - center.z())*uz) < 0.0;
+    }
+
+    reduce();
+  }
+
+
+  void BondOrientationKernel::reduce() {
+    _sums.assign(2 * _npositions, 0.0);
+    _counts.assign(2 * _npositions, 0);
+
+    uint n = _first.size();
+    for (uint k=0; k<n; ++k) {
+      double c = _cosines[k];
+      uint slot = 2 * _position[k] + _leaflet[k];
+      _sums[slot] += 1.5 * c * c - 0.5;
+      ++_counts[slot];
+    }
+  }
+
+
+  double BondOrientationKernel::order(const uint position) const {
+    if (position >= _npositions)
+      throw(std::out_of_range("Bad position in BondOrientationKernel"));
+    uint n = _counts[2*position] + _counts[2*position+1];
+    if (n == 0)
+      return(std::numeric_limits<double>::quiet_NaN());
+    return((_sums[2*position] + _sums[2*position+1]) / n);
+  }
+
+
+  double BondOrientationKernel::order(const uint position, const Leaflet leaflet) const {
+    if (position >= _npositions)
+      throw(std::out_of_range("Bad position in BondOrientationKernel"));
+    uint n = _counts[2*position + leaflet];
+    return(n ? _sums[2*position + leaflet] / n : 0.0);
+  }
+
+
+  uint BondOrientationKernel::count(const uint position, const Leaflet leaflet) const {
+    if (position >= _npositions)
+      throw(std::out_of_range("Bad position in BondOrientationKernel"));
+    return(_counts[2*position + leaflet]);
+  }
+
+}
@@ -0,0 +1,143 @@
+/*
+  This file is part of LOOS.
+
+  LOOS (Lightweight Object-Oriented Structure library)
+  Copyright (c) 2008, Tod D. Romo, Alan Grossfield
+  Department of Biochemistry and Biophysics
+  School of Medicine & Dentistry, University of Rochester
+
+  This package (LOOS) is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation under version 3 of the License.
+
+  This package is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#if !defined(LOOS_BOND_ORIENTATION_KERNEL_HPP)
+#define LOOS_BOND_ORIENTATION_KERNEL_HPP
+
+#include <map>
+#include <vector>
+
+#include <loos_defs.hpp>
+#include <AtomicGroup.hpp>
+
+
+namespace loos {
+
+
+  //! Order parameters from the orientations of many bond vectors
+  /**
+   * Each vector runs between a pair of atoms (e.g. a carbon and one
+   * of its hydrogens) and belongs to a position (e.g. a carbon number
+   * along a lipid chain).  The pairs are compiled once into flat index
+   * arrays, so each frame only packs the coordinates of the atoms
+   * involved into contiguous arrays and then runs simple loops over
+   * the pairs.  These loops are scalar; most of the time goes into
+   * gathering the coordinates from the atoms, not into the loops.
+   * For each vector, the cosine of its angle with the membrane normal
+   * is found, and the order parameter S = (3cos^2 - 1)/2 is averaged
+   * over all vectors at each position.
+   *
+   * The normal can be the same for every vector (e.g. the z-axis), or
+   * given separately for each vector (e.g. a local leaflet normal).
+   * Vectors are also split by leaflet, based on which side of the
+   * membrane center (along the normal) the first atom of the pair is
+   * on, so per-leaflet profiles come out of the same pass.
+   *
+   * For example, to compute C-H order parameters for carbons grouped
+   * by chain position, using the hydrogens bonded to each carbon,
+   * \code
+   * BondOrientationKernel kernel = BondOrientationKernel::fromBonds(carbons, system, HydrogenSelector());
+   * while (traj->readFrame()) {
+   *   traj->updateGroupCoords(system);
+   *   kernel.compute(GCoord(0,0,1));
+   *   for (uint i=0; i<kernel.positions(); ++i)
+   *     scd[i] += kernel.order(i);
+   * }
+   * \endcode
+   */
+  class BondOrientationKernel {
+  public:
+    enum Leaflet { UPPER = 0, LOWER = 1 };
+
+    BondOrientationKernel() : _npositions(0) { }
+
+    //! Starts with \a npositions positions, even if some get no vectors
+    explicit BondOrientationKernel(const uint npositions)
+      : _npositions(npositions), _sums(2 * npositions, 0.0), _counts(2 * npositions, 0) { }
+
+    //! Adds the vector from \a a to \a b at \a position
+    void addVector(const uint position, const pAtom& a, const pAtom& b);
+
+    //! Adds vectors from each atom of \a a to the corresponding atom of \a b
+    void addVectors(const uint position, const AtomicGroup& a, const AtomicGroup& b);
+
+    //! Builds a kernel from the atoms in \a system bonded to each atom in \a positions
+    /**
+     * Each atom in positions[i] is paired with every atom of \a system
+     * it is bonded to that \a partners picks (e.g. a HydrogenSelector),
+     * at position i.  Throws a LOOSError if an atom has no such partner.
+     */
+    static BondOrientationKernel fromBonds(const std::vector<AtomicGroup>& positions,
+                                           const AtomicGroup& system,
+                                           const AtomSelector& partners);
+
+    //! Number of positions
+    uint positions() const { return(_npositions); }
+
+    //! Number of vectors
+    uint size() const { return(_first.size()); }
+
+    //! Computes order parameters for the current coordinates against one normal
+    /**
+     * The leaflet of each vector is set by which side of the plane
+     * through \a center (perpendicular to \a normal) the first atom is
+     * on.
+     */
+    void compute(const GCoord& normal, const GCoord& center = GCoord(0,0,0));
+
+    //! Computes order parameters using a separate normal for each vector
+    void compute(const std::vector<GCoord>& normals, const GCoord& center = GCoord(0,0,0));
+
+    //! Average order parameter at \a position over both leaflets (NaN if there are no vectors)
+    double order(const uint position) const;
+
+    //! Average order parameter at \a position in one leaflet (0 if there are no vectors)
+    double order(const uint position, const Leaflet leaflet) const;
+
+    //! Number of vectors at \a position in \a leaflet for the last frame
+    uint count(const uint position, const Leaflet leaflet) const;
+
+    //! Cosines of each vector with the normal for the last frame
+    const std::vector<double>& cosines() const { return(_cosines); }
+
+
+  private:
+    uint atomIndex(const pAtom& a);
+    void pack();
+    void reduce();
+
+    uint _npositions;
+    std::vector<pAtom> _atoms;
+    std::map<const Atom*, uint> _index;
+    std::vector<uint> _first, _second, _position;
+
+    std::vector<double> _x, _y, _z;
+    std::vector<double> _cosines;
+    std::vector<unsigned char> _leaflet;
+    std::vector<double> _sums;
+    std::vector<uint> _counts;
+  };
+
+}
+
+
+#endif
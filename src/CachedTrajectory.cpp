@@ -0,0 +1,297 @@
+/*
+  This file is part of LOOS.
+
+  LOOS (Lightweight Object-Oriented Structure library)
+  Copyright (c) 2008, Tod D. Romo, Alan Grossfield
+  Department of Biochemistry and Biophysics
+  School of Medicine & Dentistry, University of Rochester
+
+  This package (LOOS) is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation under version 3 of the License.
+
+  This package is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include <CachedTrajectory.hpp>
+#include <exceptions.hpp>
+
+
+namespace loos {
+
+  namespace internal {
+
+    FrameCache::FrameCache(const pTraj& traj, const unsigned long max_bytes, const std::vector<uint>& indices,
+                           const bool double_precision)
+      : _traj(traj), _indices(indices), _slots(traj->natoms(), -1), _double(double_precision),
+        _scratch(double_precision ? std::vector<uint>() : indices),
+        _max_bytes(max_bytes), _bytes(0), _hits(0), _misses(0), _evictions(0)
+    {
+      for (uint i=0; i<_indices.size(); ++i) {
+        if (_indices[i] >= _slots.size())
+          throw(LOOSError("Atom index is out of bounds for the trajectory being cached"));
+        _slots[_indices[i]] = i;
+      }
+
+      // Double-precision frames are decoded through updateGroupCoords(),
+      // into bare atoms that only carry their index
+      if (_double)
+        for (uint i=0; i<_indices.size(); ++i) {
+          pAtom a(new Atom);
+          a->index(_indices[i]);
+          _dscratch.append(a);
+        }
+    }
+
+
+    FrameCache::pFrame FrameCache::frame(const uint i) {
+      pFrame f = lookup(i);
+      if (f)
+        return(f);
+
+      // Only one frame is read from the trajectory at a time, but
+      // cached frames can still be found while one is being decoded
+      boost::mutex::scoped_lock read_lock(_read_lock);
+      f = lookup(i);
+      if (f)
+        return(f);
+
+      if (!_traj->readFrame(i))
+        throw(FileReadError(_traj->filename(), "Unable to read trajectory frame"));
+
+      boost::shared_ptr<Frame> decoded(new Frame);
+      if (_double) {
+        _traj->updateGroupCoords(_dscratch);
+        decoded->dxyz.resize(3 * _dscratch.size());
+        for (uint k=0; k<_dscratch.size(); ++k) {
+          const GCoord& c = _dscratch[k]->coords();
+          decoded->dxyz[3*k] = c.x();
+          decoded->dxyz[3*k+1] = c.y();
+          decoded->dxyz[3*k+2] = c.z();
+        }
+        decoded->periodic = _traj->hasPeriodicBox();
+        decoded->box = _dscratch.periodicBox();
+      } else {
+        _scratch.coords().resize(3 * _indices.size());
+        _scratch.clearPeriodicBox();
+        _traj->updateFrameCoords(_scratch);
+
+        decoded->xyz.swap(_scratch.coords());
+        decoded->periodic = _scratch.isPeriodic();
+        decoded->box = _scratch.periodicBox();
+      }
+
+      boost::mutex::scoped_lock lock(_lock);
+      ++_misses;
+      _frames.push_front(std::make_pair(i, pFrame(decoded)));
+      _index[i] = _frames.begin();
+      _bytes += frameBytes(*decoded);
+      evict();
+
+      return(decoded);
+    }
+
+
+    // Returns the cached frame (marking it as most recently used), or
+    // an empty pointer if it is not cached
+    FrameCache::pFrame FrameCache::lookup(const uint i) {
+      boost::mutex::scoped_lock lock(_lock);
+
+      std::map<uint, FrameList::iterator>::iterator j = _index.find(i);
+      if (j == _index.end())
+        return(pFrame());
+
+      ++_hits;
+      _frames.splice(_frames.begin(), _frames, j->second);
+      return(j->second->second);
+    }
+
+
+    unsigned long FrameCache::frameBytes(const Frame& f) {
+      return(f.xyz.size() * sizeof(float) + f.dxyz.size() * sizeof(double));
+    }
+
+
+    // Always keeps at least the most recently used frame
+    void FrameCache::evict() {
+      while (_bytes > _max_bytes && _frames.size() > 1) {
+        _bytes -= frameBytes(*(_frames.back().second));
+        _index.erase(_frames.back().first);
+        _frames.pop_back();
+        ++_evictions;
+      }
+    }
+
+
+    unsigned long FrameCache::maxBytes() const {
+      boost::mutex::scoped_lock lock(_lock);
+      return(_max_bytes);
+    }
+
+
+    void FrameCache::maxBytes(const unsigned long n) {
+      boost::mutex::scoped_lock lock(_lock);
+      _max_bytes = n;
+      evict();
+    }
+
+
+    unsigned long FrameCache::bytes() const {
+      boost::mutex::scoped_lock lock(_lock);
+      return(_bytes);
+    }
+
+
+    uint FrameCache::size() const {
+      boost::mutex::scoped_lock lock(_lock);
+      return(_frames.size());
+    }
+
+
+    unsigned long FrameCache::hits() const {
+      boost::mutex::scoped_lock lock(_lock);
+      return(_hits);
+    }
+
+
+    unsigned long FrameCache::misses() const {
+      boost::mutex::scoped_lock lock(_lock);
+      return(_misses);
+    }
+
+
+    unsigned long FrameCache::evictions() const {
+      boost::mutex::scoped_lock lock(_lock);
+      return(_evictions);
+    }
+
+
+    void FrameCache::clear() {
+      boost::mutex::scoped_lock lock(_lock);
+      _frames.clear();
+      _index.clear();
+      _bytes = 0;
+    }
+
+
+    void FrameCache::resetStatistics() {
+      boost::mutex::scoped_lock lock(_lock);
+      _hits = _misses = _evictions = 0;
+    }
+
+  }
+
+
+
+  CachedTrajectory::CachedTrajectory(const pTraj& traj, const unsigned long max_bytes)
+    : _subset(false)
+  {
+    std::vector<uint> indices(traj->natoms());
+    for (uint i=0; i<indices.size(); ++i)
+      indices[i] = i;
+    _cache = internal::pFrameCache(new internal::FrameCache(traj, max_bytes, indices));
+    init();
+  }
+
+
+  CachedTrajectory::CachedTrajectory(const pTraj& traj, const unsigned long max_bytes, const AtomicGroup& subset)
+    : _subset(true)
+  {
+    std::vector<uint> indices;
+    indices.reserve(subset.size());
+    for (AtomicGroup::const_iterator i = subset.begin(); i != subset.end(); ++i) {
+      if (!(*i)->checkProperty(Atom::indexbit))
+        throw(LOOSError(**i, "Atom has no index, so it cannot be cached from a trajectory"));
+      indices.push_back((*i)->index());
+    }
+    _cache = internal::pFrameCache(new internal::FrameCache(traj, max_bytes, indices));
+    init();
+  }
+
+
+  void CachedTrajectory::init() {
+    _filename = _cache->trajectory()->filename();
+    if (nframes()) {
+      parseFrame();
+      cached_first = true;
+    }
+  }
+
+
+  bool CachedTrajectory::parseFrame(void) {
+    if (_current_frame >= nframes())
+      return(false);
+
+    _frame = _cache->frame(_current_frame);
+    return(true);
+  }
+
+
+  std::vector<GCoord> CachedTrajectory::coords(void) const {
+    if (_subset)
+      throw(LOOSError("Only a subset of atoms is cached, so the whole frame is not available"));
+    if (!_frame)
+      return(std::vector<GCoord>());
+
+    uint n = _frame->xyz.size() / 3;
+    std::vector<GCoord> crds(n);
+    for (uint i=0; i<n; ++i)
+      crds[i] = GCoord(_frame->xyz[3*i], _frame->xyz[3*i+1], _frame->xyz[3*i+2]);
+    return(crds);
+  }
+
+
+  void CachedTrajectory::updateGroupCoordsImpl(AtomicGroup& g) {
+    if (!_frame)
+      throw(LOOSError("No frame has been read from the cached trajectory"));
+
+    const std::vector<float>& xyz = _frame->xyz;
+    for (AtomicGroup::iterator i = g.begin(); i != g.end(); ++i) {
+      int k = _cache->slot((*i)->index());
+      if (k < 0)
+        throw(LOOSError(**i, "Atom is not in the cached subset of the trajectory"));
+      (*i)->coords(GCoord(xyz[3*k], xyz[3*k+1], xyz[3*k+2]));
+    }
+
+    if (_frame->periodic)
+      g.periodicBox(_frame->box);
+  }
+
+
+  void CachedTrajectory::updateFrameCoordsImpl(FloatFrame& f) {
+    if (!_frame)
+      throw(LOOSError("No frame has been read from the cached trajectory"));
+
+    const std::vector<float>& xyz = _frame->xyz;
+    const std::vector<uint>& indices = f.indices();
+    float* dst = f.data();
+    for (uint i=0; i<indices.size(); ++i) {
+      int k = _cache->slot(indices[i]);
+      if (k < 0)
+        throw(LOOSError("Atom is not in the cached subset of the trajectory"));
+      dst[3*i] = xyz[3*k];
+      dst[3*i+1] = xyz[3*k+1];
+      dst[3*i+2] = xyz[3*k+2];
+    }
+
+    if (_frame->periodic)
+      f.periodicBox(_frame->box);
+    else
+      f.clearPeriodicBox();
+  }
+
+
+  double CachedTrajectory::hitRate() const {
+    unsigned long h = hits();
+    unsigned long n = h + misses();
+    return(n ? static_cast<double>(h) / n : 0.0);
+  }
+
+}
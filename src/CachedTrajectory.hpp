@@ -0,0 +1,232 @@
+/*
+  This file is part of LOOS.
+
+  LOOS (Lightweight Object-Oriented Structure library)
+  Copyright (c) 2008, Tod D. Romo, Alan Grossfield
+  Department of Biochemistry and Biophysics
+  School of Medicine & Dentistry, University of Rochester
+
+  This package (LOOS) is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation under version 3 of the License.
+
+  This package is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#if !defined(LOOS_CACHED_TRAJECTORY_HPP)
+#define LOOS_CACHED_TRAJECTORY_HPP
+
+#include <list>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <boost/shared_ptr.hpp>
+#include <boost/thread/mutex.hpp>
+
+#include <loos_defs.hpp>
+#include <AtomicGroup.hpp>
+#include <FloatFrame.hpp>
+#include <Trajectory.hpp>
+
+
+namespace loos {
+
+  namespace internal {
+
+    // Least-recently-used cache of decoded frames from one
+    // trajectory, shared by all copies of a CachedTrajectory.  Frames
+    // are normally kept in single precision (in xyz), but can be kept
+    // in double precision instead (in dxyz) when they must match the
+    // trajectory exactly, as for the AnalysisServer.
+    class FrameCache {
+    public:
+      struct Frame {
+        std::vector<float> xyz;
+        std::vector<double> dxyz;
+        bool periodic;
+        GCoord box;
+      };
+
+      typedef boost::shared_ptr<const Frame>    pFrame;
+
+      FrameCache(const pTraj& traj, const unsigned long max_bytes, const std::vector<uint>& indices,
+                 const bool double_precision = false);
+
+      // Returns frame i, reading it from the trajectory if it is not
+      // already cached
+      pFrame frame(const uint i);
+
+      pTraj trajectory() const { return(_traj); }
+      const std::vector<uint>& indices() const { return(_indices); }
+
+      // Position of trajectory atom idx in a cached frame, or -1 if
+      // it is not cached
+      int slot(const uint idx) const { return(idx < _slots.size() ? _slots[idx] : -1); }
+
+      bool doublePrecision() const { return(_double); }
+
+      unsigned long maxBytes() const;
+      void maxBytes(const unsigned long n);
+
+      unsigned long bytes() const;
+      uint size() const;
+      unsigned long hits() const;
+      unsigned long misses() const;
+      unsigned long evictions() const;
+
+      void clear();
+      void resetStatistics();
+
+    private:
+      FrameCache(const FrameCache&);
+      FrameCache& operator=(const FrameCache&);
+
+      typedef std::list< std::pair<uint, pFrame> >    FrameList;
+
+      pFrame lookup(const uint i);
+      void evict();
+      static unsigned long frameBytes(const Frame& f);
+
+      pTraj _traj;
+      std::vector<uint> _indices;
+      std::vector<int> _slots;
+      bool _double;
+      FloatFrame _scratch;          // Only used while holding _read_lock
+      AtomicGroup _dscratch;        // Ditto, for double precision
+
+      unsigned long _max_bytes, _bytes;
+      unsigned long _hits, _misses, _evictions;
+
+      FrameList _frames;
+      std::map<uint, FrameList::iterator> _index;
+
+      mutable boost::mutex _lock;
+      boost::mutex _read_lock;
+    };
+
+    typedef boost::shared_ptr<FrameCache>    pFrameCache;
+  }
+
+
+
+  //! Trajectory that keeps recently read frames in memory
+  /**
+   * Wraps another trajectory and keeps the most recently used frames,
+   * already decoded, in memory, up to a fixed number of bytes.  When
+   * the cache is full, the least recently used frame is dropped.
+   * Frames that are revisited (e.g. bootstrapping, clustering, or
+   * comparing every frame against every other frame) come from memory
+   * instead of being read and decoded again, which matters most for
+   * compressed formats such as XTC.  At least the current frame is
+   * always kept, even if it is larger than the cache.
+   *
+   * Coordinates are stored in single precision.  Optionally, only a
+   * subset of the atoms (e.g. the selection being analyzed) is cached,
+   * so many more frames fit in the same space.  In this case, only
+   * those atoms can be updated from the trajectory and coords() is not
+   * available.
+   *
+   * Copies of a CachedTrajectory have their own current frame, but
+   * share the same cache, so different parts of a program (or
+   * different threads) can read the same frames without decoding them
+   * twice.  The wrapped trajectory should not be read directly once
+   * it has been wrapped.
+   *
+   * Example:
+   * \code
+   * pTraj traj = createTrajectory(traj_name, model);
+   * CachedTrajectory cached(traj, 512ul << 20, subset);
+   * for (uint i=0; i<ntrials; ++i) {
+   *   cached.readFrame(picks[i]);
+   *   cached.updateGroupCoords(subset);
+   *   ...
+   * }
+   * std::cerr << "Cache hit rate: " << cached.hitRate() << std::endl;
+   * \endcode
+   */
+  class CachedTrajectory : public Trajectory {
+  public:
+    //! Caches up to \a max_bytes of frames from \a traj (all atoms)
+    CachedTrajectory(const pTraj& traj, const unsigned long max_bytes);
+
+    //! Caches up to \a max_bytes of frames, but only for the atoms in \a subset
+    CachedTrajectory(const pTraj& traj, const unsigned long max_bytes, const AtomicGroup& subset);
+
+    std::string description() const { return(_cache->trajectory()->description() + " (cached)"); }
+
+    uint natoms(void) const { return(_cache->trajectory()->natoms()); }
+    float timestep(void) const { return(_cache->trajectory()->timestep()); }
+    uint nframes(void) const { return(_cache->trajectory()->nframes()); }
+    bool hasPeriodicBox(void) const { return(_cache->trajectory()->hasPeriodicBox()); }
+    GCoord periodicBox(void) const { return(_frame ? _frame->box : GCoord(0,0,0)); }
+
+    //! Current frame (throws if only a subset of atoms is cached, empty if no frame has been read)
+    std::vector<GCoord> coords(void) const;
+
+    bool parseFrame(void);
+
+
+    //! The wrapped trajectory
+    pTraj trajectory() const { return(_cache->trajectory()); }
+
+    //! True if only some of the atoms are cached
+    bool isSubset() const { return(_subset); }
+
+    //! Maximum size of the cache, in bytes
+    unsigned long maxBytes() const { return(_cache->maxBytes()); }
+
+    //! Changes the maximum size of the cache (dropping frames if necessary)
+    void maxBytes(const unsigned long n) { _cache->maxBytes(n); }
+
+    //! Bytes of coordinates currently cached
+    unsigned long bytes() const { return(_cache->bytes()); }
+
+    //! Number of frames currently cached
+    uint cachedFrames() const { return(_cache->size()); }
+
+    //! Frames found in the cache
+    unsigned long hits() const { return(_cache->hits()); }
+
+    //! Frames that had to be read from the wrapped trajectory
+    unsigned long misses() const { return(_cache->misses()); }
+
+    //! Frames dropped to make room for others
+    unsigned long evictions() const { return(_cache->evictions()); }
+
+    //! Fraction of frames found in the cache (0 if nothing has been read)
+    double hitRate() const;
+
+    //! Drops all cached frames (the current frame is kept until the next read)
+    void clear() { _cache->clear(); }
+
+    //! Zeroes the hit, miss, and eviction counts
+    void resetStatistics() { _cache->resetStatistics(); }
+
+  private:
+    void rewindImpl(void) { }
+    void seekNextFrameImpl(void) { }
+    void seekFrameImpl(const uint i) { }
+    void updateGroupCoordsImpl(AtomicGroup& g);
+    void updateFrameCoordsImpl(FloatFrame& f);
+
+    void init();
+
+    internal::pFrameCache _cache;
+    internal::FrameCache::pFrame _frame;
+    bool _subset;
+  };
+
+
+}
+
+
+#endif
@@ -0,0 +1,241 @@
+/*
+  This file is part of LOOS.
+
+  LOOS (Lightweight Object-Oriented Structure library)
+  Copyright (c) 2008, Tod D. Romo, Alan Grossfield
+  Department of Biochemistry and Biophysics
+  School of Medicine & Dentistry, University of Rochester
+
+  This package (LOOS) is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation under version 3 of the License.
+
+  This package is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+#include <boost/cstdint.hpp>
+
+#include <CompressedEnsemble.hpp>
+#include <exceptions.hpp>
+
+
+namespace loos {
+
+
+  CompressedEnsemble::CompressedEnsemble(const Storage storage, const double precision)
+    : _storage(storage), _precision(precision), _natoms(0), _max_error(0.0)
+  {
+    if (_storage == FIXED && !(_precision > 0.0))
+      throw(LOOSError("Precision for a CompressedEnsemble must be positive"));
+  }
+
+
+  CompressedEnsemble::Storage CompressedEnsemble::storageFromName(const std::string& name) {
+    if (name == "double")
+      return(DOUBLE);
+    else if (name == "float")
+      return(FLOAT);
+    else if (name == "int16")
+      return(INT16);
+    else if (name == "fixed")
+      return(FIXED);
+
+    throw(LOOSError("Unknown ensemble storage '" + name + "' (must be double, float, int16, or fixed)"));
+  }
+
+
+  // Stores (v - origin) / scale for each coordinate as a T, rounding
+  // to the nearest integer for integer types
+  template<typename T>
+  void CompressedEnsemble::pack(const std::vector<double>& v, const Header& h) {
+    _data.resize(h.offset + v.size() * sizeof(T));
+    unsigned char* p = &_data[h.offset];
+
+    for (uint i=0; i<v.size(); ++i) {
+      uint k = i % 3;
+      double t = (v[i] - h.origin[k]) / h.scale[k];
+      T q;
+      if (std::numeric_limits<T>::is_integer)
+        q = static_cast<T>(std::min(std::floor(t + 0.5), static_cast<double>(std::numeric_limits<T>::max())));
+      else
+        q = static_cast<T>(t);
+      std::memcpy(p + i * sizeof(T), &q, sizeof(T));
+    }
+  }
+
+
+  template<typename T>
+  void CompressedEnsemble::unpack(const Header& h, double* out) const {
+    const unsigned char* p = &_data[h.offset];
+    uint n = 3 * _natoms;
+
+    for (uint i=0; i<n; i += 3) {
+      T q[3];
+      std::memcpy(q, p + i * sizeof(T), 3 * sizeof(T));
+      out[i] = h.origin[0] + q[0] * h.scale[0];
+      out[i+1] = h.origin[1] + q[1] * h.scale[1];
+      out[i+2] = h.origin[2] + q[2] * h.scale[2];
+    }
+  }
+
+
+  // Integer storage relative to the lower corner of the frame's
+  // bounding box.  INT16 spreads 65536 levels over each axis' range,
+  // while FIXED uses the requested precision and only widens to 32
+  // bits when the range needs it.
+  void CompressedEnsemble::encodeScaled(const std::vector<double>& v, Header& h, const bool fixed) {
+    double lo[3], hi[3];
+    for (uint k=0; k<3; ++k) {
+      lo[k] = std::numeric_limits<double>::max();
+      hi[k] = -std::numeric_limits<double>::max();
+    }
+    for (uint i=0; i<v.size(); ++i) {
+      lo[i%3] = std::min(lo[i%3], v[i]);
+      hi[i%3] = std::max(hi[i%3], v[i]);
+    }
+
+    double levels = 0.0;
+    for (uint k=0; k<3; ++k) {
+      h.origin[k] = lo[k];
+      if (fixed)
+        h.scale[k] = _precision;
+      else
+        h.scale[k] = (hi[k] > lo[k]) ? (hi[k] - lo[k]) / std::numeric_limits<boost::uint16_t>::max() : 1.0;
+      levels = std::max(levels, std::ceil((hi[k] - lo[k]) / h.scale[k]));
+      if (hi[k] > lo[k])
+        _max_error = std::max(_max_error, 0.5 * h.scale[k]);
+    }
+
+    // INT16 always fits by construction (levels may round up past the limit)
+    if (!fixed || levels <= std::numeric_limits<boost::uint16_t>::max()) {
+      h.width = 2;
+      pack<boost::uint16_t>(v, h);
+    } else if (levels <= std::numeric_limits<boost::uint32_t>::max()) {
+      h.width = 4;
+      pack<boost::uint32_t>(v, h);
+    } else
+      throw(LOOSError("Precision is too fine for the range of coordinates in a CompressedEnsemble"));
+  }
+
+
+  // FIXED frames may need 32 bits, but most will not
+  void CompressedEnsemble::reserve(const uint nframes, const uint natoms) {
+    unsigned long width = (_storage == DOUBLE) ? sizeof(double) : (_storage == FLOAT) ? sizeof(float) : sizeof(boost::uint16_t);
+    _data.reserve(static_cast<unsigned long>(nframes) * 3 * natoms * width);
+    _frames.reserve(nframes);
+  }
+
+
+  void CompressedEnsemble::append(const std::vector<double>& v) {
+    if (_frames.empty()) {
+      if (v.size() % 3)
+        throw(LOOSError("Frame added to a CompressedEnsemble must have 3 coordinates per atom"));
+      _natoms = v.size() / 3;
+    } else if (v.size() != 3 * _natoms)
+      throw(LOOSError("Frame added to a CompressedEnsemble has the wrong number of atoms"));
+
+    Header h;
+    h.offset = _data.size();
+    for (uint k=0; k<3; ++k) {
+      h.origin[k] = 0.0;
+      h.scale[k] = 1.0;
+    }
+
+    switch(_storage) {
+    case DOUBLE:
+      h.width = sizeof(double);
+      pack<double>(v, h);
+      break;
+
+    case FLOAT:
+      h.width = sizeof(float);
+      pack<float>(v, h);
+      for (uint i=0; i<v.size(); ++i)
+        _max_error = std::max(_max_error, std::fabs(v[i] - static_cast<float>(v[i])));
+      break;
+
+    case INT16:
+      encodeScaled(v, h, false);
+      break;
+
+    case FIXED:
+      encodeScaled(v, h, true);
+      break;
+    }
+
+    _frames.push_back(h);
+  }
+
+
+  void CompressedEnsemble::append(const AtomicGroup& g) {
+    std::vector<double> v(3 * g.size());
+    for (uint i=0; i<g.size(); ++i) {
+      const GCoord& c = g[i]->coords();
+      v[3*i] = c.x();
+      v[3*i+1] = c.y();
+      v[3*i+2] = c.z();
+    }
+    append(v);
+  }
+
+
+  void CompressedEnsemble::decode(const uint i, std::vector<double>& v) const {
+    if (i >= _frames.size())
+      throw(LOOSError("Frame index into a CompressedEnsemble is out of bounds"));
+
+    v.resize(3 * _natoms);
+    const Header& h = _frames[i];
+
+    if (_storage == DOUBLE)
+      unpack<double>(h, v.data());
+    else if (_storage == FLOAT)
+      unpack<float>(h, v.data());
+    else if (h.width == 2)
+      unpack<boost::uint16_t>(h, v.data());
+    else
+      unpack<boost::uint32_t>(h, v.data());
+  }
+
+
+  void CompressedEnsemble::decode(const uint first, const uint n, std::vector< std::vector<double> >& tile) const {
+    uint m = (first < size()) ? std::min(n, size() - first) : 0;
+    tile.resize(m);
+    for (uint i=0; i<m; ++i)
+      decode(first + i, tile[i]);
+  }
+
+
+  uint CompressedEnsemble::tileFrames(const unsigned long bytes) const {
+    unsigned long frame_bytes = 3ul * _natoms * sizeof(double);
+    if (!frame_bytes)
+      return(1);
+    return(std::max(1ul, bytes / frame_bytes));
+  }
+
+
+  unsigned long CompressedEnsemble::bytes() const {
+    return(_data.size() + _frames.size() * sizeof(Header));
+  }
+
+
+  void CompressedEnsemble::clear() {
+    _data.clear();
+    _frames.clear();
+    _natoms = 0;
+    _max_error = 0.0;
+  }
+
+
+}
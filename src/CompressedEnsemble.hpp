@@ -0,0 +1,154 @@
+/*
+  This file is part of LOOS.
+
+  LOOS (Lightweight Object-Oriented Structure library)
+  Copyright (c) 2008, Tod D. Romo, Alan Grossfield
+  Department of Biochemistry and Biophysics
+  School of Medicine & Dentistry, University of Rochester
+
+  This package (LOOS) is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation under version 3 of the License.
+
+  This package is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#if !defined(LOOS_COMPRESSED_ENSEMBLE_HPP)
+#define LOOS_COMPRESSED_ENSEMBLE_HPP
+
+#include <string>
+#include <vector>
+
+#include <loos_defs.hpp>
+#include <AtomicGroup.hpp>
+
+
+namespace loos {
+
+
+  //! Ensemble of coordinate frames stored at reduced precision
+  /**
+   * Holds the same information as the vector of flattened coordinate
+   * vectors returned by readCoords(), i.e. x, y, and z for each atom
+   * in each frame, but can store them more compactly:
+   *
+   * - DOUBLE stores full precision (8 bytes per coordinate)
+   * - FLOAT stores single precision (4 bytes)
+   * - INT16 stores each coordinate as a 16-bit integer, scaled to the
+   *   range of that axis in that frame (2 bytes, with an error of at
+   *   most 1/131070 of the range, e.g. under 0.001 \AA for a 100 \AA
+   *   wide selection)
+   * - FIXED rounds each coordinate to a given precision, as XTC files
+   *   do, using 16-bit integers when a frame's range allows it and
+   *   32-bit integers otherwise (2 or 4 bytes, with an error of at
+   *   most half the precision)
+   *
+   * Frames are decoded back to doubles on demand, either one at a
+   * time or as a tile of consecutive frames small enough to stay in
+   * cache while a kernel (such as centeredRMSD()) runs over it, so
+   * the ensemble is never fully expanded.
+   *
+   * \code
+   * CompressedEnsemble ensemble(CompressedEnsemble::INT16);
+   * appendCoords(ensemble, subset, traj, frames, true);
+   * std::vector< std::vector<double> > tile;
+   * for (uint j=0; j<ensemble.size(); j += tile.size()) {
+   *   ensemble.decode(j, ensemble.tileFrames(), tile);
+   *   ...
+   * }
+   * \endcode
+   */
+  class CompressedEnsemble {
+  public:
+    enum Storage { DOUBLE, FLOAT, INT16, FIXED };
+
+    //! Empty ensemble (\a precision is only used with FIXED storage)
+    explicit CompressedEnsemble(const Storage storage = FLOAT, const double precision = 0.001);
+
+    //! Parses a storage name (double, float, int16, or fixed)
+    static Storage storageFromName(const std::string& name);
+
+    Storage storage() const { return(_storage); }
+    double precision() const { return(_precision); }
+
+    //! Number of frames
+    uint size() const { return(_frames.size()); }
+    bool empty() const { return(_frames.empty()); }
+
+    //! Atoms per frame (set by the first frame added)
+    uint natoms() const { return(_natoms); }
+
+    //! Reserves space for \a nframes frames of \a natoms atoms
+    void reserve(const uint nframes, const uint natoms);
+
+    //! Appends a frame of 3 * natoms() coordinates
+    void append(const std::vector<double>& v);
+
+    //! Appends the current coordinates of \a g
+    void append(const AtomicGroup& g);
+
+    //! Decodes frame \a i into \a v
+    void decode(const uint i, std::vector<double>& v) const;
+
+    //! Returns frame \a i
+    std::vector<double> frame(const uint i) const {
+      std::vector<double> v;
+      decode(i, v);
+      return(v);
+    }
+
+    //! Decodes up to \a n frames starting at \a first into \a tile
+    /**
+     * The tile is resized to the number of frames actually decoded.
+     * Its vectors are reused, so decoding tile after tile into the
+     * same container does not allocate.
+     */
+    void decode(const uint first, const uint n, std::vector< std::vector<double> >& tile) const;
+
+    //! Number of frames that fit in a tile of about \a bytes (when decoded)
+    uint tileFrames(const unsigned long bytes = 1ul << 18) const;
+
+    //! Bytes used to store the frames
+    unsigned long bytes() const;
+
+    //! Bytes the same frames would take at full precision
+    unsigned long uncompressedBytes() const { return(static_cast<unsigned long>(size()) * 3 * _natoms * sizeof(double)); }
+
+    //! Largest error in any stored coordinate from quantization (0 for DOUBLE)
+    double maxError() const { return(_max_error); }
+
+    void clear();
+
+  private:
+    struct Header {
+      unsigned long offset;
+      double origin[3];
+      double scale[3];
+      unsigned char width;
+    };
+
+    void encodeScaled(const std::vector<double>& v, Header& h, const bool fixed);
+    template<typename T> void pack(const std::vector<double>& v, const Header& h);
+    template<typename T> void unpack(const Header& h, double* out) const;
+
+    Storage _storage;
+    double _precision;
+    uint _natoms;
+    double _max_error;
+
+    std::vector<unsigned char> _data;
+    std::vector<Header> _frames;
+  };
+
+
+}
+
+
+#endif
@@ -0,0 +1,202 @@
+/*
+  This file is part of LOOS.
+
+  LOOS (Lightweight Object-Oriented Structure library)
+  Copyright (c) 2008, Tod D. Romo, Alan Grossfield
+  Department of Biochemistry and Biophysics
+  School of Medicine & Dentistry, University of Rochester
+
+  This package (LOOS) is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation under version 3 of the License.
+
+  This package is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include <algorithm>
+#include <cstdlib>
+#include <stdexcept>
+
+#include <ConvexHull2D.hpp>
+#include <exceptions.hpp>
+
+
+namespace loos {
+
+  namespace {
+
+    // z-component of (b - a) x (c - a), positive when a->b->c turns left
+    inline double cross(const double ax, const double ay, const double bx, const double by,
+                        const double cx, const double cy) {
+      return((bx - ax) * (cy - ay) - (by - ay) * (cx - ax));
+    }
+
+
+    struct LexicalOrder {
+      LexicalOrder(const std::vector<double>& p) : xy(p) { }
+      bool operator()(const uint i, const uint j) const {
+        if (xy[2*i] != xy[2*j])
+          return(xy[2*i] < xy[2*j]);
+        return(xy[2*i+1] < xy[2*j+1]);
+      }
+
+      const std::vector<double>& xy;
+    };
+
+
+    void checkColumns(const int n) {
+      if (n != 2 && n != 3)
+        throw(LOOSError("Points for a ConvexHull2D must have 2 or 3 columns"));
+    }
+
+  }
+
+
+
+  void ConvexHull2D::update(const AtomicGroup& g) {
+    std::vector<double> xy(2 * g.size());
+    for (uint i=0; i<g.size(); ++i) {
+      const GCoord& c = g[i]->coords();
+      xy[2*i] = c.x();
+      xy[2*i+1] = c.y();
+    }
+    build(xy);
+  }
+
+
+  void ConvexHull2D::update(double* seq, int m, int n) {
+    checkColumns(n);
+    std::vector<double> xy(2 * m);
+    for (int i=0; i<m; ++i) {
+      xy[2*i] = seq[i*n];
+      xy[2*i+1] = seq[i*n+1];
+    }
+    build(xy);
+  }
+
+
+  // Andrew's monotone chain.  Points are sorted lexically, then the
+  // lower and upper hulls are built by dropping any point that does
+  // not make a strict left turn.
+  void ConvexHull2D::build(std::vector<double>& xy) {
+    uint n = xy.size() / 2;
+    std::vector<uint> order(n);
+    for (uint i=0; i<n; ++i)
+      order[i] = i;
+    std::sort(order.begin(), order.end(), LexicalOrder(xy));
+
+    std::vector<uint> hull(2 * n + 1);
+    uint k = 0;
+    for (uint i=0; i<n; ++i) {
+      uint p = order[i];
+      while (k >= 2 && cross(xy[2*hull[k-2]], xy[2*hull[k-2]+1], xy[2*hull[k-1]], xy[2*hull[k-1]+1],
+                             xy[2*p], xy[2*p+1]) <= 0.0)
+        --k;
+      hull[k++] = p;
+    }
+
+    uint lower = k + 1;
+    for (int i=static_cast<int>(n)-2; i >= 0; --i) {
+      uint p = order[i];
+      while (k >= lower && cross(xy[2*hull[k-2]], xy[2*hull[k-2]+1], xy[2*hull[k-1]], xy[2*hull[k-1]+1],
+                                 xy[2*p], xy[2*p+1]) <= 0.0)
+        --k;
+      hull[k++] = p;
+    }
+
+    // The last point repeats the first
+    if (k > 1)
+      --k;
+    hull.resize(k);
+
+    _vertices = hull;
+    _hx.resize(k);
+    _hy.resize(k);
+    for (uint i=0; i<k; ++i) {
+      _hx[i] = xy[2*hull[i]];
+      _hy[i] = xy[2*hull[i]+1];
+    }
+  }
+
+
+  GCoord ConvexHull2D::vertex(const uint i) const {
+    if (i >= _vertices.size())
+      throw(std::out_of_range("Bad index into ConvexHull2D"));
+    return(GCoord(_hx[i], _hy[i], 0.0));
+  }
+
+
+  double ConvexHull2D::area() const {
+    uint n = _vertices.size();
+    if (n < 3)
+      return(0.0);
+
+    double a = 0.0;
+    for (uint i=0, j=n-1; i<n; j = i++)
+      a += _hx[j] * _hy[i] - _hx[i] * _hy[j];
+    return(0.5 * a);
+  }
+
+
+  // Binary search over the fan of triangles from the first vertex
+  bool ConvexHull2D::inside(const double x, const double y) const {
+    uint n = _vertices.size();
+    if (n < 3)
+      return(false);
+
+    const double x0 = _hx[0], y0 = _hy[0];
+    if (cross(x0, y0, _hx[1], _hy[1], x, y) < 0.0 || cross(x0, y0, _hx[n-1], _hy[n-1], x, y) > 0.0)
+      return(false);
+
+    // Find the wedge (v0, v[lo], v[lo+1]) containing the point
+    uint lo = 1, hi = n - 1;
+    while (hi - lo > 1) {
+      uint mid = (lo + hi) / 2;
+      if (cross(x0, y0, _hx[mid], _hy[mid], x, y) >= 0.0)
+        lo = mid;
+      else
+        hi = mid;
+    }
+
+    return(cross(_hx[lo], _hy[lo], _hx[lo+1], _hy[lo+1], x, y) >= 0.0);
+  }
+
+
+  void ConvexHull2D::classify(double* seq, int m, int n, int** flags, int* nflags) const {
+    checkColumns(n);
+    int* fp = static_cast<int*>(malloc((m ? m : 1) * sizeof(int)));
+    for (int i=0; i<m; ++i)
+      fp[i] = inside(seq[i*n], seq[i*n+1]);
+
+    *flags = fp;
+    *nflags = m;
+  }
+
+
+  AtomicGroup ConvexHull2D::insideAtoms(const AtomicGroup& g) const {
+    AtomicGroup result;
+    for (AtomicGroup::const_iterator i = g.begin(); i != g.end(); ++i)
+      if (inside((*i)->coords().x(), (*i)->coords().y()))
+        result.append(*i);
+
+    if (g.isPeriodic())
+      result.periodicBox(g.periodicBox());
+    return(result);
+  }
+
+
+  uint ConvexHull2D::countInside(const AtomicGroup& g) const {
+    uint n = 0;
+    for (AtomicGroup::const_iterator i = g.begin(); i != g.end(); ++i)
+      n += inside((*i)->coords().x(), (*i)->coords().y());
+    return(n);
+  }
+
+}
@@ -0,0 +1,111 @@
+/*
+  This file is part of LOOS.
+
+  LOOS (Lightweight Object-Oriented Structure library)
+  Copyright (c) 2008, Tod D. Romo, Alan Grossfield
+  Department of Biochemistry and Biophysics
+  School of Medicine & Dentistry, University of Rochester
+
+  This package (LOOS) is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation under version 3 of the License.
+
+  This package is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#if !defined(LOOS_CONVEX_HULL_2D_HPP)
+#define LOOS_CONVEX_HULL_2D_HPP
+
+#include <vector>
+
+#include <loos_defs.hpp>
+#include <AtomicGroup.hpp>
+
+
+namespace loos {
+
+
+  //! Convex hull of a set of points projected onto the xy-plane
+  /**
+   * The hull is built with Andrew's monotone chain algorithm, and
+   * its vertices are stored in counter-clockwise order without any
+   * collinear points.  Testing whether a point is inside is a binary
+   * search over the hull, so it takes O(log h) time for a hull with h
+   * vertices.  Points on the boundary count as inside.  Only x and y
+   * are used; z is ignored.
+   *
+   * This is the engine behind loos.pyloos.ConvexHull.  From Python,
+   * the batch functions take NumPy arrays of coordinates (one point
+   * per row, with 2 or 3 columns), so membership for thousands of
+   * points can be tested without looping in Python:
+   * \code{.py}
+   * hull = loos.ConvexHull2D(helix_centroids)
+   * flags = hull.classify(lipids.getCoords())
+   * \endcode
+   *
+   * With fewer than three non-collinear points there is no interior,
+   * so nothing is inside.
+   */
+  class ConvexHull2D {
+  public:
+    ConvexHull2D() { }
+
+    //! Builds the hull of the atoms in \a g
+    explicit ConvexHull2D(const AtomicGroup& g) { update(g); }
+
+    //! Rebuilds the hull from the atoms in \a g
+    void update(const AtomicGroup& g);
+
+    //! Rebuilds the hull from an \a m x \a n row-major array of points
+    /**
+     * \a n must be 2 or 3 (the third column is ignored).
+     */
+    void update(double* seq, int m, int n);
+
+    //! Number of vertices in the hull
+    uint size() const { return(_vertices.size()); }
+
+    //! Indices (into the points the hull was built from) of the vertices, counter-clockwise
+    std::vector<uint> vertices() const { return(_vertices); }
+
+    //! Coordinates of the ith vertex (with z = 0)
+    GCoord vertex(const uint i) const;
+
+    //! Area enclosed by the hull
+    double area() const;
+
+    //! True if \a p is inside (or on) the hull
+    bool isInside(const GCoord& p) const { return(inside(p.x(), p.y())); }
+
+    //! Classifies each row of an \a m x \a n array of points
+    /**
+     * Returns a newly allocated (with malloc) array of \a m flags,
+     * 1 if the point is inside the hull and 0 otherwise.
+     */
+    void classify(double* seq, int m, int n, int** flags, int* nflags) const;
+
+    //! Returns the atoms of \a g that are inside the hull
+    AtomicGroup insideAtoms(const AtomicGroup& g) const;
+
+    //! Counts the atoms of \a g that are inside the hull
+    uint countInside(const AtomicGroup& g) const;
+
+  private:
+    void build(std::vector<double>& xy);
+    bool inside(const double x, const double y) const;
+
+    std::vector<uint> _vertices;
+    std::vector<double> _hx, _hy;
+  };
+
+}
+
+
+#endif
@@ -0,0 +1,315 @@
+/*
+  This file is part of LOOS.
+
+  LOOS (Lightweight Object-Oriented Structure library)
+  Copyright (c) 2008, Tod D. Romo, Alan Grossfield
+  Department of Biochemistry and Biophysics
+  School of Medicine & Dentistry, University of Rochester
+
+  This package (LOOS) is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation under version 3 of the License.
+
+  This package is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#if !defined(LOOS_DISTANCE_KERNELS_HPP)
+#define LOOS_DISTANCE_KERNELS_HPP
+
+#include <cmath>
+#include <vector>
+
+#include <loos_defs.hpp>
+#include <Coord.hpp>
+
+
+namespace loos {
+
+  //! Compile-time specialized distance calculations
+  /**
+   * The distance kernels are built from two pieces: a periodicity
+   * policy that knows how to apply the minimum image convention to a
+   * difference vector, and a functor that uses the policy to compute
+   * either the exact distance-squared (Distance2) or only whether two
+   * points are within a cutoff (WithinCutoff).  Both are templated on
+   * the precision used for the arithmetic.  Since everything is
+   * resolved at compile-time, there are no run-time checks for the
+   * presence of a box in the inner loops.
+   *
+   * The batch functions work on packed, interleaved coordinates
+   * (x0, y0, z0, x1, ...), as produced by packCoords() or a
+   * FloatFrame, and are written so that the compiler can vectorize
+   * them.
+   *
+   * Example:
+   * \code
+   * std::vector<double> xyz;
+   * DistanceKernels::packCoords(solvent, xyz);
+   *
+   * DistanceKernels::WithinCutoff< DistanceKernels::Orthorhombic<double> > close(3.5, box);
+   * for (AtomicGroup::iterator i = protein.begin(); i != protein.end(); ++i) {
+   *   double c[3] = { (*i)->coords().x(), (*i)->coords().y(), (*i)->coords().z() };
+   *   if (DistanceKernels::anyWithinBatch(close, c, xyz.data(), solvent.size()))
+   *     ...
+   * }
+   * \endcode
+   */
+  namespace DistanceKernels {
+
+    // --- Periodicity policies
+
+    //! No periodicity
+    template<typename T>
+    struct NoPeriodicity {
+      typedef T value_type;
+
+      void reimage(T&, T&, T&) const { }
+    };
+
+
+    //! Orthorhombic (rectangular) periodic box
+    /**
+     * Uses the same minimum image convention as Coord::reimage().  A
+     * box dimension of zero disables periodicity along that axis.
+     */
+    template<typename T>
+    struct Orthorhombic {
+      typedef T value_type;
+
+      Orthorhombic(const GCoord& box)
+        : bx(box.x()), by(box.y()), bz(box.z()),
+          ibx(box.x() == 0.0 ? 0.0 : 1.0 / box.x()),
+          iby(box.y() == 0.0 ? 0.0 : 1.0 / box.y()),
+          ibz(box.z() == 0.0 ? 0.0 : 1.0 / box.z())
+      { }
+
+      void reimage(T& dx, T& dy, T& dz) const {
+        dx -= bx * std::round(dx * ibx);
+        dy -= by * std::round(dy * iby);
+        dz -= bz * std::round(dz * ibz);
+      }
+
+      T bx, by, bz;
+      T ibx, iby, ibz;
+    };
+
+
+    //! Triclinic periodic box
+    /**
+     * The box vectors must be in the reduced (lower-triangular) form
+     * used by GROMACS, i.e. a = (ax, 0, 0), b = (bx, by, 0), and
+     * c = (cx, cy, cz).  The minimum image is found by successively
+     * removing the c, b, and a vectors, which is exact for boxes that
+     * are not too skewed.
+     */
+    template<typename T>
+    struct Triclinic {
+      typedef T value_type;
+
+      Triclinic(const GCoord& a, const GCoord& b, const GCoord& c)
+        : ax(a.x()),
+          bx(b.x()), by(b.y()),
+          cx(c.x()), cy(c.y()), cz(c.z()),
+          iax(1.0 / a.x()), iby(1.0 / b.y()), icz(1.0 / c.z())
+      { }
+
+      void reimage(T& dx, T& dy, T& dz) const {
+        T n = std::round(dz * icz);
+        dx -= n * cx;
+        dy -= n * cy;
+        dz -= n * cz;
+
+        n = std::round(dy * iby);
+        dx -= n * bx;
+        dy -= n * by;
+
+        dx -= ax * std::round(dx * iax);
+      }
+
+      T ax, bx, by, cx, cy, cz;
+      T iax, iby, icz;
+    };
+
+
+
+    // --- Distance functors
+
+    //! Exact distance-squared with the given periodicity policy and precision
+    template<class Periodicity, typename T = double>
+    struct Distance2 {
+      typedef T value_type;
+      typedef Periodicity periodicity_type;
+
+      Distance2() { }
+      Distance2(const Periodicity& p) : policy(p) { }
+
+      T operator()(const T* a, const T* b) const {
+        T dx = b[0] - a[0];
+        T dy = b[1] - a[1];
+        T dz = b[2] - a[2];
+        policy.reimage(dx, dy, dz);
+        return(dx*dx + dy*dy + dz*dz);
+      }
+
+      double operator()(const GCoord& a, const GCoord& b) const {
+        T dx = b.x() - a.x();
+        T dy = b.y() - a.y();
+        T dz = b.z() - a.z();
+        policy.reimage(dx, dy, dz);
+        return(dx*dx + dy*dy + dz*dz);
+      }
+
+      //! Minimum image difference vector (b - a)
+      GCoord delta(const GCoord& a, const GCoord& b) const {
+        T dx = b.x() - a.x();
+        T dy = b.y() - a.y();
+        T dz = b.z() - a.z();
+        policy.reimage(dx, dy, dz);
+        return(GCoord(dx, dy, dz));
+      }
+
+      Periodicity policy;
+    };
+
+
+    //! Only tests whether two points are within a cutoff
+    /**
+     * The scalar form rejects pairs as soon as any single component
+     * of the difference exceeds the cutoff, so the full
+     * distance-squared is only computed for nearby pairs.
+     */
+    template<class Periodicity, typename T = double>
+    struct WithinCutoff {
+      typedef T value_type;
+      typedef Periodicity periodicity_type;
+
+      WithinCutoff(const double cutoff) : cut(cutoff), cut2(cutoff * cutoff) { }
+      WithinCutoff(const double cutoff, const Periodicity& p) : policy(p), cut(cutoff), cut2(cutoff * cutoff) { }
+
+      bool operator()(const T* a, const T* b) const {
+        T dx = b[0] - a[0];
+        T dy = b[1] - a[1];
+        T dz = b[2] - a[2];
+        policy.reimage(dx, dy, dz);
+        if (std::abs(dx) > cut || std::abs(dy) > cut || std::abs(dz) > cut)
+          return(false);
+        return(dx*dx + dy*dy + dz*dz <= cut2);
+      }
+
+      bool operator()(const GCoord& a, const GCoord& b) const {
+        T u[3] = { static_cast<T>(a.x()), static_cast<T>(a.y()), static_cast<T>(a.z()) };
+        T v[3] = { static_cast<T>(b.x()), static_cast<T>(b.y()), static_cast<T>(b.z()) };
+        return(operator()(u, v));
+      }
+
+      Periodicity policy;
+      T cut, cut2;
+    };
+
+
+
+    // --- Packing
+
+    //! Pack the coordinates of a group of atoms into an interleaved array
+    /**
+     * \a G can be an AtomicGroup or any container of pAtoms.
+     */
+    template<class G, typename T>
+    void packCoords(const G& g, std::vector<T>& xyz) {
+      xyz.resize(3 * g.size());
+      for (uint i=0; i<g.size(); ++i) {
+        const GCoord& c = g[i]->coords();
+        xyz[3*i] = c.x();
+        xyz[3*i+1] = c.y();
+        xyz[3*i+2] = c.z();
+      }
+    }
+
+    //! Pack a vector of GCoords into an interleaved array
+    template<typename T>
+    void packCoords(const std::vector<GCoord>& g, std::vector<T>& xyz) {
+      xyz.resize(3 * g.size());
+      for (uint i=0; i<g.size(); ++i) {
+        xyz[3*i] = g[i].x();
+        xyz[3*i+1] = g[i].y();
+        xyz[3*i+2] = g[i].z();
+      }
+    }
+
+
+
+    // --- Batch (one-to-many) kernels
+
+    //! Distance-squared from \a point to each of the \a n packed coordinates
+    template<class Periodicity, typename T>
+    void distance2Batch(const Distance2<Periodicity, T>& op, const T* point, const T* xyz, const uint n, T* out) {
+      const T px = point[0], py = point[1], pz = point[2];
+      for (uint i=0; i<n; ++i) {
+        T dx = xyz[3*i] - px;
+        T dy = xyz[3*i+1] - py;
+        T dz = xyz[3*i+2] - pz;
+        op.policy.reimage(dx, dy, dz);
+        out[i] = dx*dx + dy*dy + dz*dz;
+      }
+    }
+
+
+    //! Number of the \a n packed coordinates within the cutoff of \a point
+    template<class Periodicity, typename T>
+    uint countWithinBatch(const WithinCutoff<Periodicity, T>& op, const T* point, const T* xyz, const uint n) {
+      const T px = point[0], py = point[1], pz = point[2];
+      uint count = 0;
+      for (uint i=0; i<n; ++i) {
+        T dx = xyz[3*i] - px;
+        T dy = xyz[3*i+1] - py;
+        T dz = xyz[3*i+2] - pz;
+        op.policy.reimage(dx, dy, dz);
+        count += (dx*dx + dy*dy + dz*dz <= op.cut2);
+      }
+      return(count);
+    }
+
+
+    //! True if any of the \a n packed coordinates is within the cutoff of \a point
+    /**
+     * The coordinates are tested in fixed-size blocks without
+     * branching, so the inner loop can be vectorized while still
+     * exiting early.
+     */
+    template<class Periodicity, typename T>
+    bool anyWithinBatch(const WithinCutoff<Periodicity, T>& op, const T* point, const T* xyz, const uint n) {
+      const uint block = 32;
+      const T px = point[0], py = point[1], pz = point[2];
+
+      for (uint j=0; j<n; j += block) {
+        uint m = (n - j < block) ? n - j : block;
+        const T* p = xyz + 3*j;
+        uint hits = 0;
+        for (uint i=0; i<m; ++i) {
+          T dx = p[3*i] - px;
+          T dy = p[3*i+1] - py;
+          T dz = p[3*i+2] - pz;
+          op.policy.reimage(dx, dy, dz);
+          hits += (dx*dx + dy*dy + dz*dz <= op.cut2);
+        }
+        if (hits)
+          return(true);
+      }
+
+      return(false);
+    }
+
+
+  }
+
+}
+
+
+#endif
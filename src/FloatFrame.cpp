@@ -0,0 +1,231 @@
+/*
+  This file is part of LOOS.
+
+  LOOS (Lightweight Object-Oriented Structure library)
+  Copyright (c) 2008, Tod D. Romo, Alan Grossfield
+  Department of Biochemistry and Biophysics
+  School of Medicine & Dentistry, University of Rochester
+
+  This package (LOOS) is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation under version 3 of the License.
+
+  This package is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include <cmath>
+
+#include <FloatFrame.hpp>
+#include <AtomicGroup.hpp>
+#include <alignment.hpp>
+#include <XForm.hpp>
+#include <DistanceKernels.hpp>
+#include <exceptions.hpp>
+
+
+namespace loos {
+
+
+  FloatFrame::FloatFrame(const AtomicGroup& g)
+    : _indices(g.size()), _coords(3 * g.size()), _box(0,0,0), _periodic(false)
+  {
+    for (uint i=0; i<g.size(); ++i)
+      _indices[i] = g[i]->index();
+    copyFrom(g);
+  }
+
+
+  void FloatFrame::copyFrom(const AtomicGroup& g) {
+    if (g.size() != size())
+      throw(LOOSError("AtomicGroup and FloatFrame have different sizes"));
+
+    for (uint i=0; i<g.size(); ++i)
+      coord(i, g[i]->coords());
+
+    if (g.isPeriodic())
+      periodicBox(g.periodicBox());
+    else
+      clearPeriodicBox();
+  }
+
+
+  void FloatFrame::copyTo(AtomicGroup& g) const {
+    if (g.size() != size())
+      throw(LOOSError("AtomicGroup and FloatFrame have different sizes"));
+
+    for (uint i=0; i<g.size(); ++i)
+      g[i]->coords(coord(i));
+
+    if (_periodic)
+      g.periodicBox(_box);
+  }
+
+
+  void FloatFrame::copyFromFrame(const std::vector<GCoord>& frame) {
+    for (uint i=0; i<_indices.size(); ++i) {
+      uint idx = _indices[i];
+      if (idx >= frame.size())
+        throw(LOOSError("Atom index into the trajectory frame is out of bounds"));
+      coord(i, frame[idx]);
+    }
+  }
+
+
+  void FloatFrame::copyFromFrame(const float* x, const float* y, const float* z, const uint n) {
+    float* p = _coords.data();
+    for (uint i=0; i<_indices.size(); ++i, p += 3) {
+      uint idx = _indices[i];
+      if (idx >= n)
+        throw(LOOSError("Atom index into the trajectory frame is out of bounds"));
+      p[0] = x[idx];
+      p[1] = y[idx];
+      p[2] = z[idx];
+    }
+  }
+
+
+
+  GCoord centroid(const FloatFrame& f) {
+    double cx = 0.0, cy = 0.0, cz = 0.0;
+    const float* p = f.data();
+    const uint n = f.size();
+
+    for (uint i=0; i<n; ++i, p += 3) {
+      cx += p[0];
+      cy += p[1];
+      cz += p[2];
+    }
+
+    if (n)
+      return(GCoord(cx / n, cy / n, cz / n));
+    return(GCoord(0,0,0));
+  }
+
+
+  GCoord centerAtOrigin(FloatFrame& f) {
+    GCoord c = centroid(f);
+    float cx = c.x(), cy = c.y(), cz = c.z();
+    float* p = f.data();
+    const uint n = f.size();
+
+    for (uint i=0; i<n; ++i, p += 3) {
+      p[0] -= cx;
+      p[1] -= cy;
+      p[2] -= cz;
+    }
+
+    return(c);
+  }
+
+
+  void applyTransform(FloatFrame& f, const XForm& W) {
+    GMatrix M = W.current();
+    float* p = f.data();
+    const uint n = f.size();
+
+    for (uint i=0; i<n; ++i, p += 3) {
+      GCoord c = M * GCoord(p[0], p[1], p[2]);
+      p[0] = c.x();
+      p[1] = c.y();
+      p[2] = c.z();
+    }
+  }
+
+
+  double rmsd(const FloatFrame& a, const FloatFrame& b) {
+    if (a.size() != b.size())
+      throw(LOOSError("Cannot compute RMSD between frames of different sizes"));
+
+    const uint n = 3 * a.size();
+    const float* p = a.data();
+    const float* q = b.data();
+    double d = 0.0;
+    for (uint i=0; i<n; ++i) {
+      double delta = p[i] - q[i];
+      d += delta * delta;
+    }
+
+    return(a.size() ? sqrt(d / a.size()) : 0.0);
+  }
+
+
+  double centeredRMSD(const FloatFrame& a, const FloatFrame& b) {
+    if (a.size() != b.size())
+      throw(LOOSError("Cannot compute RMSD between frames of different sizes"));
+
+    const uint n = a.size();
+    const float* u = a.data();
+    const float* v = b.data();
+
+    // Correlation matrix (column-major, R = U * V') and the total
+    // sum of squares, all accumulated in double-precision...
+    alignment::vecDouble R(9, 0.0);
+    double E0 = 0.0;
+    for (uint k=0; k<n; ++k, u += 3, v += 3) {
+      for (uint j=0; j<3; ++j) {
+        double vj = v[j];
+        R[3*j] += u[0] * vj;
+        R[3*j+1] += u[1] * vj;
+        R[3*j+2] += u[2] * vj;
+      }
+      E0 += static_cast<double>(u[0])*u[0] + static_cast<double>(u[1])*u[1] + static_cast<double>(u[2])*u[2]
+        + static_cast<double>(v[0])*v[0] + static_cast<double>(v[1])*v[1] + static_cast<double>(v[2])*v[2];
+    }
+
+    alignment::SVDTupleVec svd = alignment::correlationSVD(R);
+    const alignment::vecDouble& S = boost::get<1>(svd);
+    double ss = S[0] + S[1] + S[2];
+
+    return(n ? sqrt(std::abs(E0 - 2.0*ss) / n) : 0.0);
+  }
+
+
+  double distance2(const FloatFrame& a, const uint i, const FloatFrame& b, const uint j) {
+    const float* p = a.data() + 3*i;
+    const float* q = b.data() + 3*j;
+
+    double d2 = 0.0;
+    if (a.isPeriodic()) {
+      GCoord box = a.periodicBox();
+      for (uint k=0; k<3; ++k) {
+        double d = q[k] - p[k];
+        d -= box[k] * round(d / box[k]);
+        d2 += d*d;
+      }
+    } else
+      for (uint k=0; k<3; ++k) {
+        double d = q[k] - p[k];
+        d2 += d*d;
+      }
+
+    return(d2);
+  }
+
+
+  namespace {
+    template<class Periodicity>
+    uint countWithinImpl(const FloatFrame& a, const FloatFrame& b, const DistanceKernels::WithinCutoff<Periodicity, float>& op) {
+      uint count = 0;
+      for (uint i=0; i<a.size(); ++i)
+        if (DistanceKernels::anyWithinBatch(op, a.data() + 3*i, b.data(), b.size()))
+          ++count;
+      return(count);
+    }
+  }
+
+
+  uint countWithin(const FloatFrame& a, const FloatFrame& b, const double cutoff) {
+    if (a.isPeriodic())
+      return(countWithinImpl(a, b, DistanceKernels::WithinCutoff< DistanceKernels::Orthorhombic<float>, float >(cutoff, a.periodicBox())));
+
+    return(countWithinImpl(a, b, DistanceKernels::WithinCutoff< DistanceKernels::NoPeriodicity<float>, float >(cutoff)));
+  }
+
+}
@@ -0,0 +1,167 @@
+/*
+  This file is part of LOOS.
+
+  LOOS (Lightweight Object-Oriented Structure library)
+  Copyright (c) 2008, Tod D. Romo, Alan Grossfield
+  Department of Biochemistry and Biophysics
+  School of Medicine & Dentistry, University of Rochester
+
+  This package (LOOS) is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation under version 3 of the License.
+
+  This package is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#if !defined(LOOS_FLOAT_FRAME_HPP)
+#define LOOS_FLOAT_FRAME_HPP
+
+#include <vector>
+
+#include <loos_defs.hpp>
+#include <Coord.hpp>
+
+
+namespace loos {
+
+  class XForm;
+
+
+  //! Single-precision coordinate buffer for a subset of a trajectory frame
+  /**
+   * A FloatFrame holds the coordinates for a fixed set of atoms (given
+   * by their trajectory indices) as a contiguous, interleaved array of
+   * floats (x0, y0, z0, x1, y1, z1, ...), along with the periodic box.
+   * It is half the size of the equivalent AtomicGroup coordinates and
+   * avoids the per-atom indirection, which makes it suitable for
+   * caching large numbers of frames.
+   *
+   * DCD and XTC files only store single-precision coordinates, so
+   * nothing is lost by using a FloatFrame with them.  Use
+   * Trajectory::updateFrameCoords() to fill a FloatFrame with the
+   * current trajectory frame.  Formats that store floats (DCD) copy
+   * directly without going through doubles.
+   *
+   * The kernels below operate on FloatFrames, but accumulate sums in
+   * double-precision.
+   *
+   * Example:
+   * \code
+   * FloatFrame frame(subset);
+   * while (traj->readFrame()) {
+   *   traj->updateFrameCoords(frame);
+   *   GCoord c = centroid(frame);
+   *   ...
+   * }
+   * \endcode
+   */
+  class FloatFrame {
+  public:
+    typedef float                       value_type;
+    typedef std::vector<value_type>     storage_type;
+
+    FloatFrame() : _box(0,0,0), _periodic(false) { }
+
+    //! Frame for the atoms in g, initialized with g's current coordinates
+    explicit FloatFrame(const AtomicGroup& g);
+
+    //! Empty frame for the atoms with the given trajectory indices
+    explicit FloatFrame(const std::vector<uint>& indices)
+      : _indices(indices), _coords(3 * indices.size(), 0.0f), _box(0,0,0), _periodic(false) { }
+
+    //! Number of atoms
+    uint size() const { return(_indices.size()); }
+    bool empty() const { return(_indices.empty()); }
+
+    //! Trajectory indices of the atoms in this frame
+    const std::vector<uint>& indices() const { return(_indices); }
+
+    //! Raw interleaved coordinates (3 * size() floats)
+    value_type* data() { return(_coords.data()); }
+    const value_type* data() const { return(_coords.data()); }
+
+    storage_type& coords() { return(_coords); }
+    const storage_type& coords() const { return(_coords); }
+
+    //! Coordinates of the ith atom (promoted to double)
+    GCoord coord(const uint i) const {
+      return(GCoord(_coords[3*i], _coords[3*i+1], _coords[3*i+2]));
+    }
+
+    void coord(const uint i, const GCoord& c) {
+      _coords[3*i] = c.x();
+      _coords[3*i+1] = c.y();
+      _coords[3*i+2] = c.z();
+    }
+
+    bool isPeriodic() const { return(_periodic); }
+    GCoord periodicBox() const { return(_box); }
+    void periodicBox(const GCoord& c) { _box = c; _periodic = true; }
+    void clearPeriodicBox() { _box = GCoord(0,0,0); _periodic = false; }
+
+
+    //! Copy the coordinates (and box) from g, which must match this frame's atoms
+    void copyFrom(const AtomicGroup& g);
+
+    //! Copy the coordinates (and box) into g, which must match this frame's atoms
+    void copyTo(AtomicGroup& g) const;
+
+    //! Pull out this frame's atoms from a full frame of coordinates
+    /**
+     * This is the generic path used by Trajectory::updateFrameCoords().
+     * An error is thrown if an index is out of range.
+     */
+    void copyFromFrame(const std::vector<GCoord>& frame);
+
+    //! Pull out this frame's atoms from separate x, y, z float arrays
+    void copyFromFrame(const float* x, const float* y, const float* z, const uint n);
+
+  private:
+    std::vector<uint> _indices;
+    storage_type _coords;
+    GCoord _box;
+    bool _periodic;
+  };
+
+
+
+  //! Centroid of the frame (accumulated in double-precision)
+  GCoord centroid(const FloatFrame& f);
+
+  //! Translate the frame so its centroid is at the origin, returning the old centroid
+  GCoord centerAtOrigin(FloatFrame& f);
+
+  //! Apply the current transform in W to every atom in the frame
+  void applyTransform(FloatFrame& f, const XForm& W);
+
+  //! RMSD between two frames without any superposition
+  double rmsd(const FloatFrame& a, const FloatFrame& b);
+
+  //! RMSD after optimal superposition, assuming both frames are already centered
+  /**
+   * The 3x3 correlation matrix is accumulated in double-precision,
+   * and the SVD shares its implementation with
+   * alignment::centeredRMSD().
+   */
+  double centeredRMSD(const FloatFrame& a, const FloatFrame& b);
+
+  //! Distance-squared between atom i of a and atom j of b, using a's periodic box if present
+  double distance2(const FloatFrame& a, const uint i, const FloatFrame& b, const uint j);
+
+  //! Number of atoms in a that are within cutoff of any atom in b
+  /**
+   * The periodic box of a is used, if present.
+   */
+  uint countWithin(const FloatFrame& a, const FloatFrame& b, const double cutoff);
+
+}
+
+
+#endif
@@ -0,0 +1,536 @@
+/*
+  This file is part of LOOS.
+
+  LOOS (Lightweight Object-Oriented Structure library)
+  Copyright (c) 2008, Tod D. Romo, Alan Grossfield
+  Department of Biochemistry and Biophysics
+  School of Medicine & Dentistry, University of Rochester
+
+  This package (LOOS) is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation under version 3 of the License.
+
+  This package is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include <cctype>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <limits>
+
+#include <boost/algorithm/string.hpp>
+#include <boost/cstdint.hpp>
+
+#include <FrameFeatures.hpp>
+#include <Geometry.hpp>
+#include <exceptions.hpp>
+#include <utils.hpp>
+
+
+namespace loos {
+
+  namespace {
+
+    bool isIdentifier(const std::string& s) {
+      if (s.empty() || !(std::isalpha(s[0]) || s[0] == '_'))
+        return(false);
+      for (uint i=1; i<s.size(); ++i)
+        if (!(std::isalnum(s[i]) || s[i] == '_'))
+          return(false);
+      return(true);
+    }
+
+
+
+    // Evaluates a query directly as it is parsed, one column at a
+    // time, so each term costs a single pass over the rows it names.
+    class QueryParser {
+    public:
+      typedef std::vector<char>    Mask;
+
+      QueryParser(const FrameFeatureIndex& index, const std::string& text)
+        : _index(index), _text(text), _pos(0) { }
+
+      Mask parse() {
+        Mask m = orExpr();
+        skipSpace();
+        if (_pos != _text.size())
+          error("unexpected text");
+        return(m);
+      }
+
+    private:
+      struct Operand {
+        Operand() : column(0), value(0.0) { }
+        double operator[](const uint i) const { return(column ? (*column)[i] : (frames.empty() ? value : frames[i])); }
+
+        const std::vector<float>* column;
+        std::vector<double> frames;
+        double value;
+      };
+
+
+      void error(const std::string& msg) const {
+        throw(ParseError("Error in frame query at position " + boost::lexical_cast<std::string>(_pos) + " (" + msg + "): " + _text));
+      }
+
+      void skipSpace() {
+        while (_pos < _text.size() && std::isspace(_text[_pos]))
+          ++_pos;
+      }
+
+      bool accept(const std::string& tok) {
+        skipSpace();
+        if (_text.compare(_pos, tok.size(), tok) == 0) {
+          _pos += tok.size();
+          return(true);
+        }
+        return(false);
+      }
+
+      uint rows() const { return(_index.frames()); }
+
+
+      Mask orExpr() {
+        Mask m = andExpr();
+        while (accept("||")) {
+          Mask r = andExpr();
+          for (uint i=0; i<m.size(); ++i)
+            m[i] = m[i] || r[i];
+        }
+        return(m);
+      }
+
+      Mask andExpr() {
+        Mask m = unary();
+        while (accept("&&")) {
+          Mask r = unary();
+          for (uint i=0; i<m.size(); ++i)
+            m[i] = m[i] && r[i];
+        }
+        return(m);
+      }
+
+      Mask unary() {
+        if (accept("!") ) {
+          Mask m = unary();
+          for (uint i=0; i<m.size(); ++i)
+            m[i] = !m[i];
+          return(m);
+        }
+
+        if (accept("(")) {
+          Mask m = orExpr();
+          if (!accept(")"))
+            error("missing ')'");
+          return(m);
+        }
+
+        return(comparison());
+      }
+
+
+      // a op b [op c ...], e.g. 2 < d <= 4
+      Mask comparison() {
+        Operand left = operand();
+        Mask m(rows(), 1);
+        bool compared = false;
+
+        while (true) {
+          int op = comparator();
+          if (op < 0)
+            break;
+          Operand right = operand();
+          for (uint i=0; i<m.size(); ++i)
+            if (m[i])
+              m[i] = compare(op, left[i], right[i]);
+          left = right;
+          compared = true;
+        }
+
+        if (!compared)
+          error("expected a comparison");
+        return(m);
+      }
+
+      int comparator() {
+        static const char* ops[] = { "<=", ">=", "==", "!=", "<", ">" };
+        for (int i=0; i<6; ++i)
+          if (accept(ops[i]))
+            return(i);
+        return(-1);
+      }
+
+      static bool compare(const int op, const double a, const double b) {
+        switch(op) {
+        case 0: return(a <= b);
+        case 1: return(a >= b);
+        case 2: return(a == b);
+        case 3: return(a != b);
+        case 4: return(a < b);
+        default: return(a > b);
+        }
+      }
+
+
+      Operand operand() {
+        skipSpace();
+        Operand o;
+
+        uint start = _pos;
+        while (_pos < _text.size() && (std::isalnum(_text[_pos]) || _text[_pos] == '_'
+                                       || _text[_pos] == '.' || _text[_pos] == '-' || _text[_pos] == '+'))
+          ++_pos;
+        std::string tok = _text.substr(start, _pos - start);
+        if (tok.empty())
+          error("expected a feature name or number");
+
+        if (isIdentifier(tok)) {
+          if (tok == "frame") {
+            const std::vector<uint>& f = _index.frameNumbers();
+            o.frames.assign(f.begin(), f.end());
+          } else {
+            try {
+              o.column = &(_index.column(tok));
+            }
+            catch (LOOSError&) {
+              error("unknown feature '" + tok + "'");
+            }
+          }
+          return(o);
+        }
+
+        char* end;
+        o.value = std::strtod(tok.c_str(), &end);
+        if (*end != '\0') {
+          // Back up to where the number ended (e.g. "4-d" is not a number)
+          _pos = start + (end - tok.c_str());
+          if (end == tok.c_str())
+            error("expected a feature name or number");
+        }
+        return(o);
+      }
+
+
+      const FrameFeatureIndex& _index;
+      std::string _text;
+      std::string::size_type _pos;
+    };
+
+
+
+    // Index files are native-endian, with a marker so they can still
+    // be read on a machine with the other byte order
+    const char index_magic[] = "LOOSFIDX";
+    const boost::uint32_t index_endian = 0x01020304;
+    const boost::uint32_t index_version = 1;
+
+
+    template<typename T>
+    void writeValue(std::ostream& os, const T& t) {
+      os.write(reinterpret_cast<const char*>(&t), sizeof(T));
+    }
+
+    void writeString(std::ostream& os, const std::string& s) {
+      writeValue<boost::uint32_t>(os, s.size());
+      os.write(s.data(), s.size());
+    }
+
+
+    class IndexReader {
+    public:
+      IndexReader(std::istream& is, const std::string& fname) : _is(is), _fname(fname), _swab(false) { }
+
+      void swapBytes(const bool b) { _swab = b; }
+
+      template<typename T>
+      T value() {
+        T t;
+        _is.read(reinterpret_cast<char*>(&t), sizeof(T));
+        if (_is.fail())
+          throw(FileReadError(_fname, "Frame index is truncated"));
+        return(_swab ? swab(t) : t);
+      }
+
+      template<typename T>
+      void array(std::vector<T>& v, const uint n) {
+        v.resize(n);
+        if (n)
+          _is.read(reinterpret_cast<char*>(&v[0]), n * sizeof(T));
+        if (_is.fail())
+          throw(FileReadError(_fname, "Frame index is truncated"));
+        if (_swab)
+          for (uint i=0; i<n; ++i)
+            v[i] = swab(v[i]);
+      }
+
+      std::string string() {
+        boost::uint32_t n = value<boost::uint32_t>();
+        std::string s(n, ' ');
+        if (n)
+          _is.read(&s[0], n);
+        if (_is.fail())
+          throw(FileReadError(_fname, "Frame index is truncated"));
+        return(s);
+      }
+
+    private:
+      std::istream& _is;
+      std::string _fname;
+      bool _swab;
+    };
+
+  }
+
+
+
+  FrameFeature::FrameFeature(const std::string& spec, const AtomicGroup& model)
+    : _spec(spec), _cutoff2(0.0)
+  {
+    std::string::size_type eq = spec.find('=');
+    if (eq == std::string::npos)
+      throw(ParseError("Feature must be given as name=kind; selection; ...: " + spec));
+    _name = boost::trim_copy(spec.substr(0, eq));
+    if (!isIdentifier(_name) || _name == "frame")
+      throw(ParseError("Bad feature name '" + _name + "' (must be letters, digits, and underscores, and not 'frame')"));
+
+    std::vector<std::string> args;
+    std::string rest = spec.substr(eq+1);
+    boost::split(args, rest, boost::is_any_of(";"));
+    for (uint i=0; i<args.size(); ++i)
+      boost::trim(args[i]);
+
+    std::string kind = boost::to_lower_copy(args[0]);
+    uint nsel;
+    bool cutoff = false;
+    if (kind == "distance") {
+      _kind = DISTANCE;
+      nsel = 2;
+    } else if (kind == "mindist") {
+      _kind = MINDIST;
+      nsel = 2;
+    } else if (kind == "contacts") {
+      _kind = CONTACTS;
+      nsel = 2;
+      cutoff = true;
+    } else if (kind == "count") {
+      _kind = COUNT;
+      nsel = 2;
+      cutoff = true;
+    } else if (kind == "angle") {
+      _kind = ANGLE;
+      nsel = 3;
+    } else if (kind == "dihedral") {
+      _kind = DIHEDRAL;
+      nsel = 4;
+    } else if (kind == "rgyr") {
+      _kind = RGYR;
+      nsel = 1;
+    } else
+      throw(ParseError("Unknown kind of feature '" + args[0] + "' in " + spec));
+
+    if (args.size() != 1 + nsel + cutoff)
+      throw(ParseError("Feature '" + _name + "' of kind " + kind + " needs " + boost::lexical_cast<std::string>(nsel)
+                       + " selections" + (cutoff ? " and a cutoff" : "")));
+
+    for (uint i=0; i<nsel; ++i) {
+      AtomicGroup g = selectAtoms(model, args[i+1]);
+      if (g.empty())
+        throw(LOOSError("Feature '" + _name + "': '" + args[i+1] + "' selected no atoms"));
+      _groups.push_back(g);
+    }
+
+    if (cutoff) {
+      double d = parseStringAs<double>(args[nsel+1]);
+      _cutoff2 = d * d;
+    }
+  }
+
+
+  double FrameFeature::value() const {
+    bool periodic = _groups[0].isPeriodic();
+    GCoord box = periodic ? _groups[0].periodicBox() : GCoord(0,0,0);
+    const GCoord* pbox = periodic ? &box : 0;
+
+    switch(_kind) {
+
+    case DISTANCE:
+      {
+        GCoord a = _groups[0].centroid();
+        GCoord b = _groups[1].centroid();
+        return(periodic ? a.distance(b, box) : a.distance(b));
+      }
+
+    case MINDIST:
+      {
+        double mind2 = std::numeric_limits<double>::max();
+        for (AtomicGroup::const_iterator i = _groups[0].begin(); i != _groups[0].end(); ++i) {
+          const GCoord& a = (*i)->coords();
+          for (AtomicGroup::const_iterator j = _groups[1].begin(); j != _groups[1].end(); ++j) {
+            if (*i == *j)
+              continue;
+            double d2 = periodic ? a.distance2((*j)->coords(), box) : a.distance2((*j)->coords());
+            if (d2 < mind2)
+              mind2 = d2;
+          }
+        }
+        return(std::sqrt(mind2));
+      }
+
+    case CONTACTS:
+      {
+        uint n = 0;
+        for (AtomicGroup::const_iterator i = _groups[0].begin(); i != _groups[0].end(); ++i) {
+          const GCoord& a = (*i)->coords();
+          for (AtomicGroup::const_iterator j = _groups[1].begin(); j != _groups[1].end(); ++j)
+            if (*i != *j && (periodic ? a.distance2((*j)->coords(), box) : a.distance2((*j)->coords())) <= _cutoff2)
+              ++n;
+        }
+        return(n);
+      }
+
+    case COUNT:
+      {
+        uint n = 0;
+        for (AtomicGroup::const_iterator j = _groups[1].begin(); j != _groups[1].end(); ++j) {
+          const GCoord& b = (*j)->coords();
+          for (AtomicGroup::const_iterator i = _groups[0].begin(); i != _groups[0].end(); ++i)
+            if (*i != *j && (periodic ? b.distance2((*i)->coords(), box) : b.distance2((*i)->coords())) <= _cutoff2) {
+              ++n;
+              break;
+            }
+        }
+        return(n);
+      }
+
+    case ANGLE:
+      return(Math::angle(_groups[0].centroid(), _groups[1].centroid(), _groups[2].centroid(), pbox));
+
+    case DIHEDRAL:
+      return(Math::torsion(_groups[0].centroid(), _groups[1].centroid(), _groups[2].centroid(),
+                           _groups[3].centroid(), pbox));
+
+    case RGYR:
+      return(_groups[0].radiusOfGyration());
+    }
+
+    return(0.0);
+  }
+
+
+
+
+  FrameFeatureIndex::FrameFeatureIndex(const std::vector<std::string>& names, const std::vector<std::string>& definitions,
+                                       const std::vector<uint>& frames)
+    : _names(names), _definitions(definitions), _frames(frames),
+      _columns(names.size(), std::vector<float>(frames.size(), 0.0f))
+  {
+    if (_definitions.size() != _names.size())
+      throw(LOOSError("Each feature in a frame index needs a definition"));
+  }
+
+
+  const std::vector<float>& FrameFeatureIndex::column(const std::string& name) const {
+    for (uint i=0; i<_names.size(); ++i)
+      if (_names[i] == name)
+        return(_columns[i]);
+    throw(LOOSError("No feature named '" + name + "' in the frame index"));
+  }
+
+
+  std::vector<uint> FrameFeatureIndex::queryRows(const std::string& expr) const {
+    QueryParser parser(*this, expr);
+    std::vector<char> mask = parser.parse();
+
+    std::vector<uint> rows;
+    for (uint i=0; i<mask.size(); ++i)
+      if (mask[i])
+        rows.push_back(i);
+    return(rows);
+  }
+
+
+  std::vector<uint> FrameFeatureIndex::query(const std::string& expr) const {
+    std::vector<uint> rows = queryRows(expr);
+    for (uint i=0; i<rows.size(); ++i)
+      rows[i] = _frames[rows[i]];
+    return(rows);
+  }
+
+
+  void FrameFeatureIndex::write(const std::string& fname) const {
+    std::ofstream ofs(fname.c_str(), std::ios_base::out | std::ios_base::binary);
+    if (!ofs)
+      throw(FileOpenError(fname));
+
+    ofs.write(index_magic, 8);
+    writeValue(ofs, index_endian);
+    writeValue(ofs, index_version);
+    writeString(ofs, _trajectory);
+    writeValue<boost::uint32_t>(ofs, _frames.size());
+    writeValue<boost::uint32_t>(ofs, _names.size());
+    for (uint i=0; i<_names.size(); ++i) {
+      writeString(ofs, _names[i]);
+      writeString(ofs, _definitions[i]);
+    }
+
+    for (uint i=0; i<_frames.size(); ++i)
+      writeValue<boost::uint32_t>(ofs, _frames[i]);
+    for (uint i=0; i<_columns.size(); ++i)
+      if (!_frames.empty())
+        ofs.write(reinterpret_cast<const char*>(&_columns[i][0]), _frames.size() * sizeof(float));
+
+    if (ofs.fail())
+      throw(FileWriteError(fname));
+  }
+
+
+  void FrameFeatureIndex::read(const std::string& fname) {
+    std::ifstream ifs(fname.c_str(), std::ios_base::in | std::ios_base::binary);
+    if (!ifs)
+      throw(FileOpenError(fname));
+
+    char magic[8];
+    ifs.read(magic, 8);
+    if (ifs.fail() || std::memcmp(magic, index_magic, 8) != 0)
+      throw(FileReadError(fname, "Not a LOOS frame index"));
+
+    IndexReader reader(ifs, fname);
+    boost::uint32_t endian = reader.value<boost::uint32_t>();
+    if (endian != index_endian) {
+      if (swab(endian) != index_endian)
+        throw(FileReadError(fname, "Frame index has a bad byte-order marker"));
+      reader.swapBytes(true);
+    }
+    if (reader.value<boost::uint32_t>() != index_version)
+      throw(FileReadError(fname, "Unsupported frame index version"));
+
+    _trajectory = reader.string();
+    uint nframes = reader.value<boost::uint32_t>();
+    uint nfeatures = reader.value<boost::uint32_t>();
+    _names.resize(nfeatures);
+    _definitions.resize(nfeatures);
+    for (uint i=0; i<nfeatures; ++i) {
+      _names[i] = reader.string();
+      _definitions[i] = reader.string();
+    }
+
+    std::vector<boost::uint32_t> frames;
+    reader.array(frames, nframes);
+    _frames.assign(frames.begin(), frames.end());
+
+    _columns.resize(nfeatures);
+    for (uint i=0; i<nfeatures; ++i)
+      reader.array(_columns[i], nframes);
+  }
+
+}
@@ -0,0 +1,159 @@
+/*
+  This file is part of LOOS.
+
+  LOOS (Lightweight Object-Oriented Structure library)
+  Copyright (c) 2008, Tod D. Romo, Alan Grossfield
+  Department of Biochemistry and Biophysics
+  School of Medicine & Dentistry, University of Rochester
+
+  This package (LOOS) is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation under version 3 of the License.
+
+  This package is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#if !defined(LOOS_FRAME_FEATURES_HPP)
+#define LOOS_FRAME_FEATURES_HPP
+
+#include <string>
+#include <vector>
+
+#include <loos_defs.hpp>
+#include <AtomicGroup.hpp>
+
+
+namespace loos {
+
+
+  //! A named quantity computed for each frame of a trajectory
+  /**
+   * Features are written as "name=kind; selection; ...", where the
+   * kind is one of:
+   *
+   * - distance; sel1; sel2 -- distance between the centroids
+   * - mindist; sel1; sel2 -- smallest distance between any pair of atoms
+   * - contacts; sel1; sel2; cutoff -- number of atom pairs within cutoff
+   * - count; sel1; sel2; cutoff -- number of atoms of sel2 within cutoff of any atom of sel1
+   * - angle; sel1; sel2; sel3 -- angle (in degrees) between the centroids
+   * - dihedral; sel1; sel2; sel3; sel4 -- torsion (in degrees) between the centroids
+   * - rgyr; sel -- radius of gyration
+   *
+   * For example,
+   * \code
+   * FrameFeature f("bridge=mindist; resid == 45 && name =~ '^OE'; resid == 80 && name == 'NZ'", model);
+   * while (traj->readFrame()) {
+   *   traj->updateGroupCoords(model);
+   *   double d = f.value();
+   * }
+   * \endcode
+   *
+   * Distances use the periodic box (if the model has one) to find the
+   * closest image.
+   */
+  class FrameFeature {
+  public:
+    enum Kind { DISTANCE, MINDIST, CONTACTS, COUNT, ANGLE, DIHEDRAL, RGYR };
+
+    //! Parses \a spec and selects its atoms from \a model
+    FrameFeature(const std::string& spec, const AtomicGroup& model);
+
+    std::string name() const { return(_name); }
+    Kind kind() const { return(_kind); }
+
+    //! The definition, as given to the constructor
+    std::string definition() const { return(_spec); }
+
+    //! Computes the feature from the current coordinates of the model's atoms
+    double value() const;
+
+  private:
+    std::string _spec;
+    std::string _name;
+    Kind _kind;
+    std::vector<AtomicGroup> _groups;
+    double _cutoff2;
+  };
+
+
+
+  //! Table of per-frame features for querying which frames meet some condition
+  /**
+   * The index is stored by column (one column of single precision
+   * values per feature, plus the trajectory frame number of each
+   * row), so a query only touches the columns it names.  It is
+   * normally built once by the frame-index tool and stored next to
+   * the trajectory (as e.g. "traj.dcd.fidx"), then queried with the
+   * frame-query tool, whose output can be passed to any --range
+   * option.
+   *
+   * Queries are boolean expressions over the feature names, with the
+   * usual comparisons (<, <=, >, >=, ==, !=), combined with &&, ||,
+   * !, and parentheses.  Comparisons may be chained to test a range,
+   * and "frame" is the trajectory frame number:
+   * \code
+   * FrameFeatureIndex index("traj.dcd.fidx");
+   * std::vector<uint> frames = index.query("ligsite < 4 && 2.5 <= bridge <= 3.5 && frame >= 1000");
+   * std::cout << rangeListAsString(frames) << std::endl;
+   * \endcode
+   */
+  class FrameFeatureIndex {
+  public:
+    FrameFeatureIndex() { }
+
+    //! Reads an index from a file
+    explicit FrameFeatureIndex(const std::string& fname) { read(fname); }
+
+    //! Empty index with room for \a frames rows of the named features
+    FrameFeatureIndex(const std::vector<std::string>& names, const std::vector<std::string>& definitions,
+                      const std::vector<uint>& frames);
+
+    //! Usual name for the index of trajectory \a traj
+    static std::string defaultName(const std::string& traj) { return(traj + ".fidx"); }
+
+    uint frames() const { return(_frames.size()); }
+    uint features() const { return(_names.size()); }
+
+    //! Trajectory frame number of each row
+    const std::vector<uint>& frameNumbers() const { return(_frames); }
+
+    const std::vector<std::string>& names() const { return(_names); }
+    const std::vector<std::string>& definitions() const { return(_definitions); }
+
+    //! Column of a feature, by name (throws if there is no such feature)
+    const std::vector<float>& column(const std::string& name) const;
+    const std::vector<float>& column(const uint i) const { return(_columns.at(i)); }
+    std::vector<float>& column(const uint i) { return(_columns.at(i)); }
+
+    //! Name of the trajectory the index was built from
+    std::string trajectoryName() const { return(_trajectory); }
+    void trajectoryName(const std::string& s) { _trajectory = s; }
+
+    //! Trajectory frame numbers of the rows where \a expr is true
+    std::vector<uint> query(const std::string& expr) const;
+
+    //! Rows (not frame numbers) where \a expr is true
+    std::vector<uint> queryRows(const std::string& expr) const;
+
+    void read(const std::string& fname);
+    void write(const std::string& fname) const;
+
+  private:
+    std::string _trajectory;
+    std::vector<std::string> _names, _definitions;
+    std::vector<uint> _frames;
+    std::vector< std::vector<float> > _columns;
+  };
+
+
+}
+
+
+#endif
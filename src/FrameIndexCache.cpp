@@ -0,0 +1,241 @@
+/*
+  This file is part of LOOS.
+
+  LOOS (Lightweight Object-Oriented Structure library)
+  Copyright (c) 2008, Tod D. Romo, Alan Grossfield
+  Department of Biochemistry and Biophysics
+  School of Medicine & Dentistry, University of Rochester
+
+  This package (LOOS) is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation under version 3 of the License.
+
+  This package is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include <algorithm>
+#include <cerrno>
+#include <climits>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <unistd.h>
+
+#include <boost/cstdint.hpp>
+
+#include <FrameIndexCache.hpp>
+
+
+namespace loos {
+
+  namespace {
+
+    const char cache_magic[8] = { 'L', 'O', 'O', 'S', 'I', 'D', 'X', '1' };
+
+
+    // 64-bit FNV-1a, used to turn the key into a file name
+    boost::uint64_t fnv1a(const std::string& s) {
+      boost::uint64_t h = 0xcbf29ce484222325ull;
+      for (std::string::const_iterator i = s.begin(); i != s.end(); ++i) {
+        h ^= static_cast<unsigned char>(*i);
+        h *= 0x100000001b3ull;
+      }
+      return(h);
+    }
+
+
+    template<typename T>
+    void put(std::ostream& os, const T& x) {
+      os.write(reinterpret_cast<const char*>(&x), sizeof(T));
+    }
+
+    template<typename T>
+    bool get(std::istream& is, T& x) {
+      is.read(reinterpret_cast<char*>(&x), sizeof(T));
+      return(is.good());
+    }
+
+    void putString(std::ostream& os, const std::string& s) {
+      put(os, static_cast<boost::uint32_t>(s.size()));
+      os.write(s.data(), s.size());
+    }
+
+    bool getString(std::istream& is, std::string& s) {
+      boost::uint32_t n;
+      if (!get(is, n) || n > PATH_MAX)
+        return(false);
+      s.resize(n);
+      if (n > 0)
+        is.read(&s[0], n);
+      return(is.good());
+    }
+
+  }
+
+
+
+  FrameIndexCache::FrameIndexCache(const std::string& filename, const std::string& format)
+    : _format(format), _size(0), _sec(0), _nsec(0)
+  {
+    std::string dir = directory();
+    if (dir.empty() || filename.empty())
+      return;
+
+    char* p = realpath(filename.c_str(), 0);
+    if (!p)
+      return;
+    _path = p;
+    free(p);
+
+    if (!stamp(_size, _sec, _nsec)) {
+      _path.clear();
+      return;
+    }
+
+    std::ostringstream oss;
+    oss << dir << '/' << std::hex << fnv1a(_format + '\0' + _path) << ".idx";
+    _entry = oss.str();
+  }
+
+
+  std::string FrameIndexCache::directory(const bool create) {
+    const char* p = getenv("LOOS_INDEX_CACHE");
+    if (p) {
+      std::string dir(p);
+      if (dir.empty() || dir == "0")
+        return(std::string());
+      if (create && mkdir(dir.c_str(), 0700) < 0 && errno != EEXIST)
+        return(std::string());
+      return(dir);
+    }
+
+    p = getenv("HOME");
+    if (!p || !*p)
+      return(std::string());
+
+    std::string dir = std::string(p) + "/.loos";
+    if (create && mkdir(dir.c_str(), 0700) < 0 && errno != EEXIST)
+      return(std::string());
+    dir += "/index";
+    if (create && mkdir(dir.c_str(), 0700) < 0 && errno != EEXIST)
+      return(std::string());
+
+    return(dir);
+  }
+
+
+  bool FrameIndexCache::stamp(unsigned long& size, long& sec, long& nsec) const {
+    struct stat st;
+    if (stat(_path.c_str(), &st) < 0)
+      return(false);
+
+    size = st.st_size;
+    sec = st.st_mtime;
+#if defined(__APPLE__)
+    nsec = st.st_mtimespec.tv_nsec;
+#else
+    nsec = st.st_mtim.tv_nsec;
+#endif
+    return(true);
+  }
+
+
+  bool FrameIndexCache::lookup(FrameIndex& index) const {
+    if (_entry.empty())
+      return(false);
+
+    std::ifstream ifs(_entry.c_str(), std::ios::in | std::ios::binary);
+    if (!ifs)
+      return(false);
+
+    char magic[sizeof(cache_magic)];
+    ifs.read(magic, sizeof(magic));
+    if (!ifs.good() || !std::equal(magic, magic + sizeof(magic), cache_magic))
+      return(false);
+
+    // The hash may collide, so check the full key as well
+    std::string path, format;
+    boost::uint64_t size;
+    boost::int64_t sec, nsec;
+    if (!(getString(ifs, path) && getString(ifs, format) && get(ifs, size) && get(ifs, sec) && get(ifs, nsec)))
+      return(false);
+    if (path != _path || format != _format || size != _size || sec != _sec || nsec != _nsec)
+      return(false);
+
+    boost::uint32_t natoms;
+    float timestep;
+    boost::uint64_t n;
+    if (!(get(ifs, natoms) && get(ifs, timestep) && get(ifs, n)))
+      return(false);
+    if (n == 0 || n > _size)
+      return(false);
+
+    std::vector<boost::uint64_t> offsets(n);
+    ifs.read(reinterpret_cast<char*>(&offsets[0]), n * sizeof(boost::uint64_t));
+    if (ifs.gcount() != static_cast<std::streamsize>(n * sizeof(boost::uint64_t)))
+      return(false);
+
+    // Offsets must be increasing and lie within the file
+    for (boost::uint64_t i=0; i<n; ++i)
+      if (offsets[i] >= _size || (i > 0 && offsets[i] <= offsets[i-1]))
+        return(false);
+
+    index.natoms = natoms;
+    index.timestep = timestep;
+    index.offsets.assign(offsets.begin(), offsets.end());
+    return(true);
+  }
+
+
+  // Written to a temporary file and then renamed, so a reader never
+  // sees a partial entry.  The temporary name includes this object's
+  // address so threads opening the same file don't share it.
+  void FrameIndexCache::store(const FrameIndex& index) const {
+    if (_entry.empty() || index.offsets.size() < min_frames)
+      return;
+
+    unsigned long size;
+    long sec, nsec;
+    if (!stamp(size, sec, nsec) || size != _size || sec != _sec || nsec != _nsec)
+      return;
+
+    if (directory(true).empty())
+      return;
+
+    std::ostringstream oss;
+    oss << _entry << '.' << getpid() << '.' << this;
+    std::string tmpname = oss.str();
+
+    std::ofstream ofs(tmpname.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+    if (!ofs)
+      return;
+
+    ofs.write(cache_magic, sizeof(cache_magic));
+    putString(ofs, _path);
+    putString(ofs, _format);
+    put(ofs, static_cast<boost::uint64_t>(_size));
+    put(ofs, static_cast<boost::int64_t>(_sec));
+    put(ofs, static_cast<boost::int64_t>(_nsec));
+    put(ofs, static_cast<boost::uint32_t>(index.natoms));
+    put(ofs, index.timestep);
+    put(ofs, static_cast<boost::uint64_t>(index.offsets.size()));
+    for (std::vector<size_t>::const_iterator i = index.offsets.begin(); i != index.offsets.end(); ++i)
+      put(ofs, static_cast<boost::uint64_t>(*i));
+    ofs.close();
+
+    if (ofs.fail() || rename(tmpname.c_str(), _entry.c_str()) < 0)
+      unlink(tmpname.c_str());
+  }
+
+}
@@ -0,0 +1,106 @@
+/*
+  This file is part of LOOS.
+
+  LOOS (Lightweight Object-Oriented Structure library)
+  Copyright (c) 2008, Tod D. Romo, Alan Grossfield
+  Department of Biochemistry and Biophysics
+  School of Medicine & Dentistry, University of Rochester
+
+  This package (LOOS) is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation under version 3 of the License.
+
+  This package is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#if !defined(LOOS_FRAME_INDEX_CACHE_HPP)
+#define LOOS_FRAME_INDEX_CACHE_HPP
+
+#include <string>
+#include <vector>
+
+#include <loos_defs.hpp>
+
+
+namespace loos {
+
+
+  //! Frame offsets for a trajectory file, as kept by the index cache
+  struct FrameIndex {
+    FrameIndex() : natoms(0), timestep(0.0) { }
+
+    uint natoms;
+    float timestep;
+    std::vector<size_t> offsets;    ///< Byte offset of the start of each frame
+  };
+
+
+  //! On-disk cache of frame indices
+  /**
+   * Formats that do not store the number of frames (XTC and TRR)
+   * have to read every frame header to find where the frames are.
+   * For long trajectories this dominates the time to open them, so
+   * the index is saved and reused the next time the same file is
+   * opened.
+   *
+   * Indices are kept in the directory named by the LOOS_INDEX_CACHE
+   * environment variable, or in ~/.loos/index if it is not set.
+   * Setting LOOS_INDEX_CACHE to 0 (or to an empty string) disables
+   * the cache.  Each entry records the full path, size and
+   * modification time of the trajectory it came from, and is ignored
+   * if any of these no longer match.  Only trajectories with at least
+   * min_frames frames are stored.
+   *
+   * The cache is only an optimization, so errors reading or writing
+   * it are ignored (the trajectory is simply scanned).  Usage:
+   * \code
+   * FrameIndexCache cache(filename, "xtc");
+   * FrameIndex index;
+   * if (!cache.lookup(index)) {
+   *   // ...scan the file, filling in index...
+   *   cache.store(index);
+   * }
+   * \endcode
+   */
+  class FrameIndexCache {
+  public:
+    //! Smallest trajectory (in frames) that is worth caching
+    static const uint min_frames = 100;
+
+    //! Prepare to cache the index for filename, read as format
+    /**
+     * The format is a tag (e.g. "xtc") that keeps indices for the
+     * same file read as different formats apart.  The file's size and
+     * modification time are taken here, so an index is only stored if
+     * the file did not change while it was being scanned.
+     */
+    FrameIndexCache(const std::string& filename, const std::string& format);
+
+    //! Get the cached index, returning false if there is no valid entry
+    bool lookup(FrameIndex& index) const;
+
+    //! Save the index (if the file hasn't changed since construction)
+    void store(const FrameIndex& index) const;
+
+    //! Directory used for the cache (empty if it is disabled)
+    static std::string directory(const bool create = false);
+
+  private:
+    bool stamp(unsigned long& size, long& sec, long& nsec) const;
+
+    std::string _path, _format, _entry;
+    unsigned long _size;
+    long _sec, _nsec;
+  };
+
+}
+
+
+#endif
@@ -46,15 +46,18 @@ namespace loos {
 
     bool HBondDetector::hBonded(const pAtom donor, const pAtom hydrogen,
                                 const pAtom acceptor) {
-        // Check distance between hydrogen and acceptor
-        double d2;
+        // Check distance between hydrogen and acceptor.  The
+        // reimaged hydrogen-acceptor vector is reused for the angle.
+        GCoord h_to_a;
         if (box.isPeriodic()) {
-            d2 = hydrogen->coords().distance2(acceptor->coords(), box.box());
+            DistanceKernels::Distance2< DistanceKernels::Orthorhombic<double> > op(box.box());
+            h_to_a = op.delta(hydrogen->coords(), acceptor->coords());
         }
         else {
-            d2 = hydrogen->coords().distance2(acceptor->coords());
+            h_to_a = acceptor->coords() - hydrogen->coords();
         }
 
+        double d2 = h_to_a.length2();
         if (d2 > cutoff_dist2) {
             return false;
         }
@@ -65,10 +68,6 @@ namespace loos {
         // Return true if the angle is greater than the threshold (meaning
         // the cosine is less than the threshold)
         GCoord d_to_h =  hydrogen->coords() - donor->coords();
-        GCoord h_to_a =  acceptor->coords() - hydrogen->coords();
-        if (box.isPeriodic()) {
-            h_to_a.reimage(box.box());
-        }
 
         double cosine = (d_to_h * h_to_a)/(d_to_h.length() * sqrt(d2));
         return (cosine > cutoff_cos);
@@ -281,13 +281,13 @@ namespace loos {
     }
 
 
-    
-    // Provide storage for class-level selector
-    BackboneSelector Backbone::bbsel;
 
 
     void Backbone::execute(void) {
       requireAtom();
+
+      // BackboneSelector has no state, so there's no need to share one
+      BackboneSelector bbsel;
       Value v(bbsel(atom));
       
       stack->push(v);
@@ -45,8 +45,6 @@
 
 namespace loos {
 
-  class BackboneSelector;
-
   //! Loos esoterica.
   /** You probably don't want to look in here unless you want to
    *  program with the virtual machine for atom selections, but I'd
@@ -325,7 +323,6 @@ namespace loos {
 
     //! Shortcut for checking for backbone atoms...
     class Backbone : public Action {
-      static BackboneSelector bbsel;    // Make this class-level since we only need one to wrap
     public:
       Backbone() : Action("Backbone") { }
       void execute(void);
@@ -41,6 +41,7 @@
 
 
 #include "grammar.hh"
+#include "exceptions.hpp"
 
 // @cond TOOLS_INTERNAL
 
@@ -51,7 +52,9 @@ public:
   LoosLexer(std::istream* in) : LoosFlexLexer(in, 0) { }
   
   loos::parser::token_type looslex(loos::parser::semantic_type* yylval);
-  
+
+  // Flex's default handler exits the process...
+  void LexerError(const char* msg) { throw(loos::ParseError(msg)); }
 };
 
 // @endcond
@@ -119,6 +119,7 @@ namespace loos {
 
     //! Returns the array pointer
     T* data(void) { return(matrix); }
+    const T* data(void) const { return(matrix); }
 
 
     //! Addition of two matrices
@@ -0,0 +1,75 @@
+/*
+  This file is part of LOOS.
+
+  LOOS (Lightweight Object-Oriented Structure library)
+  Copyright (c) 2008, Tod D. Romo, Alan Grossfield
+  Department of Biochemistry and Biophysics
+  School of Medicine & Dentistry, University of Rochester
+
+  This package (LOOS) is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation under version 3 of the License.
+
+  This package is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include <ModeProjection.hpp>
+#include <exceptions.hpp>
+
+#include <cmath>
+
+
+namespace loos {
+
+
+  DoubleMatrix modeFrames(const std::vector<double>& x0, const DoubleMatrix& D, const DoubleMatrix& A) {
+    if (x0.size() != D.rows() || A.cols() != D.cols())
+      throw(LOOSError("modeFrames() arguments have mismatched sizes"));
+
+    DoubleMatrix X = Math::MMMultiply(D, A, false, true);
+
+    uint m = X.rows();
+    for (uint f=0; f<X.cols(); ++f) {
+      double* x = X.get() + static_cast<ulong>(f) * m;
+      for (uint i=0; i<m; ++i)
+        x[i] += x0[i];
+    }
+
+    return(X);
+  }
+
+
+
+  std::vector<double> modeFluctuations(const DoubleMatrix& V, const std::vector<double>& w) {
+    if (w.size() != V.cols())
+      throw(LOOSError("modeFluctuations() needs one weight per column"));
+    if (V.rows() % 3 != 0)
+      throw(LOOSError("Mode matrix must have 3 rows per atom"));
+
+    uint m = V.rows();
+    std::vector<double> sq(m, 0.0);
+
+    // Column at a time, so V is read in storage order
+    for (uint j=0; j<V.cols(); ++j) {
+      const double* v = V.get() + static_cast<ulong>(j) * m;
+      double k = w[j];
+      for (uint i=0; i<m; ++i)
+        sq[i] += k * v[i] * v[i];
+    }
+
+    std::vector<double> fluct(m / 3);
+    for (uint i=0; i<fluct.size(); ++i)
+      fluct[i] = sq[3*i] + sq[3*i+1] + sq[3*i+2];
+
+    return(fluct);
+  }
+
+
+}
@@ -0,0 +1,111 @@
+/*
+  This file is part of LOOS.
+
+  LOOS (Lightweight Object-Oriented Structure library)
+  Copyright (c) 2008, Tod D. Romo, Alan Grossfield
+  Department of Biochemistry and Biophysics
+  School of Medicine & Dentistry, University of Rochester
+
+  This package (LOOS) is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation under version 3 of the License.
+
+  This package is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#if !defined(LOOS_MODE_PROJECTION_HPP)
+#define LOOS_MODE_PROJECTION_HPP
+
+#include <vector>
+#include <cmath>
+
+#include <loos_defs.hpp>
+#include <MatrixOps.hpp>
+#include <exceptions.hpp>
+
+
+namespace loos {
+
+  // Helpers for turning a set of modes (eigenvectors from an ENM or
+  // left singular vectors from a PCA, one 3N-vector per column, with
+  // atom i's components in rows 3i..3i+2) back into structures and
+  // per-atom quantities, as in enmovie, porcupine, and eigenflucc.
+
+
+  //! Selected columns of a mode matrix, each multiplied by a scale
+  /**
+   * Column j of the result is scales[j] times column cols[j] of \a U.
+   * If \a uniform is true, each atom's 3-vector is first normalized
+   * to unit length (so every atom moves the same distance).  The
+   * result is always double, whatever the precision of \a U.
+   */
+  template<typename T>
+  DoubleMatrix scaledModes(const Math::Matrix<T, Math::ColMajor>& U, const std::vector<int>& cols,
+                           const std::vector<double>& scales, const bool uniform = false) {
+    if (scales.size() != cols.size())
+      throw(LOOSError("scaledModes() needs one scale per column"));
+    if (U.rows() % 3 != 0)
+      throw(LOOSError("Mode matrix must have 3 rows per atom"));
+
+    uint m = U.rows();
+    DoubleMatrix D(m, cols.size());
+    for (uint j=0; j<cols.size(); ++j) {
+      if (cols[j] < 0 || static_cast<uint>(cols[j]) >= U.cols())
+        throw(LOOSError("Mode column is out of range"));
+
+      const T* u = U.get() + static_cast<ulong>(cols[j]) * m;
+      double* d = D.get() + static_cast<ulong>(j) * m;
+      double k = scales[j];
+
+      for (uint i=0; i<m; i += 3) {
+        double x = u[i], y = u[i+1], z = u[i+2];
+        if (uniform) {
+          double l = sqrt(x*x + y*y + z*z);
+          x /= l;
+          y /= l;
+          z /= l;
+        }
+        d[i] = x * k;
+        d[i+1] = y * k;
+        d[i+2] = z * k;
+      }
+    }
+
+    return(D);
+  }
+
+
+  //! Coordinates of a block of frames displaced along a set of modes
+  /**
+   * \a D holds one 3N mode per column, \a A has one row per frame
+   * with the amplitude of each mode, and \a x0 is the 3N reference
+   * coordinates.  The result is 3N x F, with frame f in column f
+   * (so each frame is contiguous and can be passed straight to
+   * TrajectoryWriter::writeFrames()).  All of the displacements are
+   * formed by a single matrix multiply, D A^T.
+   */
+  DoubleMatrix modeFrames(const std::vector<double>& x0, const DoubleMatrix& D, const DoubleMatrix& A);
+
+
+  //! Weighted sum of the squared length of each atom's mode components
+  /**
+   * For atom i, this is sum_j w[j] * |V_ij|^2, where V_ij is the
+   * atom's 3-vector in column j of \a V.  With \a w the variance of
+   * each mode (e.g. inverse ENM eigenvalues), this is the trace of
+   * the atom's 3x3 block of V diag(w) V^T, i.e. its mean square
+   * fluctuation, without forming the 3N x 3N covariance.
+   */
+  std::vector<double> modeFluctuations(const DoubleMatrix& V, const std::vector<double>& w);
+
+
+}
+
+
+#endif
@@ -20,14 +20,85 @@
 */
 
 
+#include <cstdlib>
+
 #include <utils_structural.hpp>
 #include <OptionsFramework.hpp>
+#include <AnalysisClient.hpp>
+
+#if defined(HAS_NETCDF)
+#include <amber_netcdf_writer.hpp>
+#endif
 
 #include <boost/lambda/lambda.hpp>
 
 namespace loos {
   namespace OptionsFramework {
 
+    namespace {
+
+      // The analysis server can be set for all tools via the environment
+      std::string defaultServer() {
+        const char* p = getenv("LOOS_SERVER");
+        return(p ? std::string(p) : std::string());
+      }
+
+      const char* server_help = "Load through a LOOS analysis server (loosd) on this socket (default is $LOOS_SERVER)";
+
+
+      // NetCDF layout options only mean something when LOOS can write
+      // NetCDF, so they're hidden otherwise
+      void addNetcdfOptions(po::options_description& opts, uint& chunk, int& deflate) {
+#if defined(HAS_NETCDF)
+        opts.add_options()
+          ("nc-chunk", po::value<uint>(&chunk)->default_value(chunk), "Frames per chunk for NetCDF output (0 = classic, unchunked file)")
+          ("nc-deflate", po::value<int>(&deflate)->default_value(deflate), "Compression level (0-9) for NetCDF output");
+#endif
+      }
+
+      // The writer checks the level too, but catching it here gives the
+      // user an error message rather than an exception
+      bool validDeflateLevel(const int deflate) {
+        if (deflate < 0 || deflate > 9) {
+          std::cerr << "Error- NetCDF deflate level must be between 0 and 9\n";
+          return(false);
+        }
+        return(true);
+      }
+
+      pTrajectoryWriter configureNetcdf(pTrajectoryWriter traj, const uint chunk, const int deflate) {
+#if defined(HAS_NETCDF)
+        boost::shared_ptr<AmberNetcdfWriter> nc = boost::dynamic_pointer_cast<AmberNetcdfWriter>(traj);
+        if (nc && !nc->isAppending()) {
+          nc->framesPerChunk(chunk);
+          nc->deflateLevel(deflate);
+        }
+#endif
+        return(traj);
+      }
+
+      // Returns an empty pointer (after warning) if the server can't
+      // be reached, so the caller can fall back to reading the files
+      // itself
+      boost::shared_ptr<AnalysisClient> connectToServer(const std::string& path) {
+        boost::shared_ptr<AnalysisClient> client;
+        if (path.empty())
+          return(client);
+
+        try {
+          client = boost::shared_ptr<AnalysisClient>(new AnalysisClient(path));
+        }
+        catch (internal::AnalysisServerError& e) {
+          std::cerr << "Warning- " << e.what() << "\n";
+          std::cerr << "Warning- reading files directly instead\n";
+        }
+
+        return(client);
+      }
+
+    }
+
+
     void BasicOptions::addGeneric(po::options_description& opts) {
       if (!full_help.empty())
         opts.add_options()("fullhelp", "More detailed help");
@@ -172,9 +243,13 @@ namespace loos {
     void ModelWithCoords::addGeneric(po::options_description& opts) {
       std::string filetypes = "Model types:\n" + availableSystemFileTypes();
 
+      if (server_name.empty())
+        server_name = defaultServer();
+
       opts.add_options()
         ("coordinates,c", po::value<std::string>(&coords_name)->default_value(coords_name), "File to use for coordinates")
-        ("modeltype", po::value<std::string>(), filetypes.c_str());
+        ("modeltype", po::value<std::string>(), filetypes.c_str())
+        ("server", po::value<std::string>(&server_name)->default_value(server_name), server_help);
     }
 
     void ModelWithCoords::addHidden(po::options_description& opts) {
@@ -193,10 +268,15 @@ namespace loos {
     }
 
     bool ModelWithCoords::postConditions(po::variables_map& map) {
-      if (map.count("modeltype")) {
+      if (map.count("modeltype"))
         model_type = map["modeltype"].as<std::string>();
+
+      boost::shared_ptr<AnalysisClient> client = connectToServer(server_name);
+      if (client)
+        model = client->createSystem(model_name, model_type, coords_name, true);
+      else if (!model_type.empty())
         model = loadStructureWithCoords(model_name, model_type, coords_name);
-      } else
+      else
         model = loadStructureWithCoords(model_name, coords_name);
 
       return(true);
@@ -211,6 +291,8 @@ namespace loos {
       oss << boost::format("model='%s', modeltype='%s'") % model_name % model_type;
       if (!coords_name.empty())
         oss << boost::format(", coords='%s'") % coords_name;
+      if (!server_name.empty())
+        oss << boost::format(", server='%s'") % server_name;
 
       return(oss.str());
     }
@@ -298,10 +380,14 @@ namespace loos {
       std::string modeltypes = "Model types:\n" + availableSystemFileTypes();
       std::string trajtypes = "Trajectory types:\n" + availableTrajectoryFileTypes();
 
+      if (server_name.empty())
+        server_name = defaultServer();
+
       opts.add_options()
         ("skip,k", po::value<unsigned int>(&skip)->default_value(skip), "Number of frames to skip")
         ("modeltype", po::value<std::string>(), modeltypes.c_str())
-        ("trajtype", po::value<std::string>(), trajtypes.c_str());
+        ("trajtype", po::value<std::string>(), trajtypes.c_str())
+        ("server", po::value<std::string>(&server_name)->default_value(server_name), server_help);
     };
 
     void BasicTrajectory::addHidden(po::options_description& opts) {
@@ -320,28 +406,51 @@ namespace loos {
     }
 
     bool BasicTrajectory::postConditions(po::variables_map& map) {
-      if (map.count("modeltype")) {
+      if (map.count("modeltype"))
         model_type = map["modeltype"].as<std::string>();
-        model = createSystem(model_name, model_type);
-      } else
-        model = createSystem(model_name);
-
-      if (map.count("trajtype")) {
+      if (map.count("trajtype"))
         traj_type = map["trajtype"].as<std::string>();
-        trajectory = createTrajectory(traj_name, traj_type, model);
-      } else
-        trajectory = createTrajectory(traj_name, model);
 
-      if (skip > 0)
-        trajectory->readFrame(skip-1);
+      client = connectToServer(server_name);
+      if (client)
+        model = client->createSystem(model_name, model_type);
+      else
+        model = model_type.empty() ? createSystem(model_name) : createSystem(model_name, model_type);
+
+      if (open_trajectory)
+        trajectory = openTrajectory();
 
       return(true);
     }
 
+    pTraj BasicTrajectory::openTrajectory() const {
+      pTraj traj;
+      if (client)
+        traj = client->createTrajectory(traj_name, traj_type, model_name, model_type);
+      else
+        traj = traj_type.empty() ? createTrajectory(traj_name, model) : createTrajectory(traj_name, traj_type, model);
+
+      if (skip > 0)
+        traj->readFrame(skip-1);
+
+      return(traj);
+    }
+
+    TrajectoryInfo BasicTrajectory::probe() const {
+      if (client) {
+        pTraj traj = client->createTrajectory(traj_name, traj_type, model_name, model_type);
+        return(trajectoryInfoFrom(*traj));
+      }
+
+      return(traj_type.empty() ? probeTrajectory(traj_name, model) : probeTrajectory(traj_name, traj_type, model));
+    }
+
     std::string BasicTrajectory::help() const { return("model trajectory"); }
     std::string BasicTrajectory::print() const {
       std::ostringstream oss;
       oss << boost::format("model='%s', model_type='%s', traj='%s', traj_type='%s', skip=%d") % model_name % model_type % traj_name % traj_type % skip;
+      if (!server_name.empty())
+        oss << boost::format(", server='%s'") % server_name;
       return(oss.str());
     }
 
@@ -353,12 +462,16 @@ namespace loos {
       std::string modeltypes = "Model types:\n" + availableSystemFileTypes();
       std::string trajtypes = "Trajectory types:\n" + availableTrajectoryFileTypes();
 
+      if (server_name.empty())
+        server_name = defaultServer();
+
       opts.add_options()
         ("skip,k", po::value<unsigned int>(&skip)->default_value(skip), "Number of frames to skip")
         ("modeltype", po::value<std::string>(&model_type)->default_value(model_type), modeltypes.c_str())
         ("trajtype", po::value<std::string>(&traj_type)->default_value(traj_type), trajtypes.c_str())
         ("stride,i", po::value<unsigned int>(&stride)->default_value(stride), "Take every ith frame")
-        ("range,r", po::value<std::string>(&frame_index_spec), "Which frames to use (matlab style range, overrides stride and skip)");
+        ("range,r", po::value<std::string>(&frame_index_spec), "Which frames to use (matlab style range, overrides stride and skip)")
+        ("server", po::value<std::string>(&server_name)->default_value(server_name), server_help);
     };
 
     void TrajectoryWithFrameIndices::addHidden(po::options_description& opts) {
@@ -382,6 +495,13 @@ namespace loos {
         return(false);
       }
 
+      boost::shared_ptr<AnalysisClient> client = connectToServer(server_name);
+      if (client) {
+        model = client->createSystem(model_name, model_type);
+        trajectory = client->createTrajectory(traj_name, traj_type, model_name, model_type);
+        return(true);
+      }
+
       if (model_type.empty())
         model = createSystem(model_name);
       else
@@ -403,6 +523,8 @@ namespace loos {
         oss << ", skip=" << skip;
       else if (!frame_index_spec.empty())
         oss << ", range='" << frame_index_spec << "'";
+      if (!server_name.empty())
+        oss << ", server='" << server_name << "'";
 
       return(oss.str());
     }
@@ -413,6 +535,37 @@ namespace loos {
       return uniquifyVector(indices);
     }
 
+    pTraj TrajectoryWithFrameIndices::openTrajectory() const {
+      boost::shared_ptr<AnalysisClient> client = connectToServer(server_name);
+      if (client)
+        return(client->createTrajectory(traj_name, traj_type, model_name, model_type));
+
+      if (traj_type.empty())
+        return(createTrajectory(traj_name, model));
+      return(createTrajectory(traj_name, traj_type, model));
+    }
+
+    // -------------------------------------------------------
+
+    void ProcessOptions::addGeneric(po::options_description& opts) {
+      opts.add_options()
+        ("procs", po::value<unsigned int>(&procs)->default_value(procs), "Number of processes to split the trajectory across");
+    }
+
+    bool ProcessOptions::postConditions(po::variables_map& map) {
+      if (procs == 0) {
+        std::cerr << "Error- --procs must be at least 1\n";
+        return(false);
+      }
+      return(true);
+    }
+
+    std::string ProcessOptions::print() const {
+      std::ostringstream oss;
+      oss << "procs=" << procs;
+      return(oss.str());
+    }
+
     // -------------------------------------------------------
 
     void MultiTrajOptions::addGeneric(po::options_description& opts) {
@@ -505,6 +658,7 @@ namespace loos {
       opts.add_options()
 	("outtrajtype,t", po::value<std::string>(&type), types.c_str())
 	("append", po::value<bool>(&append)->default_value(append), "Append if trajectory exists, otherwise overwrite");
+      addNetcdfOptions(opts, nc_chunk, nc_deflate);
     }
 
     void OutputTrajectoryOptions::addHidden(po::options_description& opts) {
@@ -527,7 +681,10 @@ namespace loos {
       if (type.empty())
 	type = boost::get<1>(names);
 
-      outraj = createOutputTrajectory(name, type, append);
+      if (!validDeflateLevel(nc_deflate))
+        return(false);
+
+      outraj = configureNetcdf(createOutputTrajectory(name, type, append), nc_chunk, nc_deflate);
       return(true);
     }
 
@@ -553,6 +710,12 @@ namespace loos {
       opts.add_options()
 	("outtrajtype,t", po::value<std::string>(&type)->default_value("dcd"), types.c_str())
 	("append", po::value<bool>(&append)->default_value(append), "Append if trajectory exists, otherwise overwrite");
+      addNetcdfOptions(opts, nc_chunk, nc_deflate);
+    }
+
+
+    bool OutputTrajectoryTypeOptions::postConditions(po::variables_map& map) {
+      return(validDeflateLevel(nc_deflate));
     }
 
 
@@ -568,7 +731,7 @@ namespace loos {
     pTrajectoryWriter OutputTrajectoryTypeOptions::createTrajectory(const std::string& prefix) {
 
       std::string fname = prefix + "." + type;
-      return(createOutputTrajectory(fname, type, append));
+      return(configureNetcdf(createOutputTrajectory(fname, type, append), nc_chunk, nc_deflate));
     }
 
     // -------------------------------------------------------
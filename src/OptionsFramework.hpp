@@ -38,6 +38,8 @@
 
 namespace loos {
 
+  class AnalysisClient;
+
   //! Namespace for encapsulating options processing
   /**
    * The OptionsFramework provides a consistent set of "common" options
@@ -154,6 +156,10 @@ namespace loos {
    *    processTrajectoryFrame(traj->readFrame(*i));
    * \endcode
    *
+   * Tools that handle each frame independently can also add
+   * ProcessOptions, which provides --procs, and split the frame list
+   * across that many processes with a ProcessPool.
+   *
    * <b>Writing a ToolOption class</b>
    *
    * The common idiom to add tool-specific options \e not covered by
@@ -425,6 +431,9 @@ namespace loos {
 
       std::string model_name, coords_name, model_type;
 
+      //! Socket for an AnalysisServer to load through (see loosd)
+      std::string server_name;
+
       AtomicGroup model;
 
     private:
@@ -491,15 +500,36 @@ namespace loos {
      *
      * The contained trajectory object will already be skipped to the
      * correct frame by postConditions().
+     *
+     * Tools that may not need to read the trajectory can construct
+     * this with open set to false.  The trajectory is then left empty
+     * and the tool can call probe() to get the metadata, or
+     * openTrajectory() when it does need the frames.
      **/
     class BasicTrajectory : public OptionsPackage {
     public:
-      BasicTrajectory() : skip(0) { }
+      BasicTrajectory() : skip(0), open_trajectory(true) { }
+      BasicTrajectory(const bool open) : skip(0), open_trajectory(open) { }
+
+      //! Open the trajectory (primed by --skip), through the server if one is used
+      pTraj openTrajectory() const;
+
+      //! Metadata for the trajectory
+      /**
+       * Without a server, this uses probeTrajectory(), so no frames
+       * are read for formats that support it.  With a server, the
+       * server opens the trajectory and the metadata comes from it.
+       * --skip is not applied.
+       */
+      TrajectoryInfo probe() const;
 
 
       unsigned int skip;
       std::string model_name, model_type, traj_name, traj_type;
 
+      //! Socket for an AnalysisServer to load through (see loosd)
+      std::string server_name;
+
       //! Model that describes the trajectory
       AtomicGroup model;
 
@@ -508,6 +538,9 @@ namespace loos {
 
 
     private:
+      bool open_trajectory;
+      boost::shared_ptr<AnalysisClient> client;
+
       void addGeneric(po::options_description& opts);
       void addHidden(po::options_description& opts);
 
@@ -541,10 +574,20 @@ namespace loos {
       //! Returns the list of frames the user requested
       std::vector<uint> frameList() const;
 
+      //! Opens another copy of the trajectory
+      /**
+       * Each process in a ProcessPool needs its own copy since open
+       * files are shared across a fork().
+       */
+      pTraj openTrajectory() const;
+
       unsigned int skip, stride;
       std::string frame_index_spec;
       std::string model_name, model_type, traj_name, traj_type;
 
+      //! Socket for an AnalysisServer to load through (see loosd)
+      std::string server_name;
+
 
       //! Model that describes the trajectory
       AtomicGroup model;
@@ -569,6 +612,25 @@ namespace loos {
 
 
 
+    // -------------------------------------------------
+
+    //! Number of processes to split the frames of a trajectory across (--procs)
+    /**
+     * Only for tools that use a ProcessPool.
+     */
+    class ProcessOptions : public OptionsPackage {
+    public:
+      ProcessOptions() : procs(1) { }
+
+      unsigned int procs;
+
+    private:
+      void addGeneric(po::options_description& opts);
+      bool postConditions(po::variables_map& map);
+      std::string print() const;
+    };
+
+
     // -------------------------------------------------
 
 
@@ -717,9 +779,9 @@ namespace loos {
     // ----------------------------------------------------------------------
     class OutputTrajectoryOptions : public OptionsPackage {
     public:
-      OutputTrajectoryOptions() : name("output.dcd"), label("Output Trajectory"), append(false) {}
-      OutputTrajectoryOptions(const std::string& s) : name(s), label("Output Trajectory"), append(false) {}
-      OutputTrajectoryOptions(const std::string& s, const bool appending) : name(s), label("Output Trajectory"), append(appending) {}
+      OutputTrajectoryOptions() : name("output.dcd"), label("Output Trajectory"), append(false), nc_chunk(0), nc_deflate(0) {}
+      OutputTrajectoryOptions(const std::string& s) : name(s), label("Output Trajectory"), append(false), nc_chunk(0), nc_deflate(0) {}
+      OutputTrajectoryOptions(const std::string& s, const bool appending) : name(s), label("Output Trajectory"), append(appending), nc_chunk(0), nc_deflate(0) {}
 
 
       std::string name;
@@ -729,6 +791,11 @@ namespace loos {
       std::string basename;
       pTrajectoryWriter outraj;
 
+      //! Frames per chunk for NetCDF output (0 for a classic, unchunked file)
+      uint nc_chunk;
+      //! Compression level for NetCDF output
+      int nc_deflate;
+
 
     private:
       void addGeneric(po::options_description& opts);
@@ -752,16 +819,19 @@ namespace loos {
       OutputTrajectoryTypeOptions() :
 	label("Output Trajectory Type"),
 	append(false),
-	type("dcd") {}
+	type("dcd"),
+	nc_chunk(0), nc_deflate(0) {}
 
       OutputTrajectoryTypeOptions(const std::string& s) :
 	label("Output Trajectory Type"),
 	append(false),
-	type(s) {}
+	type(s),
+	nc_chunk(0), nc_deflate(0) {}
 
       OutputTrajectoryTypeOptions(const std::string& s, const bool appending) :
 	label("Output Trajectory Type"),
-	append(appending), type(s) {}
+	append(appending), type(s),
+	nc_chunk(0), nc_deflate(0) {}
 
       pTrajectoryWriter createTrajectory(const std::string& prefix);
 
@@ -769,9 +839,12 @@ namespace loos {
       std::string label;
       bool append;
       std::string type;
+      uint nc_chunk;
+      int nc_deflate;
 
     private:
       void addGeneric(po::options_description& opts);
+      bool postConditions(po::variables_map& map);
       std::string print() const;
     };
 
@@ -0,0 +1,268 @@
+/*
+  This file is part of LOOS.
+
+  LOOS (Lightweight Object-Oriented Structure library)
+  Copyright (c) 2008, Tod D. Romo, Alan Grossfield
+  Department of Biochemistry and Biophysics
+  School of Medicine & Dentistry, University of Rochester
+
+  This package (LOOS) is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation under version 3 of the License.
+
+  This package is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include <PairDistanceHistogram.hpp>
+#include <DistanceKernels.hpp>
+#include <exceptions.hpp>
+
+#include <cmath>
+#include <algorithm>
+#include <boost/thread/thread.hpp>
+
+
+namespace loos {
+
+  namespace {
+
+    // Rows are handed out in blocks, and each block of rows is run
+    // against a tile of columns at a time (3 x 2048 doubles, plus
+    // weights and distances, fits in a typical L2)
+    const uint row_block = 32;
+    const uint col_block = 2048;
+
+    // Below this many pairs, threads are not worth starting
+    const double min_threaded_pairs = 1.0e5;
+
+    // Row blocks are dealt round-robin into a fixed number of chunks,
+    // each with its own partial histogram.  Threads take whole chunks,
+    // so the order of the floating point sums depends only on the
+    // number of atoms and not on the number of threads.
+    const uint max_chunks = 64;
+
+
+    struct Packed {
+      std::vector<double> x, y, z, w;
+    };
+
+    void pack(const AtomicGroup& g, const std::vector<double>& w, Packed& p) {
+      uint n = g.size();
+      p.x.resize(n);
+      p.y.resize(n);
+      p.z.resize(n);
+      for (uint i=0; i<n; ++i) {
+        const GCoord& c = g[i]->coords();
+        p.x[i] = c.x();
+        p.y[i] = c.y();
+        p.z[i] = c.z();
+      }
+      if (w.empty())
+        p.w.assign(n, 1.0);
+      else
+        p.w = w;
+    }
+
+
+    struct Partial {
+      Partial(const uint nbins) : hist(nbins, 0.0), total(0.0), excluded(0) { }
+
+      std::vector<double> hist;
+      double total;
+      ulong excluded;
+    };
+
+
+    struct Range {
+      double min, max, width;
+    };
+
+
+    // Rows [i0, i1) of a against b (or the upper triangle when a and b
+    // are the same group)
+    template<class Periodicity>
+    void rowBlock(const Periodicity& pbc, const Packed& a, const Packed& b, const bool same,
+                  const uint i0, const uint i1, const Range& r, std::vector<double>& d, Partial& out) {
+
+      const uint nb = b.x.size();
+      const uint nbins = out.hist.size();
+
+      for (uint j0 = same ? i0+1 : 0; j0 < nb; j0 += col_block) {
+        const uint j1 = std::min(j0 + col_block, nb);
+
+        for (uint i=i0; i<i1; ++i) {
+          const uint js = same ? std::max(j0, i+1) : j0;
+          if (js >= j1)
+            continue;
+
+          const uint m = j1 - js;
+          const double xi = a.x[i], yi = a.y[i], zi = a.z[i];
+          const double* X = &b.x[js];
+          const double* Y = &b.y[js];
+          const double* Z = &b.z[js];
+
+          // Distances for the whole tile row first (this loop vectorizes)...
+          for (uint k=0; k<m; ++k) {
+            double dx = X[k] - xi;
+            double dy = Y[k] - yi;
+            double dz = Z[k] - zi;
+            pbc.reimage(dx, dy, dz);
+            d[k] = sqrt(dx*dx + dy*dy + dz*dz);
+          }
+
+          // ...then the scatter into the histogram
+          const double wi = a.w[i];
+          const double* W = &b.w[js];
+          for (uint k=0; k<m; ++k) {
+            if (d[k] >= r.max || d[k] <= r.min) {
+              ++out.excluded;
+              continue;
+            }
+            uint bin = static_cast<uint>((d[k] - r.min) / r.width);
+            if (bin >= nbins)
+              bin = nbins - 1;
+            double e2 = wi * W[k];
+            out.hist[bin] += e2;
+            out.total += e2;
+          }
+        }
+      }
+    }
+
+
+    // Every block of rows in one chunk
+    template<class Periodicity>
+    void chunk(const Periodicity& pbc, const Packed& a, const Packed& b, const bool same,
+               const Range& r, const uint c, const uint nchunks, std::vector<double>& d, Partial& out) {
+      const uint na = a.x.size();
+      for (uint i0 = c * row_block; i0 < na; i0 += nchunks * row_block)
+        rowBlock(pbc, a, b, same, i0, std::min(i0 + row_block, na), r, d, out);
+    }
+
+
+    template<class Periodicity>
+    void chunks(const Periodicity& pbc, const Packed& a, const Packed& b, const bool same,
+                const Range& r, const uint worker, const uint nworkers, std::vector<Partial>& partials) {
+      std::vector<double> d(col_block);
+      for (uint c = worker; c < partials.size(); c += nworkers)
+        chunk(pbc, a, b, same, r, c, partials.size(), d, partials[c]);
+    }
+
+
+    template<class Periodicity>
+    void runAll(const Periodicity& pbc, const Packed& a, const Packed& b, const bool same,
+                const Range& r, uint nthreads, std::vector<Partial>& partials) {
+
+      double npairs = same ? 0.5 * a.x.size() * a.x.size() : static_cast<double>(a.x.size()) * b.x.size();
+      uint nchunks = partials.size();
+      if (npairs < min_threaded_pairs)
+        nthreads = 1;
+      nthreads = std::max(1u, std::min(nthreads, nchunks));
+
+      if (nthreads == 1) {
+        chunks(pbc, a, b, same, r, 0, 1, partials);
+        return;
+      }
+
+      std::vector<boost::thread*> threads(nthreads);
+      for (uint t=0; t<nthreads; ++t)
+        threads[t] = new boost::thread([&, t]() { chunks(pbc, a, b, same, r, t, nthreads, partials); });
+      for (uint t=0; t<nthreads; ++t) {
+        threads[t]->join();
+        delete threads[t];
+      }
+    }
+
+  }
+
+
+
+  PairDistanceHistogram::PairDistanceHistogram(const double min, const double max, const uint nbins)
+    : _min(min), _max(max), _nthreads(1), _periodic(false), _hist(nbins, 0.0), _total(0.0), _excluded(0)
+  {
+    if (nbins == 0 || !(max > min))
+      throw(LOOSError("PairDistanceHistogram needs at least one bin and max > min"));
+    _width = (_max - _min) / nbins;
+  }
+
+
+  void PairDistanceHistogram::threads(const uint n) {
+    _nthreads = n ? n : boost::thread::hardware_concurrency();
+    if (_nthreads == 0)
+      _nthreads = 1;
+  }
+
+
+  void PairDistanceHistogram::clear() {
+    std::fill(_hist.begin(), _hist.end(), 0.0);
+    _total = 0.0;
+    _excluded = 0;
+  }
+
+
+  std::vector<double> PairDistanceHistogram::normalized() const {
+    std::vector<double> h(_hist);
+    if (_total != 0.0)
+      for (uint i=0; i<h.size(); ++i)
+        h[i] /= _total;
+    return(h);
+  }
+
+
+  void PairDistanceHistogram::accumulate(const AtomicGroup& g) {
+    run(g, std::vector<double>(), 0, 0);
+  }
+
+
+  void PairDistanceHistogram::accumulate(const AtomicGroup& g, const std::vector<double>& weights) {
+    run(g, weights, 0, 0);
+  }
+
+
+  void PairDistanceHistogram::accumulate(const AtomicGroup& a, const std::vector<double>& wa,
+                                         const AtomicGroup& b, const std::vector<double>& wb) {
+    run(a, wa, &b, &wb);
+  }
+
+
+  void PairDistanceHistogram::run(const AtomicGroup& a, const std::vector<double>& wa,
+                                  const AtomicGroup* b, const std::vector<double>* wb) {
+    if (!wa.empty() && wa.size() != a.size())
+      throw(LOOSError("PairDistanceHistogram weights do not match the number of atoms"));
+    if (b && !wb->empty() && wb->size() != b->size())
+      throw(LOOSError("PairDistanceHistogram weights do not match the number of atoms"));
+
+    Packed pa, pb;
+    pack(a, wa, pa);
+    if (b)
+      pack(*b, *wb, pb);
+    const Packed& other = b ? pb : pa;
+
+    Range r;
+    r.min = _min;
+    r.max = _max;
+    r.width = _width;
+
+    uint nblocks = (pa.x.size() + row_block - 1) / row_block;
+    std::vector<Partial> partials(std::max(1u, std::min(nblocks, max_chunks)), Partial(_hist.size()));
+    if (_periodic)
+      runAll(DistanceKernels::Orthorhombic<double>(a.periodicBox()), pa, other, !b, r, _nthreads, partials);
+    else
+      runAll(DistanceKernels::NoPeriodicity<double>(), pa, other, !b, r, _nthreads, partials);
+
+    for (uint t=0; t<partials.size(); ++t) {
+      for (uint i=0; i<_hist.size(); ++i)
+        _hist[i] += partials[t].hist[i];
+      _total += partials[t].total;
+      _excluded += partials[t].excluded;
+    }
+  }
+
+}
@@ -0,0 +1,122 @@
+/*
+  This file is part of LOOS.
+
+  LOOS (Lightweight Object-Oriented Structure library)
+  Copyright (c) 2008, Tod D. Romo, Alan Grossfield
+  Department of Biochemistry and Biophysics
+  School of Medicine & Dentistry, University of Rochester
+
+  This package (LOOS) is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation under version 3 of the License.
+
+  This package is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#if !defined(LOOS_PAIR_DISTANCE_HISTOGRAM_HPP)
+#define LOOS_PAIR_DISTANCE_HISTOGRAM_HPP
+
+#include <vector>
+
+#include <loos_defs.hpp>
+#include <AtomicGroup.hpp>
+
+
+namespace loos {
+
+
+  //! Weighted histogram of all pairwise distances
+  /**
+   * Histograms the distance between every pair of atoms in a group
+   * (or every pair between two groups), weighting each pair by the
+   * product of per-atom weights, e.g. the number of electrons for a
+   * scattering-like pair distribution.  There is no cutoff, so the
+   * work grows as N^2.  The coordinates are copied into separate x, y,
+   * and z arrays and the pairs are worked through in tiles, so the
+   * distance loop vectorizes and a tile of atoms stays in cache while
+   * a block of rows is done.  Blocks of rows are dealt into a fixed
+   * number of chunks, each with its own histogram, that threads work
+   * through whole.  The chunk histograms are summed in chunk order, so
+   * the result is the same for any number of threads (and does not
+   * depend on scheduling), although it can differ in the last bits
+   * from a plain serial loop over the pairs.
+   *
+   * Distances at or beyond either end of the range are not
+   * histogrammed but are counted (see excluded()).  Repeated calls to
+   * accumulate() add to the histogram, so it can cover a whole
+   * trajectory or be cleared for each frame:
+   * \code
+   * PairDistanceHistogram pdh(0.0, 50.0, 100);
+   * pdh.threads(8);
+   * while (traj->readFrame()) {
+   *   traj->updateGroupCoords(subset);
+   *   pdh.accumulate(subset, electrons);
+   * }
+   * \endcode
+   */
+  class PairDistanceHistogram {
+  public:
+    PairDistanceHistogram(const double min, const double max, const uint nbins);
+
+    //! Number of threads to use (0 means all available)
+    void threads(const uint n);
+    uint threads() const { return(_nthreads); }
+
+    //! Use the minimum image (with the box of the group(s) passed to accumulate())
+    void periodic(const bool b) { _periodic = b; }
+    bool periodic() const { return(_periodic); }
+
+    //! All unique pairs within \a g, each with weight 1
+    void accumulate(const AtomicGroup& g);
+
+    //! All unique pairs within \a g, weighted by weights[i] * weights[j]
+    void accumulate(const AtomicGroup& g, const std::vector<double>& weights);
+
+    //! All pairs between \a a and \a b
+    void accumulate(const AtomicGroup& a, const std::vector<double>& wa,
+                    const AtomicGroup& b, const std::vector<double>& wb);
+
+    //! Zero the histogram and counts
+    void clear();
+
+    //! Sum of pair weights in each bin
+    const std::vector<double>& histogram() const { return(_hist); }
+
+    //! Histogram divided by the total weight (all zeros if nothing was histogrammed)
+    std::vector<double> normalized() const;
+
+    //! Total weight of the histogrammed pairs
+    double totalWeight() const { return(_total); }
+
+    //! Number of pairs outside the histogram range
+    ulong excluded() const { return(_excluded); }
+
+    uint bins() const { return(_hist.size()); }
+    double binWidth() const { return(_width); }
+    double binCenter(const uint i) const { return(_min + (i + 0.5) * _width); }
+
+  private:
+    void run(const AtomicGroup& a, const std::vector<double>& wa,
+             const AtomicGroup* b, const std::vector<double>* wb);
+
+    double _min, _max, _width;
+    uint _nthreads;
+    bool _periodic;
+
+    std::vector<double> _hist;
+    double _total;
+    ulong _excluded;
+  };
+
+
+}
+
+
+#endif
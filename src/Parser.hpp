@@ -84,6 +84,11 @@ namespace loos {
    *  Parser objects are intended to be a parse-once object.  If you
    *  want to parse multiple selection strings, then you should
    *  instantiate a Parser object for each selection string.
+   *
+   *  Each Parser has its own lexer and parser state, so separate
+   *  Parser objects may be used concurrently from different threads.
+   *  A single Parser (and its Kernel) should not be shared between
+   *  threads without locking.
    */
 
   class Parser {
@@ -0,0 +1,153 @@
+/*
+  This file is part of LOOS.
+
+  LOOS (Lightweight Object-Oriented Structure library)
+  Copyright (c) 2008, Tod D. Romo, Alan Grossfield
+  Department of Biochemistry and Biophysics
+  School of Medicine & Dentistry, University of Rochester
+
+  This package (LOOS) is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation under version 3 of the License.
+
+  This package is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <sstream>
+
+#include <sys/types.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <ProcessPool.hpp>
+#include <exceptions.hpp>
+
+
+namespace loos {
+
+  namespace internal {
+
+    void* allocateShared(const std::size_t bytes) {
+      if (bytes == 0)
+        return(0);
+
+      void* p = mmap(0, bytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+      if (p == MAP_FAILED)
+        throw(LOOSError(std::string("Cannot allocate shared memory: ") + strerror(errno)));
+
+      return(p);
+    }
+
+
+    void freeShared(void* p, const std::size_t bytes) {
+      if (p)
+        munmap(p, bytes);
+    }
+
+  }
+
+
+
+  std::vector< std::vector<uint> > ProcessPool::partition(const std::vector<uint>& frames, const uint n) {
+    std::vector< std::vector<uint> > parts(n ? n : 1);
+
+    uint m = parts.size();
+    uint chunk = frames.size() / m;
+    uint extra = frames.size() % m;
+    std::vector<uint>::const_iterator i = frames.begin();
+    for (uint k=0; k<m; ++k) {
+      uint len = chunk + (k < extra);
+      parts[k].assign(i, i + len);
+      i += len;
+    }
+
+    return(parts);
+  }
+
+
+  void ProcessPool::run(const std::vector<uint>& frames, const Worker& worker) const {
+    if (_nprocs == 1) {
+      worker(frames, 0);
+      return;
+    }
+
+    std::vector< std::vector<uint> > parts = partition(frames, _nprocs);
+
+    // Anything still buffered would otherwise be written once by
+    // every worker...
+    std::cout.flush();
+    std::cerr.flush();
+    fflush(0);
+
+    std::vector<pid_t> pids;
+    std::string fork_error;
+    for (uint k=0; k<parts.size(); ++k) {
+      if (parts[k].empty())
+        continue;
+
+      pid_t pid = fork();
+      if (pid < 0) {
+        fork_error = strerror(errno);
+        break;
+      }
+
+      if (pid == 0) {
+        int status = 0;
+        try {
+          worker(parts[k], k);
+        }
+        catch (std::exception& e) {
+          std::cerr << "Error- worker " << k << ": " << e.what() << std::endl;
+          status = 1;
+        }
+        catch (...) {
+          std::cerr << "Error- worker " << k << " failed\n";
+          status = 1;
+        }
+        std::cout.flush();
+        std::cerr.flush();
+        fflush(0);
+
+        // Skip exit handlers and destructors, since they belong to
+        // the parent
+        _exit(status);
+      }
+
+      pids.push_back(pid);
+    }
+
+    uint failed = 0;
+    for (std::vector<pid_t>::const_iterator i = pids.begin(); i != pids.end(); ++i) {
+      int status;
+      while (waitpid(*i, &status, 0) < 0)
+        if (errno != EINTR) {
+          status = -1;
+          break;
+        }
+      if (!(WIFEXITED(status) && WEXITSTATUS(status) == 0))
+        ++failed;
+    }
+
+    if (!fork_error.empty())
+      throw(LOOSError("Cannot start worker process: " + fork_error));
+
+    if (failed) {
+      std::ostringstream oss;
+      oss << failed << " of " << pids.size() << " worker processes failed";
+      throw(LOOSError(oss.str()));
+    }
+  }
+
+}
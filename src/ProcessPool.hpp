@@ -0,0 +1,156 @@
+/*
+  This file is part of LOOS.
+
+  LOOS (Lightweight Object-Oriented Structure library)
+  Copyright (c) 2008, Tod D. Romo, Alan Grossfield
+  Department of Biochemistry and Biophysics
+  School of Medicine & Dentistry, University of Rochester
+
+  This package (LOOS) is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation under version 3 of the License.
+
+  This package is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#if !defined(LOOS_PROCESS_POOL_HPP)
+#define LOOS_PROCESS_POOL_HPP
+
+#include <cstddef>
+#include <vector>
+
+#include <boost/function.hpp>
+
+#include <loos_defs.hpp>
+
+
+namespace loos {
+
+  namespace internal {
+    // Anonymous shared mappings that survive fork()
+    void* allocateShared(const std::size_t bytes);
+    void freeShared(void* p, const std::size_t bytes);
+  }
+
+
+  //! Per-worker accumulators in shared memory, combined after the workers finish
+  /**
+   * Each worker in a ProcessPool gets its own slot of \a n elements
+   * to accumulate into (e.g. a histogram, grid, or matrix stored as a
+   * flat array), so workers never contend for memory.  The slots live
+   * in memory shared between processes, so once
+   * ProcessPool::run() returns, the parent can combine them with
+   * sum() (or by walking the slots itself).
+   *
+   * The SharedReduction must be created before ProcessPool::run() is
+   * called.  \a T must be a plain type (e.g. double, ulong) since the
+   * memory is shared between processes.
+   */
+  template<typename T>
+  class SharedReduction {
+  public:
+    SharedReduction(const uint nworkers, const std::size_t n, const T& value = T())
+      : _nworkers(nworkers), _n(n),
+        _data(static_cast<T*>(internal::allocateShared(nworkers * n * sizeof(T))))
+    {
+      for (std::size_t i=0; i<_nworkers * _n; ++i)
+        _data[i] = value;
+    }
+
+    ~SharedReduction() { internal::freeShared(_data, _nworkers * _n * sizeof(T)); }
+
+    //! Accumulator for worker \a k
+    T* slot(const uint k) { return(_data + k * _n); }
+    const T* slot(const uint k) const { return(_data + k * _n); }
+
+    //! Element-wise sum over all workers' slots
+    std::vector<T> sum() const {
+      std::vector<T> result(slot(0), slot(0) + _n);
+      for (uint k=1; k<_nworkers; ++k) {
+        const T* p = slot(k);
+        for (std::size_t i=0; i<_n; ++i)
+          result[i] += p[i];
+      }
+      return(result);
+    }
+
+    uint workers() const { return(_nworkers); }
+    std::size_t size() const { return(_n); }
+
+  private:
+    SharedReduction(const SharedReduction&);
+    SharedReduction& operator=(const SharedReduction&);
+
+    uint _nworkers;
+    std::size_t _n;
+    T* _data;
+  };
+
+
+
+  //! Splits a list of trajectory frames across forked worker processes
+  /**
+   * This lets a tool that processes one frame at a time use several
+   * cores without having to be made thread-safe.  run() forks the
+   * workers, hands each a contiguous, disjoint piece of the frame
+   * list, and waits for them all to finish.  Workers inherit
+   * everything loaded before run() (the model, selections, etc.)
+   * copy-on-write, and return their results through a
+   * SharedReduction.  For example,
+   * \code
+   * ProcessPool pool(nprocs);
+   * SharedReduction<double> hist(pool.size(), nbins);
+   * pool.run(frames, [&](const std::vector<uint>& mine, const uint k) {
+   *     pTraj traj = trajopts->openTrajectory();
+   *     double* h = hist.slot(k);
+   *     for (uint i=0; i<mine.size(); ++i) {
+   *       traj->readFrame(mine[i]);
+   *       ...
+   *     }
+   *   });
+   * std::vector<double> total = hist.sum();
+   * \endcode
+   *
+   * Open files are shared with the parent after a fork (including
+   * the read position), so each worker must open its own trajectory
+   * (see opts::TrajectoryWithFrameIndices::openTrajectory()).
+   * Anything a worker writes to stdout is interleaved with the other
+   * workers, and changes a worker makes to memory other than a
+   * SharedReduction are lost when it exits.
+   *
+   * With one process, the work is done in the calling process
+   * without forking.  If a worker throws or dies, run() throws a
+   * LOOSError once all workers have finished.
+   */
+  class ProcessPool {
+  public:
+    //! Function run by each worker with its frames and worker number
+    typedef boost::function<void (const std::vector<uint>&, const uint)>    Worker;
+
+    explicit ProcessPool(const uint nprocs) : _nprocs(nprocs ? nprocs : 1) { }
+
+    //! Number of workers (and slots needed in a SharedReduction)
+    uint size() const { return(_nprocs); }
+
+    //! Splits \a frames into \a n contiguous pieces whose sizes differ by at most one
+    static std::vector< std::vector<uint> > partition(const std::vector<uint>& frames, const uint n);
+
+    //! Runs \a worker over \a frames, split across the pool
+    void run(const std::vector<uint>& frames, const Worker& worker) const;
+
+  private:
+    uint _nprocs;
+  };
+
+
+}
+
+
+#endif
@@ -36,6 +36,175 @@
 
 namespace loos {
 
+  //! Streaming Flyvbjerg-Petersen blocking of a time series
+  /**
+   * Estimates the standard error of the mean of correlated data
+   * without storing the data.  Each sample is added at level 0, and
+   * every pair of consecutive samples at level k is averaged to make
+   * one sample at level k+1, so level k holds the averages of blocks
+   * of 2^k samples.  Only the running mean and variance of each level
+   * (and at most one unpaired sample) are kept, so the state is
+   * O(log n) for n samples.  The standard error can be read off for
+   * every block size at any time, and should plateau as the block
+   * size grows past the correlation time.  See
+   * Flyvbjerg, H. & Petersen, H. G. J. Chem. Phys., 1989, 91, 461-466.
+   *
+   * Accumulators can be merged, e.g. when each thread (or trajectory
+   * segment) has its own.  The per-level statistics are combined
+   * exactly, and unpaired samples left over from each part are paired
+   * with each other, so blocks never straddle two parts except for at
+   * most one block per level.
+   *
+   * Unlike TimeSeries::block_var(), which divides the data into a
+   * given number of blocks, the block sizes here are powers of two.
+   */
+template<class T>
+class BlockingAccumulator {
+public:
+  BlockingAccumulator() : _n(0) { }
+
+  //! Adds the next sample
+  void push(const T x) {
+    ++_n;
+    add(0, x);
+  }
+
+  //! Adds the samples in \a other, treated as following this accumulator's
+  void merge(const BlockingAccumulator<T>& other) {
+    if (other._levels.size() > _levels.size())
+      _levels.resize(other._levels.size());
+
+    for (uint k=0; k<other._levels.size(); ++k) {
+      Level& a = _levels[k];
+      const Level& b = other._levels[k];
+      if (b.n == 0)
+        continue;
+      ulong n = a.n + b.n;
+      T delta = b.mean - a.mean;
+      a.m2 += b.m2 + delta * delta * static_cast<T>(a.n) * static_cast<T>(b.n) / n;
+      a.mean += delta * static_cast<T>(b.n) / n;
+      a.n = n;
+    }
+
+    for (uint k=0; k<other._levels.size(); ++k) {
+      if (!other._levels[k].has_pending)
+        continue;
+      if (_levels[k].has_pending) {
+        _levels[k].has_pending = false;
+        add(k+1, (_levels[k].pending + other._levels[k].pending) / 2);
+      } else {
+        _levels[k].pending = other._levels[k].pending;
+        _levels[k].has_pending = true;
+      }
+    }
+
+    _n += other._n;
+  }
+
+  //! Total number of samples
+  ulong size() const { return(_n); }
+
+  //! Number of levels (block sizes) with at least one block
+  uint levels() const { return(_levels.size()); }
+
+  //! Number of samples in each block at \a level
+  ulong blockSize(const uint level) const { return(1ul << level); }
+
+  //! Number of complete blocks at \a level
+  ulong blocks(const uint level) const {
+    return(level < _levels.size() ? _levels[level].n : 0);
+  }
+
+  //! Mean of all samples
+  T mean() const { return(_levels.empty() ? 0 : _levels[0].mean); }
+
+  //! Variance (with N-1) of the block averages at \a level
+  T variance(const uint level = 0) const {
+    ulong n = blocks(level);
+    return(n > 1 ? _levels[level].m2 / (n - 1) : 0);
+  }
+
+  //! Estimated standard error of the mean using blocks at \a level
+  T stdErr(const uint level) const {
+    ulong n = blocks(level);
+    return(n > 1 ? sqrt(variance(level) / n) : 0);
+  }
+
+  //! Uncertainty in stdErr() at \a level (Flyvbjerg & Petersen eq 28)
+  T stdErrError(const uint level) const {
+    ulong n = blocks(level);
+    return(n > 1 ? stdErr(level) / sqrt(2.0 * (n - 1)) : 0);
+  }
+
+  //! Standard errors for each level with at least two blocks
+  std::vector<T> stdErrs() const {
+    std::vector<T> errs;
+    for (uint k=0; k<_levels.size() && _levels[k].n > 1; ++k)
+      errs.push_back(stdErr(k));
+    return(errs);
+  }
+
+  //! Smallest level past the correlation time, or -1 if there isn't one yet
+  /**
+   * Uses the criterion of Lee, Needs & Towler, Phys. Rev. B, 2011,
+   * 83, 184506: the smallest block size B with
+   * B^3 > 2n(stdErr(B) / stdErr(1))^4.
+   */
+  int optimalLevel() const {
+    T se0 = stdErr(0);
+    if (se0 <= 0)
+      return(-1);
+
+    for (uint k=0; k<_levels.size() && _levels[k].n > 1; ++k) {
+      T ratio = stdErr(k) / se0;
+      T b = blockSize(k);
+      if (b * b * b > 2.0 * _levels[0].n * ratio * ratio * ratio * ratio)
+        return(k);
+    }
+    return(-1);
+  }
+
+private:
+  struct Level {
+    Level() : n(0), mean(0), m2(0), pending(0), has_pending(false) { }
+    ulong n;
+    T mean, m2;
+    T pending;
+    bool has_pending;
+  };
+
+
+  // Adds x to level k and carries averages of pairs up the levels
+  void add(uint k, T x) {
+    while (true) {
+      if (k == _levels.size())
+        _levels.push_back(Level());
+      Level& lev = _levels[k];
+
+      ++lev.n;
+      T delta = x - lev.mean;
+      lev.mean += delta / lev.n;
+      lev.m2 += delta * (x - lev.mean);
+
+      if (!lev.has_pending) {
+        lev.pending = x;
+        lev.has_pending = true;
+        return;
+      }
+
+      lev.has_pending = false;
+      x = (lev.pending + x) / 2;
+      ++k;
+    }
+  }
+
+
+  ulong _n;
+  std::vector<Level> _levels;
+};
+
+
+
   //! Time Series Class
   /*!
    *  This class provides basic operations on a time series, such
@@ -473,6 +642,7 @@ public:
     //! for each block, and returns the variance of the averages.
     //! This is useful for doing Flyvjberg and Petersen-style block averaging.
     //! Flyvbjerg, H. & Petersen, H. G. J. Chem. Phys., 1989, 91, 461-466
+    //! (see also BlockingAccumulator, which does not need the whole series)
     //
     T block_var(const int num_blocks) const {
       int points_per_block = size() / num_blocks;
@@ -547,6 +717,14 @@ public:
       return(c);
     }
 
+  //! Returns the blocking statistics for this time series
+  BlockingAccumulator<T> blocking() const {
+    BlockingAccumulator<T> acc;
+    for (const_iterator i = _data.begin(); i != _data.end(); ++i)
+      acc.push(*i);
+    return(acc);
+  }
+
   // Vector interface...
   void push_back(const T& x) { _data.push_back(x); }
 
@@ -48,6 +48,7 @@ namespace loos {
   %rename(__div__) loos::TimeSeries<double>::operator/;
 
 
+  %template(BlockingAccumulatorDbl) loos::BlockingAccumulator<double>;
   %template(TimeSeriesDbl) loos::TimeSeries<double>;
   
 
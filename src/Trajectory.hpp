@@ -32,6 +32,7 @@
 
 #include <loos_defs.hpp>
 #include <AtomicGroup.hpp>
+#include <FloatFrame.hpp>
 
 #include <AtomicGroup.hpp>
 
@@ -174,6 +175,20 @@ namespace loos {
 
 
 
+		//! Update the coordinates in a FloatFrame with the current frame
+		/**
+		 * The frame's atoms are given by the trajectory indices it
+		 * was constructed with (see FloatFrame).  Formats that store
+		 * single-precision coordinates copy them directly, without
+		 * going through an AtomicGroup or GCoords.  The periodic box
+		 * is also copied, if present.
+		 */
+		void updateFrameCoords(FloatFrame& f)
+		{
+			updateFrameCoordsImpl(f);
+		}
+
+
 		//! Returns the current frame's velocities as a vector of GCoords
 		/**
 		 * If the trajectory format supports velocities "natively", then those will
@@ -316,6 +331,13 @@ namespace loos {
 		//! NVI implementation of updateGroupCoords() for derived classes to override
 		virtual void updateGroupCoordsImpl(AtomicGroup& g) =0;
 
+		//! NVI implementation of updateFrameCoords().  The default goes through coords()
+		virtual void updateFrameCoordsImpl(FloatFrame& f) {
+			f.copyFromFrame(coords());
+			if (hasPeriodicBox())
+				f.periodicBox(periodicBox());
+		}
+
 		virtual void updateGroupVelocitiesImpl(AtomicGroup& g) {
 			throw(LOOSError("No velocity update implementation defined but trajectory supports it"));
 		}
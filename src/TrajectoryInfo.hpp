@@ -0,0 +1,102 @@
+/*
+  This file is part of LOOS.
+
+  LOOS (Lightweight Object-Oriented Structure library)
+  Copyright (c) 2008, Tod D. Romo, Alan Grossfield
+  Department of Biochemistry and Biophysics
+  School of Medicine & Dentistry, University of Rochester
+
+  This package (LOOS) is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation under version 3 of the License.
+
+  This package is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#if !defined(LOOS_TRAJECTORY_INFO_HPP)
+#define LOOS_TRAJECTORY_INFO_HPP
+
+#include <iostream>
+#include <string>
+
+#include <loos_defs.hpp>
+
+
+namespace loos {
+
+
+  //! Metadata describing a trajectory file, without any coordinates
+  /**
+   * A TrajectoryInfo is returned by probeTrajectory() (and the
+   * per-format probe() functions).  Probing a trajectory only reads
+   * the headers (and, for formats without a frame count in the
+   * header, the per-frame headers) so no coordinates are decoded.
+   *
+   * The layout fields describe where frames live in the file.  If
+   * fixed_frame_size is true, then frame i begins at
+   * first_frame_offset + i * frame_size bytes.  Formats with variable
+   * sized frames (e.g. XTC) report a frame_size of 0.
+   */
+  struct TrajectoryInfo {
+    TrajectoryInfo() : filename(""), format(""), natoms(0), nframes(0), timestep(0.0),
+                       periodic(false), velocities(false), precision(0),
+                       compression_precision(0.0), native_endian(true),
+                       fixed_frame_size(false), first_frame_offset(0), frame_size(0) { }
+
+    std::string filename;
+    std::string format;             ///< Same as Trajectory::description()
+
+    uint natoms;
+    uint nframes;
+    float timestep;
+
+    bool periodic;                  ///< Frames have periodic box info
+    bool velocities;                ///< Frames carry velocities
+
+    uint precision;                 ///< Bytes per stored coordinate value (0 for ASCII)
+    double compression_precision;   ///< XTC compression precision (0 if not applicable)
+    bool native_endian;
+
+    bool fixed_frame_size;
+    unsigned long first_frame_offset;
+    unsigned long frame_size;
+
+#if !defined(SWIG)
+    friend std::ostream& operator<<(std::ostream& os, const TrajectoryInfo& t) {
+      os << "<TRAJECTORYINFO FILENAME='" << t.filename << "' FORMAT='" << t.format
+         << "' NATOMS=" << t.natoms << " NFRAMES=" << t.nframes
+         << " TIMESTEP=" << t.timestep << " PERIODIC=" << t.periodic
+         << " VELOCITIES=" << t.velocities << " PRECISION=" << t.precision;
+      if (t.compression_precision != 0.0)
+        os << " COMPRESSION=" << t.compression_precision;
+      os << " NATIVE=" << t.native_endian;
+      if (t.fixed_frame_size)
+        os << " OFFSET=" << t.first_frame_offset << " FRAMESIZE=" << t.frame_size;
+      os << "/>";
+      return(os);
+    }
+#endif
+
+  };
+
+
+  class Trajectory;
+
+  //! Fill in a TrajectoryInfo from an already opened Trajectory
+  /**
+   * This is the fallback used for formats that have no cheaper way
+   * of getting at their metadata.  The layout fields are left empty.
+   */
+  TrajectoryInfo trajectoryInfoFrom(const Trajectory& traj);
+
+}
+
+
+#endif
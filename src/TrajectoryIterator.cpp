@@ -0,0 +1,383 @@
+/*
+  This file is part of LOOS.
+
+  LOOS (Lightweight Object-Oriented Structure library)
+  Copyright (c) 2008, Tod D. Romo, Alan Grossfield
+  Department of Biochemistry and Biophysics
+  School of Medicine & Dentistry, University of Rochester
+
+  This package (LOOS) is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation under version 3 of the License.
+
+  This package is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include <boost/thread/thread.hpp>
+
+#include <TrajectoryIterator.hpp>
+#include <alignment.hpp>
+#include <exceptions.hpp>
+#include <sfactories.hpp>
+
+
+namespace loos {
+
+
+  // A frame read ahead of time by a background thread, through the
+  // source's private reader and into a copy of its model.  Only the
+  // worker touches these until the thread is joined.
+  struct TrajectoryIterator::Prefetched {
+    Prefetched(const uint i, const pTraj& t, const AtomicGroup& model, const uint frameno)
+      : index(i), traj(t), group(model.copy()), frame(frameno), ok(false) { }
+
+    void operator()() {
+      try {
+        if (!traj->readFrame(frame))
+          return;
+        traj->updateGroupCoords(group);
+        if (traj->hasVelocities())
+          traj->updateGroupVelocities(group);
+        ok = true;
+      }
+      catch (...) {
+        ok = false;
+      }
+    }
+
+    uint index;
+    pTraj traj;
+    AtomicGroup group;
+    uint frame;
+    bool ok;
+    boost::thread thread;
+  };
+
+
+
+  TrajectoryIterator::TrajectoryIterator()
+    : _skip(0), _stride(1), _use_indices(false), _stale(true), _next(0), _current_source(-1),
+      _aligned(false), _align_rmsd(-1.0), _align_iters(-1), _prefetch(false)
+  { }
+
+
+  TrajectoryIterator::TrajectoryIterator(const pTraj& traj, const AtomicGroup& model, const AtomicGroup& subset,
+                                         const uint skip, const uint stride)
+    : _skip(0), _stride(1), _use_indices(false), _stale(true), _next(0), _current_source(-1),
+      _aligned(false), _align_rmsd(-1.0), _align_iters(-1), _prefetch(false)
+  {
+    append(traj, model, subset, skip, stride);
+  }
+
+
+  TrajectoryIterator::TrajectoryIterator(const pTraj& traj, const AtomicGroup& model, const AtomicGroup& subset,
+                                         const std::vector<uint>& frames)
+    : _skip(0), _stride(1), _use_indices(false), _stale(true), _next(0), _current_source(-1),
+      _aligned(false), _align_rmsd(-1.0), _align_iters(-1), _prefetch(false)
+  {
+    append(traj, model, subset, frames);
+  }
+
+
+  TrajectoryIterator::~TrajectoryIterator() {
+    if (_pending)
+      _pending->thread.join();
+  }
+
+
+  void TrajectoryIterator::append(const pTraj& traj, const AtomicGroup& model, const AtomicGroup& subset,
+                                  const std::vector<uint>& frames) {
+    for (std::vector<uint>::const_iterator i = frames.begin(); i != frames.end(); ++i)
+      if (*i >= traj->nframes())
+        throw(LOOSError("Frame index is out of range for trajectory " + traj->filename()));
+
+    Source s;
+    s.traj = traj;
+    s.model = model;
+    s.subset = subset;
+    s.frames = frames;
+    if (alignmentWanted())
+      s.align_subset = selectAtoms(model, _align_selection);
+
+    _sources.push_back(s);
+    invalidate();
+  }
+
+
+  void TrajectoryIterator::append(const pTraj& traj, const AtomicGroup& model, const AtomicGroup& subset,
+                                  const uint skip, const uint stride) {
+    if (stride == 0)
+      throw(LOOSError("Trajectory stride must be at least 1"));
+
+    std::vector<uint> frames;
+    for (uint i=skip; i<traj->nframes(); i += stride)
+      frames.push_back(i);
+
+    append(traj, model, subset, frames);
+  }
+
+
+  void TrajectoryIterator::setSubset(const uint i, const AtomicGroup& subset) {
+    if (i >= _sources.size())
+      throw(LOOSError("Source index is out of range in TrajectoryIterator"));
+    _sources[i].subset = subset;
+  }
+
+
+  void TrajectoryIterator::setFrames(const uint skip, const uint stride) {
+    if (stride == 0)
+      throw(LOOSError("Trajectory stride must be at least 1"));
+
+    _skip = skip;
+    _stride = stride;
+    _use_indices = false;
+    invalidate();
+  }
+
+
+  void TrajectoryIterator::setFrameList(const std::vector<uint>& indices) {
+    _indices = indices;
+    _use_indices = true;
+    invalidate();
+  }
+
+
+  // Anything that changes which frames are used (or how they're
+  // aligned) ends up here...
+  void TrajectoryIterator::invalidate() {
+    if (_pending) {
+      _pending->thread.join();
+      _pending.reset();
+    }
+
+    _stale = true;
+    _aligned = false;
+    _xforms.clear();
+    _align_rmsd = -1.0;
+    _align_iters = -1;
+    _next = 0;
+  }
+
+
+  void TrajectoryIterator::rebuild() const {
+    std::vector<Location> all;
+    for (uint j=0; j<_sources.size(); ++j)
+      for (uint i=0; i<_sources[j].frames.size(); ++i)
+        all.push_back(Location(j, i));
+
+    _locations.clear();
+    if (_use_indices) {
+      for (std::vector<uint>::const_iterator i = _indices.begin(); i != _indices.end(); ++i) {
+        if (*i >= all.size())
+          throw(LOOSError("Frame index is out of range for the composite trajectory"));
+        _locations.push_back(all[*i]);
+      }
+    } else
+      for (uint i=_skip; i<all.size(); i += _stride)
+        _locations.push_back(all[i]);
+
+    _stale = false;
+  }
+
+
+  uint TrajectoryIterator::size() const {
+    if (_stale)
+      rebuild();
+    return(_locations.size());
+  }
+
+
+  TrajectoryIterator::Location TrajectoryIterator::location(const uint i) const {
+    if (i >= size())
+      throw(std::out_of_range("Frame index is out of range"));
+    return(_locations[i]);
+  }
+
+
+  uint TrajectoryIterator::frameNumber(const uint i) const {
+    Location loc = location(i);
+    return(_sources[loc.first].frames[loc.second]);
+  }
+
+
+
+  // Reads the ith frame into its source's model (no alignment)
+  void TrajectoryIterator::readInto(const uint i) {
+    Location loc = location(i);
+    Source& s = _sources[loc.first];
+
+    if (!finishPrefetch(i)) {
+      if (!s.traj->readFrame(s.frames[loc.second]))
+        throw(FileReadError(s.traj->filename(), "Unable to read trajectory frame"));
+      s.traj->updateGroupCoords(s.model);
+      if (s.traj->hasVelocities())
+        s.traj->updateGroupVelocities(s.model);
+    }
+
+    _current_source = loc.first;
+  }
+
+
+  // The source's trajectory may be used elsewhere, so the background
+  // thread reads through its own copy, opened the first time it's
+  // needed.  If that can't be done, the frame is read when it's asked
+  // for instead.
+  void TrajectoryIterator::startPrefetch(const uint i) {
+    Location loc = location(i);
+    Source& s = _sources[loc.first];
+
+    if (!s.reader && !s.no_reader) {
+      try {
+        s.reader = createTrajectory(s.traj->filename(), s.model);
+      }
+      catch (...) {
+        s.no_reader = true;
+      }
+    }
+    if (!s.reader)
+      return;
+
+    _pending = boost::shared_ptr<Prefetched>(new Prefetched(i, s.reader, s.model, s.frames[loc.second]));
+    _pending->thread = boost::thread(boost::ref(*_pending));
+  }
+
+
+  // Copies a prefetched frame into the model if it's the one
+  // requested.  Returns false if the frame still needs to be read.
+  bool TrajectoryIterator::finishPrefetch(const uint i) {
+    if (!_pending)
+      return(false);
+
+    boost::shared_ptr<Prefetched> p = _pending;
+    _pending.reset();
+    p->thread.join();
+
+    if (p->index != i || !p->ok)
+      return(false);
+
+    // The copy has the same atoms in the same order as the model
+    AtomicGroup& model = _sources[location(i).first].model;
+    bool velocities = p->traj->hasVelocities();
+    for (uint j=0; j<model.size(); ++j) {
+      model[j]->coords(p->group[j]->coords());
+      if (velocities)
+        model[j]->velocities(p->group[j]->velocities());
+    }
+    if (p->group.isPeriodic())
+      model.periodicBox(p->group.periodicBox());
+
+    return(true);
+  }
+
+
+
+  AtomicGroup TrajectoryIterator::readFrame(const uint i) {
+    if (alignmentWanted() && !_aligned)
+      align();
+
+    readInto(i);
+
+    if (_prefetch && i+1 < size())
+      startPrefetch(i+1);
+
+    Source& s = _sources[_current_source];
+    if (_aligned)
+      s.subset.applyTransform(_xforms[i]);
+
+    return(s.subset);
+  }
+
+
+  bool TrajectoryIterator::next() {
+    if (_next >= size())
+      return(false);
+
+    readFrame(_next++);
+    return(true);
+  }
+
+
+  AtomicGroup TrajectoryIterator::frame() const {
+    if (_current_source < 0)
+      return(AtomicGroup());
+    return(_sources[_current_source].subset);
+  }
+
+
+
+  void TrajectoryIterator::alignWith(const std::string& selection) {
+    _align_selection = selection;
+    if (alignmentWanted())
+      for (std::vector<Source>::iterator i = _sources.begin(); i != _sources.end(); ++i)
+        i->align_subset = selectAtoms(i->model, selection);
+
+    _aligned = false;
+    _xforms.clear();
+  }
+
+
+  void TrajectoryIterator::setReference(const AtomicGroup& reference) {
+    _reference = reference.copy();
+    _aligned = false;
+    _xforms.clear();
+  }
+
+
+  void TrajectoryIterator::align(const greal threshold, const int maxiter) {
+    if (!alignmentWanted())
+      throw(LOOSError("No alignment selection has been set for TrajectoryIterator"));
+
+    if (_pending) {
+      _pending->thread.join();
+      _pending.reset();
+    }
+
+    uint n = size();
+    _xforms.clear();
+
+    if (!_reference.empty()) {
+      for (uint i=0; i<n; ++i) {
+        readInto(i);
+        GMatrix M = _sources[_current_source].align_subset.superposition(_reference);
+        XForm W;
+        W.load(M);
+        _xforms.push_back(W);
+      }
+      _align_rmsd = 0.0;
+      _align_iters = 0;
+
+    } else {
+      alignment::vecMatrix ensemble;
+      ensemble.reserve(n);
+      for (uint i=0; i<n; ++i) {
+        readInto(i);
+        ensemble.push_back(_sources[_current_source].align_subset.coordsAsVector());
+      }
+
+      boost::tuple<std::vector<XForm>, greal, int> res = iterativeAlignment(ensemble, threshold, maxiter);
+      _xforms = boost::get<0>(res);
+      _align_rmsd = boost::get<1>(res);
+      _align_iters = boost::get<2>(res);
+    }
+
+    _aligned = true;
+  }
+
+
+
+  void TrajectoryIterator::prefetch(const bool b) {
+    if (!b && _pending) {
+      _pending->thread.join();
+      _pending.reset();
+    }
+    _prefetch = b;
+  }
+
+}
@@ -0,0 +1,241 @@
+/*
+  This file is part of LOOS.
+
+  LOOS (Lightweight Object-Oriented Structure library)
+  Copyright (c) 2008, Tod D. Romo, Alan Grossfield
+  Department of Biochemistry and Biophysics
+  School of Medicine & Dentistry, University of Rochester
+
+  This package (LOOS) is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation under version 3 of the License.
+
+  This package is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#if !defined(LOOS_TRAJECTORY_ITERATOR_HPP)
+#define LOOS_TRAJECTORY_ITERATOR_HPP
+
+#include <string>
+#include <vector>
+#include <utility>
+
+#include <boost/shared_ptr.hpp>
+
+#include <loos_defs.hpp>
+#include <AtomicGroup.hpp>
+#include <Trajectory.hpp>
+#include <XForm.hpp>
+
+
+namespace loos {
+
+
+  //! Iterates over frames from one or more trajectories, optionally aligning them
+  /**
+   * This is the native engine behind the PyLOOS Trajectory,
+   * VirtualTrajectory, and AlignedVirtualTrajectory classes (see
+   * loos/pyloos/trajectories.py), but can be used from C++ as well.
+   *
+   * A TrajectoryIterator is built from one or more sources.  Each
+   * source is a trajectory, the model it updates, the subset that is
+   * returned for each frame, and the list of frames (in the
+   * trajectory) to use.  The frames of all sources are concatenated
+   * and a composite skip/stride (or explicit list of indices) is then
+   * applied to pick the frames that are iterated over.
+   *
+   * If alignment is enabled, each frame's subset is transformed as
+   * it is read.  The transforms come either from superimposing each
+   * frame onto a reference structure, or from an iterative alignment
+   * of all frames.  Either way, they are computed once by align()
+   * (which is called implicitly when needed).
+   *
+   * If prefetching is enabled, the next frame is read in a background
+   * thread while the caller works on the current one.  The background
+   * thread reads through its own copy of each source's trajectory
+   * (reopened from the same file), so the trajectories passed in are
+   * never touched from another thread.  This also means a source
+   * trajectory's current frame does not follow the iterator when
+   * frames are prefetched.  Sources whose file can't be reopened
+   * (e.g. one that needs an explicit trajectory type) are read
+   * without prefetching.
+   *
+   * Either way, each frame updates the source's model as
+   * Trajectory::updateGroupCoords() does, and also updates the
+   * velocities if the trajectory has them.
+   *
+   * Remember that atoms are shared.  The subset returned for a frame
+   * shares its atoms with the source's model, so it is overwritten by
+   * the next frame from the same source.  Use AtomicGroup::copy() to
+   * keep a frame.
+   *
+   * Example:
+   * \code
+   * TrajectoryIterator frames(traj, model, selectAtoms(model, "name == 'CA'"));
+   * frames.alignWith("name == 'CA'");
+   * frames.align();
+   * while (frames.next()) {
+   *   AtomicGroup ca = frames.frame();
+   *   ...
+   * }
+   * \endcode
+   */
+  class TrajectoryIterator {
+  public:
+    //! Location of a composite frame (source index, index into source's frame list)
+    typedef std::pair<uint, uint>   Location;
+
+    TrajectoryIterator();
+
+    //! Iterate over all frames of a single trajectory (with skip and stride)
+    TrajectoryIterator(const pTraj& traj, const AtomicGroup& model, const AtomicGroup& subset,
+                       const uint skip = 0, const uint stride = 1);
+
+    //! Iterate over the listed frames of a single trajectory
+    TrajectoryIterator(const pTraj& traj, const AtomicGroup& model, const AtomicGroup& subset,
+                       const std::vector<uint>& frames);
+
+    ~TrajectoryIterator();
+
+
+    //! Add a source.  The list of frames refers to frames in traj
+    void append(const pTraj& traj, const AtomicGroup& model, const AtomicGroup& subset,
+                const std::vector<uint>& frames);
+
+    //! Add a source using all frames of traj, with skip and stride
+    void append(const pTraj& traj, const AtomicGroup& model, const AtomicGroup& subset,
+                const uint skip = 0, const uint stride = 1);
+
+    //! Number of sources
+    uint sources() const { return(_sources.size()); }
+
+    //! Change the subset returned for the ith source
+    void setSubset(const uint i, const AtomicGroup& subset);
+
+
+    //! Apply a skip and stride to the composite (concatenated) frames
+    void setFrames(const uint skip, const uint stride);
+
+    //! Use an explicit list of indices into the composite frames
+    void setFrameList(const std::vector<uint>& indices);
+
+
+    //! Number of frames that will be iterated over
+    uint size() const;
+
+    //! Where the ith frame comes from
+    Location location(const uint i) const;
+
+    //! Frame number within the trajectory file for the ith frame
+    uint frameNumber(const uint i) const;
+
+
+    //! Read the ith frame and return its (possibly aligned) subset
+    AtomicGroup readFrame(const uint i);
+
+    //! Read the next frame, returning false when there are no more
+    bool next();
+
+    //! Subset for the most recently read frame
+    AtomicGroup frame() const;
+
+    //! Index of the most recently read frame (via next()), or -1
+    int index() const { return(static_cast<int>(_next) - 1); }
+
+    //! Restart iteration
+    void reset() { _next = 0; }
+
+
+    //! Selection (applied to each source's model) used for alignment
+    /**
+     * Setting this enables alignment.  Pass an empty string to
+     * disable it.
+     */
+    void alignWith(const std::string& selection);
+
+    //! Align all frames to this structure, rather than iteratively
+    /**
+     * The reference is copied.  Pass an empty group to go back to
+     * iterative alignment.
+     */
+    void setReference(const AtomicGroup& reference);
+
+    //! Compute the alignment transforms now
+    void align(const greal threshold = 1e-6, const int maxiter = 1000);
+
+    bool isAligned() const { return(_aligned); }
+
+    //! Final RMSD from the iterative alignment (0 for reference alignment, -1 if not aligned)
+    double alignmentRMSD() const { return(_align_rmsd); }
+    int alignmentIterations() const { return(_align_iters); }
+
+    //! The alignment transforms, one per frame
+    std::vector<XForm> transforms() const { return(_xforms); }
+
+
+    //! Read the next frame in a background thread
+    void prefetch(const bool b);
+    bool prefetching() const { return(_prefetch); }
+
+
+  private:
+    struct Source {
+      Source() : no_reader(false) { }
+
+      pTraj traj;
+      AtomicGroup model;
+      AtomicGroup subset;
+      AtomicGroup align_subset;
+      std::vector<uint> frames;
+
+      // Private copy of traj, only used for prefetching
+      pTraj reader;
+      bool no_reader;
+    };
+
+    struct Prefetched;
+
+    void invalidate();
+    void rebuild() const;
+    void readInto(const uint i);
+    void startPrefetch(const uint i);
+    bool finishPrefetch(const uint i);
+    bool alignmentWanted() const { return(!_align_selection.empty()); }
+
+    std::vector<Source> _sources;
+
+    // Composite frame selection
+    uint _skip, _stride;
+    std::vector<uint> _indices;
+    bool _use_indices;
+
+    mutable bool _stale;
+    mutable std::vector<Location> _locations;
+
+    uint _next;
+    int _current_source;
+
+    // Alignment state
+    std::string _align_selection;
+    AtomicGroup _reference;
+    bool _aligned;
+    std::vector<XForm> _xforms;
+    double _align_rmsd;
+    int _align_iters;
+
+    bool _prefetch;
+    boost::shared_ptr<Prefetched> _pending;
+  };
+
+
+}
+
+
+#endif
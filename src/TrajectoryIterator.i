@@ -0,0 +1,71 @@
+/*
+  This file is part of LOOS.
+
+  LOOS (Lightweight Object-Oriented Structure library)
+  Copyright (c) 2008, Tod D. Romo, Alan Grossfield
+  Department of Biochemistry and Biophysics
+  School of Medicine & Dentistry, University of Rochester
+
+  This package (LOOS) is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation under version 3 of the License.
+
+  This package is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+%include <std_pair.i>
+
+%header %{
+#include <TrajectoryIterator.hpp>
+%}
+
+%template(UIntPair) std::pair<unsigned int, unsigned int>;
+
+// The end of iteration is signalled from C++ with std::out_of_range
+%exception loos::TrajectoryIterator::__next__
+{
+  try {
+    $action
+      }
+  catch (std::out_of_range& e) {
+    PyErr_SetNone(PyExc_StopIteration);
+    return(NULL);
+  }
+}
+
+%catches(loos::LOOSError, std::out_of_range) loos::TrajectoryIterator::readFrame;
+%catches(loos::LOOSError, std::out_of_range) loos::TrajectoryIterator::location;
+%catches(loos::LOOSError, std::out_of_range) loos::TrajectoryIterator::frameNumber;
+%catches(loos::LOOSError) loos::TrajectoryIterator::append;
+%catches(loos::LOOSError) loos::TrajectoryIterator::align;
+
+%include "TrajectoryIterator.hpp"
+
+namespace loos {
+
+  %extend TrajectoryIterator {
+
+    ulong __len__() {
+      return($self->size());
+    }
+
+    loos::AtomicGroup __next__() {
+      if (!$self->next())
+        throw(std::out_of_range("End of trajectory"));
+      return($self->frame());
+    }
+
+    %pythoncode %{
+      def __iter__(self):
+          return(self)
+    %}
+
+  };
+
+}
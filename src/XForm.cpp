@@ -23,6 +23,21 @@
 
 namespace loos {
 
+  GMatrix centerRotateTranslate(const GMatrix& R, const GCoord& center, const GCoord& t) {
+    GMatrix M(R);
+
+    // M = T(t) * R * T(-center), so the translation column picks up
+    // -R*center + t
+    for (int j=0; j<3; ++j) {
+      M(j, 3) = t[j] + R(j, 3);
+      for (int i=0; i<3; ++i)
+        M(j, 3) -= R(j, i) * center[i];
+    }
+
+    return(M);
+  }
+
+
   void XForm::push(void) { GMatrix M = stack.back(); stack.push_back(M); _unset = false; }
   void XForm::pop(void) {  stack.pop_back(); _unset = false; }
   void XForm::load(const GMatrix& m) { stack.back() = m; _unset = false; }
@@ -107,6 +122,10 @@ namespace loos {
     return(stack.back() * v);
   }
 
+  void XForm::transform(std::vector<double>& xyz) const {
+    affineTransform(stack.back(), xyz.data(), xyz.data(), xyz.size() / 3);
+  }
+
   GMatrix XForm::current(void) const {
     GMatrix M = stack.back();
     return(M);
@@ -88,6 +88,53 @@ namespace loos {
    * coordinates... 
    */
 
+  //! Apply the affine part of a transform to packed coordinates
+  /**
+   * Only the upper 3x4 of \a M is used (i.e. the bottom row is
+   * assumed to be [0 0 0 1]), so this is a 3x3 multiply plus a
+   * translation per coordinate.  The coordinates are interleaved
+   * (x0, y0, z0, x1, ...).  \a in and \a out may be the same array.
+   */
+  template<typename T>
+  void affineTransform(const GMatrix& M, const T* in, T* out, const uint n) {
+    const greal* m = M.data();
+    const T m0 = m[0], m1 = m[1], m2 = m[2], m3 = m[3];
+    const T m4 = m[4], m5 = m[5], m6 = m[6], m7 = m[7];
+    const T m8 = m[8], m9 = m[9], m10 = m[10], m11 = m[11];
+
+    for (uint i=0; i<n; ++i, in += 3, out += 3) {
+      const T x = in[0], y = in[1], z = in[2];
+      out[0] = m0*x + m1*y + m2*z + m3;
+      out[1] = m4*x + m5*y + m6*z + m7;
+      out[2] = m8*x + m9*y + m10*z + m11;
+    }
+  }
+
+  //! Apply the affine part of a transform to a single coordinate
+  inline void affineTransform(const GMatrix& M, GCoord& c) {
+    const greal* m = M.data();
+    const greal x = c.x(), y = c.y(), z = c.z();
+    c.set(m[0]*x + m[1]*y + m[2]*z + m[3],
+          m[4]*x + m[5]*y + m[6]*z + m[7],
+          m[8]*x + m[9]*y + m[10]*z + m[11]);
+  }
+
+  //! True if the bottom row of the matrix is [0 0 0 1]
+  inline bool isAffine(const GMatrix& M) {
+    const greal* m = M.data();
+    return(m[12] == 0.0 && m[13] == 0.0 && m[14] == 0.0 && m[15] == 1.0);
+  }
+
+  //! Build the transform that centers, rotates, and then translates
+  /**
+   * The result is equivalent to translating by -center, applying \a
+   * R, and then translating by \a t, so all three can be applied to
+   * coordinates in a single pass with affineTransform().
+   */
+  GMatrix centerRotateTranslate(const GMatrix& R, const GCoord& center, const GCoord& t);
+
+
+
   class XForm {
     std::vector<GMatrix> stack;
     bool _unset;
@@ -143,6 +190,19 @@ namespace loos {
     //! Transform a GCoord() with the current transformation
     GCoord transform(const GCoord&);
 
+    //! Transform \a n packed coordinates with the current transformation
+    /**
+     * See affineTransform().  This assumes the transformation is
+     * affine (as all of the XForm operations are).
+     */
+    template<typename T>
+    void transform(const T* in, T* out, const uint n) const {
+      affineTransform(stack.back(), in, out, n);
+    }
+
+    //! Transform packed coordinates in place
+    void transform(std::vector<double>& xyz) const;
+
     //! Get the current trasnformation
     // Should we copy or return a ref?
     GMatrix current(void) const;
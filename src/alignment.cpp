@@ -39,7 +39,17 @@ namespace loos {
 
 #endif
 
-      // Now compute the SVD of R...
+      return(correlationSVD(R));
+    }
+
+
+    // SVD of a 3x3 correlation matrix (column-major), with the
+    // reflection correction.  This is split out from kabschCore() so
+    // that callers that build the correlation matrix themselves (e.g.
+    // the FloatFrame kernels) can share it.
+    SVDTupleVec correlationSVD(const vecDouble& C) {
+      vecDouble R(C);
+
       char joba='G';
       char jobu = 'U', jobv = 'V';
       int mv = 0;
@@ -223,17 +233,16 @@ namespace loos {
       GCoord V_center = centerAtOrigin(cV);
       GMatrix M = kabschCentered(cU, cV);
 
-      XForm W;
-      W.identity();
-      W.translate(V_center);
-      W.concat(M);
-      W.translate(-U_center);
-
-      return W.current();
+      return(centerRotateTranslate(M, U_center, V_center));
     }
 
 
     void applyTransform(const GMatrix& M, vecDouble& v) {
+      if (isAffine(M)) {
+        affineTransform(M, v.data(), v.data(), v.size() / 3);
+        return;
+      }
+
       for (uint i=0; i<v.size(); i += 3) {
         GCoord c(v[i],v[i+1],v[i+2]);
 
@@ -45,6 +45,7 @@ namespace loos {
         
         
                 SVDTupleVec kabschCore(const vecDouble& u, const vecDouble& v);
+                SVDTupleVec correlationSVD(const vecDouble& R);
                 GCoord centerAtOrigin(vecDouble& v);
                 double alignedRMSD(const vecDouble& U, const vecDouble& V);
                 double centeredRMSD(const vecDouble& U, const vecDouble& V);
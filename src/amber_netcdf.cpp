@@ -11,13 +11,20 @@ namespace loos {
 
 		char buf[4];
 		ifs.read(buf, 4);
-		return (buf[0] == 'C' && buf[1] == 'D' && buf[2] == 'F' && (buf[3] = 0x01 || buf[3] == 0x02));
+		if (!ifs)
+			return(false);
+
+		// Classic and 64-bit offset files start with "CDF", and
+		// NetCDF-4 files are HDF5 files
+		if (buf[0] == 'C' && buf[1] == 'D' && buf[2] == 'F')
+			return(buf[3] == 0x01 || buf[3] == 0x02 || buf[3] == 0x05);
+		return(buf[0] == '\x89' && buf[1] == 'H' && buf[2] == 'D' && buf[3] == 'F');
 	}
 
 
 
 
-	void AmberNetcdf::init(const char* name, const uint natoms) {
+	void AmberNetcdf::init(const char* name, const uint natoms, const bool read_first) {
 		int retval;
 
 
@@ -96,9 +103,34 @@ namespace loos {
 
 
 		// Now cache the first frame...
-		readRawFrame(0);
-		cached_first = true;
+		if (read_first) {
+			readRawFrame(0);
+			cached_first = true;
+		}
+
+	}
+
+
+	TrajectoryInfo AmberNetcdf::probe(const std::string& fname, const AtomicGroup& model) {
+		if (!isFileNetCDF(fname))
+			return(AmberTraj::probe(fname, model));
+
+		AmberNetcdf nc(fname, model.size(), false);
+
+		TrajectoryInfo info;
+		info.filename = fname;
+		info.format = nc.description();
+		info.natoms = nc.natoms();
+		info.nframes = nc.nframes();
+		info.timestep = nc.timestep();
+		info.periodic = nc.hasPeriodicBox();
+		info.velocities = nc.hasVelocities();
+
+		nc_type type;
+		if (!nc_inq_vartype(nc._ncid, nc._coord_id, &type))
+			info.precision = (type == NC_DOUBLE) ? sizeof(double) : sizeof(float);
 
+		return(info);
 	}
 
 
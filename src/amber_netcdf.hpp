@@ -11,6 +11,7 @@
 #include <loos_defs.hpp>
 #include <Coord.hpp>
 #include <Trajectory.hpp>
+#include <TrajectoryInfo.hpp>
 #include <exceptions.hpp>
 
 #include <amber_traj.hpp>
@@ -102,6 +103,9 @@ namespace loos {
 			return(pTraj(new AmberTraj(fname, model.size())));
 		}
 
+		//! Return metadata from the NetCDF header without reading any frames
+		static TrajectoryInfo probe(const std::string& fname, const AtomicGroup& model);
+
 		uint natoms() const { return(_natoms); }
 		uint nframes() const { return(_nframes); }
 		float timestep() const { return(_timestep); }
@@ -124,9 +128,22 @@ namespace loos {
 
 	private:
 
+		// Header-only construction (see probe())
+		AmberNetcdf(const std::string& s, const uint na, const bool read_first)
+			: Trajectory(s),
+			  _coord_data(new GCoord::element_type[na*3]),
+			  _velocity_data(new GCoord::element_type[na*3]),
+			  _box_data(new GCoord::element_type[3]),
+			  _periodic(false),
+			  _velocities(false),
+			  _timestep(1e-12)
+		{
+			cached_first = false;
+			init(s.c_str(), na, read_first);
+		}
 
 
-		void init(const char* name, const uint natoms);
+		void init(const char* name, const uint natoms, const bool read_first = true);
 		void readGlobalAttributes();
 		std::string readGlobalAttribute(const std::string& name);
 		void readRawFrame(const uint frameno);
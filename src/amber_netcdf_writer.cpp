@@ -0,0 +1,349 @@
+/*
+  This file is part of LOOS.
+
+  LOOS (Lightweight Object-Oriented Structure library)
+  Copyright (c) 2008, Tod D. Romo, Alan Grossfield
+  Department of Biochemistry and Biophysics
+  School of Medicine & Dentistry, University of Rochester
+
+  This package (LOOS) is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation under version 3 of the License.
+
+  This package is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+#include <amber_netcdf_writer.hpp>
+#include <exceptions.hpp>
+
+
+namespace loos {
+
+  namespace {
+
+    // Without chunking, frames are buffered up to this many at a time
+    // (or less, for large systems)...
+    const uint max_buffered_frames = 16;
+    const size_t max_buffer_bytes = 8 << 20;
+
+    // HDF5 cannot store chunks of 4GB or larger
+    const size_t max_chunk_bytes = 0xffffffffUL;
+
+    const char* const cell_angular_labels = "alpha" "beta " "gamma";
+
+
+    size_t frameBytes(const uint natoms) {
+      return(3 * sizeof(float) * std::max(natoms, 1u));
+    }
+
+    uint defaultBlockSize(const uint natoms) {
+      size_t n = max_buffer_bytes / frameBytes(natoms);
+      return(n < 1 ? 1 : std::min(n, static_cast<size_t>(max_buffered_frames)));
+    }
+
+  }
+
+
+
+  void AmberNetcdfWriter::init(const std::string& fname, const bool append) {
+    _filename = fname;
+    _ncid = -1;
+    _defined = false;
+    _natoms = _nframes = _buffered = _block = 0;
+    _periodic = false;
+    _coord_id = _time_id = _lengths_id = _angles_id = -1;
+
+    struct stat statbuf;
+    if (append && !stat(fname.c_str(), &statbuf) && statbuf.st_size > 0) {
+      openForAppend();
+      appending_ = true;
+    }
+  }
+
+
+  // Tools should call flush() after the last frame so that errors are
+  // reported properly.  An exception can't escape the destructor, so
+  // here the best that can be done is to say what was lost.
+  AmberNetcdfWriter::~AmberNetcdfWriter() {
+    try {
+      writeBlock();
+    }
+    catch (std::exception& e) {
+      std::cerr << "Error- " << e.what() << std::endl;
+    }
+
+    if (_ncid >= 0) {
+      int retval = nc_close(_ncid);
+      if (retval)
+        std::cerr << "Error- cannot close " << _filename << ": " << nc_strerror(retval) << std::endl;
+    }
+  }
+
+
+  void AmberNetcdfWriter::check(const int retval, const std::string& msg) const {
+    if (retval)
+      throw(FileWriteError(_filename, msg + ": " + nc_strerror(retval)));
+  }
+
+
+  // Used when constructing, so a bad level is caught before the file
+  // is touched
+  int AmberNetcdfWriter::validDeflateLevel(const int level) {
+    if (level < 0 || level > 9)
+      throw(LOOSError("NetCDF deflate level must be between 0 and 9"));
+    return(level);
+  }
+
+
+  void AmberNetcdfWriter::framesPerChunk(const uint n) {
+    if (_defined)
+      throw(LOOSError("Cannot change NetCDF chunking after frames have been written"));
+    _chunk_frames = n;
+  }
+
+
+  void AmberNetcdfWriter::deflateLevel(const int level) {
+    if (_defined)
+      throw(LOOSError("Cannot change NetCDF compression after frames have been written"));
+    _deflate = validDeflateLevel(level);
+  }
+
+
+  void AmberNetcdfWriter::setComments(const std::vector<std::string>& comments) {
+    if (_defined)
+      throw(LOOSError("Cannot change the title of a NetCDF trajectory after frames have been written"));
+
+    _title.clear();
+    for (std::vector<std::string>::const_iterator i = comments.begin(); i != comments.end(); ++i) {
+      if (!_title.empty())
+        _title += ' ';
+      _title += *i;
+    }
+  }
+
+
+  // The existing file's layout (format, chunking, etc) is kept, and
+  // new frames go after the existing ones
+  void AmberNetcdfWriter::openForAppend() {
+    int retval = nc_open(_filename.c_str(), NC_WRITE, &_ncid);
+    if (retval)
+      throw(FileOpenError(_filename, "Cannot open Amber netcdf trajectory for appending", retval));
+
+    int dim_id;
+    size_t len;
+    retval = nc_inq_dimid(_ncid, "atom", &dim_id);
+    if (!retval)
+      retval = nc_inq_dimlen(_ncid, dim_id, &len);
+    if (retval)
+      throw(FileOpenError(_filename, "Cannot read atom dimension", retval));
+    _natoms = len;
+
+    retval = nc_inq_dimid(_ncid, "frame", &dim_id);
+    if (!retval)
+      retval = nc_inq_dimlen(_ncid, dim_id, &len);
+    if (retval)
+      throw(FileOpenError(_filename, "Cannot read frame dimension", retval));
+    _nframes = len;
+
+    retval = nc_inq_varid(_ncid, "coordinates", &_coord_id);
+    if (retval)
+      throw(FileOpenError(_filename, "Cannot get id for coordinates", retval));
+
+    if (nc_inq_varid(_ncid, "time", &_time_id))
+      _time_id = -1;
+    _periodic = !nc_inq_varid(_ncid, "cell_lengths", &_lengths_id)
+      && !nc_inq_varid(_ncid, "cell_angles", &_angles_id);
+
+    int storage;
+    size_t chunks[3];
+    if (!nc_inq_var_chunking(_ncid, _coord_id, &storage, chunks) && storage == NC_CHUNKED)
+      _chunk_frames = chunks[0];
+
+    _defined = true;
+    allocateBuffer();
+  }
+
+
+  void AmberNetcdfWriter::defineHeader(const AtomicGroup& model) {
+    _natoms = model.size();
+    _periodic = model.isPeriodic();
+
+    bool netcdf4 = (_chunk_frames || _deflate);
+    if (netcdf4) {
+      if (!_chunk_frames)
+        _chunk_frames = defaultBlockSize(_natoms);
+      size_t largest = max_chunk_bytes / frameBytes(_natoms);
+      if (_chunk_frames > largest)
+        _chunk_frames = largest < 1 ? 1 : largest;
+    }
+
+    int mode = NC_CLOBBER | (netcdf4 ? NC_NETCDF4 | NC_CLASSIC_MODEL : NC_64BIT_OFFSET);
+    int retval = nc_create(_filename.c_str(), mode, &_ncid);
+    if (retval)
+      throw(FileOpenError(_filename, "Cannot create Amber netcdf trajectory", retval));
+
+    std::string application("LOOS");
+    check(nc_put_att_text(_ncid, NC_GLOBAL, "title", _title.size(), _title.c_str()), "Cannot write title");
+    check(nc_put_att_text(_ncid, NC_GLOBAL, "application", application.size(), application.c_str()), "Cannot write application");
+    check(nc_put_att_text(_ncid, NC_GLOBAL, "program", application.size(), application.c_str()), "Cannot write program");
+    check(nc_put_att_text(_ncid, NC_GLOBAL, "Conventions", 5, "AMBER"), "Cannot write conventions");
+    check(nc_put_att_text(_ncid, NC_GLOBAL, "ConventionVersion", 3, "1.0"), "Cannot write convention version");
+
+    int frame_dim, spatial_dim, atom_dim, cell_spatial_dim = -1, cell_angular_dim = -1, label_dim = -1;
+    check(nc_def_dim(_ncid, "frame", NC_UNLIMITED, &frame_dim), "Cannot define frame dimension");
+    check(nc_def_dim(_ncid, "spatial", 3, &spatial_dim), "Cannot define spatial dimension");
+    check(nc_def_dim(_ncid, "atom", _natoms, &atom_dim), "Cannot define atom dimension");
+    if (_periodic) {
+      check(nc_def_dim(_ncid, "cell_spatial", 3, &cell_spatial_dim), "Cannot define cell_spatial dimension");
+      check(nc_def_dim(_ncid, "cell_angular", 3, &cell_angular_dim), "Cannot define cell_angular dimension");
+      check(nc_def_dim(_ncid, "label", 5, &label_dim), "Cannot define label dimension");
+    }
+
+    int spatial_id, cell_spatial_id = -1, cell_angular_id = -1;
+    int dims[3];
+
+    dims[0] = spatial_dim;
+    check(nc_def_var(_ncid, "spatial", NC_CHAR, 1, dims, &spatial_id), "Cannot define spatial");
+
+    dims[0] = frame_dim;
+    check(nc_def_var(_ncid, "time", NC_FLOAT, 1, dims, &_time_id), "Cannot define time");
+    check(nc_put_att_text(_ncid, _time_id, "units", 10, "picosecond"), "Cannot write time units");
+
+    dims[1] = atom_dim;
+    dims[2] = spatial_dim;
+    check(nc_def_var(_ncid, "coordinates", NC_FLOAT, 3, dims, &_coord_id), "Cannot define coordinates");
+    check(nc_put_att_text(_ncid, _coord_id, "units", 8, "angstrom"), "Cannot write coordinate units");
+
+    if (_periodic) {
+      dims[0] = cell_spatial_dim;
+      check(nc_def_var(_ncid, "cell_spatial", NC_CHAR, 1, dims, &cell_spatial_id), "Cannot define cell_spatial");
+      dims[0] = cell_angular_dim;
+      dims[1] = label_dim;
+      check(nc_def_var(_ncid, "cell_angular", NC_CHAR, 2, dims, &cell_angular_id), "Cannot define cell_angular");
+
+      dims[0] = frame_dim;
+      dims[1] = cell_spatial_dim;
+      check(nc_def_var(_ncid, "cell_lengths", NC_DOUBLE, 2, dims, &_lengths_id), "Cannot define cell_lengths");
+      check(nc_put_att_text(_ncid, _lengths_id, "units", 8, "angstrom"), "Cannot write cell_lengths units");
+      dims[1] = cell_angular_dim;
+      check(nc_def_var(_ncid, "cell_angles", NC_DOUBLE, 2, dims, &_angles_id), "Cannot define cell_angles");
+      check(nc_put_att_text(_ncid, _angles_id, "units", 6, "degree"), "Cannot write cell_angles units");
+    }
+
+    // Per-frame variables are chunked by the same number of frames
+    // so a block of frames lands in one chunk of each
+    if (netcdf4) {
+      size_t chunks[3] = {_chunk_frames, std::max(_natoms, 1u), 3};
+      check(nc_def_var_chunking(_ncid, _coord_id, NC_CHUNKED, chunks), "Cannot set chunking for coordinates");
+      if (_deflate)
+        check(nc_def_var_deflate(_ncid, _coord_id, 1, 1, _deflate), "Cannot set compression for coordinates");
+
+      check(nc_def_var_chunking(_ncid, _time_id, NC_CHUNKED, chunks), "Cannot set chunking for time");
+      if (_periodic) {
+        chunks[1] = 3;
+        check(nc_def_var_chunking(_ncid, _lengths_id, NC_CHUNKED, chunks), "Cannot set chunking for cell_lengths");
+        check(nc_def_var_chunking(_ncid, _angles_id, NC_CHUNKED, chunks), "Cannot set chunking for cell_angles");
+      }
+    }
+
+    check(nc_enddef(_ncid), "Cannot finish the netcdf header");
+
+    size_t start[2] = {0, 0};
+    size_t count[2] = {3, 5};
+    check(nc_put_vara_text(_ncid, spatial_id, start, count, "xyz"), "Cannot write spatial labels");
+    if (_periodic) {
+      check(nc_put_vara_text(_ncid, cell_spatial_id, start, count, "abc"), "Cannot write cell_spatial labels");
+      check(nc_put_vara_text(_ncid, cell_angular_id, start, count, cell_angular_labels), "Cannot write cell_angular labels");
+    }
+
+    _defined = true;
+    allocateBuffer();
+  }
+
+
+  // The buffer holds exactly one chunk when the file is chunked, so
+  // each chunk is written in a single call...
+  void AmberNetcdfWriter::allocateBuffer() {
+    _block = _chunk_frames ? _chunk_frames : defaultBlockSize(_natoms);
+
+    _coords.resize(static_cast<size_t>(_block) * _natoms * 3);
+    _times.resize(_block);
+    if (_periodic)
+      _lengths.resize(3 * _block);
+  }
+
+
+  void AmberNetcdfWriter::writeBlock() {
+    if (!_buffered)
+      return;
+
+    size_t start[3] = {_nframes, 0, 0};
+    size_t count[3] = {_buffered, _natoms, 3};
+
+    check(nc_put_vara_float(_ncid, _coord_id, start, count, &_coords[0]), "Cannot write coordinates");
+
+    if (_time_id >= 0)
+      check(nc_put_vara_float(_ncid, _time_id, start, count, &_times[0]), "Cannot write time");
+
+    if (_periodic) {
+      count[1] = 3;
+      std::vector<double> angles(3 * _buffered, 90.0);
+      check(nc_put_vara_double(_ncid, _lengths_id, start, count, &_lengths[0]), "Cannot write cell_lengths");
+      check(nc_put_vara_double(_ncid, _angles_id, start, count, &angles[0]), "Cannot write cell_angles");
+    }
+
+    _nframes += _buffered;
+    _buffered = 0;
+  }
+
+
+  void AmberNetcdfWriter::flush() {
+    writeBlock();
+    if (_defined)
+      check(nc_sync(_ncid), "Cannot sync");
+  }
+
+
+  void AmberNetcdfWriter::writeFrame(const AtomicGroup& model) {
+    writeFrame(model, 0, framesWritten() * _dt);
+  }
+
+
+  void AmberNetcdfWriter::writeFrame(const AtomicGroup& model, const uint step, const double time) {
+    if (!_defined)
+      defineHeader(model);
+
+    if (model.size() != _natoms)
+      throw(LOOSError("Frame has a different number of atoms than the Amber netcdf trajectory being written"));
+
+    float* p = &_coords[static_cast<size_t>(_buffered) * _natoms * 3];
+    for (AtomicGroup::const_iterator i = model.begin(); i != model.end(); ++i) {
+      const GCoord& c = (*i)->coords();
+      *(p++) = c.x();
+      *(p++) = c.y();
+      *(p++) = c.z();
+    }
+
+    _times[_buffered] = time;
+    if (_periodic) {
+      GCoord box = model.periodicBox();
+      for (uint j=0; j<3; ++j)
+        _lengths[3 * _buffered + j] = box[j];
+    }
+
+    if (++_buffered == _block)
+      writeBlock();
+  }
+
+}
@@ -0,0 +1,164 @@
+/*
+  This file is part of LOOS.
+
+  LOOS (Lightweight Object-Oriented Structure library)
+  Copyright (c) 2008, Tod D. Romo, Alan Grossfield
+  Department of Biochemistry and Biophysics
+  School of Medicine & Dentistry, University of Rochester
+
+  This package (LOOS) is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation under version 3 of the License.
+
+  This package is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#if !defined(LOOS_AMBER_NETCDF_WRITER_HPP)
+#define LOOS_AMBER_NETCDF_WRITER_HPP
+
+#include <string>
+#include <vector>
+
+#include <netcdf.h>
+
+#include <loos_defs.hpp>
+#include <AtomicGroup.hpp>
+#include <trajwriter.hpp>
+
+
+namespace loos {
+
+
+  //! Class for writing Amber trajectories in NetCDF format
+  /**
+   * Writes files following the AMBER NetCDF trajectory convention
+   * (version 1.0), with single-precision coordinates, the time of
+   * each frame (in picoseconds), and the periodic box (if the first
+   * frame written is periodic).
+   *
+   * Frames are buffered and written to the file a block at a time,
+   * so each write covers many frames at once.  By default, the output
+   * is a classic (64-bit offset) NetCDF file that any Amber-aware
+   * program can read.  Setting framesPerChunk() or deflateLevel()
+   * switches to a NetCDF-4 file (using the classic data model), where
+   * the coordinates are stored in chunks of that many frames and may
+   * be compressed.  Since a chunk holds whole frames, reading an
+   * arbitrary frame only decompresses the chunk containing it.  The
+   * buffer holds one chunk, so each chunk is written exactly once.
+   * These settings must be made before the first frame is written.
+   *
+   * As with XTCWriter, frames are assumed to be evenly spaced in time
+   * (see timePerFrame()) unless a time is passed to writeFrame().
+   */
+  class AmberNetcdfWriter : public TrajectoryWriter {
+  public:
+
+    //! Class factory function
+    static pTrajectoryWriter create(const std::string& s, const bool append = false) {
+      return(pTrajectoryWriter(new AmberNetcdfWriter(s, append)));
+    }
+
+
+    AmberNetcdfWriter(const std::string& fname, const bool append = false)
+      : TrajectoryWriter(static_cast<std::iostream*>(0), false),
+        _chunk_frames(0), _deflate(0), _dt(1.0)
+    {
+      init(fname, append);
+    }
+
+    //! Chunked and (if \a deflate is nonzero) compressed output
+    AmberNetcdfWriter(const std::string& fname, const uint frames_per_chunk, const int deflate, const bool append = false)
+      : TrajectoryWriter(static_cast<std::iostream*>(0), false),
+        _chunk_frames(frames_per_chunk), _deflate(validDeflateLevel(deflate)), _dt(1.0)
+    {
+      init(fname, append);
+    }
+
+
+    //! Writes out any buffered frames and closes the file
+    /**
+     * Errors here can only be reported on stderr, so call flush()
+     * after the last frame to have them thrown instead.
+     */
+    ~AmberNetcdfWriter();
+
+
+    //! Number of frames in each chunk of the coordinates (0 for an unchunked, classic file)
+    uint framesPerChunk() const { return(_chunk_frames); }
+
+    //! Sets the number of frames per chunk, before the first frame is written
+    void framesPerChunk(const uint n);
+
+    //! Compression level (0 = none, 9 = most)
+    int deflateLevel() const { return(_deflate); }
+
+    //! Sets the compression level, before the first frame is written
+    void deflateLevel(const int level);
+
+    //! Time (in picoseconds) between frames
+    double timePerFrame() const { return(_dt); }
+
+    //! Sets the time between frames when no explicit time is given
+    void timePerFrame(const double dt) { _dt = dt; }
+
+
+    using TrajectoryWriter::setComments;
+
+    //! Sets the title, before the first frame is written
+    void setComments(const std::vector<std::string>& comments);
+
+    void writeFrame(const AtomicGroup& model);
+
+    //! Writes a frame with an explicit time (the step is ignored)
+    void writeFrame(const AtomicGroup& model, const uint step, const double time);
+
+    //! Writes any buffered frames to the file
+    void flush();
+
+    bool hasFrameTime() const { return(true); }
+    bool hasComments() const { return(true); }
+
+    //! Frames in the file, including any still buffered
+    uint framesWritten() const { return(_nframes + _buffered); }
+
+  private:
+    void init(const std::string& fname, const bool append);
+    void openForAppend();
+    void defineHeader(const AtomicGroup& model);
+    void allocateBuffer();
+    void writeBlock();
+    void check(const int retval, const std::string& msg) const;
+    static int validDeflateLevel(const int level);
+
+  private:
+    int _ncid;
+    bool _defined;
+    uint _natoms;
+    uint _nframes;
+    uint _buffered;
+    uint _block;
+    bool _periodic;
+
+    uint _chunk_frames;
+    int _deflate;
+    double _dt;
+    std::string _title;
+
+    int _coord_id, _time_id, _lengths_id, _angles_id;
+
+    std::vector<float> _coords;
+    std::vector<float> _times;
+    std::vector<double> _lengths;
+  };
+
+}
+
+
+#endif
@@ -23,19 +23,150 @@
 
 #include <amber_traj.hpp>
 #include <AtomicGroup.hpp>
+#include <algorithm>
 #include <iomanip>
 #include <sstream>
 
+#include <boost/bind.hpp>
+#include <boost/scoped_array.hpp>
+#include <boost/thread/thread.hpp>
+
 namespace loos {
 
-  // Scan the trajectory file to determine frame sizes and box
-  void AmberTraj::init(void) {
+  namespace {
+
+    const uint field_width = 8;
+    const uint fields_per_line = 10;
+
+    // Parses one fixed-width field (i.e. "%8.3f") without going
+    // through iostreams or the locale.  Only plain decimal numbers
+    // are accepted, so anything unusual (including the asterisks
+    // Amber writes on overflow) is rejected.
+    inline bool parseField(const char* p, double& val) {
+      static const double scales[] = { 1.0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8 };
+      const char* e = p + field_width;
+
+      while (p < e && *p == ' ')
+        ++p;
+
+      bool negative = false;
+      if (p < e && (*p == '-' || *p == '+'))
+        negative = (*p++ == '-');
+
+      long mant = 0;
+      uint digits = 0, decimals = 0;
+      while (p < e && *p >= '0' && *p <= '9') {
+        mant = mant * 10 + (*p++ - '0');
+        ++digits;
+      }
+      if (p < e && *p == '.') {
+        ++p;
+        while (p < e && *p >= '0' && *p <= '9') {
+          mant = mant * 10 + (*p++ - '0');
+          ++decimals;
+        }
+      }
+
+      if (p != e || digits + decimals == 0)
+        return(false);
+
+      val = mant / scales[decimals];
+      if (negative)
+        val = -val;
+      return(true);
+    }
+
+  }
+
+
+  void AmberTraj::init(const bool read_first) {
     char buf[1024];
 
     ifs->getline(buf, 1024);
     frame_offset = ifs->tellg();
+
+    if (!initFixedWidth(read_first)) {
+      periodic = false;
+      eol_size = 1;
+      ifs->clear();
+      ifs->seekg(frame_offset);
+      initStream();
+    }
+
+    cached_first = read_first;
+  }
+
+
+  // Checks whether the first frame uses the standard fixed-width
+  // layout.  If so, the frame size and count are computed directly
+  // and the first frame is parsed.
+  bool AmberTraj::initFixedWidth(const bool read_first) {
+    char buf[1024];
+
+    if (_natoms == 0)
+      return(false);
+
+    ifs->getline(buf, 1024);
+    if (ifs->fail())
+      return(false);
+    std::string line(buf);
+    eol_size = (!line.empty() && line[line.size()-1] == '\r') ? 2 : 1;
+
+    const unsigned long nvals = 3 * _natoms;
+    const unsigned long nlines = (nvals + fields_per_line - 1) / fields_per_line;
+    const unsigned long coord_size = nvals * field_width + nlines * eol_size;
+    const unsigned long box_size = 3 * field_width + eol_size;
+
+    // Read enough for the coordinates and a possible box line...
+    ifs->seekg(frame_offset);
+    framebuf.resize(coord_size + box_size);
+    ifs->read(&framebuf[0], framebuf.size());
+    unsigned long n = ifs->gcount();
+    ifs->clear();
+    if (n + eol_size < coord_size)
+      return(false);
+
+    // The box is a line with exactly 3 fields following the
+    // coordinates.  This is ambiguous for a single atom, so those are
+    // left to initStream()...
+    if (nvals <= 3)
+      return(false);
+
+    unsigned long len = 0;
+    while (coord_size + len < n && framebuf[coord_size + len] != '\n')
+      ++len;
+    if (len && eol_size == 2 && framebuf[coord_size + len - 1] == '\r')
+      --len;
+    periodic = (len == 3 * field_width);
+
+    frame_size = coord_size + (periodic ? box_size : 0);
+    if (read_first) {
+      if (!parseFrameBuffer(&framebuf[0], std::min(n, frame_size), frame, box))
+        return(false);
+    } else if (!checkFrameLayout(&framebuf[0], std::min(n, frame_size)))
+      return(false);
+
+    // The last frame may be missing its final line-ending...
+    ifs->seekg(0, std::ios_base::end);
+    unsigned long fsize = ifs->tellg();
+    _nframes = (fsize - frame_offset + eol_size) / frame_size;
+
+    ifs->clear();
+    ifs->seekg(frame_offset + frame_size);
+    if (ifs->fail())
+      throw(FileOpenError(_filename, "Cannot determine frame information for Amber trajectory"));
+
+    fixed_width = true;
+    return(true);
+  }
+
+
+  // Scan the trajectory file to determine frame sizes and box
+  void AmberTraj::initStream(void) {
+    char buf[1024];
     greal x, y, z;
 
+    frame.clear();
     for (uint i=0; i<_natoms; i++) {
       *(ifs) >> std::setw(8) >> x >> std::setw(8) >> y >> std::setw(8) >> z;
       frame.push_back(GCoord(x,y,z));
@@ -78,12 +209,101 @@ namespace loos {
     // Punt our failure check to the end...for now...
     if (ifs->fail())
       throw(FileOpenError(_filename, "Cannot determine frame information for Amber trajectory"));
+  }
+
+
+  // Parses a frame (of n bytes) laid out as fixed-width fields.
+  // Returns false if the layout isn't what's expected...
+  bool AmberTraj::parseFrameBuffer(const char* p, const unsigned long n, std::vector<GCoord>& crds, GCoord& pbox) const {
+    const char* e = p + n;
+    const uint nvals = 3 * _natoms;
+    double v[3];
+
+    crds.resize(_natoms);
+    for (uint k=0; k<nvals; ++k) {
+      if (k && k % fields_per_line == 0) {
+        if (e - p < static_cast<long>(eol_size) || p[eol_size-1] != '\n')
+          return(false);
+        p += eol_size;
+      }
+      if (e - p < static_cast<long>(field_width) || !parseField(p, v[k % 3]))
+        return(false);
+      p += field_width;
+      if (k % 3 == 2)
+        crds[k / 3] = GCoord(v[0], v[1], v[2]);
+    }
 
-    cached_first = true;
+    if (periodic) {
+      if (e - p < static_cast<long>(eol_size) || p[eol_size-1] != '\n')
+        return(false);
+      p += eol_size;
+      for (uint k=0; k<3; ++k) {
+        if (e - p < static_cast<long>(field_width) || !parseField(p, v[k]))
+          return(false);
+        p += field_width;
+      }
+      pbox = GCoord(v[0], v[1], v[2]);
+    }
+
+    // Only a final line-ending (or nothing, at the end of the file) may remain
+    return(p == e || (e - p == static_cast<long>(eol_size) && p[eol_size-1] == '\n'));
   }
 
 
+
+  // Same checks as parseFrameBuffer(), but only of where the
+  // line-endings fall (the fields themselves are not parsed)
+  bool AmberTraj::checkFrameLayout(const char* p, const unsigned long n) const {
+    const char* e = p + n;
+    const uint nvals = 3 * _natoms;
+
+    for (uint k=0; k<nvals; ++k) {
+      if (k && k % fields_per_line == 0) {
+        if (e - p < static_cast<long>(eol_size) || p[eol_size-1] != '\n')
+          return(false);
+        p += eol_size;
+      }
+      if (e - p < static_cast<long>(field_width))
+        return(false);
+      p += field_width;
+    }
+
+    if (periodic) {
+      if (e - p < static_cast<long>(eol_size) || p[eol_size-1] != '\n')
+        return(false);
+      p += eol_size + 3 * field_width;
+      if (p > e)
+        return(false);
+    }
+
+    return(p == e || (e - p == static_cast<long>(eol_size) && p[eol_size-1] == '\n'));
+  }
+
   bool AmberTraj::parseFrame(void) {
+    if (!fixed_width)
+      return(parseFrameStream());
+
+    framebuf.resize(frame_size);
+    ifs->read(&framebuf[0], frame_size);
+    unsigned long n = ifs->gcount();
+
+    // As with parseFrameStream(), running off the end of the
+    // trajectory is not an error...
+    if (n + eol_size < frame_size) {
+      ifs->clear();
+      ifs->seekg(0, std::ios_base::end);
+      return(false);
+    }
+    ifs->clear();
+
+    if (!parseFrameBuffer(&framebuf[0], n, frame, box))
+      throw(FileReadError(_filename, "Problem reading from Amber trajectory"));
+
+    return(true);
+  }
+
+
+  bool AmberTraj::parseFrameStream(void) {
     greal x, y, z;
 
     if (ifs->eof())
@@ -117,6 +337,70 @@ namespace loos {
   }
 
 
+  void AmberTraj::parseFrameRange(const std::vector<char>* block, const uint first, const uint last,
+                                  std::vector< std::vector<GCoord> >* frames, std::vector<GCoord>* boxes,
+                                  bool* ok) const {
+    *ok = true;
+    for (uint i=first; i<last; ++i) {
+      unsigned long offset = i * frame_size;
+      unsigned long n = std::min(frame_size, block->size() - offset);
+      if (!parseFrameBuffer(&(*block)[offset], n, (*frames)[i], (*boxes)[i])) {
+        *ok = false;
+        return;
+      }
+    }
+  }
+
+
+  void AmberTraj::readFrames(const uint start, const uint n,
+                             std::vector< std::vector<GCoord> >& frames,
+                             std::vector<GCoord>& boxes,
+                             const uint nthreads) {
+    if (!fixed_width)
+      throw(LOOSError("Amber trajectory " + _filename + " does not use the fixed-width layout"));
+    if (start + n > _nframes)
+      throw(FileError(_filename, "Attempting to read frames beyond end of trajectory"));
+
+    frames.resize(n);
+    boxes.resize(n);
+    if (n == 0)
+      return;
+
+    // Read the whole block, leaving the current frame untouched
+    ifs->clear();
+    std::streampos current = ifs->tellg();
+    std::vector<char> block(n * frame_size);
+    ifs->seekg(frame_offset + start * frame_size);
+    ifs->read(&block[0], block.size());
+    block.resize(ifs->gcount());
+    ifs->clear();
+    ifs->seekg(current);
+
+    if (block.size() + eol_size < n * frame_size)
+      throw(FileReadError(_filename, "Problem reading from Amber trajectory"));
+
+    uint nt = std::max(1u, std::min(nthreads, n));
+    uint per = (n + nt - 1) / nt;
+    boost::scoped_array<bool> oks(new bool[nt]);
+
+    boost::thread_group threads;
+    for (uint t=0; t<nt; ++t) {
+      uint first = t * per;
+      uint last = std::min(n, first + per);
+      oks[t] = true;
+      if (t == nt-1)
+        parseFrameRange(&block, first, last, &frames, &boxes, &oks[t]);
+      else
+        threads.create_thread(boost::bind(&AmberTraj::parseFrameRange, this, &block, first, last, &frames, &boxes, &oks[t]));
+    }
+    threads.join_all();
+
+    for (uint t=0; t<nt; ++t)
+      if (!oks[t])
+        throw(FileReadError(_filename, "Problem reading from Amber trajectory"));
+  }
+
+
   void AmberTraj::seekFrameImpl(const uint i) {
 
     cached_first = false;
@@ -131,6 +415,24 @@ namespace loos {
   }
 
 
+  TrajectoryInfo AmberTraj::probe(const std::string& fname, const AtomicGroup& model) {
+    AmberTraj traj(fname, model.size(), false);
+
+    TrajectoryInfo info;
+    info.filename = fname;
+    info.format = traj.description();
+    info.natoms = traj.natoms();
+    info.nframes = traj.nframes();
+    info.timestep = traj.timestep();
+    info.periodic = traj.hasPeriodicBox();
+    info.fixed_frame_size = true;
+    info.first_frame_offset = traj.frame_offset;
+    info.frame_size = traj.frame_size;
+
+    return(info);
+  }
+
+
   void AmberTraj::updateGroupCoordsImpl(AtomicGroup& g) {
 
     for (AtomicGroup::iterator i = g.begin(); i != g.end(); ++i) {
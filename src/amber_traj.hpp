@@ -24,10 +24,12 @@
 
 
 #include <string>
+#include <vector>
 
 #include <loos_defs.hpp>
 #include <Coord.hpp>
 #include <Trajectory.hpp>
+#include <TrajectoryInfo.hpp>
 
 
 namespace loos {
@@ -43,23 +45,42 @@ namespace loos {
    *
    * Note that the Amber timestep is (presumably) defined in the parmtop
    * file, not in the trajectory file.  So we return a null-value here...
+   *
+   * Amber writes coordinates as fixed-width (8 character) fields, 10
+   * to a line.  When the first frame matches this layout, the byte
+   * offset of every frame is computed directly and frames are parsed
+   * straight from a buffer with a fixed-width number parser rather
+   * than through iostreams.  Files that don't match the layout are
+   * read field-by-field as before.  Blocks of frames can also be
+   * parsed in parallel with readFrames().
    */
 
   class AmberTraj : public Trajectory {
   public:
     explicit AmberTraj(const std::string& s, const int na) : Trajectory(s),
                                                              _natoms(na), frame_offset(0),
-                                                             frame_size(0), periodic(false) { init(); }
+                                                             frame_size(0), periodic(false),
+                                                             fixed_width(false), eol_size(1) { init(); }
 
     explicit AmberTraj(std::istream& is, const int na) : Trajectory(is), _natoms(na),
                                                      frame_offset(0), frame_size(0),
-                                                     periodic(false) { init(); }
+                                                     periodic(false), fixed_width(false),
+                                                     eol_size(1) { init(); }
 
     std::string description() const { return("Amber trajectory"); }
     static pTraj create(const std::string& fname, const AtomicGroup& model) {
       return(pTraj(new AmberTraj(fname, model.size())));
     }
 
+    //! Return metadata for the trajectory
+    /**
+     * The number of atoms must come from the model.  For the
+     * fixed-width layout, only the line-endings of the first frame are
+     * checked and no coordinates are parsed.  Other files still have
+     * their first frame parsed to find the frame size.
+     */
+    static TrajectoryInfo probe(const std::string& fname, const AtomicGroup& model);
+
 
     virtual uint nframes(void) const { return(_nframes); }
     virtual uint natoms(void) const { return(_natoms); }
@@ -79,21 +100,59 @@ namespace loos {
 
     virtual bool parseFrame(void);
 
+    //! True if frames are being read using the fixed-width layout
+    bool isFixedWidth(void) const { return(fixed_width); }
+
+    //! Read \a n frames starting with frame \a start
+    /**
+     * The frames are read from the file as a single block and then
+     * parsed using \a nthreads threads.  Each frame is returned as a
+     * vector of coordinates (and the box, if the trajectory is
+     * periodic, is placed in \a boxes).  This does not change the
+     * current frame.  The trajectory must use the fixed-width layout.
+     */
+    void readFrames(const uint start, const uint n,
+                    std::vector< std::vector<GCoord> >& frames,
+                    std::vector<GCoord>& boxes,
+                    const uint nthreads = 1);
+
 
   private:
-    void init(void);
+    // Only determines the frame layout (see probe())
+    AmberTraj(const std::string& s, const int na, const bool read_first) : Trajectory(s),
+                                                                          _natoms(na), frame_offset(0),
+                                                                          frame_size(0), periodic(false),
+                                                                          fixed_width(false), eol_size(1) { init(read_first); }
+
+    void init(const bool read_first = true);
+    bool initFixedWidth(const bool read_first);
+    void initStream(void);
+    bool parseFrameStream(void);
+    bool parseFrameBuffer(const char* p, const unsigned long n, std::vector<GCoord>& crds, GCoord& pbox) const;
+    bool checkFrameLayout(const char* p, const unsigned long n) const;
+    void parseFrameRange(const std::vector<char>* block, const uint first, const uint last,
+                         std::vector< std::vector<GCoord> >* frames, std::vector<GCoord>* boxes,
+                         bool* ok) const;
     virtual void rewindImpl(void) { ifs->clear(); ifs->seekg(frame_offset); }
     virtual void seekNextFrameImpl(void) { }
     virtual void seekFrameImpl(const uint);
     virtual void updateGroupCoordsImpl(AtomicGroup&);
+    virtual void updateFrameCoordsImpl(FloatFrame& f) {
+      f.copyFromFrame(frame);
+      if (periodic)
+        f.periodicBox(box);
+    }
 
 
   private:
     uint _natoms, _nframes;
     unsigned long frame_offset, frame_size;
     bool periodic;
+    bool fixed_width;
+    uint eol_size;          // 1 for \n, 2 for \r\n line-endings
     GCoord box;
     std::vector<GCoord> frame;
+    std::vector<char> framebuf;
 
   };
 
@@ -68,6 +68,7 @@ selectAtoms;
 %catches(loos::FileError) AmberTraj::parseFrame;
 %catches(loos::FileError) AmberTraj::seekFrameImpl;
 %catches(loos::LOOSError) AmberTraj::updateGroupCoordsImpl;
+%catches(loos::LOOSError) AmberTraj::readFrames;
 
 // Atom
 %catches(loos::LOOSError) Atom::checkUserBits;
@@ -232,3 +233,19 @@ Trajectory::parseFrame;
 
 %catches(loos::FileReadError, loos::FileOpenError, loos::FileError, loos::LOOSError) XTCWriter::XTCWriter;
 %catches(loos::FileWriteError, loos::LOOSError) XTCWriter::writeFame;
+
+// analysis kernels
+%catches(loos::LOOSError) accumulateContacts;
+%catches(loos::LOOSError) accumulateCylindricalHistogram;
+%catches(loos::LOOSError) accumulateCylindricalHeights;
+%catches(loos::LOOSError) ConvexHull2D::update;
+%catches(loos::LOOSError) ConvexHull2D::classify;
+%catches(std::out_of_range) ConvexHull2D::vertex;
+
+// cached trajectories
+%catches(loos::FileReadError, loos::LOOSError) CachedTrajectory::CachedTrajectory;
+%catches(loos::LOOSError) CachedTrajectory::coords;
+
+// pair distance histograms
+%catches(loos::LOOSError) PairDistanceHistogram::PairDistanceHistogram;
+%catches(loos::LOOSError) PairDistanceHistogram::accumulate;
@@ -44,7 +44,7 @@ namespace loos {
   GCoord DCD::periodicBox(void) const { return(GCoord(qcrys[0], qcrys[1], qcrys[2])); }
 
 
-  bool DCD::suppress_warnings = false;
+  std::atomic<bool> DCD::suppress_warnings(false);
   
   
   std::vector<std::string> DCD::titles(void) const { return(_titles); }
@@ -233,11 +233,11 @@ namespace loos {
     ptr = readF77Line(&len);
     if (len != 4)
       throw(FileReadError(_filename, "Error reading number of atoms from DCD"));
-    if (swabbing)
-      _natoms = swab(ptr->i);
-    else
-      _natoms = ptr->i;
+    int natoms = swabbing ? swab(ptr->i) : ptr->i;
     delete[] ptr;
+    if (natoms < 0)
+      throw(FileReadError(_filename, "DCD header has a negative number of atoms"));
+    _natoms = natoms;
 
 
     // Finally, set internal variables and allocate space for a frame...
@@ -426,6 +426,34 @@ namespace loos {
 
 
 
+  void DCD::updateFrameCoordsImpl(FloatFrame& f) {
+    f.copyFromFrame(&xcrds[0], &ycrds[0], &zcrds[0], _natoms);
+    if (hasPeriodicBox())
+      f.periodicBox(periodicBox());
+  }
+
+
+
+  TrajectoryInfo DCD::probe(const std::string& fname, const AtomicGroup& model) {
+    DCD dcd(fname, false);
+
+    TrajectoryInfo info;
+    info.filename = fname;
+    info.format = dcd.description();
+    info.natoms = dcd.natoms();
+    info.nframes = dcd.nframes();
+    info.timestep = dcd.timestep();
+    info.periodic = dcd.hasPeriodicBox();
+    info.precision = sizeof(dcd_real);
+    info.native_endian = dcd.nativeFormat();
+    info.fixed_frame_size = true;
+    info.first_frame_offset = dcd.first_frame_pos;
+    info.frame_size = dcd.frame_size;
+
+    return(info);
+  }
+
+
   void DCD::initTrajectory() {
         readHeader();
         bool b = parseFrame();
@@ -25,6 +25,7 @@
 #define LOOS_DCD_HPP
 
 
+#include <atomic>
 #include <iostream>
 #include <string>
 #include <stdexcept>
@@ -33,6 +34,7 @@
 #include <loos_defs.hpp>
 
 #include <Trajectory.hpp>
+#include <TrajectoryInfo.hpp>
 
 
 namespace loos {
@@ -61,7 +63,7 @@ namespace loos {
      *  - Endian detection is based on the expected size of the header
      */
     class DCD : public Trajectory {
-        static bool suppress_warnings;
+        static std::atomic<bool> suppress_warnings;
 
 
         // Use a union to convert data to appropriate type...
@@ -95,6 +97,20 @@ namespace loos {
             return(pTraj(new DCD(fname)));
         }
 
+        //! Return metadata for the DCD by only reading its header
+        static TrajectoryInfo probe(const std::string& fname, const AtomicGroup& model);
+
+        //! Open a DCD and read only the header (no frame is cached)
+        /**
+         * This is intended for tools that only want the DCD metadata
+         * (e.g. dcdinfo).  Since the first frame is not read, the
+         * coordinate accessors are not valid and you must call
+         * rewind() (or readFrame(i)) before iterating over frames.
+         */
+        static boost::shared_ptr<DCD> headerOnly(const std::string& fname) {
+            return(boost::shared_ptr<DCD>(new DCD(fname, false)));
+        }
+
 
 
         // Accessor methods...
@@ -118,6 +134,11 @@ namespace loos {
         virtual float timestep(void) const;
         virtual uint nframes(void) const;
 
+        //! Byte offset of the first frame in the file
+        std::streampos firstFramePos(void) const { return(first_frame_pos); }
+        //! Size (in bytes) of each frame, including F77 record markers
+        std::streamoff frameSize(void) const { return(frame_size); }
+
         //! Return the raw coords...
         std::vector<dcd_real> xcoords(void) const;
         //! Return the raw coords...
@@ -145,13 +166,28 @@ namespace loos {
 
 
 
+        //! Suppress warnings about DCDs that appear empty
+        /**
+         * This is process-wide and may be called from any thread.
+         */
         static void setSuppression(const bool b) { suppress_warnings = b; }
+        static bool suppression() { return(suppress_warnings); }
 
         //! Parse a frame of the DCD
         virtual bool parseFrame(void);
 
     private:
 
+        // Header-only construction (see headerOnly())
+        DCD(const std::string& s, const bool read_first) : Trajectory(s), _natoms(0), _nframes(0),
+                                                            qcrys(std::vector<double>(6)), frame_size(0),
+                                                            first_frame_pos(0), swabbing(false) {
+            if (read_first)
+                initTrajectory();
+            else
+                readHeader();
+        }
+
         //! Read in the header from the stored stream
         void readHeader(void);
 
@@ -170,6 +206,9 @@ namespace loos {
         //! Update an AtomicGroup coordinates with the currently-read frame.
         virtual void updateGroupCoordsImpl(AtomicGroup& g);
 
+        //! Copy the current frame into a FloatFrame without converting to doubles
+        virtual void updateFrameCoordsImpl(FloatFrame& f);
+
 
 
         void allocateSpace(const int n);
@@ -0,0 +1,354 @@
+/*
+  This file is part of LOOS.
+
+  LOOS (Lightweight Object-Oriented Structure library)
+  Copyright (c) 2008, Tod D. Romo, Alan Grossfield
+  Department of Biochemistry and Biophysics
+  School of Medicine & Dentistry, University of Rochester
+
+  This package (LOOS) is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation under version 3 of the License.
+
+  This package is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#if defined(__linux__)
+#include <sys/sendfile.h>
+#endif
+
+#include <dcd_raw.hpp>
+#include <exceptions.hpp>
+#include <utils.hpp>
+
+
+// copy_file_range() first appeared in glibc 2.27
+#if defined(__linux__) && defined(__GLIBC__) && defined(__GLIBC_PREREQ)
+#if __GLIBC_PREREQ(2, 27)
+#define LOOS_HAS_COPY_FILE_RANGE
+#endif
+#endif
+
+
+namespace loos {
+
+  namespace {
+
+    // Size of the buffer used when the kernel can't copy for us (or
+    // when frames have to be byte-swapped)
+    const long raw_copy_buffer_size = 8 * 1024 * 1024;
+
+    // Offsets (in bytes) of the two frame counts in the DCD header
+    // (see fixdcd and DCDWriter::writeHeader())
+    const long header_nframes_offsets[2] = { 8, 20 };
+
+
+    void swab32(char* p, const long nwords) {
+      uint* q = reinterpret_cast<uint*>(p);
+      for (long i=0; i<nwords; ++i)
+        q[i] = swab(q[i]);
+    }
+
+    void swab64(char* p, const long nwords) {
+      double* q = reinterpret_cast<double*>(p);
+      for (long i=0; i<nwords; ++i)
+        q[i] = swab(q[i]);
+    }
+
+
+    // Reads an F77 record marker stored in a buffer
+    uint recordLength(const char* p, const bool swapped) {
+      uint n;
+      memcpy(&n, p, sizeof(n));
+      return(swapped ? swab(n) : n);
+    }
+
+
+    // Byte-swap the header records, in place.  The records must be
+    // parsed in the source byte-order, which is swapped if
+    // native is false.
+    void swabHeader(std::vector<char>& hdr, const bool native) {
+      long pos = 0;
+
+      // First record: "CORD" followed by the ICNTRL array
+      uint len = recordLength(&hdr[pos], !native);
+      swab32(&hdr[pos], 1);
+      swab32(&hdr[pos+8], (len - 4) / sizeof(uint));
+      pos += 4 + len;
+      swab32(&hdr[pos], 1);
+      pos += 4;
+
+      // Title record: a count followed by 80-char lines
+      len = recordLength(&hdr[pos], !native);
+      swab32(&hdr[pos], 2);
+      pos += 4 + len;
+      swab32(&hdr[pos], 1);
+      pos += 4;
+
+      // Number of atoms
+      swab32(&hdr[pos], 3);
+    }
+
+
+    // Byte-swap a frame, in place.  Crystal params are doubles,
+    // everything else is 4-byte words.
+    void swabFrame(char* p, const long frame_size, const bool has_box) {
+      long pos = 0;
+      if (has_box) {
+        swab32(p, 1);
+        swab64(p + 4, 6);
+        swab32(p + 52, 1);
+        pos = 56;
+      }
+      swab32(p + pos, (frame_size - pos) / sizeof(uint));
+    }
+
+
+    void readFully(const int fd, char* p, long n, long offset, const std::string& fname) {
+      while (n > 0) {
+        ssize_t k = pread(fd, p, n, offset);
+        if (k < 0 && errno == EINTR)
+          continue;
+        if (k <= 0)
+          throw(FileReadError(fname, "Unable to read raw DCD data"));
+        p += k;
+        n -= k;
+        offset += k;
+      }
+    }
+
+
+    void writeFully(const int fd, const char* p, long n, const std::string& fname) {
+      while (n > 0) {
+        ssize_t k = write(fd, p, n);
+        if (k < 0 && errno == EINTR)
+          continue;
+        if (k <= 0)
+          throw(FileWriteError(fname, "Unable to write raw DCD data"));
+        p += k;
+        n -= k;
+      }
+    }
+
+  }
+
+
+
+  RawDCD::RawDCD(const std::string& fname) : _filename(fname), _fd(-1) {
+    boost::shared_ptr<DCD> dcd = DCD::headerOnly(fname);
+
+    _natoms = dcd->natoms();
+    _header_frames = dcd->icntrl(0);
+    _has_box = dcd->hasCrystalParams();
+    _native = dcd->nativeFormat();
+    _timestep = dcd->timestep();
+    _first_frame_pos = dcd->firstFramePos();
+    _frame_size = dcd->frameSize();
+
+    _fd = open(fname.c_str(), O_RDONLY);
+    if (_fd < 0)
+      throw(FileOpenError(fname));
+
+    struct stat st;
+    if (fstat(_fd, &st) < 0)
+      throw(FileOpenError(fname, "Cannot determine size of DCD"));
+
+    long datasize = st.st_size - _first_frame_pos;
+    _nframes = datasize / _frame_size;
+    _partial = (datasize % _frame_size != 0);
+  }
+
+
+  RawDCD::~RawDCD() {
+    if (_fd >= 0)
+      ::close(_fd);
+  }
+
+
+  std::vector<char> RawDCD::header() const {
+    std::vector<char> hdr(_first_frame_pos);
+    readFully(_fd, &hdr[0], _first_frame_pos, 0, _filename);
+    return(hdr);
+  }
+
+
+
+  RawDCDWriter::RawDCDWriter(const std::string& fname, const RawDCD& tmpl, const ByteOrder order)
+    : _filename(fname), _fd(-1), _natoms(tmpl.natoms()), _nframes(0),
+      _has_box(tmpl.hasCrystalParams()), _frame_size(tmpl.frameSize())
+  {
+    switch(order) {
+    case NATIVE: _native = true; break;
+    case SWAPPED: _native = false; break;
+    default: _native = tmpl.nativeFormat();
+    }
+
+    _fd = open(fname.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0666);
+    if (_fd < 0)
+      throw(FileOpenError(fname));
+
+    writeHeader(tmpl);
+  }
+
+
+  RawDCDWriter::~RawDCDWriter() {
+    // Don't throw from the destructor...
+    try {
+      close();
+    }
+    catch (...) { }
+  }
+
+
+  void RawDCDWriter::writeHeader(const RawDCD& tmpl) {
+    std::vector<char> hdr = tmpl.header();
+    if (tmpl.nativeFormat() != _native)
+      swabHeader(hdr, tmpl.nativeFormat());
+
+    writeFully(_fd, &hdr[0], hdr.size(), _filename);
+  }
+
+
+  void RawDCDWriter::close() {
+    if (_fd < 0)
+      return;
+
+    uint n = _native ? _nframes : swab(_nframes);
+    for (uint i=0; i<2; ++i)
+      if (pwrite(_fd, &n, sizeof(n), header_nframes_offsets[i]) != sizeof(n))
+        throw(FileWriteError(_filename, "Unable to update frame count in DCD header"));
+
+    ::close(_fd);
+    _fd = -1;
+  }
+
+
+  // Let the kernel do the copying if possible...
+  void RawDCDWriter::copyBytes(const int infd, long offset, long n) {
+
+#if defined(LOOS_HAS_COPY_FILE_RANGE)
+    while (n > 0) {
+      loff_t off = offset;
+      ssize_t k = copy_file_range(infd, &off, _fd, 0, n, 0);
+      if (k <= 0)
+        break;
+      offset += k;
+      n -= k;
+    }
+#endif
+
+#if defined(__linux__)
+    while (n > 0) {
+      off_t off = offset;
+      ssize_t k = sendfile(_fd, infd, &off, n);
+      if (k <= 0)
+        break;
+      offset += k;
+      n -= k;
+    }
+#endif
+
+    if (n > 0) {
+      std::vector<char> buf(std::min(n, raw_copy_buffer_size));
+      while (n > 0) {
+        long k = std::min(n, static_cast<long>(buf.size()));
+        readFully(infd, &buf[0], k, offset, _filename);
+        writeFully(_fd, &buf[0], k, _filename);
+        offset += k;
+        n -= k;
+      }
+    }
+  }
+
+
+  void RawDCDWriter::copySwapped(const RawDCD& src, const uint first, const uint n) {
+    uint block = std::max(1l, raw_copy_buffer_size / _frame_size);
+    std::vector<char> buf(std::min(block, n) * _frame_size);
+
+    for (uint i=0; i<n; i += block) {
+      uint m = std::min(block, n - i);
+      long nbytes = m * _frame_size;
+      readFully(src.fd(), &buf[0], nbytes, src.firstFramePos() + (first + i) * _frame_size, src.filename());
+      for (uint j=0; j<m; ++j)
+        swabFrame(&buf[j * _frame_size], _frame_size, _has_box);
+      writeFully(_fd, &buf[0], nbytes, _filename);
+    }
+  }
+
+
+  void RawDCDWriter::copyFrames(const RawDCD& src, const uint first, const uint n) {
+    if (_fd < 0)
+      throw(FileWriteError(_filename, "Attempting to write to a closed DCD"));
+    if (src.natoms() != _natoms || src.hasCrystalParams() != _has_box)
+      throw(LOOSError("Cannot copy frames from " + src.filename() + " since it has a different layout than " + _filename));
+    if (first + n > src.nframes())
+      throw(FileReadError(src.filename(), "Requested DCD frames are out of range"));
+
+    if (n == 0)
+      return;
+
+    if (src.nativeFormat() == _native)
+      copyBytes(src.fd(), src.firstFramePos() + first * _frame_size, n * _frame_size);
+    else
+      copySwapped(src, first, n);
+
+    _nframes += n;
+  }
+
+
+  void RawDCDWriter::copyFrames(const RawDCD& src, const std::vector<uint>& frames) {
+    uint i = 0;
+    while (i < frames.size()) {
+      uint j = i + 1;
+      while (j < frames.size() && frames[j] == frames[j-1] + 1)
+        ++j;
+      copyFrames(src, frames[i], j - i);
+      i = j;
+    }
+  }
+
+
+
+  uint fixDCDHeader(const std::string& fname) {
+    uint n;
+    bool native;
+    {
+      RawDCD dcd(fname);
+      n = dcd.nframes();
+      native = dcd.nativeFormat();
+      if (n == dcd.headerFrames())
+        return(n);
+    }
+
+    int fd = open(fname.c_str(), O_WRONLY);
+    if (fd < 0)
+      throw(FileOpenError(fname));
+
+    uint datum = native ? n : swab(n);
+    for (uint i=0; i<2; ++i)
+      if (pwrite(fd, &datum, sizeof(datum), header_nframes_offsets[i]) != sizeof(datum)) {
+        ::close(fd);
+        throw(FileWriteError(fname, "Unable to update frame count in DCD header"));
+      }
+
+    ::close(fd);
+    return(n);
+  }
+
+}
@@ -0,0 +1,164 @@
+/*
+  This file is part of LOOS.
+
+  LOOS (Lightweight Object-Oriented Structure library)
+  Copyright (c) 2008, Tod D. Romo, Alan Grossfield
+  Department of Biochemistry and Biophysics
+  School of Medicine & Dentistry, University of Rochester
+
+  This package (LOOS) is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation under version 3 of the License.
+
+  This package is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+
+
+#if !defined(LOOS_DCD_RAW_HPP)
+#define LOOS_DCD_RAW_HPP
+
+#include <string>
+#include <vector>
+
+#include <boost/utility.hpp>
+
+#include <loos_defs.hpp>
+#include <dcd.hpp>
+
+
+namespace loos {
+
+
+  //! Record-level (undecoded) access to a DCD file
+  /**
+   * A RawDCD uses the DCD header parsing to find the layout of the
+   * file (header size, frame size, endianness) but never decodes any
+   * frames.  It is meant for manipulating DCDs as blocks of bytes,
+   * i.e. concatenating, extracting frames, repairing headers, or
+   * converting endianness (see RawDCDWriter).
+   *
+   * The number of frames reported is the number of complete frames
+   * actually present in the file, which may differ from what the
+   * header claims (see headerFrames()).
+   */
+  class RawDCD : public boost::noncopyable {
+  public:
+    explicit RawDCD(const std::string& fname);
+    ~RawDCD();
+
+    std::string filename() const { return(_filename); }
+
+    uint natoms() const { return(_natoms); }
+    //! Number of complete frames in the file
+    uint nframes() const { return(_nframes); }
+    //! Number of frames according to the header
+    uint headerFrames() const { return(_header_frames); }
+    //! True if the file ends with an incomplete frame
+    bool hasPartialFrame() const { return(_partial); }
+
+    bool hasCrystalParams() const { return(_has_box); }
+    bool nativeFormat() const { return(_native); }
+    float timestep() const { return(_timestep); }
+
+    long firstFramePos() const { return(_first_frame_pos); }
+    long frameSize() const { return(_frame_size); }
+
+    //! The raw header bytes (everything before the first frame)
+    std::vector<char> header() const;
+
+    //! True if frames from o can be copied into a file with this layout
+    bool compatible(const RawDCD& o) const {
+      return(_natoms == o._natoms && _has_box == o._has_box);
+    }
+
+    //! Underlying file descriptor (for RawDCDWriter)
+    int fd() const { return(_fd); }
+
+  private:
+    std::string _filename;
+    int _fd;
+    uint _natoms, _nframes, _header_frames;
+    bool _partial, _has_box, _native;
+    float _timestep;
+    long _first_frame_pos, _frame_size;
+  };
+
+
+
+  //! Writes a DCD by copying raw frame records from RawDCDs
+  /**
+   * The header is taken from a template RawDCD.  Frames are then
+   * copied from any compatible RawDCD (same number of atoms and box
+   * information) as blocks of bytes.  On Linux, the copy is done in
+   * the kernel (copy_file_range() or sendfile()), otherwise large
+   * buffered reads/writes are used.  Frames are only touched if their
+   * endianness must be changed.
+   *
+   * The frame count in the header is updated when the writer is
+   * closed (or destroyed).
+   *
+   * Example (concatenation):
+   * \code
+   * RawDCD a("a.dcd"), b("b.dcd");
+   * RawDCDWriter out("ab.dcd", a);
+   * out.copyFrames(a);
+   * out.copyFrames(b);
+   * \endcode
+   */
+  class RawDCDWriter : public boost::noncopyable {
+  public:
+    //! Byte-order of the output file
+    enum ByteOrder { SAME_AS_TEMPLATE, NATIVE, SWAPPED };
+
+    RawDCDWriter(const std::string& fname, const RawDCD& tmpl, const ByteOrder order = SAME_AS_TEMPLATE);
+    ~RawDCDWriter();
+
+    //! Copy all frames from src
+    void copyFrames(const RawDCD& src) { copyFrames(src, 0, src.nframes()); }
+
+    //! Copy n contiguous frames from src, starting with first
+    void copyFrames(const RawDCD& src, const uint first, const uint n);
+
+    //! Copy the frames listed (in order), coalescing contiguous runs
+    void copyFrames(const RawDCD& src, const std::vector<uint>& frames);
+
+    uint framesWritten() const { return(_nframes); }
+
+    //! True if the output is in native byte-order
+    bool nativeFormat() const { return(_native); }
+
+    //! Writes the final frame count into the header and closes the file
+    void close();
+
+  private:
+    void writeHeader(const RawDCD& tmpl);
+    void copyBytes(const int infd, long offset, long n);
+    void copySwapped(const RawDCD& src, const uint first, const uint n);
+
+    std::string _filename;
+    int _fd;
+    uint _natoms, _nframes;
+    bool _has_box, _native;
+    long _frame_size;
+  };
+
+
+  //! Rewrites the frame count in a DCD header to match the file, in place
+  /**
+   * Returns the number of frames now stored in the header.  Only the
+   * header is touched.
+   */
+  uint fixDCDHeader(const std::string& fname);
+
+}
+
+
+#endif
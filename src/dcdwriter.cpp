@@ -106,7 +106,10 @@ namespace loos {
 
 
 
-  void DCDWriter::writeFrame(const AtomicGroup& grp) {
+  // Checks that a frame matches what has already been written and,
+  // if nothing has been written yet, puts the header in place
+
+  void DCDWriter::prepareFrames(const AtomicGroup& grp) {
 
     if (_natoms == 0) {   // Assume this is the first frame being written...
       _natoms = grp.size();
@@ -122,15 +125,31 @@ namespace loos {
 
     }
 
-    if (_current >= _nsteps) {
+    if (!_header_written && !appending_)
+      writeHeader();
+  }
+
+
+  // Once frames have been written past the end of the DCD as described
+  // by the header, extends the header to cover them.  This is done
+  // after the coordinates are written, so the header never counts
+  // frames that are not in the file.
+
+  void DCDWriter::extendHeader() {
+    stream_->flush();
+    if (_current > _nsteps) {
       stream_->seekp(0);
-      ++_nsteps;
+      _nsteps = _current;
       writeHeader();
       stream_->seekp(0, std::ios_base::end);
       if (stream_->fail())
         throw(FileWriteError(_filename, "Error while re-writing DCD header"));
+      stream_->flush();
     }
+  }
+
 
+  void DCDWriter::writeFrameData(const AtomicGroup& grp) {
     if (_has_box)
       writeBox(grp.periodicBox());
 
@@ -148,17 +167,62 @@ namespace loos {
     writeF77Line((char *)data, _natoms * sizeof(float));
 
     delete[] data;
-
-    stream_->flush();
     ++_current;
   }
 
 
+
+  void DCDWriter::writeFrame(const AtomicGroup& grp) {
+    prepareFrames(grp);
+    writeFrameData(grp);
+    extendHeader();
+  }
+
+
   void DCDWriter::writeFrames(const std::vector<AtomicGroup>& grps) {
     std::vector<AtomicGroup>::const_iterator i;
 
+    if (grps.empty())
+      return;
+
+    // Check every frame before writing any, then extend the header
+    // once for the whole set
+    for (i= grps.begin(); i != grps.end(); i++)
+      prepareFrames(*i);
+
     for (i= grps.begin(); i != grps.end(); i++)
-      writeFrame(*i);
+      writeFrameData(*i);
+
+    extendHeader();
+  }
+
+
+  void DCDWriter::writeFrames(AtomicGroup& grp, const double* xyz, const uint nframes) {
+    if (nframes == 0)
+      return;
+
+    prepareFrames(grp);
+
+    GCoord box;
+    if (_has_box)
+      box = grp.periodicBox();
+
+    std::vector<float> data(_natoms);
+    for (uint f=0; f<nframes; ++f) {
+      const double* p = xyz + static_cast<ulong>(3) * _natoms * f;
+
+      if (_has_box)
+        writeBox(box);
+
+      for (uint k=0; k<3; ++k) {
+        for (uint i=0; i<_natoms; ++i)
+          data[i] = p[3*i+k];
+        writeF77Line((char *)&data[0], _natoms * sizeof(float));
+      }
+    }
+
+    _current += nframes;
+    extendHeader();
   }
 
   void DCDWriter::prepareToAppend() {
@@ -204,6 +204,16 @@ namespace loos {
     //! Same as writeFrame(), but writes out the vector of frames...
     void writeFrames(const std::vector<AtomicGroup>& grps);
 
+    //! Writes a block of frames straight from a packed coordinate buffer
+    /**
+     * See TrajectoryWriter::writeFrames().  The header is extended
+     * once, after the whole block has been written.  The coordinates
+     * are converted directly from \a xyz, and \a grp is only used for
+     * the atom count and the periodic box (so its coordinates are left
+     * untouched).
+     */
+    void writeFrames(AtomicGroup& grp, const double* xyz, const uint nframes);
+
     void writeHeader(void);
 
     uint framesWritten(void) const { return(_current); }
@@ -212,6 +222,9 @@ namespace loos {
     void writeF77Line(const char* const data, const unsigned int len); 
     std::string fixStringSize(const std::string& s, const unsigned int size);
     void writeBox(const GCoord& box);
+    void prepareFrames(const AtomicGroup& grp);
+    void writeFrameData(const AtomicGroup& grp);
+    void extendHeader();
 
     void prepareToAppend();
 
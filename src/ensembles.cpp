@@ -28,6 +28,7 @@
 #include <AtomicGroup.hpp>
 #include <Trajectory.hpp>
 #include <alignment.hpp>
+#include <CompressedEnsemble.hpp>
 
 namespace loos {
 
@@ -147,6 +148,16 @@ namespace loos {
   }
 
 
+  void applyTransforms(std::vector< std::vector<double> >& ensemble, const std::vector<XForm>& xforms) {
+    uint n = ensemble.size();
+    if (n != xforms.size())
+      throw(std::runtime_error("Mismatch in the size of the ensemble and the transformations"));
+
+    for (uint i=0; i<n; ++i)
+      xforms[i].transform(ensemble[i]);
+  }
+
+
 
   void readTrajectory(std::vector<AtomicGroup>& ensemble, const AtomicGroup& model, pTraj trajectory) {
     AtomicGroup clone = model.copy();
@@ -297,6 +308,44 @@ namespace loos {
 
 
 
+  void appendCoords(CompressedEnsemble& ensemble, AtomicGroup& model, pTraj& traj, const std::vector<uint>& indices, const bool updates, const bool center) {
+
+    uint l = indices.size();
+    uint n = model.size();
+    ensemble.reserve(ensemble.size() + l, n);
+
+    PercentProgressWithTime watcher;
+    PercentTrigger trigger(0.1);
+    ProgressCounter<PercentTrigger, EstimatingCounter> slayer(trigger, EstimatingCounter(l));
+
+    if (updates) {
+      slayer.attach(&watcher);
+      slayer.start();
+    }
+
+    std::vector<double> v(3*n);
+    for (uint j=0; j<l; ++j) {
+      traj->readFrame(indices[j]);
+      traj->updateGroupCoords(model);
+      if (updates)
+        slayer.update();
+      for (uint i=0; i<n; ++i) {
+        GCoord c = model[i]->coords();
+        v[i*3] = c.x();
+        v[i*3+1] = c.y();
+        v[i*3+2] = c.z();
+      }
+      if (center)
+        alignment::centerAtOrigin(v);
+      ensemble.append(v);
+    }
+
+    if (updates)
+      slayer.finish();
+  }
+
+
+
 
   
 }
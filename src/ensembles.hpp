@@ -39,6 +39,7 @@
 
 namespace loos {
   class XForm;
+  class CompressedEnsemble;
 
   //! Compute the average structure of a set of AtomicGroup objects
   AtomicGroup averageStructure(const std::vector<AtomicGroup>& ensemble);
@@ -67,6 +68,9 @@ namespace loos {
 
   void applyTransforms(std::vector<AtomicGroup>& ensemble, std::vector<XForm>& xforms);
 
+  //! Apply the ith transform to the ith structure in the ensemble (packed coordinates)
+  void applyTransforms(std::vector< std::vector<double> >& ensemble, const std::vector<XForm>& xforms);
+
   void readTrajectory(std::vector<AtomicGroup>& ensemble, const AtomicGroup& model, pTraj trajectory);
   void readTrajectory(std::vector<AtomicGroup>& ensemble, const AtomicGroup& model, pTraj trajectory, std::vector<uint>& frames);
 
@@ -103,6 +107,19 @@ namespace loos {
                                                 pTraj& traj,
                                                 const std::vector<uint>& indices,
                                                 const bool updates);
+
+
+#if !defined(SWIG)
+
+  //! Appends the given frames to a CompressedEnsemble, optionally centering each one first
+  void appendCoords(CompressedEnsemble& ensemble,
+                    AtomicGroup& model,
+                    pTraj& traj,
+                    const std::vector<uint>& indices,
+                    const bool updates,
+                    const bool center = false);
+
+#endif   // !defined(SWIG)
 };
 
 
@@ -73,8 +73,25 @@
 #include <tinkerxyz.hpp>
 
 #include <Trajectory.hpp>
+#include <TrajectoryInfo.hpp>
+#include <FrameIndexCache.hpp>
 #include <dcd.hpp>
 #include <dcd_utils.hpp>
+#include <dcd_raw.hpp>
+#include <FloatFrame.hpp>
+#include <DistanceKernels.hpp>
+#include <TrajectoryIterator.hpp>
+#include <AnalysisServer.hpp>
+#include <AnalysisClient.hpp>
+#include <ProcessPool.hpp>
+#include <AnalysisKernels.hpp>
+#include <ConvexHull2D.hpp>
+#include <BondOrientationKernel.hpp>
+#include <CachedTrajectory.hpp>
+#include <CompressedEnsemble.hpp>
+#include <FrameFeatures.hpp>
+#include <PairDistanceHistogram.hpp>
+#include <ModeProjection.hpp>
 #include <MultiTraj.hpp>
 
 #include <trajwriter.hpp>
@@ -85,6 +102,7 @@
 
 #if defined(HAS_NETCDF)
 #include <amber_netcdf.hpp>
+#include <amber_netcdf_writer.hpp>
 #endif
 
 #include <amber_rst.hpp>
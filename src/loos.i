@@ -65,6 +65,7 @@ namespace loos {
 %include "pdb_remarks.i"
 %include "XForm.i"
 %include "AtomicGroup.i"
+%include "FloatFrame.i"
 %include "Trajectory.i"
 %include "utils.i"
 %include "cryst.i"
@@ -78,7 +79,12 @@ namespace loos {
 %include "xtcwriter.i"
 %include "sfactories.i"
 %include "alignment.i"
+%include "TrajectoryIterator.i"
 %include "gro.i"
 %include "utils_structural.i"
 %include "Weights.i"
 %include "RnaSuite.i"
+%include "AnalysisKernels.i"
+%include "ConvexHull2D.i"
+%include "CachedTrajectory.i"
+%include "PairDistanceHistogram.i"
@@ -126,6 +126,9 @@ namespace loos {
   class TrajectoryWriter;
   class DCDWriter;
   class XTCWriter;
+#if defined(HAS_NETCDF)
+  class AmberNetcdfWriter;
+#endif
 
   // Trajectory and subclasses...
   class Atom;
@@ -39,6 +39,7 @@
 
 #if defined(HAS_NETCDF)
 #include <amber_netcdf.hpp>
+#include <amber_netcdf_writer.hpp>
 #endif
 
 #include <amber_rst.hpp>
@@ -126,27 +127,28 @@ namespace loos {
       std::string suffix;
       std::string type;
       pTraj (*creator)(const std::string& fname, const AtomicGroup& model);
+      TrajectoryInfo (*prober)(const std::string& fname, const AtomicGroup& model);
     };
 
     TrajectoryNameBindingType trajectory_name_bindings[] = {
 #if defined(HAS_NETCDF)
-      { "crd", "Amber Traj (NetCDF/Amber)", &AmberNetcdf::create},
-      { "mdcrd", "Amber Traj (NetCDF/Amber)", &AmberNetcdf::create},
-      { "nc", "Amber Traj (NetCDF)", &AmberNetcdf::create},
-      { "netcdf", "Amber Traj (NetCDF)", &AmberNetcdf::create},
+      { "crd", "Amber Traj (NetCDF/Amber)", &AmberNetcdf::create, &AmberNetcdf::probe},
+      { "mdcrd", "Amber Traj (NetCDF/Amber)", &AmberNetcdf::create, &AmberNetcdf::probe},
+      { "nc", "Amber Traj (NetCDF)", &AmberNetcdf::create, &AmberNetcdf::probe},
+      { "netcdf", "Amber Traj (NetCDF)", &AmberNetcdf::create, &AmberNetcdf::probe},
 #else
-      { "crd", "Amber Traj", &AmberTraj::create},
-      { "mdcrd", "Amber Traj", &AmberTraj::create},
+      { "crd", "Amber Traj", &AmberTraj::create, &AmberTraj::probe},
+      { "mdcrd", "Amber Traj", &AmberTraj::create, &AmberTraj::probe},
 #endif
-      { "inpcrd", "Amber Restart", &AmberRst::create},
-      { "rst", "Amber Restart", &AmberRst::create},
-      { "rst7", "Amber Restart", &AmberRst::create},
-      { "dcd", "CHARMM/NAMD DCD", &DCD::create},
-      { "pdb", "Concatenated PDB", &CCPDB::create},
-      { "trr", "Gromacs TRR", &TRR::create},
-      { "xtc", "Gromacs XTC", &XTC::create},
-      { "arc", "Tinker ARC", &TinkerArc::create},
-      { "", "", 0}
+      { "inpcrd", "Amber Restart", &AmberRst::create, 0},
+      { "rst", "Amber Restart", &AmberRst::create, 0},
+      { "rst7", "Amber Restart", &AmberRst::create, 0},
+      { "dcd", "CHARMM/NAMD DCD", &DCD::create, &DCD::probe},
+      { "pdb", "Concatenated PDB", &CCPDB::create, 0},
+      { "trr", "Gromacs TRR", &TRR::create, &TRR::probe},
+      { "xtc", "Gromacs XTC", &XTC::create, &XTC::probe},
+      { "arc", "Tinker ARC", &TinkerArc::create, 0},
+      { "", "", 0, 0}
     };
 
 
@@ -193,6 +195,49 @@ namespace loos {
   }
 
 
+  TrajectoryInfo trajectoryInfoFrom(const Trajectory& traj) {
+    TrajectoryInfo info;
+
+    info.filename = traj.filename();
+    info.format = traj.description();
+    info.natoms = traj.natoms();
+    info.nframes = traj.nframes();
+    info.timestep = traj.timestep();
+    info.periodic = traj.hasPeriodicBox();
+    info.velocities = traj.hasVelocities();
+
+    return(info);
+  }
+
+
+  TrajectoryInfo probeTrajectory(const std::string& filename, const std::string& filetype, const AtomicGroup& g) {
+    for (internal::TrajectoryNameBindingType* p = internal::trajectory_name_bindings; p->creator != 0; ++p) {
+      if (p->suffix == filetype) {
+        if (p->prober != 0)
+          return((*(p->prober))(filename, g));
+
+        // No metadata-only path for this format, so fall back to opening it
+        pTraj traj = (*(p->creator))(filename, g);
+        return(trajectoryInfoFrom(*traj));
+      }
+    }
+
+    throw(std::runtime_error("Error- unknown input trajectory file type '" + filetype + "' for file '" + filename + "'.  Try --help to see available types."));
+  }
+
+
+  TrajectoryInfo probeTrajectory(const std::string& filename, const AtomicGroup& g) {
+    boost::tuple<std::string, std::string> names = splitFilename(filename);
+    std::string suffix = boost::get<1>(names);
+
+    if (suffix.empty())
+      throw(std::runtime_error("Error- trajectory filename must end in an extension or the filetype must be explicitly specified"));
+
+    boost::to_lower(suffix);
+    return(probeTrajectory(filename, suffix, g));
+  }
+
+
   namespace internal {
     struct OutputTrajectoryNameBindingType {
       std::string suffix;
@@ -203,6 +248,10 @@ namespace loos {
     OutputTrajectoryNameBindingType output_trajectory_name_bindings[] = {
       { "dcd", "NAMD DCD", &DCDWriter::create},
       { "xtc", "Gromacs XTC (compressed trajectory)", &XTCWriter::create},
+#if defined(HAS_NETCDF)
+      { "nc", "Amber Traj (NetCDF)", &AmberNetcdfWriter::create},
+      { "netcdf", "Amber Traj (NetCDF)", &AmberNetcdfWriter::create},
+#endif
       { "", "", 0}
     };
 
@@ -32,6 +32,7 @@
 #include <string>
 
 #include <loos_defs.hpp>
+#include <TrajectoryInfo.hpp>
 
 namespace loos {
 
@@ -73,6 +74,25 @@ namespace loos {
   pTraj createTrajectory(const std::string&, const std::string&, const AtomicGroup&);
 
 
+  //! Factory function for reading trajectory metadata
+  /*!
+   * Like createTrajectory(), this will determine the filetype by
+   * examining the suffix of the file.  Rather than returning a
+   * Trajectory, it returns a TrajectoryInfo describing the file.
+   * Formats that support it will only read their headers (no
+   * coordinates are decoded and the first frame is not cached).
+   * XTC and TRR store no frame count, so they read every frame header
+   * to count (and index) the frames, unless the index is already in
+   * the FrameIndexCache.  Other formats fall back to opening the
+   * trajectory normally.
+   *
+   * The model is only used by formats that do not store the number
+   * of atoms (e.g. Amber ASCII trajectories).
+   */
+  TrajectoryInfo probeTrajectory(const std::string&, const AtomicGroup&);
+  TrajectoryInfo probeTrajectory(const std::string&, const std::string&, const AtomicGroup&);
+
+
   pTrajectoryWriter createOutputTrajectory(const std::string& filename, const std::string& type, const bool append = false);
   pTrajectoryWriter createOutputTrajectory(const std::string& filename, const bool append = false);
 
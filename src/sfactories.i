@@ -21,7 +21,10 @@
 
 %header %{
   #include <loos_defs.hpp>
+  #include <TrajectoryInfo.hpp>
  %}
 
+%include "TrajectoryInfo.hpp"
+
 
 %include "sfactories.hpp"
@@ -73,7 +73,7 @@ namespace loos {
      * the TrajectoryWriter object.
      */
     TrajectoryWriter(std::iostream* s, const bool append = false)
-      : _filename("stream"), appending_(append), delete_(false) {}
+      : stream_(s), _filename("stream"), appending_(append), delete_(false) {}
 
 
     virtual ~TrajectoryWriter() {
@@ -103,6 +103,38 @@ namespace loos {
       writeFrame(model);
     }
 
+    //! Write a block of frames from a packed coordinate buffer
+    /**
+     * \a xyz holds \a nframes frames back-to-back, each with the x, y,
+     * and z of every atom in \a model (so frame f starts at
+     * xyz[3 * model.size() * f]).  The default copies each frame into
+     * \a model and calls writeFrame(), so \a model is left with the
+     * coordinates of the last frame.  Formats that can write straight
+     * from the buffer (and update their metadata once per block rather
+     * than once per frame) should override this.
+     */
+    virtual void writeFrames(AtomicGroup& model, const double* xyz, const uint nframes) {
+      uint n = model.size();
+      for (uint f=0; f<nframes; ++f) {
+        const double* p = xyz + static_cast<ulong>(3) * n * f;
+        for (uint i=0; i<n; ++i)
+          model[i]->coords(GCoord(p[3*i], p[3*i+1], p[3*i+2]));
+        writeFrame(model);
+      }
+    }
+
+    //! Writes out anything the writer is holding back
+    /**
+     * Formats that buffer frames (e.g. AmberNetcdfWriter) write them
+     * out here.  Tools should call this after their last frame, so a
+     * failed write is reported rather than lost when the writer is
+     * destroyed.
+     */
+    virtual void flush() {
+      if (stream_)
+        stream_->flush();
+    }
+
     //! Can format write step on a per-frame basis?
     virtual bool hasFrameStep() const { return(false); }
 
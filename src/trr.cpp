@@ -29,6 +29,7 @@
 
 
 #include <trr.hpp>
+#include <FrameIndexCache.hpp>
 
 
 namespace loos {
@@ -115,8 +116,10 @@ namespace loos {
 
 
 	// Initialize the object, along with scanning file for frames to
-	// build the frame index, and finally caches the first frame.
-	void TRR::init(void) {
+	// build the frame index, and finally caches the first frame.  The
+	// index comes from the FrameIndexCache if this file has been
+	// scanned before.
+	void TRR::init(const bool read_first, const bool use_cache) {
 		Header h;
 		h.natoms = 0;
 
@@ -124,11 +127,26 @@ namespace loos {
 		// frame, we track the max and then reserve that space...
 		int maxatoms = 0;
 
+		ifs->seekg(0, std::ios_base::end);
+		file_size_ = ifs->tellg();
 		rewindImpl();
 		frame_indices.clear();
 
+		FrameIndexCache cache(use_cache ? _filename : std::string(), "trr");
+		FrameIndex index;
+		bool cached = cache.lookup(index);
+		if (cached) {
+			frame_indices = index.offsets;
+			maxatoms = index.natoms;
+
+			// The scan leaves h with the last frame's header
+			(xdr_file.get())->seekg(frame_indices.back());
+			if (!readHeader(h))
+				throw(FileReadError(_filename, "Cannot read TRR header"));
+		}
+
 		size_t frame_start = (xdr_file.get())->tellg();
-		while (readHeader(h)) {
+		while (!cached && readHeader(h)) {
 			frame_indices.push_back(frame_start);
 			if (h.natoms > maxatoms)
 				maxatoms = h.natoms;
@@ -146,19 +164,45 @@ namespace loos {
 			frame_start = (xdr_file.get())->tellg();
 		}
 
+		if (!cached) {
+			index.natoms = maxatoms;
+			index.offsets = frame_indices;
+			cache.store(index);
+		}
+
 		coords_.reserve(maxatoms);
 		velo_.reserve(maxatoms);
 		forc_.reserve(maxatoms);
 
 		rewindImpl();
 
-		parseFrame();
-		cached_first = true;
+		if (read_first) {
+			parseFrame();
+			cached_first = true;
+		}
 		hdr_ = h;
 
 	}
 
+
+	TrajectoryInfo TRR::probe(const std::string& fname, const AtomicGroup& model) {
+		TRR trr(fname, false);
+
+		TrajectoryInfo info;
+		info.filename = fname;
+		info.format = trr.description();
+		info.natoms = trr.natoms();
+		info.nframes = trr.nframes();
+		info.timestep = trr.timestep();
+		info.periodic = trr.hasPeriodicBox();
+		info.velocities = trr.hasVelocities();
+		info.precision = trr.isDouble() ? sizeof(double) : sizeof(float);
+
+		return(info);
+	}
+
 	void TRR::updateGroupCoordsImpl(AtomicGroup& g) {
+		checkDecoded(COORDINATES, "coordinates");
 
 		for (AtomicGroup::iterator i = g.begin(); i != g.end(); ++i) {
 			uint idx = (*i)->index();
@@ -172,6 +216,7 @@ namespace loos {
 	}
 
 	void TRR::updateGroupVelocitiesImpl(AtomicGroup& g) {
+		checkDecoded(VELOCITIES, "velocities");
 
 		for (AtomicGroup::iterator i = g.begin(); i != g.end(); ++i) {
 			uint idx = (*i)->index();
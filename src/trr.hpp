@@ -42,6 +42,7 @@
 #include <xdr.hpp>
 #include <AtomicGroup.hpp>
 #include <Trajectory.hpp>
+#include <TrajectoryInfo.hpp>
 
 #include <boost/format.hpp>
 
@@ -73,6 +74,17 @@ namespace loos {
 	 * Finally, note that GROMACS stores data in nm whereas LOOS uses
 	 * angstroms, so coordinate/box data will be automatically scaled by
 	 * LOOS.
+	 *
+	 * Not every analysis needs every section of a TRR frame.  The
+	 * sections that are decoded can be restricted with sections()
+	 * (see TRR::Section).  Sections that are not requested are
+	 * skipped over without being read, so, for example, reading only
+	 * the coordinates from a TRR that also has velocities and forces
+	 * touches about a third of the data.  The box is always read.
+	 * \code
+	 * TRR trr("traj.trr");
+	 * trr.sections(TRR::COORDINATES);
+	 * \endcode
 	 */
 
 	class TRR : public Trajectory {
@@ -104,15 +116,25 @@ namespace loos {
 		};
 
 	public:
-		explicit TRR(const std::string& s) : Trajectory(s), xdr_file(ifs.get()) {
+		//! Sections of a TRR frame that may be decoded (see sections())
+		enum Section {
+			VIRIAL = 1,
+			PRESSURE = 2,
+			COORDINATES = 4,
+			VELOCITIES = 8,
+			FORCES = 16,
+			ALL_SECTIONS = 31
+		};
+
+		explicit TRR(const std::string& s) : Trajectory(s), xdr_file(ifs.get()), sections_(ALL_SECTIONS), file_size_(0) {
 			init();
 		}
 
-		explicit TRR(const char* p) : Trajectory(p), xdr_file(ifs.get()) {
+		explicit TRR(const char* p) : Trajectory(p), xdr_file(ifs.get()), sections_(ALL_SECTIONS), file_size_(0) {
 			init();
 		}
-		explicit TRR(std::istream& is) : Trajectory(is), xdr_file(ifs.get()) {
-			init();
+		explicit TRR(std::istream& is) : Trajectory(is), xdr_file(ifs.get()), sections_(ALL_SECTIONS), file_size_(0) {
+			init(true, false);
 		}
 
 		std::string description() const { return("Gromacs TRR"); }
@@ -120,6 +142,9 @@ namespace loos {
 			return(pTraj(new TRR(fname)));
 		}
 
+		//! Return metadata by scanning the frame headers only
+		static TrajectoryInfo probe(const std::string& fname, const AtomicGroup& model);
+
 
 		uint natoms(void) const { return(hdr_.natoms); }
 
@@ -141,12 +166,22 @@ namespace loos {
 		std::vector<GCoord> forces(void) const { return(forc_); }
 
 		bool isDouble(void) const { return(hdr_.bDouble); }
+
 		bool hasVirial(void) const { return(hdr_.vir_size != 0); }
 		bool hasPressure(void) const { return(hdr_.pres_size != 0); }
 		bool hasCoords(void) const { return(hdr_.x_size != 0); }
 		bool hasVelocities(void) const { return(hdr_.v_size != 0); }
 		bool hasForces(void) const { return(hdr_.f_size != 0); }
 
+		//! Select which sections are decoded (a bitwise-or of TRR::Section values)
+		/**
+		 * This takes effect with the next frame read.  The has*()
+		 * functions still report what is present in the file, but the
+		 * data for a section that was not decoded will be empty.
+		 */
+		void sections(const uint mask) { sections_ = mask; }
+		uint sections(void) const { return(sections_); }
+
 		double time(void) const { return( hdr_.bDouble ? hdr_.td : hdr_.tf ); }
 		double lambda(void) const { return( hdr_.bDouble ? hdr_.lambdad : hdr_.lambdaf); }
 
@@ -164,23 +199,39 @@ namespace loos {
 
 
 	private:
-		void init(void);
+		// Only builds the frame index (see probe())
+		TRR(const std::string& s, const bool read_first) : Trajectory(s), xdr_file(ifs.get()), sections_(ALL_SECTIONS), file_size_(0) {
+			init(read_first);
+		}
+
+		// Streams have no file to key the index cache on
+		void init(const bool read_first = true, const bool use_cache = true);
 		int floatSize(Header& h);
 		bool readHeader(Header& h);
 
 		// These simplify reading of blocks of data from the TRR file.
 		// Templatized since GROMACS can store data in either single or
-		// double-precision...
+		// double-precision.  Each precision has its own scratch
+		// buffer, which is reused between frames.
+
+		std::vector<float>& scratch(float*) { return(fbuf_); }
+		std::vector<double>& scratch(double*) { return(dbuf_); }
 
 		template<typename T>
-		void readBlock(std::vector<double>& v, const uint n, const std::string& msg) {
-			T buf[n];
-			uint i = xdr_file.read(buf, n);
-			if (i != n)
+		const T* readScratch(const uint n, const std::string& msg) {
+			std::vector<T>& buf = scratch(static_cast<T*>(0));
+			if (buf.size() < n)
+				buf.resize(n);
+
+			if (xdr_file.read(buf.data(), n) != n)
 				throw(FileReadError(_filename, "Unable to read " + msg));
+			return(buf.data());
+		}
 
-			for (i=0; i<n; ++i)
-				v.push_back(buf[i]);
+		template<typename T>
+		void readBlock(std::vector<double>& v, const uint n, const std::string& msg) {
+			const T* buf = readScratch<T>(n, msg);
+			v.assign(buf, buf + n);
 		}
 
 
@@ -188,18 +239,36 @@ namespace loos {
 		// into GCoords, scaling from nm to Angstroms along the way...
 		template<typename T>
 		void readBlock(std::vector<GCoord>& v, const uint n, const std::string& msg) {
-			T* buf = new T[n];
-			if (buf == 0)
-				throw(std::runtime_error("Out of memory"));
+			const T* buf = readScratch<T>(n, msg);
+			v.resize(n / DIM);
+			for (uint i=0, j=0; i<n; i += DIM, ++j)
+				v[j] = GCoord(buf[i], buf[i+1], buf[i+2]) * 10.0;
+		}
+
+
+		// Seek past a section that isn't wanted.  Seeking past the end
+		// of the file does not fail, so a truncated section is caught
+		// by checking against the file size.
+		template<typename T>
+		void skipBlock(const uint n, const std::string& msg) {
+			std::istream* is = xdr_file.get();
+			std::streamoff len = static_cast<std::streamoff>(n) * sizeof(T);
+			std::streamoff pos = is->tellg();
+			if (is->fail() || pos + len > file_size_)
+				throw(FileReadError(_filename, "Unable to skip " + msg));
+			is->seekg(len, std::ios_base::cur);
+		}
 
-			if (xdr_file.read(buf, n) != n) {
-				delete[] buf;
-				throw(FileReadError(_filename, "Unable to read " + msg));
-			}
-			for (uint i=0; i<n; i += DIM)
-				v.push_back(GCoord(buf[i], buf[i+1], buf[i+2]) * 10.0);
 
-			delete[] buf;
+		// Reads a section if present, skipping it if it's not wanted
+		template<typename T, typename V>
+		void readSection(V& v, const int size, const uint section, const uint n, const std::string& msg) {
+			if (!size)
+				return;
+			if (sections_ & section)
+				readBlock<T>(v, n, msg);
+			else
+				skipBlock<T>(n, msg);
 		}
 
 
@@ -221,28 +290,30 @@ namespace loos {
 				// to angstroms
 			}
 
-			if (hdr_.vir_size)
-				readBlock<T>(vir_, DIM*DIM, "virial");
-			if (hdr_.pres_size)
-				readBlock<T>(pres_, DIM*DIM, "pressure");
-
-			if (hdr_.x_size)
-				readBlock<T>(coords_, hdr_.natoms * DIM, "Coordinates");
-
-			if (hdr_.v_size)
-				readBlock<T>(velo_, hdr_.natoms * DIM, "Velocities");
-
-			if (hdr_.f_size)
-				readBlock<T>(forc_, hdr_.natoms * DIM, "Forces");
-
+			readSection<T>(vir_, hdr_.vir_size, VIRIAL, DIM*DIM, "virial");
+			readSection<T>(pres_, hdr_.pres_size, PRESSURE, DIM*DIM, "pressure");
+			readSection<T>(coords_, hdr_.x_size, COORDINATES, hdr_.natoms * DIM, "Coordinates");
+			readSection<T>(velo_, hdr_.v_size, VELOCITIES, hdr_.natoms * DIM, "Velocities");
+			readSection<T>(forc_, hdr_.f_size, FORCES, hdr_.natoms * DIM, "Forces");
 
 			return(! ((xdr_file.get())->fail() || (xdr_file.get())->eof()) );
 		}
 
+		void checkDecoded(const uint section, const std::string& what) const {
+			if (!(sections_ & section))
+				throw(LOOSError("TRR " + what + " were requested but are not being decoded (see TRR::sections())"));
+		}
+
 		void rewindImpl(void) { ifs->clear(); ifs->seekg(0, std::ios_base::beg); }
 		void seekNextFrameImpl(void) { }
 		void seekFrameImpl(uint);
 		void updateGroupCoordsImpl(AtomicGroup& g);
+		void updateFrameCoordsImpl(FloatFrame& f) {
+			checkDecoded(COORDINATES, "coordinates");
+			f.copyFromFrame(coords_);
+			if (hdr_.box_size)
+				f.periodicBox(box);
+		}
 		void updateGroupVelocitiesImpl(AtomicGroup& g);
 		std::vector<GCoord> velocitiesImpl() const { return(velo_); }
 
@@ -260,6 +331,11 @@ namespace loos {
 		std::vector<GCoord> velo_;
 		std::vector<GCoord> forc_;
 
+		uint sections_;
+		std::streamoff file_size_;
+		std::vector<float> fbuf_;
+		std::vector<double> dbuf_;
+
 		Header hdr_;
 	};
 
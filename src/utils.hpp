@@ -289,6 +289,41 @@ namespace loos {
     return(parseRangeList<T>(os.str(), endpoint));
   }
 
+  //! Formats a list of indices as Octave-style ranges (the inverse of parseRangeList)
+  /**
+   * Runs of consecutive values are written as start:stop, and runs of
+   * three or more evenly spaced values as start:step:stop, so the
+   * result can be passed back to parseRangeList() (e.g. as a --range
+   * option).  The list is sorted and duplicates are removed first.
+   */
+  template<typename T>
+  std::string rangeListAsString(const std::vector<T>& list) {
+    std::vector<T> v(list);
+    std::sort(v.begin(), v.end());
+    v.erase(std::unique(v.begin(), v.end()), v.end());
+
+    std::ostringstream oss;
+    for (typename std::vector<T>::size_type i = 0; i < v.size(); ) {
+      typename std::vector<T>::size_type j = i;
+      T step = (i+1 < v.size()) ? v[i+1] - v[i] : 1;
+      while (j+1 < v.size() && v[j+1] - v[j] == step)
+        ++j;
+
+      if (i > 0)
+        oss << ",";
+      if (j == i || (step != 1 && j == i+1)) {
+        oss << v[i];
+        j = i;
+      } else if (step == 1)
+        oss << v[i] << ":" << v[j];
+      else
+        oss << v[i] << ":" << step << ":" << v[j];
+      i = j + 1;
+    }
+    return(oss.str());
+  }
+
+
   //! Applies a string-based selection to an atomic group...
   AtomicGroup selectAtoms(const AtomicGroup&, const std::string);
 
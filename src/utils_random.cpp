@@ -20,25 +20,121 @@
 */
 
 
+#include <atomic>
+
 #include <boost/random.hpp>
+#include <boost/thread/mutex.hpp>
 #include <utils_random.hpp>
 
 namespace loos {
+
+  namespace {
+
+    // Process-wide seed that each thread's generator is derived from.
+    // The generation is bumped on every seedRNG() so that threads
+    // notice and reseed their generators on their next use.
+    struct GlobalSeed {
+      GlobalSeed() : seeded(false), seed(0), generation(0), nthreads(0) { }
+
+      bool seeded;
+      uint seed;
+      std::atomic<uint> generation;
+      uint nthreads;
+      boost::mutex lock;
+    };
+
+    GlobalSeed& globalSeed() {
+      static GlobalSeed global;
+      return(global);
+    }
+
+
+    struct ThreadRNG {
+      ThreadRNG() : index(0), generation(0), initialized(false) { }
+
+      base_generator_type rng;
+      uint index, generation;
+      bool initialized;
+    };
+
+    // Threads that never call setRNGStream() are numbered from here,
+    // well clear of the worker numbers passed to setRNGStream()
+    const uint unnumbered_streams = 0x80000000u;
+
+    ThreadRNG& threadRNG() {
+      static thread_local ThreadRNG local;
+      return(local);
+    }
+
+    void seedThread(ThreadRNG& local, const GlobalSeed& global) {
+      local.generation = global.generation;
+      if (global.seeded)
+        local.rng.seed(global.seed + local.index);
+      else if (local.index != 0)
+        local.rng.seed(base_generator_type::default_seed + local.index);
+      else
+        local.rng.seed();
+    }
+  }
+
+
+  // The first thread to use the generator (normally the main thread)
+  // gets stream 0 and the seed itself, so single-threaded code sees
+  // the same stream it always has.  Other threads get the seed plus
+  // their stream, which is either set with setRNGStream() or numbered
+  // from unnumbered_streams in first-use order.  When no seed has been
+  // set, stream 0 keeps the generator's default state.
   base_generator_type& rng_singleton(void) {
-    static base_generator_type rng;
+    ThreadRNG& local = threadRNG();
+    GlobalSeed& global = globalSeed();
+
+    if (local.initialized && local.generation == global.generation.load())
+      return(local.rng);
+
+    boost::mutex::scoped_lock lock(global.lock);
+    if (!local.initialized) {
+      local.index = global.nthreads == 0 ? 0 : unnumbered_streams + global.nthreads;
+      ++global.nthreads;
+      local.initialized = true;
+      seedThread(local, global);
+    } else if (local.generation != global.generation)
+      seedThread(local, global);
+
+    return(local.rng);
+  }
+
 
-    return(rng);
+  void setRNGStream(const uint stream) {
+    ThreadRNG& local = threadRNG();
+    GlobalSeed& global = globalSeed();
+
+    boost::mutex::scoped_lock lock(global.lock);
+    local.initialized = true;
+    local.index = stream;
+    seedThread(local, global);
+  }
+
+
+  void seedRNG(const uint seedval) {
+    GlobalSeed& global = globalSeed();
+    {
+      boost::mutex::scoped_lock lock(global.lock);
+      global.seeded = true;
+      global.seed = seedval;
+      ++global.generation;
+    }
+
+    // Reseed the caller's generator now
+    rng_singleton();
   }
 
 
   // Seeding based on the block is not the best method, but probably
   // sufficient for our purposes...
   uint randomSeedRNG(void) {
-    base_generator_type& rng = rng_singleton();
-
     uint seedval = static_cast<uint>(time(0));
 
-    rng.seed(seedval);
+    seedRNG(seedval);
     return(seedval);
   }
 };
@@ -36,16 +36,43 @@ namespace loos {
    * gets seeded.  It is up to the tool-writer to seed it with a known
    * value,
 \code
-rng_singleton().seed(seed_value);
+seedRNG(seed_value);
 \endcode
    * or call randomSeedRNG() to randomly seed the random number
    * generator...
+   *
+   * Each thread has its own generator, so threads never share
+   * generator state.  Each generator is derived from a process-wide
+   * seed, set with seedRNG() (or randomSeedRNG()).  The first thread
+   * to use its generator (normally the main thread) is seeded with
+   * the seed itself, and every other thread with the seed plus a
+   * stream number, so all threads draw different streams.  Worker
+   * threads should pick their stream with setRNGStream() (e.g. the
+   * worker number plus one); otherwise streams are handed out in the
+   * order threads first use their generators, which varies from run
+   * to run.  Calling seedRNG() reseeds the generators of all threads,
+   * which pick up the new seed the next time they call
+   * rng_singleton().  Seeding the returned generator directly only
+   * affects the calling thread.
    */
   base_generator_type& rng_singleton(void);
 
+  //! Selects the random stream of the calling thread (see rng_singleton())
+  /**
+   * The thread's generator is reseeded with the process-wide seed plus
+   * \a stream, so a worker that always uses the same stream draws the
+   * same numbers regardless of how threads are scheduled.  Stream 0 is
+   * the seed itself (normally the main thread's).
+   */
+  void setRNGStream(const uint stream);
+
+  //! Seeds the generators of all threads (see rng_singleton())
+  void seedRNG(const uint seedval);
+
   //! Randomly seeds the RNG
   /**Currently uses time(3) to seed the RNG obtained from the singleton...
-   * Returns the seed used.
+   * Returns the seed used.  As with seedRNG(), the generators of all
+   * threads are reseeded.
    */
   uint randomSeedRNG(void);
 
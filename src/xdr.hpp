@@ -27,6 +27,8 @@
 #include <string>
 #include <stdexcept>
 #include <vector>
+#include <algorithm>
+#include <cstring>
 
 #include <loos_defs.hpp>
 #include <utils.hpp>
@@ -37,6 +39,34 @@ namespace loos {
   namespace internal {
 
 
+    //! Byte-swap an array of 4-byte words in place
+    /**
+     * This is written as a simple loop over the words so the compiler
+     * can turn it into vector shuffles.
+     */
+    inline void swabArray32(void* p, const uint n) {
+      unsigned int* q = static_cast<unsigned int*>(p);
+#if defined(__GNUC__)
+      for (uint i=0; i<n; ++i)
+	q[i] = __builtin_bswap32(q[i]);
+#else
+      for (uint i=0; i<n; ++i)
+	q[i] = swab(q[i]);
+#endif
+    }
+
+    //! Byte-swap an array of 8-byte words in place
+    inline void swabArray64(void* p, const uint n) {
+      unsigned long long* q = static_cast<unsigned long long*>(p);
+#if defined(__GNUC__)
+      for (uint i=0; i<n; ++i)
+	q[i] = __builtin_bswap64(q[i]);
+#else
+      for (uint i=0; i<n; ++i)
+	q[i] = swab(q[i]);
+#endif
+    }
+
 
     //! This class provides some facility for handling XDR data
     /**
@@ -95,10 +125,29 @@ namespace loos {
 
 
       //! Read an n-array of data
+      /**
+       * Arrays of 4-byte types are read in one block and then
+       * byte-swapped in place.  Returns the number of elements read.
+       */
       template<typename T> uint read(T* ary, const uint n) {
-	uint i;
-	for (i=0; i<n && read(ary+i); ++i) ;
-	return(i);
+	if (sizeof(T) != sizeof(block_type)) {
+	  uint i;
+	  for (i=0; i<n && read(ary+i); ++i) ;
+	  return(i);
+	}
+
+	uint k = readBlock(ary, n, sizeof(T));
+	if (need_to_swab)
+	  swabArray32(ary, k);
+	return(k);
+      }
+
+      //! Read an n-array of doubles as a single block
+      uint read(double* ary, const uint n) {
+	uint k = readBlock(ary, n, sizeof(double));
+	if (need_to_swab)
+	  swabArray64(ary, k);
+	return(k);
       }
 
 
@@ -149,6 +198,15 @@ namespace loos {
       }
 
     private:
+
+      // Returns the number of complete elements actually read
+      uint readBlock(void* p, const uint n, const uint size) {
+	if (n == 0)
+	  return(0);
+	stream->read(static_cast<char*>(p), static_cast<std::streamsize>(n) * size);
+	return(stream->gcount() / size);
+      }
+
       std::istream* stream;
       bool need_to_swab;
     };
@@ -164,7 +222,7 @@ namespace loos {
 
     public:
 
-      XDRWriter() : stream(0) {
+      XDRWriter() : stream(0), need_to_swab(false) {
 	int test = 0x1234;
 	if (*(reinterpret_cast<char*>(&test)) == 0x34) {
 	  need_to_swab = true;
@@ -172,7 +230,7 @@ namespace loos {
       }
 
       //! Constructor determines need to convert data at instantiation
-      XDRWriter(std::ostream* s) : stream(s) { 
+      XDRWriter(std::ostream* s) : stream(s), need_to_swab(false) {
 	int test = 0x1234;
 	if (*(reinterpret_cast<char*>(&test)) == 0x34) {
 	  need_to_swab = true;
@@ -227,10 +285,23 @@ namespace loos {
       
 
       //! Writes an n-array of data
+      /**
+       * Arrays of 4-byte types are written as a single block (or in
+       * byte-swapped chunks, if necessary).
+       */
       template<typename T> uint write(const T* ary, const uint n) {
-	uint i;
-	for (i=0; i<n && write(ary[i]); ++i) ;
-	return(i);
+	if (sizeof(T) != sizeof(block_type)) {
+	  uint i;
+	  for (i=0; i<n && write(ary[i]); ++i) ;
+	  return(i);
+	}
+
+	return(writeBlock(ary, n, sizeof(T)));
+      }
+
+      //! Writes an n-array of doubles
+      uint write(const double* ary, const uint n) {
+	return(writeBlock(ary, n, sizeof(double)));
       }
 
       //! Writes an opaque array of n-bytes
@@ -264,6 +335,35 @@ namespace loos {
       uint write(const std::string& s) { return(write(s.c_str())); }
         
     private:
+
+      // Elements are either 4 or 8 bytes.  When swapping, the data
+      // is copied into a fixed-size buffer a chunk at a time.
+      uint writeBlock(const void* p, const uint n, const uint size) {
+	const char* cp = static_cast<const char*>(p);
+
+	if (!need_to_swab) {
+	  stream->write(cp, static_cast<std::streamsize>(n) * size);
+	  return(stream->fail() ? 0 : n);
+	}
+
+	const uint chunk = 1024;
+	unsigned long long buf[chunk];
+	uint words_per_chunk = chunk * sizeof(unsigned long long) / size;
+	for (uint i=0; i<n; i += words_per_chunk) {
+	  uint m = std::min(words_per_chunk, n - i);
+	  memcpy(buf, cp + static_cast<size_t>(i) * size, static_cast<size_t>(m) * size);
+	  if (size == sizeof(double))
+	    swabArray64(buf, m);
+	  else
+	    swabArray32(buf, m);
+	  stream->write(reinterpret_cast<char*>(buf), static_cast<std::streamsize>(m) * size);
+	  if (stream->fail())
+	    return(i);
+	}
+
+	return(n);
+      }
+
       std::ostream* stream;
       bool need_to_swab;
 
@@ -29,6 +29,7 @@
 
 
 #include <xtc.hpp>
+#include <FrameIndexCache.hpp>
 
 
 namespace loos {
@@ -418,12 +419,24 @@ namespace loos {
 
   // Scan the trajectory file, skipping each compressed frame.  In the
   // process, we build up an index relating file-pos to frame index.
-  // This permits fast seeking of indivual frames.
-  void XTC::scanFrames(void) {
+  // This permits fast seeking of indivual frames.  The index is kept
+  // in the FrameIndexCache, so later opens of the same file can skip
+  // the scan.
+  void XTC::scanFrames(const bool use_cache) {
     frame_indices.clear();
     
     rewindImpl();
 
+    // Reuse the index from a previous scan of this file if there is one
+    FrameIndexCache cache(use_cache ? _filename : std::string(), "xtc");
+    FrameIndex index;
+    if (cache.lookup(index)) {
+      frame_indices = index.offsets;
+      natoms_ = index.natoms;
+      timestep_ = index.timestep;
+      return;
+    }
+
     Header h;
     
     while (! ifs->eof()) {
@@ -432,6 +445,10 @@ namespace loos {
       bool ok = readFrameHeader(h);
       if (!ok) {
         rewindImpl();
+        index.natoms = natoms_;
+        index.timestep = timestep_;
+        index.offsets = frame_indices;
+        cache.store(index);
         return;
       }
 
@@ -477,6 +494,33 @@ namespace loos {
   }
 
 
+  TrajectoryInfo XTC::probe(const std::string& fname, const AtomicGroup& model) {
+    XTC xtc(fname, false);
+
+    TrajectoryInfo info;
+    info.filename = fname;
+    info.format = xtc.description();
+    info.natoms = xtc.natoms();
+    info.nframes = xtc.nframes();
+    info.timestep = xtc.timestep();
+    info.periodic = true;
+    info.precision = sizeof(xtc_t);
+
+    // Peek at the precision stored with the first compressed frame
+    if (info.nframes > 0 && xtc.natoms_ > min_compressed_system_size) {
+      Header h;
+      xtc.seekFrameImpl(0);
+      xtc.readFrameHeader(h);
+      uint lsize;
+      xtc_t precision;
+      if (xtc.xdr_file.read(lsize) && xtc.xdr_file.read(precision))
+        info.compression_precision = precision;
+    }
+
+    return(info);
+  }
+
+
   void XTC::seekFrameImpl(const uint i) {
     if (i >= frame_indices.size())
       throw(FileError(_filename, "Requested XTC frame is out of range"));
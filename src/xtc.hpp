@@ -42,6 +42,7 @@
 #include <xdr.hpp>
 #include <AtomicGroup.hpp>
 #include <Trajectory.hpp>
+#include <TrajectoryInfo.hpp>
 
 #include <boost/format.hpp>
 
@@ -87,7 +88,7 @@ namespace loos {
     }
 
     explicit XTC(std::istream& is) : Trajectory(is), xdr_file(ifs.get()), natoms_(0) {
-      init();
+      init(false);
     }
 
     std::string description() const { return("Gromacs XTC (compressed trajectory)"); }
@@ -95,6 +96,14 @@ namespace loos {
       return(pTraj(new XTC(fname)));
     }
 
+    //! Return metadata by scanning the frame headers only
+    /**
+     * The frame count requires a scan of the frame headers (unless
+     * the index is in the FrameIndexCache), but no coordinates are
+     * decompressed.  The precision is taken from the first frame.
+     */
+    static TrajectoryInfo probe(const std::string& fname, const AtomicGroup& model);
+
     uint natoms(void) const { return(natoms_); }
     float timestep(void) const { return(timestep_); }
     uint nframes(void) const { return(frame_indices.size()); }
@@ -112,8 +121,17 @@ namespace loos {
 
   private:
 
-    void init(void) {
-      scanFrames();
+    // Only builds the frame index (see probe())
+    XTC(const std::string& s, const bool read_first) : Trajectory(s), xdr_file(ifs.get()), natoms_(0) {
+      if (read_first)
+        init();
+      else
+        scanFrames(true);
+    }
+
+    // Streams have no file to key the index cache on
+    void init(const bool use_cache = true) {
+      scanFrames(use_cache);
       coords_.reserve(natoms_);
       if (!parseFrame())
         throw(FileReadError(_filename, "Unable to read in the first frame"));
@@ -138,12 +156,13 @@ namespace loos {
     int decodebits(int*, uint);
     void decodeints(int*, const int, int, uint*, int*);
     bool readFrameHeader(Header&);
-    void scanFrames(void);
+    void scanFrames(const bool use_cache);
     
     void seekNextFrameImpl(void) { }
     void seekFrameImpl(uint);
     void rewindImpl(void) { ifs->clear(); ifs->seekg(0); }
     void updateGroupCoordsImpl(AtomicGroup& g);
+    void updateFrameCoordsImpl(FloatFrame& f) { f.copyFromFrame(coords_); f.periodicBox(box); }
     bool readCompressedCoords(void);
     bool readUncompressedCoords(void);
   };